@@ -590,5 +590,13 @@ const cairo_perf_case_t perf_cases[] = {
     { FUNC(wave), 500, 500 },
     { FUNC(fill_clip), 16, 512 },
     { FUNC(tiger), 16, 1024 },
+    { FUNC(small_fills), 64, 512 },
+    { FUNC(prepared_fill), 64, 512 },
+    { FUNC(instances), 64, 512 },
+    { FUNC(text_threads), 256, 256 },
+    { FUNC(solid_threads), 64, 64 },
+    { FUNC(gradient_reuse), 256, 256 },
+    { FUNC(mesh), 64, 512 },
+    { FUNC(thumbnail), 64, 256 },
     { NULL }
 };
@@ -246,5 +246,13 @@ CAIRO_PERF_DECL (a1_pixel);
 CAIRO_PERF_DECL (sierpinski);
 CAIRO_PERF_DECL (fill_clip);
 CAIRO_PERF_DECL (tiger);
+CAIRO_PERF_DECL (small_fills);
+CAIRO_PERF_DECL (prepared_fill);
+CAIRO_PERF_DECL (instances);
+CAIRO_PERF_DECL (text_threads);
+CAIRO_PERF_DECL (solid_threads);
+CAIRO_PERF_DECL (gradient_reuse);
+CAIRO_PERF_DECL (mesh);
+CAIRO_PERF_DECL (thumbnail);
 
 #endif
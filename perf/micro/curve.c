@@ -95,6 +95,13 @@ do_curve_fill (cairo_t *cr, int width, int height, int loops)
     return cairo_perf_timer_elapsed ();
 }
 
+static cairo_time_t
+do_curve_fill_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return do_curve_fill (cr, width, height, loops);
+}
+
 cairo_bool_t
 curve_enabled (cairo_perf_t *perf)
 {
@@ -108,4 +115,5 @@ curve (cairo_perf_t *perf, cairo_t *cr, int width, int height)
 
     cairo_perf_run (perf, "curve-stroked", do_curve_stroke, NULL);
     cairo_perf_run (perf, "curve-filled", do_curve_fill, NULL);
+    cairo_perf_run (perf, "curve-filled-fast", do_curve_fill_fast, NULL);
 }
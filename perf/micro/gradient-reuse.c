@@ -0,0 +1,115 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures filling many small shapes with a handful of linear
+ * gradients that are reused from one fill to the next, the pattern
+ * used for buttons and other widget chrome.  The "fast" variants use
+ * CAIRO_FILTER_FAST, which lets the image backend sample a cached
+ * colour ramp rather than rebuild the gradient for every fill.
+ */
+
+#include "cairo-perf.h"
+
+#define NUM_GRADIENTS 4
+#define NUM_SHAPES 256
+
+static cairo_pattern_t *gradients[NUM_GRADIENTS];
+
+static void
+create_gradients (cairo_filter_t filter)
+{
+    int i;
+
+    for (i = 0; i < NUM_GRADIENTS; i++) {
+	gradients[i] = cairo_pattern_create_linear (0, 0, 0, 24);
+	cairo_pattern_add_color_stop_rgb (gradients[i], 0, 1, 1, 1);
+	cairo_pattern_add_color_stop_rgba (gradients[i], .5, .2 * i, .5, .8, .9);
+	cairo_pattern_add_color_stop_rgb (gradients[i], 1, 0, 0, .25 * i);
+	cairo_pattern_set_extend (gradients[i], CAIRO_EXTEND_PAD);
+	cairo_pattern_set_filter (gradients[i], filter);
+    }
+}
+
+static void
+destroy_gradients (void)
+{
+    int i;
+
+    for (i = 0; i < NUM_GRADIENTS; i++)
+	cairo_pattern_destroy (gradients[i]);
+}
+
+static cairo_time_t
+do_gradient_reuse (cairo_t *cr, int width, int height, int loops,
+		   cairo_filter_t filter)
+{
+    create_gradients (filter);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	int count;
+
+	for (count = 0; count < NUM_SHAPES; count++) {
+	    double x = (count * 37) % (width - 64);
+	    double y = (count * 23) % (height - 24);
+
+	    cairo_save (cr);
+	    cairo_translate (cr, x, y);
+	    cairo_rectangle (cr, 0, 0, 64, 24);
+	    cairo_set_source (cr, gradients[count % NUM_GRADIENTS]);
+	    cairo_fill (cr);
+	    cairo_restore (cr);
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    destroy_gradients ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_gradient_reuse_good (cairo_t *cr, int width, int height, int loops)
+{
+    return do_gradient_reuse (cr, width, height, loops, CAIRO_FILTER_GOOD);
+}
+
+static cairo_time_t
+do_gradient_reuse_fast (cairo_t *cr, int width, int height, int loops)
+{
+    return do_gradient_reuse (cr, width, height, loops, CAIRO_FILTER_FAST);
+}
+
+cairo_bool_t
+gradient_reuse_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "gradient-reuse", NULL);
+}
+
+void
+gradient_reuse (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    cairo_perf_run (perf, "gradient-reuse-good", do_gradient_reuse_good, NULL);
+    cairo_perf_run (perf, "gradient-reuse-fast", do_gradient_reuse_fast, NULL);
+}
@@ -52,6 +52,11 @@ static void mono (cairo_t *cr)
     cairo_set_antialias (cr, CAIRO_ANTIALIAS_NONE);
 }
 
+static void fast (cairo_t *cr)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+}
+
 static void aligned (cairo_t *cr, int width, int height)
 {
 }
@@ -68,6 +73,12 @@ static void rotated (cairo_t *cr, int width, int height)
     cairo_translate (cr, -width/2, -height/2);
 }
 
+static void hairline (cairo_t *cr)
+{
+    cairo_set_line_width (cr, 1.);
+    cairo_stroke (cr);
+}
+
 static void clip (cairo_t *cr)
 {
     cairo_clip (cr);
@@ -170,6 +181,15 @@ F(clip_alpha_aligned_mono, clip_alpha, aligned, mono)
 F(clip_alpha_misaligned_mono, clip_alpha, misaligned, mono)
 F(clip_alpha_rotated_mono, clip_alpha, rotated, mono)
 
+F(aligned_fast, cairo_fill, aligned, fast)
+F(misaligned_fast, cairo_fill, misaligned, fast)
+F(rotated_fast, cairo_fill, rotated, fast)
+
+F(stroke_misaligned, hairline, misaligned, aa)
+F(stroke_rotated, hairline, rotated, aa)
+F(stroke_misaligned_fast, hairline, misaligned, fast)
+F(stroke_rotated_fast, hairline, rotated, fast)
+
 cairo_bool_t
 hatching_enabled (cairo_perf_t *perf)
 {
@@ -199,4 +219,13 @@ hatching (cairo_perf_t *perf, cairo_t *cr, int width, int height)
     cairo_perf_run (perf, "hatching-clip-alpha-aligned-mono", draw_clip_alpha_aligned_mono, NULL);
     cairo_perf_run (perf, "hatching-clip-alpha-misaligned-mono", draw_clip_alpha_misaligned_mono, NULL);
     cairo_perf_run (perf, "hatching-clip-alpha-rotated-mono", draw_clip_alpha_rotated_mono, NULL);
+
+    cairo_perf_run (perf, "hatching-aligned-fast", draw_aligned_fast, NULL);
+    cairo_perf_run (perf, "hatching-misaligned-fast", draw_misaligned_fast, NULL);
+    cairo_perf_run (perf, "hatching-rotated-fast", draw_rotated_fast, NULL);
+
+    cairo_perf_run (perf, "hatching-stroke-misaligned-aa", draw_stroke_misaligned, NULL);
+    cairo_perf_run (perf, "hatching-stroke-rotated-aa", draw_stroke_rotated, NULL);
+    cairo_perf_run (perf, "hatching-stroke-misaligned-fast", draw_stroke_misaligned_fast, NULL);
+    cairo_perf_run (perf, "hatching-stroke-rotated-fast", draw_stroke_rotated_fast, NULL);
 }
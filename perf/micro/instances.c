@@ -0,0 +1,127 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures drawing scatter plot markers, once with a cairo_arc() and
+ * cairo_fill() per marker and once with a single cairo_fill_instances().
+ */
+
+#include "cairo-perf.h"
+
+#define NUM_MARKERS 10000
+#define MARKER_RADIUS 3.
+
+static uint32_t state;
+static cairo_matrix_t transforms[NUM_MARKERS];
+static double colors[4 * NUM_MARKERS];
+
+static double
+uniform_random (double minval, double maxval)
+{
+    static uint32_t const poly = 0x9a795537U;
+    uint32_t n = 32;
+    while (n-->0)
+	state = 2*state < state ? (2*state ^ poly) : 2*state;
+    return minval + state * (maxval - minval) / 4294967296.0;
+}
+
+static cairo_time_t
+do_instances_fill (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	int i;
+
+	state = 0xc0ffee;
+	for (i = 0; i < NUM_MARKERS; i++) {
+	    double x = uniform_random (0, width);
+	    double y = uniform_random (0, height);
+
+	    cairo_set_source_rgba (cr,
+				   uniform_random (0, 1),
+				   uniform_random (0, 1),
+				   uniform_random (0, 1),
+				   .75);
+	    cairo_arc (cr, x, y, MARKER_RADIUS, 0, 2 * M_PI);
+	    cairo_fill (cr);
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_instances_fill_instances (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_path_t *marker;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_new_path (cr);
+    cairo_arc (cr, 0, 0, MARKER_RADIUS, 0, 2 * M_PI);
+    marker = cairo_copy_path (cr);
+    cairo_new_path (cr);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	int i;
+
+	state = 0xc0ffee;
+	for (i = 0; i < NUM_MARKERS; i++) {
+	    double x = uniform_random (0, width);
+	    double y = uniform_random (0, height);
+
+	    cairo_matrix_init_translate (&transforms[i], x, y);
+	    colors[4*i + 0] = uniform_random (0, 1);
+	    colors[4*i + 1] = uniform_random (0, 1);
+	    colors[4*i + 2] = uniform_random (0, 1);
+	    colors[4*i + 3] = .75;
+	}
+	cairo_fill_instances (cr, marker, transforms, colors, NUM_MARKERS);
+    }
+
+    cairo_perf_timer_stop ();
+
+    cairo_path_destroy (marker);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+cairo_bool_t
+instances_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "instances", NULL);
+}
+
+void
+instances (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    cairo_perf_run (perf, "instances-fill", do_instances_fill, NULL);
+    cairo_perf_run (perf, "instances-fill-instances", do_instances_fill_instances, NULL);
+}
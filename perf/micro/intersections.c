@@ -27,6 +27,7 @@
 #include "cairo-perf.h"
 
 #define NUM_SEGMENTS 256
+#define NUM_CONTOUR_SEGMENTS 131072
 
 static unsigned state;
 static double
@@ -119,6 +120,44 @@ draw_random_curve (cairo_t *cr, cairo_fill_rule_t fill_rule,
     return cairo_perf_timer_elapsed ();
 }
 
+/* A long, ragged closed contour that keeps crossing itself, like the
+ * coastlines in GIS data, to exercise tessellation of very large
+ * self-intersecting polygons. */
+static cairo_time_t
+draw_contour (cairo_t *cr, cairo_fill_rule_t fill_rule,
+	      int width, int height, int loops)
+{
+    double cx = width / 2., cy = height / 2.;
+    double radius = MIN (width, height) / 2. - 2;
+    int i;
+
+    cairo_save (cr);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_paint (cr);
+
+    state = 0x12345678;
+    cairo_set_fill_rule (cr, fill_rule);
+    cairo_set_source_rgb (cr, 1, 0, 0);
+
+    cairo_new_path (cr);
+    for (i = 0; i < NUM_CONTOUR_SEGMENTS; i++) {
+	double t = 2 * M_PI * i / NUM_CONTOUR_SEGMENTS;
+	double r = radius * (.75 + .15 * sin (97 * t) + uniform_random (0, .1));
+
+	cairo_line_to (cr, cx + r * cos (t), cy + r * sin (t));
+    }
+    cairo_close_path (cr);
+
+    cairo_perf_timer_start ();
+    while (loops--)
+        cairo_fill_preserve (cr);
+    cairo_perf_timer_stop ();
+
+    cairo_restore (cr);
+
+    return cairo_perf_timer_elapsed ();
+}
+
 static cairo_time_t
 random_eo (cairo_t *cr, int width, int height, int loops)
 {
@@ -143,6 +182,18 @@ random_curve_nz (cairo_t *cr, int width, int height, int loops)
     return draw_random_curve (cr, CAIRO_FILL_RULE_WINDING, width, height, loops);
 }
 
+static cairo_time_t
+contour_eo (cairo_t *cr, int width, int height, int loops)
+{
+    return draw_contour (cr, CAIRO_FILL_RULE_EVEN_ODD, width, height, loops);
+}
+
+static cairo_time_t
+contour_nz (cairo_t *cr, int width, int height, int loops)
+{
+    return draw_contour (cr, CAIRO_FILL_RULE_WINDING, width, height, loops);
+}
+
 cairo_bool_t
 intersections_enabled (cairo_perf_t *perf)
 {
@@ -157,4 +208,7 @@ intersections (cairo_perf_t *perf, cairo_t *cr, int width, int height)
 
     cairo_perf_run (perf, "intersections-nz-curve-fill", random_curve_nz, NULL);
     cairo_perf_run (perf, "intersections-eo-curve-fill", random_curve_eo, NULL);
+
+    cairo_perf_run (perf, "intersections-nz-contour-fill", contour_nz, NULL);
+    cairo_perf_run (perf, "intersections-eo-contour-fill", contour_eo, NULL);
 }
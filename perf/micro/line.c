@@ -94,6 +94,14 @@ nearly_horizontal_wide (cairo_t *cr, int width, int height, int loops)
     return nearly_horizontal (cr, width, height, loops);
 }
 
+static cairo_time_t
+nearly_horizontal_hair_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_line_width (cr, 1.);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return nearly_horizontal (cr, width, height, loops);
+}
+
 
 static cairo_time_t
 vertical (cairo_t *cr, int width, int height, int loops)
@@ -163,6 +171,14 @@ nearly_vertical_wide (cairo_t *cr, int width, int height, int loops)
     return nearly_vertical (cr, width, height, loops);
 }
 
+static cairo_time_t
+nearly_vertical_hair_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_line_width (cr, 1.);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return nearly_vertical (cr, width, height, loops);
+}
+
 
 static cairo_time_t
 diagonal (cairo_t *cr, int width, int height, int loops)
@@ -196,6 +212,14 @@ diagonal_wide (cairo_t *cr, int width, int height, int loops)
     return diagonal (cr, width, height, loops);
 }
 
+static cairo_time_t
+diagonal_hair_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_line_width (cr, 1.);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return diagonal (cr, width, height, loops);
+}
+
 cairo_bool_t
 line_enabled (cairo_perf_t *perf)
 {
@@ -211,12 +235,15 @@ line (cairo_perf_t *perf, cairo_t *cr, int width, int height)
     cairo_perf_run (perf, "line-hw", horizontal_wide, NULL);
     cairo_perf_run (perf, "line-nhh", nearly_horizontal_hair, NULL);
     cairo_perf_run (perf, "line-nhw", nearly_horizontal_wide, NULL);
+    cairo_perf_run (perf, "line-nhf", nearly_horizontal_hair_fast, NULL);
 
     cairo_perf_run (perf, "line-vh", vertical_hair, NULL);
     cairo_perf_run (perf, "line-vw", vertical_wide, NULL);
     cairo_perf_run (perf, "line-nvh", nearly_vertical_hair, NULL);
     cairo_perf_run (perf, "line-nvw", nearly_vertical_wide, NULL);
+    cairo_perf_run (perf, "line-nvf", nearly_vertical_hair_fast, NULL);
 
     cairo_perf_run (perf, "line-dh", diagonal_hair, NULL);
     cairo_perf_run (perf, "line-dw", diagonal_wide, NULL);
+    cairo_perf_run (perf, "line-df", diagonal_hair_fast, NULL);
 }
@@ -28,7 +28,7 @@
 #include "cairo-perf.h"
 
 static cairo_time_t
-do_long_dashed_lines (cairo_t *cr, int width, int height, int loops)
+do_dashed_lines (cairo_t *cr, int width, int height, int loops, int overhang)
 {
     double dash[2] = { 2.0, 2.0 };
     int i;
@@ -45,8 +45,8 @@ do_long_dashed_lines (cairo_t *cr, int width, int height, int loops)
 
     for (i = 0; i < height-1; i++) {
 	double y0 = (double) i + 0.5;
-	cairo_move_to (cr, 0.0, y0);
-	cairo_line_to (cr, width, y0);
+	cairo_move_to (cr, -overhang, y0);
+	cairo_line_to (cr, width + overhang, y0);
     }
 
     cairo_perf_timer_start ();
@@ -61,6 +61,19 @@ do_long_dashed_lines (cairo_t *cr, int width, int height, int loops)
     return cairo_perf_timer_elapsed ();
 }
 
+static cairo_time_t
+do_long_dashed_lines (cairo_t *cr, int width, int height, int loops)
+{
+    return do_dashed_lines (cr, width, height, loops, 0);
+}
+
+/* Mostly off-screen: each line reaches far beyond either side. */
+static cairo_time_t
+do_long_dashed_lines_offscreen (cairo_t *cr, int width, int height, int loops)
+{
+    return do_dashed_lines (cr, width, height, loops, 16 * width);
+}
+
 cairo_bool_t
 long_dashed_lines_enabled (cairo_perf_t *perf)
 {
@@ -71,4 +84,6 @@ void
 long_dashed_lines (cairo_perf_t *perf, cairo_t *cr, int width, int height)
 {
     cairo_perf_run (perf, "long-dashed-lines", do_long_dashed_lines, NULL);
+    cairo_perf_run (perf, "long-dashed-lines-offscreen",
+		    do_long_dashed_lines_offscreen, NULL);
 }
@@ -33,11 +33,15 @@
  *
  * For comparison, this test also renders the visible portions of the
  * same lines, (this is the "long-lines-cropped" report).
+ *
+ * The "-fast" variants stroke the lines a pixel wide with
+ * CAIRO_ANTIALIAS_FAST, which draws them directly as hairlines.
  */
 
 typedef enum {
     LONG_LINES_CROPPED = 0x1,
     LONG_LINES_ONCE = 0x2,
+    LONG_LINES_FAST = 0x4,
 } long_lines_crop_t;
 #define NUM_LINES    20
 #define LONG_FACTOR  50.0
@@ -53,6 +57,11 @@ do_long_lines (cairo_t *cr, int width, int height, int loops, long_lines_crop_t
 
     cairo_translate (cr, width / 2, height / 2);
 
+    if (crop & LONG_LINES_FAST) {
+	cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+	cairo_set_line_width (cr, 1.);
+    }
+
     if (crop & LONG_LINES_CROPPED) {
 	outer_width = width;
 	outer_height = height;
@@ -132,6 +141,24 @@ long_lines_cropped_once (cairo_t *cr, int width, int height, int loops)
     return do_long_lines (cr, width, height, loops, LONG_LINES_CROPPED | LONG_LINES_ONCE);
 }
 
+static cairo_time_t
+long_lines_uncropped_fast (cairo_t *cr, int width, int height, int loops)
+{
+    return do_long_lines (cr, width, height, loops, LONG_LINES_FAST);
+}
+
+static cairo_time_t
+long_lines_uncropped_once_fast (cairo_t *cr, int width, int height, int loops)
+{
+    return do_long_lines (cr, width, height, loops, LONG_LINES_ONCE | LONG_LINES_FAST);
+}
+
+static cairo_time_t
+long_lines_cropped_fast (cairo_t *cr, int width, int height, int loops)
+{
+    return do_long_lines (cr, width, height, loops, LONG_LINES_CROPPED | LONG_LINES_FAST);
+}
+
 cairo_bool_t
 long_lines_enabled (cairo_perf_t *perf)
 {
@@ -145,4 +172,7 @@ long_lines (cairo_perf_t *perf, cairo_t *cr, int width, int height)
     cairo_perf_run (perf, "long-lines-uncropped-once", long_lines_uncropped_once, NULL);
     cairo_perf_run (perf, "long-lines-cropped", long_lines_cropped, NULL);
     cairo_perf_run (perf, "long-lines-cropped-once", long_lines_cropped_once, NULL);
+    cairo_perf_run (perf, "long-lines-uncropped-fast", long_lines_uncropped_fast, NULL);
+    cairo_perf_run (perf, "long-lines-uncropped-once-fast", long_lines_uncropped_once_fast, NULL);
+    cairo_perf_run (perf, "long-lines-cropped-fast", long_lines_cropped_fast, NULL);
 }
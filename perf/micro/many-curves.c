@@ -118,6 +118,13 @@ do_many_curves_filled (cairo_t *cr, int width, int height, int loops)
     return cairo_perf_timer_elapsed ();
 }
 
+static cairo_time_t
+do_many_curves_filled_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return do_many_curves_filled (cr, width, height, loops);
+}
+
 cairo_bool_t
 many_curves_enabled (cairo_perf_t *perf)
 {
@@ -132,4 +139,5 @@ many_curves (cairo_perf_t *perf, cairo_t *cr, int width, int height)
     cairo_perf_run (perf, "many-curves-hair-stroked", do_many_curves_hair_stroked, NULL);
     cairo_perf_run (perf, "many-curves-wide-stroked", do_many_curves_wide_stroked, NULL);
     cairo_perf_run (perf, "many-curves-filled", do_many_curves_filled, NULL);
+    cairo_perf_run (perf, "many-curves-filled-fast", do_many_curves_filled_fast, NULL);
 }
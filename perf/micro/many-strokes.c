@@ -169,6 +169,42 @@ do_many_strokes (cairo_t *cr, int width, int height, int loops)
     return cairo_perf_timer_elapsed ();
 }
 
+static cairo_time_t
+do_many_strokes_series (cairo_t *cr, int width, int height, int loops)
+{
+    int count, n = 200 * width;
+
+    /* a time series plot, with many points to each pixel column */
+    state = 0xc0ffee;
+    cairo_move_to (cr, 0, height / 2.);
+    for (count = 1; count < n; count++) {
+	cairo_line_to (cr,
+		       count * (double) width / n,
+		       height * (.5 + .3 * sin (count * 20. / n)) +
+		       uniform_random (-.1, .1) * height);
+    }
+
+    cairo_set_line_width (cr, 1.);
+
+    cairo_perf_timer_start ();
+
+    while (loops--)
+	cairo_stroke_preserve (cr);
+
+    cairo_perf_timer_stop ();
+
+    cairo_new_path (cr);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_many_strokes_series_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return do_many_strokes_series (cr, width, height, loops);
+}
+
 cairo_bool_t
 many_strokes_enabled (cairo_perf_t *perf)
 {
@@ -183,4 +219,6 @@ many_strokes (cairo_perf_t *perf, cairo_t *cr, int width, int height)
     cairo_perf_run (perf, "many-strokes-horizontal", do_many_strokes_h, NULL);
     cairo_perf_run (perf, "many-strokes-vertical", do_many_strokes_v, NULL);
     cairo_perf_run (perf, "many-strokes-random", do_many_strokes, NULL);
+    cairo_perf_run (perf, "many-strokes-time-series", do_many_strokes_series, NULL);
+    cairo_perf_run (perf, "many-strokes-time-series-fast", do_many_strokes_series_fast, NULL);
 }
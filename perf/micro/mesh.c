@@ -0,0 +1,113 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures painting mesh gradients, such as the heat-map overlays that
+ * cover a whole surface with a regular grid of coloured patches.
+ * Meshes are rasterized on the CPU before compositing, so set
+ * CAIRO_THREADS to compare the single-threaded and banded paths.
+ */
+
+#include "cairo-perf.h"
+
+static cairo_pattern_t *
+create_mesh (int width, int height, int grid)
+{
+    cairo_pattern_t *mesh;
+    int i, j;
+
+    mesh = cairo_pattern_create_mesh ();
+    for (i = 0; i < grid; i++) {
+	for (j = 0; j < grid; j++) {
+	    double x0 = (double) j * width / grid;
+	    double y0 = (double) i * height / grid;
+	    double x1 = (double) (j + 1) * width / grid;
+	    double y1 = (double) (i + 1) * height / grid;
+	    double w = (x1 - x0) / 3, h = (y1 - y0) / 3;
+
+	    cairo_mesh_pattern_begin_patch (mesh);
+	    cairo_mesh_pattern_move_to (mesh, x0, y0);
+	    cairo_mesh_pattern_curve_to (mesh, x0 + w, y0 - h/2, x1 - w, y0 + h/2, x1, y0);
+	    cairo_mesh_pattern_line_to (mesh, x1, y1);
+	    cairo_mesh_pattern_curve_to (mesh, x1 - w, y1 + h/2, x0 + w, y1 - h/2, x0, y1);
+	    cairo_mesh_pattern_line_to (mesh, x0, y0);
+
+	    cairo_mesh_pattern_set_corner_color_rgb (mesh, 0, (double) i / grid, 0, 1);
+	    cairo_mesh_pattern_set_corner_color_rgb (mesh, 1, 1, (double) j / grid, 0);
+	    cairo_mesh_pattern_set_corner_color_rgba (mesh, 2, 0, 1, (double) i / grid, .5);
+	    cairo_mesh_pattern_set_corner_color_rgb (mesh, 3, 1, 1, (double) j / grid);
+	    cairo_mesh_pattern_end_patch (mesh);
+	}
+    }
+
+    return mesh;
+}
+
+static cairo_time_t
+do_mesh (cairo_t *cr, int width, int height, int loops, int grid)
+{
+    cairo_pattern_t *mesh;
+
+    mesh = create_mesh (width, height, grid);
+    cairo_set_source (cr, mesh);
+    cairo_pattern_destroy (mesh);
+
+    cairo_perf_timer_start ();
+
+    while (loops--)
+	cairo_paint (cr);
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_mesh_1x1 (cairo_t *cr, int width, int height, int loops)
+{
+    return do_mesh (cr, width, height, loops, 1);
+}
+
+static cairo_time_t
+do_mesh_8x8 (cairo_t *cr, int width, int height, int loops)
+{
+    return do_mesh (cr, width, height, loops, 8);
+}
+
+static cairo_time_t
+do_mesh_64x64 (cairo_t *cr, int width, int height, int loops)
+{
+    return do_mesh (cr, width, height, loops, 64);
+}
+
+cairo_bool_t
+mesh_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "mesh", NULL);
+}
+
+void
+mesh (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    cairo_perf_run (perf, "mesh-1x1", do_mesh_1x1, NULL);
+    cairo_perf_run (perf, "mesh-8x8", do_mesh_8x8, NULL);
+    cairo_perf_run (perf, "mesh-64x64", do_mesh_64x64, NULL);
+}
@@ -0,0 +1,131 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures redrawing the same curved icon at many whole pixel offsets,
+ * once building and filling the path each time and once reusing a
+ * path captured with cairo_prepare_fill().
+ */
+
+#include "cairo-perf.h"
+
+#define ICON_SIZE 32
+#define PETALS 12
+
+static void
+icon_path (cairo_t *cr)
+{
+    int i;
+
+    cairo_new_path (cr);
+    cairo_move_to (cr, ICON_SIZE, ICON_SIZE / 2.);
+    for (i = 0; i < PETALS; i++) {
+	double a0 = 2 * M_PI * i / PETALS;
+	double a1 = 2 * M_PI * (i + 1) / PETALS;
+	double am = (a0 + a1) / 2;
+
+	cairo_curve_to (cr,
+			ICON_SIZE / 2. * (1 + 1.2 * cos (am - .2)),
+			ICON_SIZE / 2. * (1 + 1.2 * sin (am - .2)),
+			ICON_SIZE / 2. * (1 + .3 * cos (am + .2)),
+			ICON_SIZE / 2. * (1 + .3 * sin (am + .2)),
+			ICON_SIZE / 2. * (1 + cos (a1)),
+			ICON_SIZE / 2. * (1 + sin (a1)));
+    }
+    cairo_close_path (cr);
+    cairo_arc_negative (cr, ICON_SIZE / 2., ICON_SIZE / 2., ICON_SIZE / 6., 0, -2 * M_PI);
+}
+
+static cairo_time_t
+do_prepared_fill_path (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	int x, y;
+
+	for (y = 0; y + ICON_SIZE <= height; y += ICON_SIZE) {
+	    for (x = 0; x + ICON_SIZE <= width; x += ICON_SIZE) {
+		cairo_save (cr);
+		cairo_translate (cr, x, y);
+		icon_path (cr);
+		cairo_fill (cr);
+		cairo_restore (cr);
+	    }
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_prepared_fill_prepared (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_prepared_path_t *icon;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+
+    icon_path (cr);
+    icon = cairo_prepare_fill (cr);
+    cairo_new_path (cr);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	int x, y;
+
+	for (y = 0; y + ICON_SIZE <= height; y += ICON_SIZE) {
+	    for (x = 0; x + ICON_SIZE <= width; x += ICON_SIZE) {
+		cairo_save (cr);
+		cairo_translate (cr, x, y);
+		cairo_fill_prepared (cr, icon);
+		cairo_restore (cr);
+	    }
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    cairo_prepared_path_destroy (icon);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+cairo_bool_t
+prepared_fill_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "prepared-fill", NULL);
+}
+
+void
+prepared_fill (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    cairo_perf_run (perf, "prepared-fill-path", do_prepared_fill_path, NULL);
+    cairo_perf_run (perf, "prepared-fill-prepared", do_prepared_fill_prepared, NULL);
+}
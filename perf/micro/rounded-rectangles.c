@@ -119,6 +119,41 @@ do_rectangles_once (cairo_t *cr, int width, int height, int loops)
     return cairo_perf_timer_elapsed ();
 }
 
+static cairo_time_t
+do_rectangles_primitive (cairo_t *cr, int width, int height, int loops)
+{
+    int i;
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	for (i = 0; i < RECTANGLE_COUNT; i++) {
+	    cairo_rounded_rectangle (cr,
+				     rects[i].x, rects[i].y,
+				     rects[i].width, rects[i].height,
+				     3.0);
+	    cairo_fill (cr);
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_rectangles_primitive_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_time_t elapsed;
+
+    cairo_save (cr);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    elapsed = do_rectangles_primitive (cr, width, height, loops);
+    cairo_restore (cr);
+
+    return elapsed;
+}
+
 cairo_bool_t
 rounded_rectangles_enabled (cairo_perf_t *perf)
 {
@@ -141,4 +176,6 @@ rounded_rectangles (cairo_perf_t *perf, cairo_t *cr, int width, int height)
     MODE (perf, "one-rounded-rectangle", do_rectangle, NULL);
     MODE (perf, "rounded-rectangles", do_rectangles, NULL);
     MODE (perf, "rounded-rectangles-once", do_rectangles_once, NULL);
+    MODE (perf, "rounded-rectangles-primitive", do_rectangles_primitive, NULL);
+    MODE (perf, "rounded-rectangles-primitive-fast", do_rectangles_primitive_fast, NULL);
 }
@@ -0,0 +1,159 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures the per-fill overhead when drawing lots of tiny shapes,
+ * each with its own cairo_fill(), where setting up the scan converter
+ * costs more than the pixels it produces.
+ */
+
+#include "cairo-perf.h"
+
+#define NUM_SHAPES 1000
+
+static uint32_t state;
+
+static double
+uniform_random (double minval, double maxval)
+{
+    static uint32_t const poly = 0x9a795537U;
+    uint32_t n = 32;
+    while (n-->0)
+	state = 2*state < state ? (2*state ^ poly) : 2*state;
+    return minval + state * (maxval - minval) / 4294967296.0;
+}
+
+static cairo_time_t
+do_small_fills_triangles (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	int count;
+
+	state = 0xc0ffee;
+	for (count = 0; count < NUM_SHAPES; count++) {
+	    double x = uniform_random (0, width);
+	    double y = uniform_random (0, height);
+
+	    cairo_move_to (cr, x, y);
+	    cairo_rel_line_to (cr, uniform_random (-8, 8), uniform_random (-8, 8));
+	    cairo_rel_line_to (cr, uniform_random (-8, 8), uniform_random (-8, 8));
+	    cairo_close_path (cr);
+	    cairo_fill (cr);
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_small_fills_circles (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	int count;
+
+	state = 0xc0ffee;
+	for (count = 0; count < NUM_SHAPES; count++) {
+	    double x = uniform_random (0, width);
+	    double y = uniform_random (0, height);
+
+	    cairo_arc (cr, x, y, uniform_random (1, 6), 0, 2 * M_PI);
+	    cairo_fill (cr);
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_small_fills_circles_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_time_t elapsed;
+
+    cairo_save (cr);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    elapsed = do_small_fills_circles (cr, width, height, loops);
+    cairo_restore (cr);
+
+    return elapsed;
+}
+
+/* Chart markers: a single radius at many positions. */
+static cairo_time_t
+do_small_fills_markers_fast (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_save (cr);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+
+    cairo_perf_timer_start ();
+
+    while (loops--) {
+	int count;
+
+	state = 0xc0ffee;
+	for (count = 0; count < NUM_SHAPES; count++) {
+	    double x = uniform_random (0, width);
+	    double y = uniform_random (0, height);
+
+	    cairo_arc (cr, x, y, 3, 0, 2 * M_PI);
+	    cairo_fill (cr);
+	}
+    }
+
+    cairo_perf_timer_stop ();
+
+    cairo_restore (cr);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+cairo_bool_t
+small_fills_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "small-fills", NULL);
+}
+
+void
+small_fills (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    cairo_perf_run (perf, "small-fills-triangles", do_small_fills_triangles, NULL);
+    cairo_perf_run (perf, "small-fills-circles", do_small_fills_circles, NULL);
+    cairo_perf_run (perf, "small-fills-circles-fast", do_small_fills_circles_fast, NULL);
+    cairo_perf_run (perf, "small-fills-markers-fast", do_small_fills_markers_fast, NULL);
+}
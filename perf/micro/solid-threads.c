@@ -0,0 +1,181 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures how solid colour paints and fills scale across threads,
+ * each drawing into its own image surface with a small palette of
+ * colours, which exercises the lookup of the solid source images
+ * rather than the rasterisation.  The rate is reported over all
+ * threads, so ideal scaling shows up as a rate proportional to the
+ * number of threads.
+ */
+
+#include "cairo-perf.h"
+
+#if CAIRO_HAS_REAL_PTHREAD
+#include <pthread.h>
+
+#define MAX_THREADS 32
+#define NUM_COLORS 8
+#define NUM_SHAPES 256
+
+typedef struct {
+    pthread_t thread;
+    cairo_surface_t *surface;
+    cairo_bool_t fill;
+    int loops;
+} solid_thread_t;
+
+static void
+set_color (cairo_t *cr, int n)
+{
+    n %= NUM_COLORS;
+    cairo_set_source_rgba (cr,
+			   (n & 1) ? .75 : .25,
+			   (n & 2) ? .75 : .25,
+			   (n & 4) ? .75 : .25,
+			   .5);
+}
+
+static void *
+draw_solid_thread (void *closure)
+{
+    solid_thread_t *thread = closure;
+    int width = cairo_image_surface_get_width (thread->surface);
+    int height = cairo_image_surface_get_height (thread->surface);
+    cairo_t *cr;
+    int loops, n;
+
+    cr = cairo_create (thread->surface);
+
+    for (loops = thread->loops; loops--; ) {
+	for (n = 0; n < NUM_SHAPES; n++) {
+	    set_color (cr, n);
+	    if (thread->fill) {
+		cairo_rectangle (cr,
+				 n * 7 % (width - 8), n * 13 % (height - 8),
+				 8, 8);
+		cairo_fill (cr);
+	    } else {
+		cairo_paint (cr);
+	    }
+	}
+    }
+
+    cairo_destroy (cr);
+    return NULL;
+}
+
+static cairo_time_t
+do_solid_threads (cairo_t *cr, int width, int height, int loops,
+		  cairo_bool_t fill, int num_threads)
+{
+    solid_thread_t threads[MAX_THREADS];
+    int n;
+
+    for (n = 0; n < num_threads; n++) {
+	threads[n].surface =
+	    cairo_surface_create_similar_image (cairo_get_target (cr),
+						CAIRO_FORMAT_ARGB32,
+						width, height);
+	threads[n].fill = fill;
+	threads[n].loops = loops;
+    }
+
+    cairo_perf_timer_start ();
+
+    for (n = 1; n < num_threads; n++)
+	pthread_create (&threads[n].thread, NULL,
+			draw_solid_thread, &threads[n]);
+    draw_solid_thread (&threads[0]);
+    for (n = 1; n < num_threads; n++)
+	pthread_join (threads[n].thread, NULL);
+
+    cairo_perf_timer_stop ();
+
+    for (n = 0; n < num_threads; n++)
+	cairo_surface_destroy (threads[n].surface);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static double
+count_solid_threads (int num_threads)
+{
+    return num_threads * NUM_SHAPES / 1000.; /* kiloops */
+}
+
+#define DECL(n) \
+static cairo_time_t \
+do_paint_threads##n (cairo_t *cr, int width, int height, int loops) \
+{ \
+    return do_solid_threads (cr, width, height, loops, FALSE, n); \
+} \
+\
+static cairo_time_t \
+do_fill_threads##n (cairo_t *cr, int width, int height, int loops) \
+{ \
+    return do_solid_threads (cr, width, height, loops, TRUE, n); \
+} \
+\
+static double \
+count_solid_threads##n (cairo_t *cr, int width, int height) \
+{ \
+    return count_solid_threads (n); \
+}
+
+DECL(1)
+DECL(2)
+DECL(4)
+DECL(8)
+DECL(16)
+DECL(32)
+#endif
+
+cairo_bool_t
+solid_threads_enabled (cairo_perf_t *perf)
+{
+#if CAIRO_HAS_REAL_PTHREAD
+    return cairo_perf_can_run (perf, "solid-threads", NULL);
+#else
+    return FALSE;
+#endif
+}
+
+void
+solid_threads (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+#if CAIRO_HAS_REAL_PTHREAD
+    cairo_perf_run (perf, "solid-threads-paint-1", do_paint_threads1, count_solid_threads1);
+    cairo_perf_run (perf, "solid-threads-paint-2", do_paint_threads2, count_solid_threads2);
+    cairo_perf_run (perf, "solid-threads-paint-4", do_paint_threads4, count_solid_threads4);
+    cairo_perf_run (perf, "solid-threads-paint-8", do_paint_threads8, count_solid_threads8);
+    cairo_perf_run (perf, "solid-threads-paint-16", do_paint_threads16, count_solid_threads16);
+    cairo_perf_run (perf, "solid-threads-paint-32", do_paint_threads32, count_solid_threads32);
+
+    cairo_perf_run (perf, "solid-threads-fill-1", do_fill_threads1, count_solid_threads1);
+    cairo_perf_run (perf, "solid-threads-fill-2", do_fill_threads2, count_solid_threads2);
+    cairo_perf_run (perf, "solid-threads-fill-4", do_fill_threads4, count_solid_threads4);
+    cairo_perf_run (perf, "solid-threads-fill-8", do_fill_threads8, count_solid_threads8);
+    cairo_perf_run (perf, "solid-threads-fill-16", do_fill_threads16, count_solid_threads16);
+    cairo_perf_run (perf, "solid-threads-fill-32", do_fill_threads32, count_solid_threads32);
+#endif
+}
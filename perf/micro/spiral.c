@@ -197,6 +197,46 @@ draw_spiral_stroke (cairo_t *cr,
     return cairo_perf_timer_elapsed ();
 }
 
+static cairo_time_t
+draw_spiral_curve (cairo_t *cr,
+		   cairo_antialias_t antialias,
+		   int width, int height, int loops)
+{
+    const double step = 3;
+    double cx = width / 2., cy = height / 2.;
+    double r;
+    int side = width < height ? width : height;
+    int i;
+
+    cairo_save (cr);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_paint (cr);
+
+    cairo_set_source_rgb (cr, 1, 0, 0);
+    cairo_set_antialias (cr, antialias);
+
+    /* Half-turns about two alternating centres, so that the path is
+     * made of many curves spread over the full height. */
+    cairo_new_path (cr);
+    cairo_move_to (cr, cx + step, cy);
+    for (i = 0, r = step; r < side / 2. - step; i++, r += step) {
+	if (i & 1)
+	    cairo_arc (cr, cx + step / 2, cy, r, M_PI, 2 * M_PI);
+	else
+	    cairo_arc (cr, cx, cy, r, 0, M_PI);
+    }
+    cairo_close_path (cr);
+
+    cairo_perf_timer_start ();
+    while (loops--)
+        cairo_fill_preserve (cr);
+    cairo_perf_timer_stop ();
+
+    cairo_restore (cr);
+
+    return cairo_perf_timer_elapsed ();
+}
+
 static cairo_time_t
 draw_spiral_eo_pa_re (cairo_t *cr, int width, int height, int loops)
 {
@@ -326,6 +366,20 @@ draw_spiral_stroke_na (cairo_t *cr, int width, int height, int loops)
 			       width, height, loops);
 }
 
+static cairo_time_t
+draw_spiral_curve_default (cairo_t *cr, int width, int height, int loops)
+{
+    return draw_spiral_curve (cr, CAIRO_ANTIALIAS_DEFAULT,
+			      width, height, loops);
+}
+
+static cairo_time_t
+draw_spiral_curve_fast (cairo_t *cr, int width, int height, int loops)
+{
+    return draw_spiral_curve (cr, CAIRO_ANTIALIAS_FAST,
+			      width, height, loops);
+}
+
 cairo_bool_t
 spiral_enabled (cairo_perf_t *perf)
 {
@@ -349,4 +403,6 @@ spiral (cairo_perf_t *perf, cairo_t *cr, int width, int height)
     cairo_perf_run (perf, "spiral-rect-pixalign-nonzero-fill", draw_spiral_nz_pa_re, NULL);
     cairo_perf_run (perf, "spiral-nonalign-stroke", draw_spiral_stroke_na, NULL);
     cairo_perf_run (perf, "spiral-pixalign-stroke", draw_spiral_stroke_pa, NULL);
+    cairo_perf_run (perf, "spiral-curve-fill", draw_spiral_curve_default, NULL);
+    cairo_perf_run (perf, "spiral-curve-fast-fill", draw_spiral_curve_fast, NULL);
 }
@@ -0,0 +1,169 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures how text rendering scales across threads, each drawing
+ * into its own image surface but sharing the font and glyph caches.
+ * The rate is reported in kiloglyphs over all threads, so ideal
+ * scaling shows up as a rate proportional to the number of threads.
+ */
+
+#include "cairo-perf.h"
+
+#if CAIRO_HAS_REAL_PTHREAD
+#include <pthread.h>
+
+#define MAX_THREADS 32
+
+typedef struct {
+    pthread_t thread;
+    cairo_surface_t *surface;
+    int loops;
+} text_thread_t;
+
+static const char sample_text[] = "the jay, pig, fox, zebra and my wolves quack";
+
+static void
+setup_font (cairo_t *cr)
+{
+    cairo_select_font_face (cr,
+			    "@cairo:",
+			    CAIRO_FONT_SLANT_NORMAL,
+			    CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size (cr, 10);
+}
+
+static void *
+draw_text_thread (void *closure)
+{
+    text_thread_t *thread = closure;
+    int height = cairo_image_surface_get_height (thread->surface);
+    cairo_font_extents_t extents;
+    cairo_t *cr;
+    int loops;
+
+    cr = cairo_create (thread->surface);
+    setup_font (cr);
+    cairo_font_extents (cr, &extents);
+
+    for (loops = thread->loops; loops--; ) {
+	double y;
+
+	for (y = extents.ascent; y < height; y += extents.height) {
+	    cairo_move_to (cr, 0, y);
+	    cairo_show_text (cr, sample_text);
+	}
+    }
+
+    cairo_destroy (cr);
+    return NULL;
+}
+
+static cairo_time_t
+do_text_threads (cairo_t *cr, int width, int height, int loops,
+		 int num_threads)
+{
+    text_thread_t threads[MAX_THREADS];
+    int n;
+
+    for (n = 0; n < num_threads; n++) {
+	threads[n].surface =
+	    cairo_surface_create_similar_image (cairo_get_target (cr),
+						CAIRO_FORMAT_ARGB32,
+						width, height);
+	threads[n].loops = loops;
+    }
+
+    cairo_perf_timer_start ();
+
+    for (n = 1; n < num_threads; n++)
+	pthread_create (&threads[n].thread, NULL,
+			draw_text_thread, &threads[n]);
+    draw_text_thread (&threads[0]);
+    for (n = 1; n < num_threads; n++)
+	pthread_join (threads[n].thread, NULL);
+
+    cairo_perf_timer_stop ();
+
+    for (n = 0; n < num_threads; n++)
+	cairo_surface_destroy (threads[n].surface);
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static double
+count_text_threads (cairo_t *cr, int width, int height, int num_threads)
+{
+    cairo_font_extents_t font_extents;
+    int num_lines;
+
+    cairo_save (cr);
+    setup_font (cr);
+    cairo_font_extents (cr, &font_extents);
+    cairo_restore (cr);
+
+    num_lines = (height - font_extents.ascent) / font_extents.height + 1;
+    return num_threads * num_lines * (sizeof (sample_text) - 1) / 1000.;
+}
+
+#define DECL(n) \
+static cairo_time_t \
+do_text_threads##n (cairo_t *cr, int width, int height, int loops) \
+{ \
+    return do_text_threads (cr, width, height, loops, n); \
+} \
+\
+static double \
+count_text_threads##n (cairo_t *cr, int width, int height) \
+{ \
+    return count_text_threads (cr, width, height, n); \
+}
+
+DECL(1)
+DECL(2)
+DECL(4)
+DECL(8)
+DECL(16)
+DECL(32)
+#endif
+
+cairo_bool_t
+text_threads_enabled (cairo_perf_t *perf)
+{
+#if CAIRO_HAS_REAL_PTHREAD
+    return cairo_perf_can_run (perf, "text-threads", NULL);
+#else
+    return FALSE;
+#endif
+}
+
+void
+text_threads (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+#if CAIRO_HAS_REAL_PTHREAD
+    cairo_perf_run (perf, "text-threads-1", do_text_threads1, count_text_threads1);
+    cairo_perf_run (perf, "text-threads-2", do_text_threads2, count_text_threads2);
+    cairo_perf_run (perf, "text-threads-4", do_text_threads4, count_text_threads4);
+    cairo_perf_run (perf, "text-threads-8", do_text_threads8, count_text_threads8);
+    cairo_perf_run (perf, "text-threads-16", do_text_threads16, count_text_threads16);
+    cairo_perf_run (perf, "text-threads-32", do_text_threads32, count_text_threads32);
+#endif
+}
@@ -0,0 +1,113 @@
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures painting a large image scaled down to a thumbnail over and
+ * over again, with the filters that convolve the source.  Set
+ * CAIRO_MIPMAP=1 to have the image backend sample a cached mip level
+ * instead of the full resolution image.
+ */
+
+#include "cairo-perf.h"
+
+#define IMAGE_WIDTH 2048
+#define IMAGE_HEIGHT 1536
+
+static cairo_surface_t *
+create_photo (cairo_surface_t *target)
+{
+    cairo_surface_t *image;
+    cairo_pattern_t *gradient;
+    cairo_t *cr;
+    int i;
+
+    image = cairo_surface_create_similar_image (target, CAIRO_FORMAT_RGB24,
+						IMAGE_WIDTH, IMAGE_HEIGHT);
+    cr = cairo_create (image);
+
+    gradient = cairo_pattern_create_linear (0, 0, IMAGE_WIDTH, IMAGE_HEIGHT);
+    cairo_pattern_add_color_stop_rgb (gradient, 0, .2, .4, .8);
+    cairo_pattern_add_color_stop_rgb (gradient, 1, .9, .7, .3);
+    cairo_set_source (cr, gradient);
+    cairo_pattern_destroy (gradient);
+    cairo_paint (cr);
+
+    cairo_set_line_width (cr, 3);
+    for (i = 0; i < 200; i++) {
+	cairo_set_source_rgb (cr, (i % 7) / 6., (i % 5) / 4., (i % 3) / 2.);
+	cairo_arc (cr,
+		   (i * 97) % IMAGE_WIDTH, (i * 61) % IMAGE_HEIGHT,
+		   20 + i % 50, 0, 2 * M_PI);
+	cairo_stroke (cr);
+    }
+
+    cairo_destroy (cr);
+
+    return image;
+}
+
+static cairo_time_t
+do_thumbnail (cairo_t *cr, int width, int height, int loops,
+	      cairo_filter_t filter)
+{
+    cairo_surface_t *image;
+
+    image = create_photo (cairo_get_target (cr));
+
+    cairo_scale (cr, (double) width / IMAGE_WIDTH, (double) height / IMAGE_HEIGHT);
+    cairo_set_source_surface (cr, image, 0, 0);
+    cairo_pattern_set_filter (cairo_get_source (cr), filter);
+    cairo_surface_destroy (image);
+
+    cairo_perf_timer_start ();
+
+    while (loops--)
+	cairo_paint (cr);
+
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+static cairo_time_t
+do_thumbnail_good (cairo_t *cr, int width, int height, int loops)
+{
+    return do_thumbnail (cr, width, height, loops, CAIRO_FILTER_GOOD);
+}
+
+static cairo_time_t
+do_thumbnail_best (cairo_t *cr, int width, int height, int loops)
+{
+    return do_thumbnail (cr, width, height, loops, CAIRO_FILTER_BEST);
+}
+
+cairo_bool_t
+thumbnail_enabled (cairo_perf_t *perf)
+{
+    return cairo_perf_can_run (perf, "thumbnail", NULL);
+}
+
+void
+thumbnail (cairo_perf_t *perf, cairo_t *cr, int width, int height)
+{
+    cairo_perf_run (perf, "thumbnail-good", do_thumbnail_good, NULL);
+    cairo_perf_run (perf, "thumbnail-best", do_thumbnail_best, NULL);
+}
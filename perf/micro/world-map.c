@@ -51,68 +51,110 @@ typedef struct _wm_element {
 enum {
     STROKE = 1,
     FILL = 2,
+    ZOOM = 4,
 };
 
-static cairo_time_t
-do_world_map (cairo_t *cr, int width, int height, int loops, int mode)
+static void
+draw_world_map (cairo_t *cr, int mode)
 {
     const wm_element_t *e;
     double cx, cy;
 
+    cairo_set_source_rgb (cr, .68, .85, .90); /* lightblue */
+    cairo_rectangle (cr, 0, 0, 800, 400);
+    cairo_fill (cr);
+
+    e = &countries[0];
+    while (1) {
+	switch (e->type) {
+	case WM_NEW_PATH:
+	case WM_END:
+	    if (mode & FILL) {
+		cairo_set_source_rgb (cr, .75, .75, .75); /* silver */
+		cairo_fill_preserve (cr);
+	    }
+	    if (mode & STROKE) {
+		cairo_set_source_rgb (cr, .50, .50, .50); /* gray */
+		cairo_stroke (cr);
+	    }
+	    cairo_new_path (cr);
+	    cairo_move_to (cr, e->x, e->y);
+	    break;
+	case WM_MOVE_TO:
+	    cairo_close_path (cr);
+	    cairo_move_to (cr, e->x, e->y);
+	    break;
+	case WM_LINE_TO:
+	    cairo_line_to (cr, e->x, e->y);
+	    break;
+	case WM_HLINE_TO:
+	    cairo_get_current_point (cr, &cx, &cy);
+	    cairo_line_to (cr, e->x, cy);
+	    break;
+	case WM_VLINE_TO:
+	    cairo_get_current_point (cr, &cx, &cy);
+	    cairo_line_to (cr, cx, e->y);
+	    break;
+	case WM_REL_LINE_TO:
+	    cairo_rel_line_to (cr, e->x, e->y);
+	    break;
+	}
+	if (e->type == WM_END)
+	    break;
+	e++;
+    }
+
+    cairo_new_path (cr);
+}
+
+static cairo_time_t
+do_world_map (cairo_t *cr, int width, int height, int loops, int mode)
+{
     cairo_set_line_width (cr, 0.2);
 
+    /* Look closely at a small part of the map, leaving most of
+     * every country far outside of the surface. */
+    if (mode & ZOOM) {
+	cairo_scale (cr, 16, 16);
+	cairo_translate (cr, -380, -80);
+    }
+
     cairo_perf_timer_start ();
 
-    while (loops--) {
-	cairo_set_source_rgb (cr, .68, .85, .90); /* lightblue */
-	cairo_rectangle (cr, 0, 0, 800, 400);
-	cairo_fill (cr);
-
-	e = &countries[0];
-	while (1) {
-	    switch (e->type) {
-	    case WM_NEW_PATH:
-	    case WM_END:
-		if (mode & FILL) {
-		    cairo_set_source_rgb (cr, .75, .75, .75); /* silver */
-		    cairo_fill_preserve (cr);
-		}
-		if (mode & STROKE) {
-		    cairo_set_source_rgb (cr, .50, .50, .50); /* gray */
-		    cairo_stroke (cr);
-		}
-		cairo_new_path (cr);
-		cairo_move_to (cr, e->x, e->y);
-		break;
-	    case WM_MOVE_TO:
-		cairo_close_path (cr);
-		cairo_move_to (cr, e->x, e->y);
-		break;
-	    case WM_LINE_TO:
-		cairo_line_to (cr, e->x, e->y);
-		break;
-	    case WM_HLINE_TO:
-		cairo_get_current_point (cr, &cx, &cy);
-		cairo_line_to (cr, e->x, cy);
-		break;
-	    case WM_VLINE_TO:
-		cairo_get_current_point (cr, &cx, &cy);
-		cairo_line_to (cr, cx, e->y);
-		break;
-	    case WM_REL_LINE_TO:
-		cairo_rel_line_to (cr, e->x, e->y);
-		break;
-	    }
-	    if (e->type == WM_END)
-		break;
-	    e++;
-	}
+    while (loops--)
+	draw_world_map (cr, mode);
 
-	cairo_new_path (cr);
-    }
+    cairo_perf_timer_stop ();
+
+    return cairo_perf_timer_elapsed ();
+}
+
+/* Record the map once and replay it, so that the paths are read back
+ * from the (compacted) copies held by the recording surface. */
+static cairo_time_t
+do_world_map_replay (cairo_t *cr, int width, int height, int loops)
+{
+    cairo_surface_t *recording;
+    cairo_t *cr2;
+
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+						NULL);
+    cr2 = cairo_create (recording);
+    cairo_set_line_width (cr2, 0.2);
+    draw_world_map (cr2, FILL | STROKE);
+    cairo_destroy (cr2);
+
+    cairo_set_source_surface (cr, recording, 0, 0);
+
+    cairo_perf_timer_start ();
+
+    while (loops--)
+	cairo_paint (cr);
 
     cairo_perf_timer_stop ();
 
+    cairo_surface_destroy (recording);
+
     return cairo_perf_timer_elapsed ();
 }
 
@@ -134,6 +176,18 @@ do_world_map_both (cairo_t *cr, int width, int height, int loops)
     return do_world_map (cr, width, height, loops, FILL | STROKE);
 }
 
+static cairo_time_t
+do_world_map_zoom_stroke (cairo_t *cr, int width, int height, int loops)
+{
+    return do_world_map (cr, width, height, loops, ZOOM | STROKE);
+}
+
+static cairo_time_t
+do_world_map_zoom_fill (cairo_t *cr, int width, int height, int loops)
+{
+    return do_world_map (cr, width, height, loops, ZOOM | FILL);
+}
+
 cairo_bool_t
 world_map_enabled (cairo_perf_t *perf)
 {
@@ -146,4 +200,7 @@ world_map (cairo_perf_t *perf, cairo_t *cr, int width, int height)
     cairo_perf_run (perf, "world-map-stroke", do_world_map_stroke, NULL);
     cairo_perf_run (perf, "world-map-fill", do_world_map_fill, NULL);
     cairo_perf_run (perf, "world-map", do_world_map_both, NULL);
+    cairo_perf_run (perf, "world-map-zoom-stroke", do_world_map_zoom_stroke, NULL);
+    cairo_perf_run (perf, "world-map-zoom-fill", do_world_map_zoom_fill, NULL);
+    cairo_perf_run (perf, "world-map-replay", do_world_map_replay, NULL);
 }
@@ -0,0 +1,928 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* A scan converter for small polygons that needs neither sorted edge
+ * lists nor an active edge list.
+ *
+ * Every edge is walked once, pixel row by pixel row, and deposits its
+ * signed area into an accumulation buffer: a segment within a pixel
+ * adds the area to its right to that pixel and the remainder of its
+ * height to the following pixel.  The coverage of a pixel is then the
+ * prefix sum of its row up to and including it, folded by the fill
+ * rule.  The areas are exact to the 24.8 input precision.
+ *
+ * Accumulating the winding integral rather than sampling the winding
+ * number means that where edges of the same sign overlap within a
+ * pixel the coverage is approximate; this converter trades that for
+ * speed and is only used when speed has been asked for.
+ *
+ * As the edges are independent of each other, a path may be fed to the
+ * converter without first being flattened into a polygon.  Each curve
+ * is split into pieces monotonic in y, and every piece is stepped row
+ * by row, only being approximated by chords within a row.  Large
+ * extents are processed in bands of rows so that the accumulation
+ * buffer stays small; a path spanning several bands is first sorted
+ * into buckets by the band in which each segment starts, so that each
+ * band only visits the segments that reach into it.
+ */
+
+#include "cairoint.h"
+#include "cairo-array-private.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-spans-private.h"
+#include "cairo-error-private.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#define AREA_ONE	(2 * CAIRO_FIXED_ONE * CAIRO_FIXED_ONE)
+
+/* The maximum number of accumulators in a band. */
+#define AREA_BAND_CELLS	(32*1024)
+
+/* A line (two points) or curve (four) of a path, linked into the
+ * bucket of the band in which it starts, then into the list of those
+ * reaching the current band. */
+typedef struct _area_segment {
+    cairo_point_t p[4];
+    int num_points;
+    int last_band;
+    int next;
+} area_segment_t;
+
+typedef struct _cairo_area_scan_converter {
+    cairo_scan_converter_t base;
+
+    int xmin, ymin, xmax, ymax;
+    int width, height;
+    unsigned int winding_mask;
+
+    /* The input, replayed for every band. */
+    const cairo_polygon_t *polygon;
+    const cairo_path_fixed_t *path;
+    double tolerance;
+
+    /* Or, for a path covering several bands, its segments. */
+    cairo_array_t segments;
+    int *buckets;
+    int active;
+
+    /* The rows currently being accumulated. */
+    int band_ymin, band_ymax, band_height;
+    cairo_fixed_t band_top, band_bottom;
+
+    /* (width + 1) accumulators per row, the last catching anything
+     * right of the clip, and the range of columns touched per row. */
+    int32_t *cells;
+    int *row_min, *row_max;
+
+    cairo_half_open_span_t *spans;
+
+    int32_t cells_embedded[1024];
+    int rows_embedded[2*64];
+    cairo_half_open_span_t spans_embedded[64];
+} cairo_area_scan_converter_t;
+
+static inline void
+cell_add (cairo_area_scan_converter_t *self,
+	  int32_t *row, int y, int x, int32_t v)
+{
+    x -= self->xmin;
+    if (x < 0)
+	x = 0;
+    else if (x > self->width)
+	return;
+
+    row[x] += v;
+    if (x < self->row_min[y])
+	self->row_min[y] = x;
+    if (x > self->row_max[y])
+	self->row_max[y] = x;
+}
+
+/* Accumulates the segment (x0, y0)-(x1, y1) lying within the pixel row
+ * y, with y0 and y1 given relative to the top of the row. */
+static void
+add_segment (cairo_area_scan_converter_t *self,
+	     int y,
+	     cairo_fixed_t x0, cairo_fixed_t y0,
+	     cairo_fixed_t x1, cairo_fixed_t y1,
+	     int dir)
+{
+    int32_t *row = self->cells + y * (self->width + 1);
+    cairo_fixed_t xs, ys;
+    int64_t dx, dy;
+    int ix, ix1;
+
+    if (x0 > x1) {
+	cairo_fixed_t t;
+
+	t = x0; x0 = x1; x1 = t;
+	t = y0; y0 = y1; y1 = t;
+    }
+
+    ix = _cairo_fixed_integer_floor (x0);
+    ix1 = _cairo_fixed_integer_floor (x1);
+
+    /* Wholly left of the clip, the segment covers every pixel. */
+    if (ix1 < self->xmin) {
+	int32_t h = y1 > y0 ? y1 - y0 : y0 - y1;
+	cell_add (self, row, y, ix1, dir * h * 2 * CAIRO_FIXED_ONE);
+	return;
+    }
+
+    dx = (int64_t) x1 - x0;
+    dy = (int64_t) y1 - y0;
+    xs = x0;
+    ys = y0;
+
+    if (ix < self->xmin) {
+	cairo_fixed_t xe = _cairo_fixed_from_int (self->xmin);
+	cairo_fixed_t ye = y0 + ((int64_t) xe - x0) * dy / dx;
+	int32_t h = ye > ys ? ye - ys : ys - ye;
+
+	cell_add (self, row, y, ix, dir * h * 2 * CAIRO_FIXED_ONE);
+	xs = xe;
+	ys = ye;
+	ix = self->xmin;
+    }
+
+    /* Split the segment where it crosses each pixel boundary. */
+    do {
+	cairo_fixed_t xe, ye, fx;
+	int32_t h, a;
+
+	if (ix == ix1) {
+	    xe = x1;
+	    ye = y1;
+	} else {
+	    xe = _cairo_fixed_from_int (ix + 1);
+	    ye = y0 + ((int64_t) xe - x0) * dy / dx;
+	}
+
+	h = ye > ys ? ye - ys : ys - ye;
+	fx = _cairo_fixed_from_int (ix);
+	a = h * (xs - fx + xe - fx);
+
+	cell_add (self, row, y, ix, dir * (h * 2 * CAIRO_FIXED_ONE - a));
+	cell_add (self, row, y, ix + 1, dir * a);
+
+	xs = xe;
+	ys = ye;
+    } while (ix++ < ix1 && ix < self->xmax);
+}
+
+static void
+add_edge (cairo_area_scan_converter_t *self,
+	  const cairo_edge_t *edge)
+{
+    cairo_fixed_t top, bottom, y, x;
+    int iy;
+
+    top = MAX (edge->top, self->band_top);
+    bottom = MIN (edge->bottom, self->band_bottom);
+    if (top >= bottom)
+	return;
+
+    x = _cairo_edge_compute_intersection_x_for_y (&edge->line.p1,
+						  &edge->line.p2,
+						  top);
+    y = top;
+    iy = _cairo_fixed_integer_floor (top);
+    do {
+	cairo_fixed_t fy = _cairo_fixed_from_int (iy);
+	cairo_fixed_t ye, xe;
+
+	ye = MIN (bottom, fy + CAIRO_FIXED_ONE);
+	xe = _cairo_edge_compute_intersection_x_for_y (&edge->line.p1,
+						       &edge->line.p2,
+						       ye);
+
+	add_segment (self, iy - self->band_ymin,
+		     x, y - fy, xe, ye - fy,
+		     edge->dir);
+
+	x = xe;
+	y = ye;
+	iy++;
+    } while (y < bottom);
+}
+
+static void
+add_line (cairo_area_scan_converter_t *self,
+	  const cairo_point_t *p1,
+	  const cairo_point_t *p2)
+{
+    cairo_edge_t edge;
+
+    if (p1->y == p2->y)
+	return;
+
+    if (p1->y < p2->y) {
+	edge.line.p1 = *p1;
+	edge.line.p2 = *p2;
+	edge.dir = 1;
+    } else {
+	edge.line.p1 = *p2;
+	edge.line.p2 = *p1;
+	edge.dir = -1;
+    }
+    edge.top = edge.line.p1.y;
+    edge.bottom = edge.line.p2.y;
+
+    add_edge (self, &edge);
+}
+
+/* A cubic Bézier in power form, in fixed-point units. */
+typedef struct _area_curve {
+    cairo_point_double_t a, b, c, d;
+    double t_per_segment;
+    int dir;
+} area_curve_t;
+
+static inline void
+curve_eval (const area_curve_t *curve, double t, cairo_point_double_t *p)
+{
+    p->x = ((curve->a.x * t + curve->b.x) * t + curve->c.x) * t + curve->d.x;
+    p->y = ((curve->a.y * t + curve->b.y) * t + curve->c.y) * t + curve->d.y;
+}
+
+/* Finds where a piece of the curve monotonic in y over [t0, t1]
+ * crosses y, given that it does. */
+static double
+curve_solve_y (const area_curve_t *curve, double t0, double t1, double y)
+{
+    double y0 = ((curve->a.y * t0 + curve->b.y) * t0 + curve->c.y) * t0 + curve->d.y;
+    double t = t0;
+    int i;
+
+    if (curve->dir < 0)
+	y = -y, y0 = -y0;
+
+    /* Bisection, refined by Newton steps whenever those stay within
+     * the bracket. */
+    for (i = 0; i < 32; i++) {
+	double yt, dy;
+
+	yt = ((curve->a.y * t + curve->b.y) * t + curve->c.y) * t + curve->d.y;
+	if (curve->dir < 0)
+	    yt = -yt;
+	if (fabs (yt - y) < 1. / 64)
+	    break;
+
+	if (yt < y)
+	    t0 = t;
+	else
+	    t1 = t;
+
+	dy = (3 * curve->a.y * t + 2 * curve->b.y) * t + curve->c.y;
+	if (curve->dir < 0)
+	    dy = -dy;
+	if (dy > 0)
+	    t -= (yt - y) / dy;
+	if (! (dy > 0) || t <= t0 || t >= t1)
+	    t = (t0 + t1) / 2;
+    }
+
+    return t;
+}
+
+static inline cairo_fixed_t
+clamp_fixed (double v, cairo_fixed_t lo, cairo_fixed_t hi)
+{
+    cairo_fixed_t f = _cairo_lround (v);
+    return f < lo ? lo : f > hi ? hi : f;
+}
+
+/* Adds the part of the curve over [t0, t1] that lies within the pixel
+ * row iy, as a run of chords flat to within the tolerance. */
+static void
+add_curve_row (cairo_area_scan_converter_t *self,
+	       const area_curve_t *curve,
+	       int iy,
+	       double t0, const cairo_point_t *p0,
+	       double t1, const cairo_point_t *p1)
+{
+    cairo_fixed_t fy = _cairo_fixed_from_int (iy);
+    cairo_point_t p = *p0;
+    int n, i;
+
+    n = ceil ((t1 - t0) / curve->t_per_segment);
+    for (i = 1; i < n; i++) {
+	cairo_point_double_t q;
+	cairo_point_t next;
+
+	curve_eval (curve, t0 + (t1 - t0) * i / n, &q);
+	next.x = _cairo_lround (q.x);
+	next.y = clamp_fixed (q.y, fy, fy + CAIRO_FIXED_ONE);
+	if (curve->dir > 0 ? next.y < p.y : next.y > p.y)
+	    next.y = p.y;
+
+	add_segment (self, iy - self->band_ymin,
+		     p.x, p.y - fy, next.x, next.y - fy,
+		     curve->dir);
+	p = next;
+    }
+
+    add_segment (self, iy - self->band_ymin,
+		 p.x, p.y - fy, p1->x, p1->y - fy,
+		 curve->dir);
+}
+
+/* Steps the piece of the curve over [t0, t1], monotonic in y, through
+ * every row of the band that it crosses. */
+static void
+add_curve_piece (cairo_area_scan_converter_t *self,
+		 area_curve_t *curve,
+		 double t0, double t1)
+{
+    cairo_point_double_t q0, q1;
+    cairo_point_t p, next;
+    cairo_fixed_t y0, y1, top, bottom, y;
+    int iy;
+
+    curve_eval (curve, t0, &q0);
+    curve_eval (curve, t1, &q1);
+    y0 = _cairo_lround (q0.y);
+    y1 = _cairo_lround (q1.y);
+    if (y0 == y1)
+	return;
+
+    curve->dir = y0 < y1 ? 1 : -1;
+    top = MAX (MIN (y0, y1), self->band_top);
+    bottom = MIN (MAX (y0, y1), self->band_bottom);
+    if (top >= bottom)
+	return;
+
+    /* Walk the rows in the direction of the curve. */
+    if (curve->dir > 0) {
+	y = top;
+	if (y != y0)
+	    t0 = curve_solve_y (curve, t0, t1, y);
+	iy = _cairo_fixed_integer_floor (y);
+    } else {
+	y = bottom;
+	if (y != y0)
+	    t0 = curve_solve_y (curve, t0, t1, y);
+	iy = _cairo_fixed_integer_ceil (y) - 1;
+    }
+    curve_eval (curve, t0, &q0);
+    p.x = _cairo_lround (q0.x);
+    p.y = y;
+
+    do {
+	cairo_fixed_t fy = _cairo_fixed_from_int (iy);
+	double t;
+
+	if (curve->dir > 0)
+	    y = MIN (bottom, fy + CAIRO_FIXED_ONE);
+	else
+	    y = MAX (top, fy);
+
+	if (y == y1) {
+	    t = t1;
+	    next.x = _cairo_lround (q1.x);
+	} else {
+	    t = curve_solve_y (curve, t0, t1, y);
+	    curve_eval (curve, t, &q0);
+	    next.x = _cairo_lround (q0.x);
+	}
+	next.y = y;
+
+	add_curve_row (self, curve, iy, t0, &p, t, &next);
+
+	p = next;
+	t0 = t;
+	iy += curve->dir;
+    } while (curve->dir > 0 ? y < bottom : y > top);
+}
+
+static void
+add_curve (cairo_area_scan_converter_t *self,
+	   const cairo_point_t *p0,
+	   const cairo_point_t *p1,
+	   const cairo_point_t *p2,
+	   const cairo_point_t *p3)
+{
+    area_curve_t curve;
+    double ddx, ddy, dd, n;
+    double t[4], r[2], a, b, c, disc;
+    int num_t, num_r = 0, i;
+
+    /* Neither a curve above or below the band nor one wholly right of
+     * it contributes; one wholly left of it only adds its height. */
+    if (MAX (MAX (p0->y, p1->y), MAX (p2->y, p3->y)) <= self->band_top ||
+	MIN (MIN (p0->y, p1->y), MIN (p2->y, p3->y)) >= self->band_bottom ||
+	MIN (MIN (p0->x, p1->x), MIN (p2->x, p3->x)) >= _cairo_fixed_from_int (self->xmax))
+    {
+	return;
+    }
+    if (MAX (MAX (p0->x, p1->x), MAX (p2->x, p3->x)) < _cairo_fixed_from_int (self->xmin)) {
+	add_line (self, p0, p3);
+	return;
+    }
+
+    curve.a.x = -p0->x + 3. * p1->x - 3. * p2->x + p3->x;
+    curve.a.y = -p0->y + 3. * p1->y - 3. * p2->y + p3->y;
+    curve.b.x = 3. * p0->x - 6. * p1->x + 3. * p2->x;
+    curve.b.y = 3. * p0->y - 6. * p1->y + 3. * p2->y;
+    curve.c.x = -3. * p0->x + 3. * p1->x;
+    curve.c.y = -3. * p0->y + 3. * p1->y;
+    curve.d.x = p0->x;
+    curve.d.y = p0->y;
+
+    /* Wang's formula for the number of uniform steps in t that keep
+     * the chords within tolerance of the curve. */
+    ddx = MAX (fabs ((double) p0->x - 2. * p1->x + p2->x),
+	       fabs ((double) p1->x - 2. * p2->x + p3->x));
+    ddy = MAX (fabs ((double) p0->y - 2. * p1->y + p2->y),
+	       fabs ((double) p1->y - 2. * p2->y + p3->y));
+    dd = sqrt (ddx * ddx + ddy * ddy);
+    n = ceil (sqrt (.75 * dd / (self->tolerance * CAIRO_FIXED_ONE)));
+    curve.t_per_segment = 1. / MAX (n, 1.);
+
+    /* Split at the extrema in y, where y'(t) = 3at² + 2bt + c = 0. */
+    num_t = 0;
+    t[num_t++] = 0;
+    a = 3 * curve.a.y;
+    b = 2 * curve.b.y;
+    c = curve.c.y;
+    if (a == 0) {
+	if (b != 0)
+	    r[num_r++] = -c / b;
+    } else {
+	disc = b * b - 4 * a * c;
+	if (disc > 0) {
+	    disc = sqrt (disc);
+	    r[num_r++] = (-b - disc) / (2 * a);
+	    r[num_r++] = (-b + disc) / (2 * a);
+	    if (r[0] > r[1]) {
+		double tmp = r[0]; r[0] = r[1]; r[1] = tmp;
+	    }
+	}
+    }
+    for (i = 0; i < num_r; i++) {
+	if (r[i] > 0 && r[i] < 1)
+	    t[num_t++] = r[i];
+    }
+    t[num_t++] = 1;
+
+    for (i = 0; i + 1 < num_t; i++)
+	add_curve_piece (self, &curve, t[i], t[i+1]);
+}
+
+/* Every subpath of a fill is implicitly closed. */
+typedef struct _area_filler {
+    cairo_area_scan_converter_t *converter;
+    cairo_point_t current_point;
+    cairo_point_t last_move_to;
+    cairo_bool_t collect;
+} area_filler_t;
+
+static int
+band_of (cairo_area_scan_converter_t *self, cairo_fixed_t y)
+{
+    int band = (_cairo_fixed_integer_floor (y) - self->ymin) / self->band_height;
+
+    return band < 0 ? 0 : band;
+}
+
+/* Files the segment into the bucket of the first band it reaches,
+ * dropping those that lie wholly above or below the extents or are
+ * horizontal. */
+static cairo_status_t
+collect_segment (cairo_area_scan_converter_t *self,
+		 const cairo_point_t *points,
+		 int num_points)
+{
+    area_segment_t segment;
+    cairo_fixed_t top, bottom;
+    int first, i;
+    cairo_status_t status;
+
+    top = bottom = points[0].y;
+    for (i = 1; i < num_points; i++) {
+	if (points[i].y < top)
+	    top = points[i].y;
+	if (points[i].y > bottom)
+	    bottom = points[i].y;
+    }
+    if (top == bottom ||
+	bottom <= _cairo_fixed_from_int (self->ymin) ||
+	top >= _cairo_fixed_from_int (self->ymax))
+    {
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    memcpy (segment.p, points, num_points * sizeof (cairo_point_t));
+    segment.num_points = num_points;
+    first = band_of (self, top);
+    segment.last_band = band_of (self, bottom);
+    segment.next = self->buckets[first];
+
+    status = _cairo_array_append (&self->segments, &segment);
+    if (unlikely (status))
+	return status;
+
+    self->buckets[first] = _cairo_array_num_elements (&self->segments) - 1;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_area_filler_line_to (void *closure, const cairo_point_t *point)
+{
+    area_filler_t *filler = closure;
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+
+    if (filler->collect) {
+	cairo_point_t points[2];
+
+	points[0] = filler->current_point;
+	points[1] = *point;
+	status = collect_segment (filler->converter, points, 2);
+    } else {
+	add_line (filler->converter, &filler->current_point, point);
+    }
+    filler->current_point = *point;
+
+    return status;
+}
+
+static cairo_status_t
+_area_filler_close (void *closure)
+{
+    area_filler_t *filler = closure;
+
+    return _area_filler_line_to (closure, &filler->last_move_to);
+}
+
+static cairo_status_t
+_area_filler_move_to (void *closure, const cairo_point_t *point)
+{
+    area_filler_t *filler = closure;
+    cairo_status_t status;
+
+    status = _area_filler_close (closure);
+    filler->current_point = *point;
+    filler->last_move_to = *point;
+
+    return status;
+}
+
+static cairo_status_t
+_area_filler_curve_to (void *closure,
+		       const cairo_point_t *p1,
+		       const cairo_point_t *p2,
+		       const cairo_point_t *p3)
+{
+    area_filler_t *filler = closure;
+    cairo_status_t status = CAIRO_STATUS_SUCCESS;
+
+    if (filler->collect) {
+	cairo_point_t points[4];
+
+	points[0] = filler->current_point;
+	points[1] = *p1;
+	points[2] = *p2;
+	points[3] = *p3;
+	status = collect_segment (filler->converter, points, 4);
+    } else {
+	add_curve (filler->converter, &filler->current_point, p1, p2, p3);
+    }
+    filler->current_point = *p3;
+
+    return status;
+}
+
+static cairo_status_t
+add_path (cairo_area_scan_converter_t *self,
+	  const cairo_path_fixed_t *path,
+	  cairo_bool_t collect)
+{
+    area_filler_t filler;
+    cairo_status_t status;
+
+    filler.converter = self;
+    filler.collect = collect;
+    filler.current_point.x = filler.current_point.y = 0;
+    filler.last_move_to = filler.current_point;
+
+    status = _cairo_path_fixed_interpret (path,
+					  _area_filler_move_to,
+					  _area_filler_line_to,
+					  _area_filler_curve_to,
+					  _area_filler_close,
+					  &filler);
+    if (unlikely (status))
+	return status;
+
+    return _area_filler_close (&filler);
+}
+
+cairo_status_t
+_cairo_area_scan_converter_add_polygon (void			*converter,
+					const cairo_polygon_t	*polygon)
+{
+    cairo_area_scan_converter_t *self = converter;
+
+    if (unlikely (self->base.status))
+	return self->base.status;
+
+    self->polygon = polygon;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+cairo_status_t
+_cairo_area_scan_converter_add_path (void			*converter,
+				     const cairo_path_fixed_t	*path,
+				     double			 tolerance)
+{
+    cairo_area_scan_converter_t *self = converter;
+
+    if (unlikely (self->base.status))
+	return self->base.status;
+
+    self->path = path;
+    self->tolerance = tolerance;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static inline uint8_t
+area_to_alpha (int32_t area, unsigned int winding_mask)
+{
+    if (area < 0)
+	area = -area;
+
+    if (winding_mask == 1) {
+	area &= 2*AREA_ONE - 1;
+	if (area > AREA_ONE)
+	    area = 2*AREA_ONE - area;
+    } else if (area > AREA_ONE)
+	area = AREA_ONE;
+
+    return (area * 255 + AREA_ONE/2) / AREA_ONE;
+}
+
+static cairo_status_t
+accumulate_band (cairo_area_scan_converter_t *self, int ymin, int ymax)
+{
+    int y;
+
+    self->band_ymin = ymin;
+    self->band_ymax = ymax;
+    self->band_top = _cairo_fixed_from_int (ymin);
+    self->band_bottom = _cairo_fixed_from_int (ymax);
+
+    memset (self->cells, 0,
+	    (self->width + 1) * (ymax - ymin) * sizeof (int32_t));
+    for (y = 0; y < ymax - ymin; y++) {
+	self->row_min[y] = INT_MAX;
+	self->row_max[y] = -1;
+    }
+
+    if (self->polygon) {
+	const cairo_polygon_t *polygon = self->polygon;
+	int i;
+
+	for (i = 0; i < polygon->num_edges; i++)
+	    add_edge (self, &polygon->edges[i]);
+    }
+
+    if (self->buckets) {
+	area_segment_t *segments = _cairo_array_index (&self->segments, 0);
+	int band = (ymin - self->ymin) / self->band_height;
+	int *prev, i, next;
+
+	/* Move the segments starting in this band onto the active list */
+	for (i = self->buckets[band]; i >= 0; i = next) {
+	    next = segments[i].next;
+	    segments[i].next = self->active;
+	    self->active = i;
+	}
+
+	for (prev = &self->active; *prev >= 0; ) {
+	    area_segment_t *segment = &segments[*prev];
+
+	    if (segment->last_band < band) {
+		*prev = segment->next;
+		continue;
+	    }
+
+	    if (segment->num_points == 2)
+		add_line (self, &segment->p[0], &segment->p[1]);
+	    else
+		add_curve (self, &segment->p[0], &segment->p[1],
+			   &segment->p[2], &segment->p[3]);
+	    prev = &segment->next;
+	}
+    } else if (self->path) {
+	return add_path (self, self->path, FALSE);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+render_band (cairo_area_scan_converter_t *self,
+	     cairo_span_renderer_t *renderer)
+{
+    cairo_half_open_span_t *spans = self->spans;
+    int y;
+
+    for (y = 0; y < self->band_ymax - self->band_ymin; y++) {
+	const int32_t *row = self->cells + y * (self->width + 1);
+	int x, x_end, num_spans;
+	uint8_t last, alpha;
+	int32_t cover;
+	cairo_status_t status;
+
+	if (self->row_min[y] > self->row_max[y])
+	    continue;
+
+	/* Coverage is zero left of the first cell touched and constant
+	 * right of the last. */
+	x = self->row_min[y];
+	x_end = MIN (self->row_max[y], self->width - 1);
+	cover = 0;
+	last = 0;
+	num_spans = 0;
+	for (; x <= x_end; x++) {
+	    cover += row[x];
+	    alpha = area_to_alpha (cover, self->winding_mask);
+	    if (alpha != last) {
+		spans[num_spans].x = self->xmin + x;
+		spans[num_spans].coverage = alpha;
+		last = alpha;
+		num_spans++;
+	    }
+	}
+	if (last) {
+	    spans[num_spans].x = self->xmax;
+	    spans[num_spans].coverage = 0;
+	    num_spans++;
+	}
+
+	if (num_spans) {
+	    status = renderer->render_rows (renderer, self->band_ymin + y, 1,
+					    spans, num_spans);
+	    if (unlikely (status))
+		return status;
+	}
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_area_scan_converter_generate (void			*converter,
+				     cairo_span_renderer_t	*renderer)
+{
+    cairo_area_scan_converter_t *self = converter;
+    cairo_status_t status;
+    int num_bands, y;
+
+    /* Rather than walking all of a path again for every band, sort its
+     * segments by band once up front. */
+    num_bands = (self->height + self->band_height - 1) / self->band_height;
+    if (self->path && num_bands > 1) {
+	self->buckets = _cairo_malloc_ab (num_bands, sizeof (int));
+	if (unlikely (self->buckets == NULL))
+	    return _cairo_scan_converter_set_error (self, _cairo_error (CAIRO_STATUS_NO_MEMORY));
+
+	for (y = 0; y < num_bands; y++)
+	    self->buckets[y] = -1;
+	self->active = -1;
+
+	status = add_path (self, self->path, TRUE);
+	if (unlikely (status))
+	    return _cairo_scan_converter_set_error (self, status);
+    }
+
+    for (y = self->ymin; y < self->ymax; y += self->band_height) {
+	status = accumulate_band (self, y, MIN (y + self->band_height, self->ymax));
+	if (unlikely (status))
+	    return _cairo_scan_converter_set_error (self, status);
+
+	status = render_band (self, renderer);
+	if (unlikely (status))
+	    return _cairo_scan_converter_set_error (self, status);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_area_scan_converter_destroy (void *converter)
+{
+    cairo_area_scan_converter_t *self = converter;
+
+    if (self->cells != self->cells_embedded)
+	free (self->cells);
+    if (self->row_min != self->rows_embedded)
+	free (self->row_min);
+    if (self->spans != self->spans_embedded)
+	free (self->spans);
+    free (self->buckets);
+    _cairo_array_fini (&self->segments);
+    free (self);
+}
+
+cairo_scan_converter_t *
+_cairo_area_scan_converter_create (int			xmin,
+				   int			ymin,
+				   int			xmax,
+				   int			ymax,
+				   cairo_fill_rule_t	fill_rule)
+{
+    cairo_area_scan_converter_t *self;
+    cairo_status_t status;
+
+    self = _cairo_malloc (sizeof (cairo_area_scan_converter_t));
+    if (unlikely (self == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto bail_nomem;
+    }
+
+    self->base.destroy = _cairo_area_scan_converter_destroy;
+    self->base.generate = _cairo_area_scan_converter_generate;
+    self->base.status = CAIRO_STATUS_SUCCESS;
+
+    self->xmin = xmin;
+    self->ymin = ymin;
+    self->xmax = xmax;
+    self->ymax = ymax;
+    self->width = MAX (xmax - xmin, 0);
+    self->height = MAX (ymax - ymin, 0);
+    self->winding_mask = fill_rule == CAIRO_FILL_RULE_WINDING ? ~0 : 1;
+
+    self->polygon = NULL;
+    self->path = NULL;
+    self->tolerance = CAIRO_GSTATE_TOLERANCE_DEFAULT;
+
+    _cairo_array_init (&self->segments, sizeof (area_segment_t));
+    self->buckets = NULL;
+
+    self->band_height = MAX (AREA_BAND_CELLS / (self->width + 1), 1);
+    self->band_height = MIN (self->band_height, self->height);
+
+    self->cells = self->cells_embedded;
+    self->row_min = self->rows_embedded;
+    self->spans = self->spans_embedded;
+
+    if ((self->width + 1) * self->band_height > ARRAY_LENGTH (self->cells_embedded)) {
+	self->cells = _cairo_malloc_abc (self->band_height, self->width + 1,
+					 sizeof (int32_t));
+	if (unlikely (self->cells == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+
+    if (2 * self->band_height > ARRAY_LENGTH (self->rows_embedded)) {
+	self->row_min = _cairo_malloc_ab (2 * self->band_height, sizeof (int));
+	if (unlikely (self->row_min == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+    self->row_max = self->row_min + self->band_height;
+
+    if (self->width + 1 > ARRAY_LENGTH (self->spans_embedded)) {
+	self->spans = _cairo_malloc_ab (self->width + 1,
+					sizeof (cairo_half_open_span_t));
+	if (unlikely (self->spans == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+
+    return &self->base;
+
+ bail:
+    self->base.destroy (&self->base);
+ bail_nomem:
+    return _cairo_scan_converter_create_in_error (status);
+}
@@ -175,6 +175,18 @@ struct _cairo_backend {
 
     cairo_status_t (*tag_begin) (void *cr, const char *tag_name, const char *attributes);
     cairo_status_t (*tag_end) (void *cr, const char *tag_name);
+
+    /* Optional: without these, prepared paths are filled by appending
+     * their user space path to the context. */
+    cairo_status_t (*prepare_fill) (void *cr, cairo_prepared_path_t *prepared);
+    cairo_status_t (*fill_prepared) (void *cr, const cairo_prepared_path_t *prepared);
+
+    /* Optional: without it, each instance is filled in turn. */
+    cairo_status_t (*fill_instances) (void *cr,
+				      const cairo_path_t *path,
+				      const cairo_matrix_t *transforms,
+				      const double *colors,
+				      int num_instances);
 };
 
 static inline void
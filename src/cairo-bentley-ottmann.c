@@ -42,12 +42,25 @@
 #include "cairo-error-private.h"
 #include "cairo-freelist-private.h"
 #include "cairo-line-inline.h"
+#include "cairo-parallel-private.h"
 #include "cairo-traps-private.h"
 
 #define DEBUG_PRINT_STATE 0
 #define DEBUG_EVENTS 0
 #define DEBUG_TRAPS 0
 
+/* With this many edges, radix sort both the start and the stop events
+ * up front instead of comb sorting the starts and feeding every stop
+ * through the priority queue, which is then left holding only the
+ * (comparatively rare) intersections. */
+#define BO_RADIX_MIN_EDGES 1024
+
+/* Splitting the sweep into y-bands that are tessellated concurrently
+ * only pays off for large polygons, and each band must have enough
+ * edges of its own to amortise the extra trapezoids along the cuts. */
+#define BO_BAND_MIN_EDGES_PER_BAND 4096
+#define BO_BAND_HISTOGRAM_SIZE 256
+
 typedef cairo_point_t cairo_bo_point32_t;
 
 typedef struct _cairo_bo_intersect_ordinate {
@@ -119,6 +132,10 @@ typedef struct _cairo_bo_event_queue {
     cairo_freepool_t pool;
     pqueue_t pqueue;
     cairo_bo_event_t **start_events;
+
+    /* presorted stop events, or NULL if they are queued as we go */
+    cairo_bo_queue_event_t *stop_events;
+    cairo_bo_queue_event_t *stop_events_end;
 } cairo_bo_event_queue_t;
 
 typedef struct _cairo_bo_sweep_line {
@@ -808,6 +825,17 @@ _cairo_bo_event_dequeue (cairo_bo_event_queue_t *event_queue)
 
     event = event_queue->pqueue.elements[PQ_FIRST_ENTRY];
     cmp = *event_queue->start_events;
+    if (event_queue->stop_events != event_queue->stop_events_end) {
+	cairo_bo_event_t *stop = (cairo_bo_event_t *) event_queue->stop_events;
+
+	if ((event == NULL || cairo_bo_event_compare (stop, event) < 0) &&
+	    (cmp == NULL || cairo_bo_event_compare (stop, cmp) < 0))
+	{
+	    event_queue->stop_events++;
+	    return stop;
+	}
+    }
+
     if (event == NULL ||
 	(cmp != NULL && cairo_bo_event_compare (cmp, event) < 0))
     {
@@ -829,9 +857,14 @@ CAIRO_COMBSORT_DECLARE (_cairo_bo_event_queue_sort,
 static void
 _cairo_bo_event_queue_init (cairo_bo_event_queue_t	 *event_queue,
 			    cairo_bo_event_t		**start_events,
-			    int				  num_events)
+			    int				  num_events,
+			    cairo_bo_queue_event_t	 *stop_events)
 {
     event_queue->start_events = start_events;
+    event_queue->stop_events = stop_events;
+    event_queue->stop_events_end = stop_events;
+    if (stop_events != NULL)
+	event_queue->stop_events_end += num_events;
 
     _cairo_freepool_init (&event_queue->pool,
 			  sizeof (cairo_bo_queue_event_t));
@@ -1272,6 +1305,7 @@ _active_edges_to_traps (cairo_bo_edge_t	*pos,
 static cairo_status_t
 _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 					    int			 num_events,
+					    cairo_bo_queue_event_t *stop_events,
 					    unsigned		 fill_rule,
 					    cairo_traps_t	*traps,
 					    int			*num_intersections)
@@ -1310,7 +1344,9 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
     }
 #endif
 
-    _cairo_bo_event_queue_init (&event_queue, start_events, num_events);
+    _cairo_bo_event_queue_init (&event_queue,
+				start_events, num_events,
+				stop_events);
     _cairo_bo_sweep_line_init (&sweep_line);
 
     while ((event = _cairo_bo_event_dequeue (&event_queue))) {
@@ -1346,9 +1382,11 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 
 	    _cairo_bo_sweep_line_insert (&sweep_line, e1);
 
-	    status = _cairo_bo_event_queue_insert_stop (&event_queue, e1);
-	    if (unlikely (status))
-		goto unwind;
+	    if (stop_events == NULL) {
+		status = _cairo_bo_event_queue_insert_stop (&event_queue, e1);
+		if (unlikely (status))
+		    goto unwind;
+	    }
 
 	    /* check to see if this is a continuation of a stopped edge */
 	    /* XXX change to an infinitesimal lengthening rule */
@@ -1386,7 +1424,8 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
 
 	case CAIRO_BO_EVENT_TYPE_STOP:
 	    e1 = ((cairo_bo_queue_event_t *) event)->e1;
-	    _cairo_bo_event_queue_delete (&event_queue, event);
+	    if (stop_events == NULL)
+		_cairo_bo_event_queue_delete (&event_queue, event);
 
 	    left = e1->prev;
 	    right = e1->next;
@@ -1461,10 +1500,181 @@ _cairo_bentley_ottmann_tessellate_bo_edges (cairo_bo_event_t   **start_events,
     return status;
 }
 
-cairo_status_t
-_cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
-					   const cairo_polygon_t *polygon,
-					   cairo_fill_rule_t	  fill_rule)
+typedef struct _cairo_bo_sort_key {
+    uint64_t key;
+    int index;
+} cairo_bo_sort_key_t;
+
+/* Maps a point onto an unsigned key whose ordering matches
+ * _cairo_bo_point32_compare(), i.e. y then x. */
+static inline uint64_t
+_cairo_bo_point_to_sort_key (const cairo_point_t *point)
+{
+    return ((uint64_t) ((uint32_t) point->y ^ 0x80000000) << 32) |
+	   ((uint32_t) point->x ^ 0x80000000);
+}
+
+static inline void
+_cairo_bo_sort_key_to_point (uint64_t key, cairo_point_t *point)
+{
+    point->y = (int32_t) ((uint32_t) (key >> 32) ^ 0x80000000);
+    point->x = (int32_t) ((uint32_t) key ^ 0x80000000);
+}
+
+/* A stable least-significant-digit radix sort, a byte at a time.
+ * Passes over a byte that is shared by every key are skipped, which
+ * for real geometry removes most of the high bytes of both ordinates.
+ * Returns whichever of keys or tmp ends up holding the sorted array.
+ */
+static cairo_bo_sort_key_t *
+_cairo_bo_radix_sort (cairo_bo_sort_key_t *keys,
+		      cairo_bo_sort_key_t *tmp,
+		      int		   num_keys)
+{
+    unsigned count[8][256];
+    int pass, i;
+
+    memset (count, 0, sizeof (count));
+    for (i = 0; i < num_keys; i++) {
+	uint64_t key = keys[i].key;
+
+	for (pass = 0; pass < 8; pass++)
+	    count[pass][(key >> (8 * pass)) & 0xff]++;
+    }
+
+    for (pass = 0; pass < 8; pass++) {
+	unsigned *offset = count[pass];
+	int shift = 8 * pass;
+	unsigned sum;
+
+	if (offset[(keys[0].key >> shift) & 0xff] == (unsigned) num_keys)
+	    continue;
+
+	for (sum = i = 0; i < 256; i++) {
+	    unsigned n = offset[i];
+	    offset[i] = sum;
+	    sum += n;
+	}
+
+	for (i = 0; i < num_keys; i++)
+	    tmp[offset[(keys[i].key >> shift) & 0xff]++] = keys[i];
+
+	{
+	    cairo_bo_sort_key_t *t = keys;
+	    keys = tmp;
+	    tmp = t;
+	}
+    }
+
+    return keys;
+}
+
+/* The event queue for large polygons.  Rather than comb sorting the
+ * start events and pushing each stop event onto the priority queue as
+ * its edge is inserted, both are radix sorted in bulk beforehand.
+ * The edges are also copied into the order in which they join the
+ * sweep line, so that edges which are neighbours on the sweep line are
+ * mostly neighbours in memory too.
+ *
+ * Events that compare equal are still ordered by address, so the
+ * start events come out exactly as _cairo_bo_event_queue_sort()
+ * would leave them.
+ */
+static cairo_status_t
+_cairo_bentley_ottmann_tessellate_edges_sorted (cairo_traps_t	   *traps,
+						const cairo_edge_t *edges,
+						int		    num_edges,
+						cairo_fill_rule_t   fill_rule)
+{
+    cairo_bo_start_event_t *events;
+    cairo_bo_event_t **event_ptrs;
+    cairo_bo_queue_event_t *stop_events;
+    cairo_bo_sort_key_t *keys, *sorted;
+    cairo_status_t status;
+    int i, intersections;
+
+    keys = _cairo_malloc_ab (num_edges, 2 * sizeof (cairo_bo_sort_key_t));
+    if (unlikely (keys == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    events = _cairo_malloc_ab_plus_c (num_edges,
+				      sizeof (cairo_bo_start_event_t) +
+				      sizeof (cairo_bo_event_t *) +
+				      sizeof (cairo_bo_queue_event_t),
+				      sizeof (cairo_bo_event_t *));
+    if (unlikely (events == NULL)) {
+	free (keys);
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+    }
+
+    event_ptrs = (cairo_bo_event_t **) (events + num_edges);
+    stop_events = (cairo_bo_queue_event_t *) (event_ptrs + num_edges + 1);
+
+    for (i = 0; i < num_edges; i++) {
+	cairo_point_t point;
+
+	point.y = edges[i].top;
+	point.x = _line_compute_intersection_x_for_y (&edges[i].line,
+						      point.y);
+	keys[i].key = _cairo_bo_point_to_sort_key (&point);
+	keys[i].index = i;
+    }
+    sorted = _cairo_bo_radix_sort (keys, keys + num_edges, num_edges);
+
+    for (i = 0; i < num_edges; i++) {
+	cairo_bo_start_event_t *event = &events[i];
+
+	event->type = CAIRO_BO_EVENT_TYPE_START;
+	_cairo_bo_sort_key_to_point (sorted[i].key, &event->point);
+
+	event->edge.edge = edges[sorted[i].index];
+	event->edge.deferred_trap.right = NULL;
+	event->edge.prev = NULL;
+	event->edge.next = NULL;
+	event->edge.colinear = NULL;
+
+	event_ptrs[i] = (cairo_bo_event_t *) event;
+    }
+    event_ptrs[i] = NULL;
+
+    for (i = 0; i < num_edges; i++) {
+	const cairo_edge_t *edge = &events[i].edge.edge;
+	cairo_point_t point;
+
+	point.y = edge->bottom;
+	point.x = _line_compute_intersection_x_for_y (&edge->line, point.y);
+	keys[i].key = _cairo_bo_point_to_sort_key (&point);
+	keys[i].index = i;
+    }
+    sorted = _cairo_bo_radix_sort (keys, keys + num_edges, num_edges);
+
+    for (i = 0; i < num_edges; i++) {
+	cairo_bo_queue_event_t *event = &stop_events[i];
+
+	event->type = CAIRO_BO_EVENT_TYPE_STOP;
+	_cairo_bo_sort_key_to_point (sorted[i].key, &event->point);
+	event->e1 = &events[sorted[i].index].edge;
+	event->e2 = NULL;
+    }
+
+    free (keys);
+
+    status = _cairo_bentley_ottmann_tessellate_bo_edges (event_ptrs, num_edges,
+							 stop_events,
+							 fill_rule, traps,
+							 &intersections);
+
+    free (events);
+
+    return status;
+}
+
+static cairo_status_t
+_cairo_bentley_ottmann_tessellate_edges (cairo_traps_t		*traps,
+					 const cairo_edge_t	*edges,
+					 int			 num_events,
+					 const cairo_box_t	*limit,
+					 cairo_fill_rule_t	 fill_rule)
 {
     int intersections;
     cairo_bo_start_event_t stack_events[CAIRO_STACK_ARRAY_LENGTH (cairo_bo_start_event_t)];
@@ -1473,16 +1683,19 @@ _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
     cairo_bo_event_t **event_ptrs;
     cairo_bo_start_event_t *stack_event_y[64];
     cairo_bo_start_event_t **event_y = NULL;
-    int i, num_events, y, ymin, ymax;
+    int i, y, ymin, ymax;
     cairo_status_t status;
 
-    num_events = polygon->num_edges;
-    if (unlikely (0 == num_events))
-	return CAIRO_STATUS_SUCCESS;
+    if (num_events >= BO_RADIX_MIN_EDGES) {
+	return _cairo_bentley_ottmann_tessellate_edges_sorted (traps,
+							       edges,
+							       num_events,
+							       fill_rule);
+    }
 
-    if (polygon->num_limits) {
-	ymin = _cairo_fixed_integer_floor (polygon->limit.p1.y);
-	ymax = _cairo_fixed_integer_ceil (polygon->limit.p2.y) - ymin;
+    if (limit != NULL) {
+	ymin = _cairo_fixed_integer_floor (limit->p1.y);
+	ymax = _cairo_fixed_integer_ceil (limit->p2.y) - ymin;
 
 	if (ymax > 64) {
 	    event_y = _cairo_malloc_ab(sizeof (cairo_bo_event_t*), ymax);
@@ -1512,12 +1725,12 @@ _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
 
     for (i = 0; i < num_events; i++) {
 	events[i].type = CAIRO_BO_EVENT_TYPE_START;
-	events[i].point.y = polygon->edges[i].top;
+	events[i].point.y = edges[i].top;
 	events[i].point.x =
-	    _line_compute_intersection_x_for_y (&polygon->edges[i].line,
+	    _line_compute_intersection_x_for_y (&edges[i].line,
 						events[i].point.y);
 
-	events[i].edge.edge = polygon->edges[i];
+	events[i].edge.edge = edges[i];
 	events[i].edge.deferred_trap.right = NULL;
 	events[i].edge.prev = NULL;
 	events[i].edge.next = NULL;
@@ -1555,6 +1768,7 @@ _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
      * require storing the results of each pass into a temporary
      * cairo_traps_t. */
     status = _cairo_bentley_ottmann_tessellate_bo_edges (event_ptrs, num_events,
+							 NULL,
 							 fill_rule, traps,
 							 &intersections);
 #if DEBUG_TRAPS
@@ -1567,6 +1781,182 @@ _cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
     return status;
 }
 
+typedef struct _cairo_bo_band {
+    const cairo_edge_t *edges;
+    int num_edges;
+    cairo_fixed_t top, bottom;
+    cairo_fill_rule_t fill_rule;
+
+    cairo_traps_t traps;
+    cairo_status_t status;
+} cairo_bo_band_t;
+
+static void
+_cairo_bo_band_tessellate (void *closure, int index)
+{
+    cairo_bo_band_t *band = (cairo_bo_band_t *) closure + index;
+    cairo_edge_t *edges;
+    int i, n;
+
+    for (i = n = 0; i < band->num_edges; i++) {
+	const cairo_edge_t *edge = &band->edges[i];
+	n += edge->top < band->bottom && edge->bottom > band->top;
+    }
+    if (n == 0)
+	return;
+
+    edges = _cairo_malloc_ab (n, sizeof (cairo_edge_t));
+    if (unlikely (edges == NULL)) {
+	band->status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	return;
+    }
+
+    /* Clipping an edge only requires adjusting its extent, the line
+     * itself (and so every intersection on it) is left untouched. */
+    for (i = n = 0; i < band->num_edges; i++) {
+	const cairo_edge_t *edge = &band->edges[i];
+
+	if (edge->top < band->bottom && edge->bottom > band->top) {
+	    edges[n] = *edge;
+	    if (edges[n].top < band->top)
+		edges[n].top = band->top;
+	    if (edges[n].bottom > band->bottom)
+		edges[n].bottom = band->bottom;
+	    n++;
+	}
+    }
+
+    band->status = _cairo_bentley_ottmann_tessellate_edges (&band->traps,
+							    edges, n, NULL,
+							    band->fill_rule);
+    free (edges);
+}
+
+/* Splits a large polygon into horizontal bands, cut along pixel rows,
+ * that are swept independently on separate threads.  The trapezoids
+ * of each band are then appended in order, so the result covers the
+ * same area as a single sweep but with the trapezoids crossing a cut
+ * split in two.  Returns CAIRO_INT_STATUS_UNSUPPORTED if the polygon
+ * is too small, or threading is disabled, for this to be worthwhile.
+ */
+static cairo_int_status_t
+_cairo_bentley_ottmann_tessellate_bands (cairo_traps_t		*traps,
+					 const cairo_edge_t	*edges,
+					 int			 num_edges,
+					 cairo_fill_rule_t	 fill_rule)
+{
+    unsigned histogram[BO_BAND_HISTOGRAM_SIZE];
+    cairo_fixed_t cuts[CAIRO_PARALLEL_MAX_THREADS + 1];
+    cairo_bo_band_t *bands;
+    cairo_fixed_t ymin, ymax;
+    cairo_int_status_t status;
+    int64_t height;
+    int num_bands, bin, sum, n, i, j;
+
+    num_bands = MIN (_cairo_parallel_get_num_threads (),
+		     num_edges / BO_BAND_MIN_EDGES_PER_BAND);
+    if (num_bands < 2)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    ymin = edges[0].top;
+    ymax = edges[0].bottom;
+    for (i = 1; i < num_edges; i++) {
+	if (edges[i].top < ymin)
+	    ymin = edges[i].top;
+	if (edges[i].bottom > ymax)
+	    ymax = edges[i].bottom;
+    }
+    height = (int64_t) ymax - ymin;
+
+    /* Balance the bands by the number of edges starting in each */
+    memset (histogram, 0, sizeof (histogram));
+    for (i = 0; i < num_edges; i++)
+	histogram[((int64_t) edges[i].top - ymin) * BO_BAND_HISTOGRAM_SIZE / height]++;
+
+    cuts[0] = ymin;
+    for (i = n = 1, bin = sum = 0; i < num_bands; i++) {
+	int64_t target = (int64_t) num_edges * i / num_bands;
+	cairo_fixed_t y;
+
+	while (bin < BO_BAND_HISTOGRAM_SIZE && sum + histogram[bin] <= target)
+	    sum += histogram[bin++];
+
+	y = ymin + height * bin / BO_BAND_HISTOGRAM_SIZE;
+	y = _cairo_fixed_from_int (_cairo_fixed_integer_floor (y));
+	if (y > cuts[n-1] && y < ymax)
+	    cuts[n++] = y;
+    }
+    cuts[n] = ymax;
+    num_bands = n;
+    if (num_bands < 2)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    bands = _cairo_malloc_ab (num_bands, sizeof (cairo_bo_band_t));
+    if (unlikely (bands == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    for (i = 0; i < num_bands; i++) {
+	cairo_bo_band_t *band = &bands[i];
+
+	band->edges = edges;
+	band->num_edges = num_edges;
+	band->top = cuts[i];
+	band->bottom = cuts[i+1];
+	band->fill_rule = fill_rule;
+	band->status = CAIRO_STATUS_SUCCESS;
+	_cairo_traps_init (&band->traps);
+    }
+
+    _cairo_parallel_run (_cairo_bo_band_tessellate, bands, num_bands);
+
+    status = CAIRO_INT_STATUS_SUCCESS;
+    for (i = 0; i < num_bands; i++) {
+	cairo_bo_band_t *band = &bands[i];
+
+	if (status == CAIRO_INT_STATUS_SUCCESS)
+	    status = band->status;
+
+	for (j = 0; status == CAIRO_INT_STATUS_SUCCESS &&
+		    j < band->traps.num_traps; j++)
+	{
+	    const cairo_trapezoid_t *t = &band->traps.traps[j];
+
+	    _cairo_traps_add_trap (traps, t->top, t->bottom, &t->left, &t->right);
+	}
+	if (status == CAIRO_INT_STATUS_SUCCESS)
+	    status = traps->status;
+
+	_cairo_traps_fini (&band->traps);
+    }
+
+    free (bands);
+    return status;
+}
+
+cairo_status_t
+_cairo_bentley_ottmann_tessellate_polygon (cairo_traps_t	 *traps,
+					   const cairo_polygon_t *polygon,
+					   cairo_fill_rule_t	  fill_rule)
+{
+    cairo_int_status_t status;
+
+    if (unlikely (0 == polygon->num_edges))
+	return CAIRO_STATUS_SUCCESS;
+
+    status = _cairo_bentley_ottmann_tessellate_bands (traps,
+						      polygon->edges,
+						      polygon->num_edges,
+						      fill_rule);
+    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	return status;
+
+    return _cairo_bentley_ottmann_tessellate_edges (traps,
+						    polygon->edges,
+						    polygon->num_edges,
+						    polygon->num_limits ? &polygon->limit : NULL,
+						    fill_rule);
+}
+
 cairo_status_t
 _cairo_bentley_ottmann_tessellate_traps (cairo_traps_t *traps,
 					 cairo_fill_rule_t fill_rule)
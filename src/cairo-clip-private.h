@@ -55,6 +55,13 @@ struct _cairo_clip_path {
     double			 tolerance;
     cairo_antialias_t		 antialias;
     cairo_clip_path_t		*prev;
+
+    /* The rasterized intersection of this path and all previous ones,
+     * covering _cairo_clip_path_get_mask_extents() and shared by every
+     * clip that references this path.  It is only built once the path
+     * has been used for more than one draw. */
+    cairo_surface_t		*mask;
+    cairo_atomic_int_t		 mask_used;
 };
 
 struct _cairo_clip {
@@ -146,6 +153,21 @@ _cairo_clip_get_image (const cairo_clip_t *clip,
 		       cairo_surface_t *target,
 		       const cairo_rectangle_int_t *extents);
 
+cairo_private cairo_bool_t
+_cairo_clip_path_get_mask_extents (const cairo_clip_path_t *clip_path,
+				   cairo_rectangle_int_t *extents);
+
+cairo_private cairo_surface_t *
+_cairo_clip_path_lookup_mask (const cairo_clip_path_t *clip_path,
+			      cairo_surface_t *target);
+
+cairo_private cairo_bool_t
+_cairo_clip_path_first_mask_use (cairo_clip_path_t *clip_path);
+
+cairo_private void
+_cairo_clip_path_cache_mask (cairo_clip_path_t *clip_path,
+			     cairo_surface_t *mask);
+
 cairo_private cairo_status_t
 _cairo_clip_combine_with_surface (const cairo_clip_t *clip,
 				  cairo_surface_t *dst,
@@ -91,6 +91,69 @@ _cairo_clip_combine_with_surface (const cairo_clip_t *clip,
     return status;
 }
 
+/* Masks are only cached for clips up to this many pixels, so that a
+ * clip covering a huge surface does not pin down a huge mask. */
+#define CLIP_MASK_CACHE_MAX_PIXELS (2048 * 2048)
+
+/* Compute the area that a mask for clip_path and all the paths before
+ * it has to cover.  Returns FALSE if the mask would be empty or too
+ * large to be worth caching. */
+cairo_bool_t
+_cairo_clip_path_get_mask_extents (const cairo_clip_path_t *clip_path,
+				   cairo_rectangle_int_t *extents)
+{
+    cairo_rectangle_int_t path_extents;
+
+    _cairo_path_fixed_approximate_clip_extents (&clip_path->path, extents);
+    for (clip_path = clip_path->prev; clip_path; clip_path = clip_path->prev) {
+	_cairo_path_fixed_approximate_clip_extents (&clip_path->path,
+						    &path_extents);
+	if (! _cairo_rectangle_intersect (extents, &path_extents))
+	    return FALSE;
+    }
+
+    return extents->width > 0 && extents->height > 0 &&
+	(int64_t) extents->width * extents->height <= CLIP_MASK_CACHE_MAX_PIXELS;
+}
+
+/* Returns a new reference to the mask cached on clip_path, or NULL if
+ * there is no mask that can be used with target.  Once installed, the
+ * mask stays until the path itself is destroyed, so it may be read
+ * from any thread. */
+cairo_surface_t *
+_cairo_clip_path_lookup_mask (const cairo_clip_path_t *clip_path,
+			      cairo_surface_t *target)
+{
+    cairo_surface_t *mask;
+
+    mask = _cairo_atomic_ptr_get ((void **) &clip_path->mask);
+    if (mask == NULL ||
+	mask->backend != target->backend ||
+	mask->device != target->device)
+	return NULL;
+
+    return cairo_surface_reference (mask);
+}
+
+/* Returns TRUE the first time it is called for clip_path, so that a
+ * clip only used for a single draw is not rasterized in full. */
+cairo_bool_t
+_cairo_clip_path_first_mask_use (cairo_clip_path_t *clip_path)
+{
+    return _cairo_atomic_int_cmpxchg (&clip_path->mask_used, 0, 1);
+}
+
+/* Installs mask as the cached mask of clip_path, unless another thread
+ * got there first, in which case ours is simply not kept. */
+void
+_cairo_clip_path_cache_mask (cairo_clip_path_t *clip_path,
+			     cairo_surface_t *mask)
+{
+    cairo_surface_reference (mask);
+    if (! _cairo_atomic_ptr_cmpxchg ((void **) &clip_path->mask, NULL, mask))
+	cairo_surface_destroy (mask);
+}
+
 static cairo_status_t
 _cairo_path_fixed_add_box (cairo_path_fixed_t *path,
 			   const cairo_box_t *box,
@@ -69,6 +69,8 @@ _cairo_clip_path_create (cairo_clip_t *clip)
 
     CAIRO_REFERENCE_COUNT_INIT (&clip_path->ref_count, 1);
 
+    clip_path->mask = NULL;
+    clip_path->mask_used = 0;
     clip_path->prev = clip->path;
     clip->path = clip_path;
 
@@ -94,6 +96,7 @@ _cairo_clip_path_destroy (cairo_clip_path_t *clip_path)
 	return;
 
     _cairo_path_fixed_fini (&clip_path->path);
+    cairo_surface_destroy (clip_path->mask);
 
     if (clip_path->prev != NULL)
 	_cairo_clip_path_destroy (clip_path->prev);
@@ -0,0 +1,501 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* A scan converter for the outline of a single convex contour.
+ *
+ * Such an outline splits into two chains, the edges heading down and
+ * the edges heading up, each of which crosses every scanline within
+ * the shape exactly once.  The edges of each chain are already
+ * contiguous in the order the outline was emitted, so the converter
+ * walks the two chains in step, row by row, with neither an edge sort
+ * nor an active edge list.
+ *
+ * Within a row each chain deposits its signed area into a one-row
+ * accumulator, as the area converter does for a whole band.  Only the
+ * cells touched by the two chains are visited: everything between them
+ * is fully covered and is emitted as a single span.  As the two chains
+ * never cross, the coverage is exact to the 24.8 input precision.
+ */
+
+#include "cairoint.h"
+#include "cairo-spans-private.h"
+#include "cairo-error-private.h"
+
+#include <stdlib.h>
+#include <limits.h>
+
+#define AREA_ONE	(2 * CAIRO_FIXED_ONE * CAIRO_FIXED_ONE)
+
+typedef struct _convex_chain {
+    const cairo_edge_t **edges;
+    int num_edges;
+    int current;
+
+    /* The range of cells touched in the current row. */
+    int min, max;
+} convex_chain_t;
+
+typedef struct _cairo_convex_scan_converter {
+    cairo_scan_converter_t base;
+
+    int xmin, ymin, xmax, ymax;
+    int width;
+
+    int top, bottom;
+    convex_chain_t chains[2];
+
+    /* (width + 1) accumulators, the last catching anything right of
+     * the clip. */
+    int32_t *cells;
+    cairo_half_open_span_t *spans;
+    const cairo_edge_t **edges;
+
+    int32_t cells_embedded[256];
+    cairo_half_open_span_t spans_embedded[64];
+    const cairo_edge_t *edges_embedded[2*32];
+} cairo_convex_scan_converter_t;
+
+static inline void
+cell_add (cairo_convex_scan_converter_t *self,
+	  convex_chain_t *chain, int x, int32_t v)
+{
+    x -= self->xmin;
+    if (x < 0)
+	x = 0;
+    else if (x > self->width)
+	return;
+
+    self->cells[x] += v;
+    if (x < chain->min)
+	chain->min = x;
+    if (x > chain->max)
+	chain->max = x;
+}
+
+/* Accumulates the segment (x0, y0)-(x1, y1) lying within the current
+ * row, with y0 and y1 given relative to the top of the row. */
+static void
+add_segment (cairo_convex_scan_converter_t *self,
+	     convex_chain_t *chain,
+	     cairo_fixed_t x0, cairo_fixed_t y0,
+	     cairo_fixed_t x1, cairo_fixed_t y1,
+	     int dir)
+{
+    cairo_fixed_t xs, ys;
+    int64_t dx, dy;
+    int ix, ix1;
+
+    if (x0 > x1) {
+	cairo_fixed_t t;
+
+	t = x0; x0 = x1; x1 = t;
+	t = y0; y0 = y1; y1 = t;
+    }
+
+    ix = _cairo_fixed_integer_floor (x0);
+    ix1 = _cairo_fixed_integer_floor (x1);
+
+    /* Wholly left of the clip, the segment covers every pixel. */
+    if (ix1 < self->xmin) {
+	int32_t h = y1 > y0 ? y1 - y0 : y0 - y1;
+	cell_add (self, chain, ix1, dir * h * 2 * CAIRO_FIXED_ONE);
+	return;
+    }
+
+    dx = (int64_t) x1 - x0;
+    dy = (int64_t) y1 - y0;
+    xs = x0;
+    ys = y0;
+
+    if (ix < self->xmin) {
+	cairo_fixed_t xe = _cairo_fixed_from_int (self->xmin);
+	cairo_fixed_t ye = y0 + ((int64_t) xe - x0) * dy / dx;
+	int32_t h = ye > ys ? ye - ys : ys - ye;
+
+	cell_add (self, chain, ix, dir * h * 2 * CAIRO_FIXED_ONE);
+	xs = xe;
+	ys = ye;
+	ix = self->xmin;
+    }
+
+    /* Split the segment where it crosses each pixel boundary. */
+    do {
+	cairo_fixed_t xe, ye, fx;
+	int32_t h, a;
+
+	if (ix == ix1) {
+	    xe = x1;
+	    ye = y1;
+	} else {
+	    xe = _cairo_fixed_from_int (ix + 1);
+	    ye = y0 + ((int64_t) xe - x0) * dy / dx;
+	}
+
+	h = ye > ys ? ye - ys : ys - ye;
+	fx = _cairo_fixed_from_int (ix);
+	a = h * (xs - fx + xe - fx);
+
+	cell_add (self, chain, ix, dir * (h * 2 * CAIRO_FIXED_ONE - a));
+	cell_add (self, chain, ix + 1, dir * a);
+
+	xs = xe;
+	ys = ye;
+    } while (ix++ < ix1 && ix < self->xmax);
+}
+
+/* Advances the chain to the row [top, top + 1) and accumulates the
+ * edges crossing it. */
+static void
+chain_add_row (cairo_convex_scan_converter_t *self,
+	       convex_chain_t *chain,
+	       cairo_fixed_t top)
+{
+    cairo_fixed_t bottom = top + CAIRO_FIXED_ONE;
+    int i;
+
+    chain->min = INT_MAX;
+    chain->max = -1;
+
+    while (chain->current < chain->num_edges &&
+	   chain->edges[chain->current]->bottom <= top)
+	chain->current++;
+
+    for (i = chain->current; i < chain->num_edges; i++) {
+	const cairo_edge_t *edge = chain->edges[i];
+	cairo_fixed_t y0, y1, x0, x1;
+
+	if (edge->top >= bottom)
+	    break;
+
+	y0 = MAX (edge->top, top);
+	y1 = MIN (edge->bottom, bottom);
+	x0 = _cairo_edge_compute_intersection_x_for_y (&edge->line.p1,
+						       &edge->line.p2,
+						       y0);
+	x1 = _cairo_edge_compute_intersection_x_for_y (&edge->line.p1,
+						       &edge->line.p2,
+						       y1);
+	add_segment (self, chain, x0, y0 - top, x1, y1 - top, edge->dir);
+    }
+}
+
+static inline uint8_t
+area_to_alpha (int32_t area)
+{
+    if (area < 0)
+	area = -area;
+    if (area > AREA_ONE)
+	area = AREA_ONE;
+
+    return (area * 255 + AREA_ONE/2) / AREA_ONE;
+}
+
+static int
+emit_cells (cairo_convex_scan_converter_t *self,
+	    int x, int x_end,
+	    int32_t *cover, uint8_t *last,
+	    int num_spans)
+{
+    cairo_half_open_span_t *spans = self->spans;
+    int32_t *cells = self->cells;
+
+    for (; x <= x_end; x++) {
+	uint8_t alpha;
+
+	*cover += cells[x];
+	alpha = area_to_alpha (*cover);
+	if (alpha != *last) {
+	    spans[num_spans].x = self->xmin + x;
+	    spans[num_spans].coverage = alpha;
+	    *last = alpha;
+	    num_spans++;
+	}
+    }
+
+    return num_spans;
+}
+
+static cairo_status_t
+render_row (cairo_convex_scan_converter_t *self,
+	    cairo_span_renderer_t *renderer,
+	    int y)
+{
+    const convex_chain_t *a = &self->chains[0];
+    const convex_chain_t *b = &self->chains[1];
+    int range[2][2], num_ranges, n;
+    int32_t cover = 0;
+    uint8_t last = 0;
+    int num_spans = 0;
+
+    /* The coverage is constant between the two chains, so only the
+     * cells they touched need to be summed. */
+    num_ranges = 0;
+    if (a->min > a->max) {
+	const convex_chain_t *t = a;
+	a = b;
+	b = t;
+    }
+    if (a->min > a->max)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (b->min > b->max || (b->min <= a->max + 1 && a->min <= b->max + 1)) {
+	range[0][0] = b->min > b->max ? a->min : MIN (a->min, b->min);
+	range[0][1] = b->min > b->max ? a->max : MAX (a->max, b->max);
+	num_ranges = 1;
+    } else if (a->max < b->min) {
+	range[0][0] = a->min; range[0][1] = a->max;
+	range[1][0] = b->min; range[1][1] = b->max;
+	num_ranges = 2;
+    } else {
+	range[0][0] = b->min; range[0][1] = b->max;
+	range[1][0] = a->min; range[1][1] = a->max;
+	num_ranges = 2;
+    }
+
+    for (n = 0; n < num_ranges; n++) {
+	num_spans = emit_cells (self,
+				range[n][0], MIN (range[n][1], self->width - 1),
+				&cover, &last, num_spans);
+	memset (self->cells + range[n][0], 0,
+		(range[n][1] - range[n][0] + 1) * sizeof (int32_t));
+    }
+    if (last) {
+	self->spans[num_spans].x = self->xmax;
+	self->spans[num_spans].coverage = 0;
+	num_spans++;
+    }
+
+    if (num_spans == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    return renderer->render_rows (renderer, y, 1, self->spans, num_spans);
+}
+
+static cairo_status_t
+_cairo_convex_scan_converter_generate (void			*converter,
+				       cairo_span_renderer_t	*renderer)
+{
+    cairo_convex_scan_converter_t *self = converter;
+    int y, y_end;
+
+    y = MAX (self->ymin, _cairo_fixed_integer_floor (self->top));
+    y_end = MIN (self->ymax, _cairo_fixed_integer_ceil (self->bottom));
+    for (; y < y_end; y++) {
+	cairo_fixed_t top = _cairo_fixed_from_int (y);
+	cairo_status_t status;
+
+	chain_add_row (self, &self->chains[0], top);
+	chain_add_row (self, &self->chains[1], top);
+
+	status = render_row (self, renderer, y);
+	if (unlikely (status))
+	    return _cairo_scan_converter_set_error (self, status);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static int
+edge_compare_top (const void *a, const void *b)
+{
+    const cairo_edge_t *ea = *(const cairo_edge_t **) a;
+    const cairo_edge_t *eb = *(const cairo_edge_t **) b;
+
+    return ea->top - eb->top;
+}
+
+static cairo_bool_t
+chain_is_contiguous (const cairo_edge_t **edges, int num_edges)
+{
+    int i;
+
+    for (i = 1; i < num_edges; i++) {
+	if (edges[i]->top != edges[i-1]->bottom)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Orders the edges of a chain from top to bottom, starting from the
+ * topmost and following the outline in whichever direction continues
+ * it.  Clipping to the polygon limits may emit the pieces of an edge
+ * out of order, in which case the chain is sorted instead.  Fails if
+ * the edges do not join up into a single chain. */
+static cairo_bool_t
+chain_init (convex_chain_t *chain,
+	    const cairo_edge_t **in,
+	    const cairo_edge_t **out,
+	    int num_edges)
+{
+    int i, start, step;
+
+    if (num_edges == 0)
+	return FALSE;
+
+    start = 0;
+    for (i = 1; i < num_edges; i++) {
+	if (in[i]->top < in[start]->top)
+	    start = i;
+    }
+
+    step = 1;
+    if (num_edges > 1 &&
+	in[(start + 1) % num_edges]->top != in[start]->bottom)
+	step = num_edges - 1;
+
+    for (i = 0; i < num_edges; i++)
+	out[i] = in[(start + i * step) % num_edges];
+
+    if (! chain_is_contiguous (out, num_edges)) {
+	qsort (out, num_edges, sizeof (cairo_edge_t *), edge_compare_top);
+	if (! chain_is_contiguous (out, num_edges))
+	    return FALSE;
+    }
+
+    chain->edges = out;
+    chain->num_edges = num_edges;
+    chain->current = 0;
+    return TRUE;
+}
+
+cairo_int_status_t
+_cairo_convex_scan_converter_add_polygon (void			*converter,
+					  const cairo_polygon_t	*polygon)
+{
+    cairo_convex_scan_converter_t *self = converter;
+    const cairo_edge_t **in, **out;
+    int i, num_down, num_up;
+
+    if (unlikely (self->base.status))
+	return self->base.status;
+
+    if (! polygon->is_convex)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    if (polygon->num_edges > ARRAY_LENGTH (self->edges_embedded) / 2) {
+	self->edges = _cairo_malloc_ab (2 * polygon->num_edges,
+					sizeof (cairo_edge_t *));
+	if (unlikely (self->edges == NULL))
+	    return _cairo_scan_converter_set_error (self, _cairo_error (CAIRO_STATUS_NO_MEMORY));
+    }
+
+    /* Split the outline by direction, keeping the order it was emitted
+     * in: the edges heading down first, then those heading up. */
+    in = self->edges;
+    out = self->edges + polygon->num_edges;
+    num_down = 0;
+    for (i = 0; i < polygon->num_edges; i++) {
+	if (polygon->edges[i].dir > 0)
+	    in[num_down++] = &polygon->edges[i];
+    }
+    num_up = num_down;
+    for (i = 0; i < polygon->num_edges; i++) {
+	if (polygon->edges[i].dir < 0)
+	    in[num_up++] = &polygon->edges[i];
+    }
+    num_up -= num_down;
+
+    if (! chain_init (&self->chains[0], in, out, num_down) ||
+	! chain_init (&self->chains[1], in + num_down, out + num_down, num_up))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    if (self->chains[0].edges[0]->top != self->chains[1].edges[0]->top ||
+	self->chains[0].edges[num_down-1]->bottom != self->chains[1].edges[num_up-1]->bottom)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    self->top = self->chains[0].edges[0]->top;
+    self->bottom = self->chains[0].edges[num_down-1]->bottom;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_convex_scan_converter_destroy (void *converter)
+{
+    cairo_convex_scan_converter_t *self = converter;
+
+    if (self->cells != self->cells_embedded)
+	free (self->cells);
+    if (self->spans != self->spans_embedded)
+	free (self->spans);
+    if (self->edges != self->edges_embedded)
+	free (self->edges);
+    free (self);
+}
+
+cairo_scan_converter_t *
+_cairo_convex_scan_converter_create (int	xmin,
+				     int	ymin,
+				     int	xmax,
+				     int	ymax)
+{
+    cairo_convex_scan_converter_t *self;
+    cairo_status_t status;
+
+    self = _cairo_malloc (sizeof (cairo_convex_scan_converter_t));
+    if (unlikely (self == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto bail_nomem;
+    }
+
+    self->base.destroy = _cairo_convex_scan_converter_destroy;
+    self->base.generate = _cairo_convex_scan_converter_generate;
+    self->base.status = CAIRO_STATUS_SUCCESS;
+
+    self->xmin = xmin;
+    self->ymin = ymin;
+    self->xmax = xmax;
+    self->ymax = ymax;
+    self->width = MAX (xmax - xmin, 0);
+    self->top = self->bottom = 0;
+
+    self->cells = self->cells_embedded;
+    self->spans = self->spans_embedded;
+    self->edges = self->edges_embedded;
+
+    if (self->width + 1 > ARRAY_LENGTH (self->cells_embedded)) {
+	self->cells = _cairo_malloc_ab (self->width + 1, sizeof (int32_t));
+	if (unlikely (self->cells == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+    memset (self->cells, 0, (self->width + 1) * sizeof (int32_t));
+
+    if (self->width + 1 > ARRAY_LENGTH (self->spans_embedded)) {
+	self->spans = _cairo_malloc_ab (self->width + 1,
+					sizeof (cairo_half_open_span_t));
+	if (unlikely (self->spans == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+
+    return &self->base;
+
+ bail:
+    self->base.destroy (&self->base);
+ bail_nomem:
+    return _cairo_scan_converter_create_in_error (status);
+}
@@ -1038,6 +1038,37 @@ _cairo_default_context_stroke_extents (void *abstract_cr,
 					 x1, y1, x2, y2);
 }
 
+static cairo_status_t
+_cairo_default_context_prepare_fill (void *abstract_cr,
+				     cairo_prepared_path_t *prepared)
+{
+    cairo_default_context_t *cr = abstract_cr;
+
+    return _cairo_gstate_prepare_fill (cr->gstate, cr->path, prepared);
+}
+
+static cairo_status_t
+_cairo_default_context_fill_prepared (void *abstract_cr,
+				      const cairo_prepared_path_t *prepared)
+{
+    cairo_default_context_t *cr = abstract_cr;
+
+    return _cairo_gstate_fill_prepared (cr->gstate, prepared);
+}
+
+static cairo_status_t
+_cairo_default_context_fill_instances (void *abstract_cr,
+				       const cairo_path_t *path,
+				       const cairo_matrix_t *transforms,
+				       const double *colors,
+				       int num_instances)
+{
+    cairo_default_context_t *cr = abstract_cr;
+
+    return _cairo_gstate_fill_instances (cr->gstate, path,
+					 transforms, colors, num_instances);
+}
+
 static cairo_status_t
 _cairo_default_context_fill_preserve (void *abstract_cr)
 {
@@ -1458,6 +1489,10 @@ static const cairo_backend_t _cairo_default_context_backend = {
 
     _cairo_default_context_tag_begin,
     _cairo_default_context_tag_end,
+
+    _cairo_default_context_prepare_fill,
+    _cairo_default_context_fill_prepared,
+    _cairo_default_context_fill_instances,
 };
 
 cairo_status_t
@@ -0,0 +1,851 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* An analytic scan converter for a single axis-aligned ellipse or
+ * rounded box.
+ *
+ * Scaled to the unit circle, the area of the disc lying within the
+ * rectangle [0,u]×[0,v] has a closed form.  A rounded box is an
+ * ellipse cut along its axes with straight sides inserted, so the area
+ * of the shape within a rectangle from its centre follows as the sum
+ * of that of the inner box, the two straight strips and the curved
+ * corner, and the exact coverage of any pixel from the values at its
+ * four corners.  Each row is then emitted as the pixels crossed by the
+ * outline on either side with a single fully covered span between them;
+ * the rows between the straight sides are all alike and are emitted
+ * together.
+ *
+ * Shapes whose radii are no larger than ELLIPSE_MASK_MAX_RADIUS have
+ * the centres of their corners rounded to an eighth of a pixel, and
+ * their coverage is kept in a cache keyed by the radii and that
+ * sub-pixel phase: the whole of a small ellipse, or the top-left corner
+ * of a rounded box, mirrored for the others.  Repeated dots, markers
+ * and buttons are then rendered by copying rows of the cached masks.
+ * The rounding is applied whether or not a mask is found in the cache,
+ * so the output does not depend upon its state.
+ */
+
+#include "cairoint.h"
+#include "cairo-spans-private.h"
+#include "cairo-error-private.h"
+
+#include <math.h>
+
+#define ELLIPSE_MASK_MAX_RADIUS	16
+#define ELLIPSE_MASK_SIZE	(2 * ELLIPSE_MASK_MAX_RADIUS + 2)
+#define ELLIPSE_MASK_PHASE_BITS	3
+#define ELLIPSE_MASK_PHASES	(1 << ELLIPSE_MASK_PHASE_BITS)
+#define ELLIPSE_MASK_CACHE_SIZE	(256 * 1024)
+
+typedef struct _rounded_box {
+    double cx, cy;
+
+    /* Half the lengths of the straight sides, and the corner radii. */
+    double hx, hy;
+    double rx, ry;
+} rounded_box_t;
+
+typedef struct _cairo_ellipse_mask {
+    cairo_cache_entry_t base;
+
+    /* Radii in 1/512ths of a pixel, and sub-pixel phase of the centre. */
+    int rx, ry;
+    int phase_x, phase_y;
+
+    /* Either a whole ellipse, or the top-left corner of a rounded box. */
+    cairo_bool_t corner;
+
+    int width, height;
+    uint8_t *data;
+} cairo_ellipse_mask_t;
+
+/* Where a copy of a cached mask lies, possibly mirrored. */
+typedef struct _ellipse_mask_view {
+    int x, y;
+    int width, height;
+    cairo_bool_t flip_x, flip_y;
+    const uint8_t *data;
+} ellipse_mask_view_t;
+
+typedef struct _cairo_ellipse_scan_converter {
+    cairo_scan_converter_t base;
+
+    int xmin, ymin, xmax, ymax;
+    int width;
+
+    rounded_box_t shape;
+
+    /* A single view for a small ellipse; four for the corners of a
+     * rounded box, top-left, top-right, bottom-left and bottom-right,
+     * with the straight edges between them. */
+    int num_views;
+    ellipse_mask_view_t views[4];
+    double left, top, right, bottom;
+    uint8_t mask[ELLIPSE_MASK_SIZE * ELLIPSE_MASK_SIZE];
+
+    uint8_t *row;
+    cairo_half_open_span_t *spans;
+    int num_spans;
+    int row_end;
+    uint8_t last;
+
+    uint8_t row_embedded[256];
+    cairo_half_open_span_t spans_embedded[64];
+} cairo_ellipse_scan_converter_t;
+
+typedef struct _ellipse_row {
+    /* The offsets of the top and bottom of the row from the centre. */
+    double q0, q1;
+
+    /* The pixels touched by the shape in this row, and those of them
+     * wholly inside it. */
+    int x0, x1;
+    int in0, in1;
+} ellipse_row_t;
+
+static cairo_cache_t ellipse_mask_cache;
+
+/* The area under the unit circle between 0 and t, for t in [0, 1]. */
+static inline double
+circle_segment (double t)
+{
+    return .5 * (t * sqrt (1 - t * t) + asin (t));
+}
+
+/* The signed area of the unit disc within [0,u]×[0,v]. */
+static double
+disc_area (double u, double v)
+{
+    double sign = 1, uc;
+
+    if (u < 0) {
+	u = -u;
+	sign = -sign;
+    }
+    if (v < 0) {
+	v = -v;
+	sign = -sign;
+    }
+    if (u > 1)
+	u = 1;
+    if (v > 1)
+	v = 1;
+
+    if (u * u + v * v <= 1)
+	return sign * u * v;
+
+    uc = sqrt (1 - v * v);
+    return sign * (uc * v + circle_segment (u) - circle_segment (uc));
+}
+
+/* The signed area of the shape within [0,p]×[0,q] from its centre. */
+static double
+rounded_box_area (const rounded_box_t *shape, double p, double q)
+{
+    double sign = 1, ps, qs, u, v;
+
+    if (p < 0) {
+	p = -p;
+	sign = -sign;
+    }
+    if (q < 0) {
+	q = -q;
+	sign = -sign;
+    }
+
+    ps = MIN (p, shape->hx);
+    qs = MIN (q, shape->hy);
+    u = MIN ((p - ps) / shape->rx, 1);
+    v = MIN ((q - qs) / shape->ry, 1);
+
+    return sign * (ps * qs +
+		   ps * shape->ry * v +
+		   shape->rx * u * qs +
+		   shape->rx * shape->ry * disc_area (u, v));
+}
+
+static inline uint8_t
+area_to_alpha (double area)
+{
+    if (area <= 0)
+	return 0;
+    if (area >= 1)
+	return 255;
+
+    return area * 255 + .5;
+}
+
+/* The distance of a point q from the centre into the curved part of the
+ * shape, in units of the radius. */
+static inline double
+curve_offset (double q, double h, double r)
+{
+    if (q > h)
+	return (q - h) / r;
+    if (q < -h)
+	return (q + h) / r;
+    return 0;
+}
+
+static cairo_bool_t
+ellipse_row (const rounded_box_t *shape, int y, ellipse_row_t *row)
+{
+    double v0, v1, vmin, vmax, w;
+
+    row->q0 = y - shape->cy;
+    row->q1 = y + 1 - shape->cy;
+
+    v0 = curve_offset (row->q0, shape->hy, shape->ry);
+    v1 = curve_offset (row->q1, shape->hy, shape->ry);
+    if (v1 <= -1 || v0 >= 1)
+	return FALSE;
+
+    if (v0 <= 0 && v1 >= 0)
+	vmin = 0;
+    else
+	vmin = MIN (fabs (v0), fabs (v1));
+    vmax = MAX (fabs (v0), fabs (v1));
+
+    w = shape->hx + shape->rx * sqrt (1 - vmin * vmin);
+    row->x0 = floor (shape->cx - w);
+    row->x1 = ceil (shape->cx + w);
+
+    row->in0 = row->in1 = row->x1;
+    if (vmax < 1) {
+	w = shape->hx + shape->rx * sqrt (1 - vmax * vmax);
+	if (ceil (shape->cx - w) < floor (shape->cx + w)) {
+	    row->in0 = ceil (shape->cx - w);
+	    row->in1 = floor (shape->cx + w);
+	}
+    }
+
+    return TRUE;
+}
+
+/* Computes the coverage of the pixels [x, x_end) of the row. */
+static void
+ellipse_row_coverage (const rounded_box_t *shape,
+		      const ellipse_row_t *row,
+		      int x, int x_end,
+		      uint8_t *coverage)
+{
+    double p, a, b;
+
+    p = x - shape->cx;
+    a = rounded_box_area (shape, p, row->q1) -
+	rounded_box_area (shape, p, row->q0);
+    for (; x < x_end; x++) {
+	p = x + 1 - shape->cx;
+	b = rounded_box_area (shape, p, row->q1) -
+	    rounded_box_area (shape, p, row->q0);
+	*coverage++ = area_to_alpha (b - a);
+	a = b;
+    }
+}
+
+/* Fills in the coverage of the shape over the pixels [0, width) ×
+ * [0, height) of a mask. */
+static void
+rounded_box_render_mask (const rounded_box_t *shape,
+			 uint8_t *data, int width, int height)
+{
+    int y;
+
+    memset (data, 0, width * height);
+    for (y = 0; y < height; y++) {
+	uint8_t *coverage = data + y * width;
+	ellipse_row_t row;
+
+	if (! ellipse_row (shape, y, &row))
+	    continue;
+
+	row.x0 = MAX (row.x0, 0);
+	row.x1 = MIN (row.x1, width);
+	row.in0 = MAX (MIN (row.in0, row.x1), row.x0);
+	row.in1 = MAX (MIN (row.in1, row.x1), row.in0);
+
+	ellipse_row_coverage (shape, &row,
+			      row.x0, row.in0, coverage + row.x0);
+	memset (coverage + row.in0, 255, row.in1 - row.in0);
+	ellipse_row_coverage (shape, &row,
+			      row.in1, row.x1, coverage + row.in1);
+    }
+}
+
+static inline void
+row_start (cairo_ellipse_scan_converter_t *self)
+{
+    self->num_spans = 0;
+    self->last = 0;
+}
+
+/* Appends the pixels [x, x_end) at the given coverage to the row; the
+ * runs of a row must be added from left to right without gaps. */
+static void
+row_add (cairo_ellipse_scan_converter_t *self,
+	 int x, int x_end, uint8_t alpha)
+{
+    x = MAX (x, self->xmin);
+    x_end = MIN (x_end, self->xmax);
+    if (x >= x_end)
+	return;
+
+    if (alpha != self->last) {
+	self->spans[self->num_spans].x = x;
+	self->spans[self->num_spans].coverage = alpha;
+	self->num_spans++;
+	self->last = alpha;
+    }
+    self->row_end = x_end;
+}
+
+static void
+row_add_coverage (cairo_ellipse_scan_converter_t *self,
+		  int x, int x_end, const uint8_t *coverage)
+{
+    for (; x < x_end; x++)
+	row_add (self, x, x + 1, *coverage++);
+}
+
+static cairo_status_t
+row_emit (cairo_ellipse_scan_converter_t *self,
+	  cairo_span_renderer_t *renderer,
+	  int y, int height)
+{
+    if (self->last) {
+	self->spans[self->num_spans].x = self->row_end;
+	self->spans[self->num_spans].coverage = 0;
+	self->num_spans++;
+    }
+
+    if (self->num_spans == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    return renderer->render_rows (renderer, y, height,
+				  self->spans, self->num_spans);
+}
+
+static cairo_status_t
+render_row (cairo_ellipse_scan_converter_t *self,
+	    cairo_span_renderer_t *renderer,
+	    int y, int height)
+{
+    ellipse_row_t row;
+    int x0, x1, in0, in1;
+
+    if (! ellipse_row (&self->shape, y, &row))
+	return CAIRO_STATUS_SUCCESS;
+
+    x0 = MAX (row.x0, self->xmin);
+    x1 = MIN (row.x1, self->xmax);
+    if (x0 >= x1)
+	return CAIRO_STATUS_SUCCESS;
+    in0 = MAX (MIN (row.in0, x1), x0);
+    in1 = MAX (MIN (row.in1, x1), in0);
+
+    row_start (self);
+    ellipse_row_coverage (&self->shape, &row, x0, in0, self->row);
+    row_add_coverage (self, x0, in0, self->row);
+    row_add (self, in0, in1, 255);
+    ellipse_row_coverage (&self->shape, &row, in1, x1, self->row);
+    row_add_coverage (self, in1, x1, self->row);
+
+    return row_emit (self, renderer, y, height);
+}
+
+static void
+row_add_view (cairo_ellipse_scan_converter_t *self,
+	      const ellipse_mask_view_t *view,
+	      int y)
+{
+    const uint8_t *coverage;
+    int i, j;
+
+    j = y - view->y;
+    if (view->flip_y)
+	j = view->height - 1 - j;
+    coverage = view->data + j * view->width;
+
+    for (i = 0; i < view->width; i++) {
+	int x = view->x + i;
+
+	row_add (self, x, x + 1,
+		 coverage[view->flip_x ? view->width - 1 - i : i]);
+    }
+}
+
+static inline uint8_t
+edge_alpha (double coverage)
+{
+    return area_to_alpha (MIN (MAX (coverage, 0), 1));
+}
+
+static cairo_status_t
+render_view_rows (cairo_ellipse_scan_converter_t *self,
+		  cairo_span_renderer_t *renderer)
+{
+    const ellipse_mask_view_t *tl = &self->views[0], *tr = &self->views[1];
+    const ellipse_mask_view_t *bl = &self->views[2], *br = &self->views[3];
+    cairo_status_t status;
+    int x, y, y_end;
+
+    if (self->num_views == 1) {
+	y = MAX (self->ymin, tl->y);
+	y_end = MIN (self->ymax, tl->y + tl->height);
+	for (; y < y_end; y++) {
+	    row_start (self);
+	    row_add_view (self, tl, y);
+	    status = row_emit (self, renderer, y, 1);
+	    if (unlikely (status))
+		return status;
+	}
+
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    /* The corners, with the straight top and bottom edges between. */
+    for (y = tl->y; y < tl->y + tl->height; y++) {
+	if (y < self->ymin || y >= self->ymax)
+	    continue;
+
+	row_start (self);
+	row_add_view (self, tl, y);
+	row_add (self, tl->x + tl->width, tr->x,
+		 edge_alpha (y + 1 - self->top));
+	row_add_view (self, tr, y);
+	status = row_emit (self, renderer, y, 1);
+	if (unlikely (status))
+	    return status;
+    }
+
+    /* The rows between the corners, all alike. */
+    y = MAX (self->ymin, tl->y + tl->height);
+    y_end = MIN (self->ymax, bl->y);
+    if (y < y_end) {
+	row_start (self);
+	x = floor (self->left);
+	row_add (self, x, x + 1, edge_alpha (x + 1 - self->left));
+	row_add (self, x + 1, floor (self->right), 255);
+	x = floor (self->right);
+	row_add (self, x, x + 1, edge_alpha (self->right - x));
+	status = row_emit (self, renderer, y, y_end - y);
+	if (unlikely (status))
+	    return status;
+    }
+
+    for (y = bl->y; y < bl->y + bl->height; y++) {
+	if (y < self->ymin || y >= self->ymax)
+	    continue;
+
+	row_start (self);
+	row_add_view (self, bl, y);
+	row_add (self, bl->x + bl->width, br->x,
+		 edge_alpha (self->bottom - y));
+	row_add_view (self, br, y);
+	status = row_emit (self, renderer, y, 1);
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_ellipse_scan_converter_generate (void			*converter,
+					cairo_span_renderer_t	*renderer)
+{
+    cairo_ellipse_scan_converter_t *self = converter;
+    const rounded_box_t *shape = &self->shape;
+    cairo_status_t status;
+    int y, y_end, y_straight, y_straight_end;
+
+    if (self->num_views) {
+	status = render_view_rows (self, renderer);
+	if (unlikely (status))
+	    return _cairo_scan_converter_set_error (self, status);
+
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    /* The rows wholly between the straight sides are alike. */
+    y_straight = ceil (shape->cy - shape->hy);
+    y_straight_end = floor (shape->cy + shape->hy);
+    if (y_straight_end - y_straight < 2)
+	y_straight = y_straight_end = INT_MIN;
+
+    y = MAX (self->ymin, (int) floor (shape->cy - shape->hy - shape->ry));
+    y_end = MIN (self->ymax, (int) ceil (shape->cy + shape->hy + shape->ry));
+    while (y < y_end) {
+	int height = 1;
+
+	if (y >= y_straight && y < y_straight_end)
+	    height = MIN (y_straight_end, y_end) - y;
+
+	status = render_row (self, renderer, y, height);
+	if (unlikely (status))
+	    return _cairo_scan_converter_set_error (self, status);
+
+	y += height;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_bool_t
+_cairo_ellipse_mask_equal (const void *key_a, const void *key_b)
+{
+    const cairo_ellipse_mask_t *a = key_a, *b = key_b;
+
+    return a->rx == b->rx && a->ry == b->ry &&
+	   a->phase_x == b->phase_x && a->phase_y == b->phase_y &&
+	   a->corner == b->corner;
+}
+
+static void
+_cairo_ellipse_mask_render (cairo_ellipse_mask_t *mask)
+{
+    rounded_box_t shape;
+    int r;
+
+    shape.rx = mask->rx / 512.;
+    shape.ry = mask->ry / 512.;
+    if (mask->corner) {
+	/* A box extending well beyond the mask to the right and below. */
+	r = (mask->rx + 511) >> 9;
+	shape.hx = ELLIPSE_MASK_SIZE;
+	shape.cx = r + (double) mask->phase_x / ELLIPSE_MASK_PHASES + shape.hx;
+	r = (mask->ry + 511) >> 9;
+	shape.hy = ELLIPSE_MASK_SIZE;
+	shape.cy = r + (double) mask->phase_y / ELLIPSE_MASK_PHASES + shape.hy;
+    } else {
+	shape.hx = shape.hy = 0;
+	shape.cx = mask->width / 2 - 1 + (double) mask->phase_x / ELLIPSE_MASK_PHASES;
+	shape.cy = mask->height / 2 - 1 + (double) mask->phase_y / ELLIPSE_MASK_PHASES;
+    }
+
+    rounded_box_render_mask (&shape, mask->data, mask->width, mask->height);
+}
+
+/* Copies out the mask for the key into data, rendering it and adding
+ * it to the cache if it was not already there. */
+static void
+_cairo_ellipse_mask_lookup (cairo_ellipse_mask_t *key, uint8_t *data)
+{
+    cairo_ellipse_mask_t *mask;
+    unsigned long hash;
+
+    hash = _CAIRO_HASH_INIT_VALUE;
+    hash = _cairo_hash_bytes (hash, &key->rx, sizeof (key->rx));
+    hash = _cairo_hash_bytes (hash, &key->ry, sizeof (key->ry));
+    hash = _cairo_hash_bytes (hash, &key->phase_x, sizeof (key->phase_x));
+    hash = _cairo_hash_bytes (hash, &key->phase_y, sizeof (key->phase_y));
+    hash = _cairo_hash_bytes (hash, &key->corner, sizeof (key->corner));
+    key->base.hash = hash;
+    key->data = data;
+
+    CAIRO_MUTEX_LOCK (_cairo_ellipse_mask_cache_mutex);
+    if (unlikely (ellipse_mask_cache.hash_table == NULL)) {
+	if (_cairo_cache_init (&ellipse_mask_cache,
+			       _cairo_ellipse_mask_equal,
+			       NULL,
+			       free,
+			       ELLIPSE_MASK_CACHE_SIZE))
+	{
+	    ellipse_mask_cache.hash_table = NULL;
+	}
+    }
+    mask = NULL;
+    if (ellipse_mask_cache.hash_table != NULL)
+	mask = _cairo_cache_lookup (&ellipse_mask_cache, &key->base);
+    if (mask != NULL)
+	memcpy (data, mask->data, mask->width * mask->height);
+    CAIRO_MUTEX_UNLOCK (_cairo_ellipse_mask_cache_mutex);
+    if (mask != NULL)
+	return;
+
+    mask = _cairo_malloc (sizeof (cairo_ellipse_mask_t) +
+			  key->width * key->height);
+    if (unlikely (mask == NULL)) {
+	/* Render it just this once. */
+	_cairo_ellipse_mask_render (key);
+	return;
+    }
+
+    *mask = *key;
+    mask->base.size = key->width * key->height;
+    mask->data = (uint8_t *) (mask + 1);
+    _cairo_ellipse_mask_render (mask);
+    memcpy (data, mask->data, mask->base.size);
+
+    CAIRO_MUTEX_LOCK (_cairo_ellipse_mask_cache_mutex);
+    if (ellipse_mask_cache.hash_table == NULL ||
+	_cairo_cache_insert (&ellipse_mask_cache, &mask->base))
+	free (mask);
+    CAIRO_MUTEX_UNLOCK (_cairo_ellipse_mask_cache_mutex);
+}
+
+/* Rounds the centre of a small ellipse to the mask phase and copies its
+ * whole coverage from the cache. */
+static void
+_cairo_ellipse_scan_converter_init_ellipse_mask (cairo_ellipse_scan_converter_t *self)
+{
+    ellipse_mask_view_t *view = &self->views[0];
+    cairo_ellipse_mask_t key;
+    int cx, cy, r;
+
+    key.rx = _cairo_lround (self->shape.rx * 512);
+    key.ry = _cairo_lround (self->shape.ry * 512);
+    key.corner = FALSE;
+
+    cx = _cairo_lround (self->shape.cx * ELLIPSE_MASK_PHASES);
+    cy = _cairo_lround (self->shape.cy * ELLIPSE_MASK_PHASES);
+    key.phase_x = cx & (ELLIPSE_MASK_PHASES - 1);
+    key.phase_y = cy & (ELLIPSE_MASK_PHASES - 1);
+
+    /* The ellipse lies within its radius, rounded up, of the pixel
+     * containing its centre. */
+    r = (key.rx + 511) >> 9;
+    key.width = 2 * r + 2;
+    view->x = (cx >> ELLIPSE_MASK_PHASE_BITS) - r;
+    r = (key.ry + 511) >> 9;
+    key.height = 2 * r + 2;
+    view->y = (cy >> ELLIPSE_MASK_PHASE_BITS) - r;
+
+    view->width = key.width;
+    view->height = key.height;
+    view->flip_x = view->flip_y = FALSE;
+    view->data = self->mask;
+    _cairo_ellipse_mask_lookup (&key, self->mask);
+
+    self->num_views = 1;
+}
+
+/* Rounds the centre of a corner to the mask phase, returning the
+ * position of its first pixel.  Corners on the right or at the bottom
+ * are mirrored, so the phase is taken of the reflected centre. */
+static int
+corner_position (double c, int r, cairo_bool_t mirrored,
+		 int *phase, double *rounded)
+{
+    int phased;
+
+    if (mirrored) {
+	phased = _cairo_lround (-c * ELLIPSE_MASK_PHASES);
+	*phase = phased & (ELLIPSE_MASK_PHASES - 1);
+	*rounded = -phased / (double) ELLIPSE_MASK_PHASES;
+	return -(phased >> ELLIPSE_MASK_PHASE_BITS) - 1;
+    } else {
+	phased = _cairo_lround (c * ELLIPSE_MASK_PHASES);
+	*phase = phased & (ELLIPSE_MASK_PHASES - 1);
+	*rounded = phased / (double) ELLIPSE_MASK_PHASES;
+	return (phased >> ELLIPSE_MASK_PHASE_BITS) - r;
+    }
+}
+
+/* Rounds the corners of a small rounded box to the mask phase and copies
+ * their coverage from the cache.  The corners must be far enough apart
+ * that none of their pixels are shared, or the box is left to be
+ * computed row by row. */
+static void
+_cairo_ellipse_scan_converter_init_corner_masks (cairo_ellipse_scan_converter_t *self)
+{
+    const rounded_box_t *shape = &self->shape;
+    cairo_ellipse_mask_t key;
+    int x[2], y[2], phase_x[2], phase_y[2];
+    double cx[2], cy[2];
+    int rx, ry, i;
+
+    key.rx = _cairo_lround (shape->rx * 512);
+    key.ry = _cairo_lround (shape->ry * 512);
+    key.corner = TRUE;
+    rx = (key.rx + 511) >> 9;
+    ry = (key.ry + 511) >> 9;
+    key.width = rx + 1;
+    key.height = ry + 1;
+
+    for (i = 0; i < 2; i++) {
+	x[i] = corner_position (shape->cx + (i ? shape->hx : -shape->hx),
+				rx, i, &phase_x[i], &cx[i]);
+	y[i] = corner_position (shape->cy + (i ? shape->hy : -shape->hy),
+				ry, i, &phase_y[i], &cy[i]);
+    }
+    if (x[0] + key.width > x[1] || y[0] + key.height > y[1])
+	return;
+
+    for (i = 0; i < 4; i++) {
+	ellipse_mask_view_t *view = &self->views[i];
+	uint8_t *data = self->mask + i * key.width * key.height;
+
+	view->flip_x = i & 1;
+	view->flip_y = i >> 1;
+	view->x = x[view->flip_x];
+	view->y = y[view->flip_y];
+	view->width = key.width;
+	view->height = key.height;
+	view->data = data;
+
+	key.phase_x = phase_x[view->flip_x];
+	key.phase_y = phase_y[view->flip_y];
+	_cairo_ellipse_mask_lookup (&key, data);
+    }
+
+    self->left = cx[0] - shape->rx;
+    self->right = cx[1] + shape->rx;
+    self->top = cy[0] - shape->ry;
+    self->bottom = cy[1] + shape->ry;
+    self->num_views = 4;
+}
+
+void
+_cairo_ellipse_scan_converter_reset_static_data (void)
+{
+    CAIRO_MUTEX_LOCK (_cairo_ellipse_mask_cache_mutex);
+    if (ellipse_mask_cache.hash_table != NULL) {
+	_cairo_cache_fini (&ellipse_mask_cache);
+	ellipse_mask_cache.hash_table = NULL;
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_ellipse_mask_cache_mutex);
+}
+
+cairo_status_t
+_cairo_ellipse_scan_converter_add_ellipse (void		*converter,
+					   double	 cx,
+					   double	 cy,
+					   double	 rx,
+					   double	 ry)
+{
+    cairo_ellipse_scan_converter_t *self = converter;
+
+    if (unlikely (self->base.status))
+	return self->base.status;
+
+    self->shape.cx = cx;
+    self->shape.cy = cy;
+    self->shape.hx = self->shape.hy = 0;
+    self->shape.rx = rx;
+    self->shape.ry = ry;
+
+    if (rx <= ELLIPSE_MASK_MAX_RADIUS && ry <= ELLIPSE_MASK_MAX_RADIUS)
+	_cairo_ellipse_scan_converter_init_ellipse_mask (self);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+cairo_status_t
+_cairo_ellipse_scan_converter_add_rounded_box (void		 *converter,
+					       const cairo_box_t *box,
+					       double		  rx,
+					       double		  ry)
+{
+    cairo_ellipse_scan_converter_t *self = converter;
+    double x1, y1, x2, y2;
+
+    if (unlikely (self->base.status))
+	return self->base.status;
+
+    x1 = _cairo_fixed_to_double (box->p1.x);
+    y1 = _cairo_fixed_to_double (box->p1.y);
+    x2 = _cairo_fixed_to_double (box->p2.x);
+    y2 = _cairo_fixed_to_double (box->p2.y);
+
+    self->shape.cx = (x1 + x2) / 2;
+    self->shape.cy = (y1 + y2) / 2;
+    self->shape.rx = rx;
+    self->shape.ry = ry;
+    self->shape.hx = MAX ((x2 - x1) / 2 - rx, 0);
+    self->shape.hy = MAX ((y2 - y1) / 2 - ry, 0);
+
+    if (rx <= ELLIPSE_MASK_MAX_RADIUS && ry <= ELLIPSE_MASK_MAX_RADIUS)
+	_cairo_ellipse_scan_converter_init_corner_masks (self);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_ellipse_scan_converter_destroy (void *converter)
+{
+    cairo_ellipse_scan_converter_t *self = converter;
+
+    if (self->row != self->row_embedded)
+	free (self->row);
+    if (self->spans != self->spans_embedded)
+	free (self->spans);
+    free (self);
+}
+
+cairo_scan_converter_t *
+_cairo_ellipse_scan_converter_create (int	xmin,
+				      int	ymin,
+				      int	xmax,
+				      int	ymax)
+{
+    cairo_ellipse_scan_converter_t *self;
+    cairo_status_t status;
+
+    self = _cairo_malloc (sizeof (cairo_ellipse_scan_converter_t));
+    if (unlikely (self == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto bail_nomem;
+    }
+
+    self->base.destroy = _cairo_ellipse_scan_converter_destroy;
+    self->base.generate = _cairo_ellipse_scan_converter_generate;
+    self->base.status = CAIRO_STATUS_SUCCESS;
+
+    self->xmin = xmin;
+    self->ymin = ymin;
+    self->xmax = xmax;
+    self->ymax = ymax;
+    self->width = MAX (xmax - xmin, 0);
+
+    memset (&self->shape, 0, sizeof (self->shape));
+    self->num_views = 0;
+
+    self->row = self->row_embedded;
+    self->spans = self->spans_embedded;
+
+    if (self->width > ARRAY_LENGTH (self->row_embedded)) {
+	self->row = _cairo_malloc (self->width);
+	if (unlikely (self->row == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+
+    if (self->width + 2 > ARRAY_LENGTH (self->spans_embedded)) {
+	self->spans = _cairo_malloc_ab (self->width + 2,
+					sizeof (cairo_half_open_span_t));
+	if (unlikely (self->spans == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+
+    return &self->base;
+
+ bail:
+    self->base.destroy (&self->base);
+ bail_nomem:
+    return _cairo_scan_converter_create_in_error (status);
+}
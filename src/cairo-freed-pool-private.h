@@ -95,11 +95,12 @@ _freed_pool_get (freed_pool_t *pool)
     return _freed_pool_get_search (pool);
 }
 
-cairo_private void
-_freed_pool_put_search (freed_pool_t *pool, void *ptr);
+cairo_private cairo_bool_t
+_freed_pool_try_put_search (freed_pool_t *pool, void *ptr);
 
-static inline void
-_freed_pool_put (freed_pool_t *pool, void *ptr)
+/* Returns FALSE, leaving ptr to the caller, if the pool is full. */
+static inline cairo_bool_t
+_freed_pool_try_put (freed_pool_t *pool, void *ptr)
 {
     int i;
 
@@ -108,11 +109,18 @@ _freed_pool_put (freed_pool_t *pool, void *ptr)
 		_atomic_store (&pool->pool[i], ptr)))
     {
 	_cairo_atomic_int_set_relaxed (&pool->top, i + 1);
-	return;
+	return TRUE;
     }
 
     /* either full or contended */
-    _freed_pool_put_search (pool, ptr);
+    return _freed_pool_try_put_search (pool, ptr);
+}
+
+static inline void
+_freed_pool_put (freed_pool_t *pool, void *ptr)
+{
+    if (! _freed_pool_try_put (pool, ptr))
+	free (ptr);
 }
 
 cairo_private void
@@ -129,6 +137,7 @@ _freed_pool_reset (freed_pool_t *pool);
 typedef int freed_pool_t;
 
 #define _freed_pool_get(pool) NULL
+#define _freed_pool_try_put(pool, ptr) FALSE
 #define _freed_pool_put(pool, ptr) free(ptr)
 #define _freed_pool_reset(ptr)
 
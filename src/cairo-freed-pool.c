@@ -60,21 +60,21 @@ _freed_pool_get_search (freed_pool_t *pool)
     return NULL;
 }
 
-void
-_freed_pool_put_search (freed_pool_t *pool, void *ptr)
+cairo_bool_t
+_freed_pool_try_put_search (freed_pool_t *pool, void *ptr)
 {
     int i;
 
     for (i = 0; i < ARRAY_LENGTH (pool->pool); i++) {
 	if (_atomic_store (&pool->pool[i], ptr)) {
 	    _cairo_atomic_int_set_relaxed (&pool->top, i + 1);
-	    return;
+	    return TRUE;
 	}
     }
 
     /* full */
     _cairo_atomic_int_set_relaxed (&pool->top, i);
-    free (ptr);
+    return FALSE;
 }
 
 void
@@ -263,6 +263,22 @@ _cairo_gstate_stroke (cairo_gstate_t *gstate, cairo_path_fixed_t *path);
 cairo_private cairo_status_t
 _cairo_gstate_fill (cairo_gstate_t *gstate, cairo_path_fixed_t *path);
 
+cairo_private cairo_status_t
+_cairo_gstate_prepare_fill (cairo_gstate_t	  *gstate,
+			    cairo_path_fixed_t	  *path,
+			    cairo_prepared_path_t *prepared);
+
+cairo_private cairo_status_t
+_cairo_gstate_fill_prepared (cairo_gstate_t		 *gstate,
+			     const cairo_prepared_path_t *prepared);
+
+cairo_private cairo_status_t
+_cairo_gstate_fill_instances (cairo_gstate_t	    *gstate,
+			      const cairo_path_t    *path,
+			      const cairo_matrix_t  *transforms,
+			      const double	    *colors,
+			      int		     num_instances);
+
 cairo_private cairo_status_t
 _cairo_gstate_copy_page (cairo_gstate_t *gstate);
 
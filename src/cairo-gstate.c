@@ -43,6 +43,7 @@
 #include "cairo-list-inline.h"
 #include "cairo-gstate-private.h"
 #include "cairo-pattern-private.h"
+#include "cairo-prepared-path-private.h"
 #include "cairo-traps-private.h"
 
 static cairo_status_t
@@ -1256,8 +1257,11 @@ BAIL:
     return status;
 }
 
-cairo_status_t
-_cairo_gstate_fill (cairo_gstate_t *gstate, cairo_path_fixed_t *path)
+static cairo_status_t
+_cairo_gstate_fill_path (cairo_gstate_t		  *gstate,
+			 const cairo_path_fixed_t *path,
+			 cairo_fill_rule_t	   fill_rule,
+			 double			   tolerance)
 {
     cairo_status_t status;
 
@@ -1311,8 +1315,8 @@ _cairo_gstate_fill (cairo_gstate_t *gstate, cairo_path_fixed_t *path)
 	{
 	    status = _cairo_surface_fill (gstate->target, op, pattern,
 					  path,
-					  gstate->fill_rule,
-					  gstate->tolerance,
+					  fill_rule,
+					  tolerance,
 					  gstate->antialias,
 					  gstate->clip);
 	}
@@ -1321,6 +1325,407 @@ _cairo_gstate_fill (cairo_gstate_t *gstate, cairo_path_fixed_t *path)
     return status;
 }
 
+cairo_status_t
+_cairo_gstate_fill (cairo_gstate_t *gstate, cairo_path_fixed_t *path)
+{
+    return _cairo_gstate_fill_path (gstate, path,
+				    gstate->fill_rule,
+				    gstate->tolerance);
+}
+
+static void
+_cairo_gstate_get_user_to_backend (cairo_gstate_t *gstate,
+				   cairo_matrix_t *matrix)
+{
+    cairo_matrix_multiply (matrix,
+			   &gstate->ctm,
+			   &gstate->target->device_transform);
+}
+
+cairo_status_t
+_cairo_gstate_prepare_fill (cairo_gstate_t	  *gstate,
+			    cairo_path_fixed_t	  *path,
+			    cairo_prepared_path_t *prepared)
+{
+    cairo_matrix_t matrix;
+
+    _cairo_gstate_get_user_to_backend (gstate, &matrix);
+    return _cairo_prepared_path_set_device_path (prepared, path, &matrix);
+}
+
+static void
+_cairo_gstate_point_from_user (cairo_gstate_t	    *gstate,
+			       const cairo_matrix_t *transform,
+			       const cairo_path_data_t *data,
+			       cairo_point_t	    *point)
+{
+    double x = data->point.x, y = data->point.y;
+
+    if (transform != NULL)
+	cairo_matrix_transform_point (transform, &x, &y);
+    _cairo_gstate_user_to_backend (gstate, &x, &y);
+    point->x = _cairo_fixed_from_double (x);
+    point->y = _cairo_fixed_from_double (y);
+}
+
+/* Converts @user_path to device space, as it would be if appended to
+ * the context after applying @transform, if any, with cairo_transform(). */
+static cairo_status_t
+_cairo_gstate_path_from_user (cairo_gstate_t	   *gstate,
+			      const cairo_matrix_t *transform,
+			      const cairo_path_t   *user_path,
+			      cairo_path_fixed_t   *path)
+{
+    const cairo_path_data_t *p, *end;
+    cairo_point_t points[3];
+    cairo_status_t status;
+
+    end = user_path->data + user_path->num_data;
+    for (p = user_path->data; p < end; p += p->header.length) {
+	switch (p->header.type) {
+	case CAIRO_PATH_MOVE_TO:
+	    if (unlikely (p->header.length < 2))
+		return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	    _cairo_gstate_point_from_user (gstate, transform, &p[1], &points[0]);
+	    status = _cairo_path_fixed_move_to (path,
+						points[0].x, points[0].y);
+	    break;
+
+	case CAIRO_PATH_LINE_TO:
+	    if (unlikely (p->header.length < 2))
+		return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	    _cairo_gstate_point_from_user (gstate, transform, &p[1], &points[0]);
+	    status = _cairo_path_fixed_line_to (path,
+						points[0].x, points[0].y);
+	    break;
+
+	case CAIRO_PATH_CURVE_TO:
+	    if (unlikely (p->header.length < 4))
+		return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	    _cairo_gstate_point_from_user (gstate, transform, &p[1], &points[0]);
+	    _cairo_gstate_point_from_user (gstate, transform, &p[2], &points[1]);
+	    _cairo_gstate_point_from_user (gstate, transform, &p[3], &points[2]);
+	    status = _cairo_path_fixed_curve_to (path,
+						 points[0].x, points[0].y,
+						 points[1].x, points[1].y,
+						 points[2].x, points[2].y);
+	    break;
+
+	case CAIRO_PATH_CLOSE_PATH:
+	    if (unlikely (p->header.length < 1))
+		return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+
+	    status = _cairo_path_fixed_close_path (path);
+	    break;
+
+	default:
+	    return _cairo_error (CAIRO_STATUS_INVALID_PATH_DATA);
+	}
+
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+cairo_status_t
+_cairo_gstate_fill_prepared (cairo_gstate_t		 *gstate,
+			     const cairo_prepared_path_t *prepared)
+{
+    cairo_path_fixed_t path;
+    cairo_matrix_t matrix;
+    cairo_fixed_t offx, offy;
+    cairo_status_t status;
+
+    _cairo_gstate_get_user_to_backend (gstate, &matrix);
+    if (_cairo_prepared_path_get_offset (prepared, &matrix, &offx, &offy)) {
+	if (offx == 0 && offy == 0) {
+	    return _cairo_gstate_fill_path (gstate, &prepared->device_path,
+					    prepared->fill_rule,
+					    prepared->tolerance);
+	}
+
+	status = _cairo_path_fixed_init_translated (&path,
+						    &prepared->device_path,
+						    offx, offy);
+	if (unlikely (status))
+	    return status;
+    } else {
+	/* Transformed otherwise than when it was prepared: start afresh
+	 * from the user's path, just as cairo_append_path() would. */
+	_cairo_path_fixed_init (&path);
+	status = _cairo_gstate_path_from_user (gstate, NULL,
+					       prepared->user_path,
+					       &path);
+	if (unlikely (status)) {
+	    _cairo_path_fixed_fini (&path);
+	    return status;
+	}
+    }
+
+    status = _cairo_gstate_fill_path (gstate, &path,
+				      prepared->fill_rule,
+				      prepared->tolerance);
+    _cairo_path_fixed_fini (&path);
+
+    return status;
+}
+
+/* Instances are stamped from masks rasterized at a quarter pixel
+ * resolution, so each mask serves every instance of the same shape
+ * that lands in the same sub-pixel phase. */
+#define INSTANCE_PHASES 4
+#define INSTANCE_MASK_CACHE_SIZE 16
+#define INSTANCE_MASK_MAX_PIXELS (256 * 256)
+
+typedef struct _cairo_instance_mask {
+    double xx, yx, xy, yy;
+    int phase_x, phase_y;
+
+    /* NULL for shapes too large to be worth stamping, or empty. */
+    cairo_surface_t *mask;
+    cairo_bool_t is_empty;
+    int x, y;
+} cairo_instance_mask_t;
+
+static cairo_status_t
+_cairo_gstate_fill_instance (cairo_gstate_t		*gstate,
+			     cairo_operator_t		 op,
+			     const cairo_pattern_t	*pattern,
+			     const cairo_path_t		*user_path,
+			     const cairo_matrix_t	*transform)
+{
+    cairo_path_fixed_t path;
+    cairo_status_t status;
+
+    _cairo_path_fixed_init (&path);
+    status = _cairo_gstate_path_from_user (gstate, transform,
+					   user_path, &path);
+    if (likely (status == CAIRO_STATUS_SUCCESS)) {
+	status = _cairo_surface_fill (gstate->target, op, pattern,
+				      &path,
+				      gstate->fill_rule,
+				      gstate->tolerance,
+				      gstate->antialias,
+				      gstate->clip);
+    }
+    _cairo_path_fixed_fini (&path);
+
+    return status;
+}
+
+static cairo_status_t
+_cairo_instance_mask_init (cairo_instance_mask_t *entry,
+			   cairo_gstate_t	 *gstate,
+			   const cairo_path_t	 *user_path,
+			   const cairo_matrix_t	 *transform,
+			   const cairo_matrix_t	 *m,
+			   double x, double y)
+{
+    cairo_path_fixed_t path;
+    cairo_rectangle_int_t extents;
+    cairo_status_t status;
+
+    entry->mask = NULL;
+    entry->is_empty = FALSE;
+
+    /* Rasterize the shape where this instance falls, snapped to its
+     * phase, and place the mask relative to the whole pixel it is in. */
+    _cairo_path_fixed_init (&path);
+    status = _cairo_gstate_path_from_user (gstate, transform,
+					   user_path, &path);
+    if (unlikely (status))
+	goto BAIL;
+
+    _cairo_path_fixed_translate (&path,
+				 _cairo_fixed_from_double (x - m->x0),
+				 _cairo_fixed_from_double (y - m->y0));
+    _cairo_path_fixed_approximate_fill_extents (&path, &extents);
+    if (extents.width == 0 || extents.height == 0) {
+	entry->is_empty = TRUE;
+	goto BAIL;
+    }
+    if (extents.width * (int64_t) extents.height > INSTANCE_MASK_MAX_PIXELS)
+	goto BAIL;
+
+    entry->x = extents.x - (int) floor (x);
+    entry->y = extents.y - (int) floor (y);
+    _cairo_path_fixed_translate (&path,
+				 _cairo_fixed_from_int (-extents.x),
+				 _cairo_fixed_from_int (-extents.y));
+
+    entry->mask = _cairo_surface_create_scratch (gstate->target,
+						 CAIRO_CONTENT_ALPHA,
+						 extents.width,
+						 extents.height,
+						 CAIRO_COLOR_TRANSPARENT);
+    status = entry->mask->status;
+    if (unlikely (status))
+	goto BAIL;
+
+    status = _cairo_surface_fill (entry->mask,
+				  CAIRO_OPERATOR_ADD,
+				  &_cairo_pattern_white.base,
+				  &path,
+				  gstate->fill_rule,
+				  gstate->tolerance,
+				  gstate->antialias,
+				  NULL);
+
+BAIL:
+    _cairo_path_fixed_fini (&path);
+    if (unlikely (status)) {
+	cairo_surface_destroy (entry->mask);
+	entry->mask = NULL;
+    }
+    return status;
+}
+
+cairo_status_t
+_cairo_gstate_fill_instances (cairo_gstate_t	    *gstate,
+			      const cairo_path_t    *path,
+			      const cairo_matrix_t  *transforms,
+			      const double	    *colors,
+			      int		     num_instances)
+{
+    cairo_instance_mask_t cache[INSTANCE_MASK_CACHE_SIZE];
+    int num_cached = 0, next_evict = 0;
+    cairo_pattern_union_t source_pattern;
+    cairo_solid_pattern_t solid;
+    const cairo_pattern_t *pattern;
+    cairo_matrix_t user_to_backend;
+    cairo_operator_t op;
+    cairo_bool_t stamp;
+    cairo_status_t status;
+    int i, n;
+
+    status = _cairo_gstate_get_pattern_status (gstate->source);
+    if (unlikely (status))
+	return status;
+
+    if (gstate->op == CAIRO_OPERATOR_DEST)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (_cairo_clip_is_all_clipped (gstate->clip))
+	return CAIRO_STATUS_SUCCESS;
+
+    assert (gstate->opacity == 1.0);
+
+    if (colors == NULL) {
+	op = _reduce_op (gstate);
+	if (op == CAIRO_OPERATOR_CLEAR) {
+	    pattern = &_cairo_pattern_clear.base;
+	} else {
+	    _cairo_gstate_copy_transformed_source (gstate, &source_pattern.base);
+	    pattern = &source_pattern.base;
+	}
+    } else {
+	op = gstate->op;
+	pattern = &solid.base;
+    }
+
+    /* Vector surfaces, and the recording surfaces behind groups and
+     * paginated output, are given each instance as a fill of its own;
+     * so are operators that would clear beyond each instance. */
+    stamp = ! gstate->target->is_vector &&
+	    _cairo_operator_bounded_by_mask (op);
+
+    _cairo_gstate_get_user_to_backend (gstate, &user_to_backend);
+
+    for (i = 0; i < num_instances; i++) {
+	cairo_instance_mask_t *entry;
+	cairo_surface_pattern_t mask;
+	cairo_matrix_t m;
+	double x, y;
+	int phase_x, phase_y;
+
+	if (colors != NULL) {
+	    cairo_color_t color;
+
+	    _cairo_color_init_rgba (&color,
+				    _cairo_restrict_value (colors[4*i + 0], 0.0, 1.0),
+				    _cairo_restrict_value (colors[4*i + 1], 0.0, 1.0),
+				    _cairo_restrict_value (colors[4*i + 2], 0.0, 1.0),
+				    _cairo_restrict_value (colors[4*i + 3], 0.0, 1.0));
+	    _cairo_pattern_init_solid (&solid, &color);
+	}
+
+	if (! stamp) {
+	    status = _cairo_gstate_fill_instance (gstate, op, pattern,
+						  path, &transforms[i]);
+	    if (unlikely (status))
+		break;
+	    continue;
+	}
+
+	cairo_matrix_multiply (&m, &transforms[i], &user_to_backend);
+	x = floor (m.x0 * INSTANCE_PHASES + .5) / INSTANCE_PHASES;
+	y = floor (m.y0 * INSTANCE_PHASES + .5) / INSTANCE_PHASES;
+	phase_x = (x - floor (x)) * INSTANCE_PHASES;
+	phase_y = (y - floor (y)) * INSTANCE_PHASES;
+
+	entry = NULL;
+	for (n = 0; n < num_cached; n++) {
+	    if (cache[n].phase_x == phase_x && cache[n].phase_y == phase_y &&
+		cache[n].xx == m.xx && cache[n].yx == m.yx &&
+		cache[n].xy == m.xy && cache[n].yy == m.yy)
+	    {
+		entry = &cache[n];
+		break;
+	    }
+	}
+	if (entry == NULL) {
+	    if (num_cached < INSTANCE_MASK_CACHE_SIZE) {
+		entry = &cache[num_cached++];
+	    } else {
+		entry = &cache[next_evict];
+		next_evict = (next_evict + 1) % INSTANCE_MASK_CACHE_SIZE;
+		cairo_surface_destroy (entry->mask);
+	    }
+
+	    entry->xx = m.xx; entry->yx = m.yx;
+	    entry->xy = m.xy; entry->yy = m.yy;
+	    entry->phase_x = phase_x;
+	    entry->phase_y = phase_y;
+	    status = _cairo_instance_mask_init (entry, gstate, path,
+						&transforms[i], &m, x, y);
+	    if (unlikely (status))
+		break;
+	}
+
+	if (entry->is_empty)
+	    continue;
+
+	if (entry->mask == NULL) {
+	    status = _cairo_gstate_fill_instance (gstate, op, pattern,
+						  path, &transforms[i]);
+	    if (unlikely (status))
+		break;
+	    continue;
+	}
+
+	_cairo_pattern_init_for_surface (&mask, entry->mask);
+	mask.base.filter = CAIRO_FILTER_NEAREST;
+	cairo_matrix_init_translate (&mask.base.matrix,
+				     -(floor (x) + entry->x),
+				     -(floor (y) + entry->y));
+	status = _cairo_surface_mask (gstate->target, op, pattern,
+				      &mask.base, gstate->clip);
+	_cairo_pattern_fini (&mask.base);
+	if (unlikely (status))
+	    break;
+    }
+
+    for (n = 0; n < num_cached; n++)
+	cairo_surface_destroy (cache[n].mask);
+
+    return status;
+}
+
 cairo_bool_t
 _cairo_gstate_in_fill (cairo_gstate_t	  *gstate,
 		       cairo_path_fixed_t *path,
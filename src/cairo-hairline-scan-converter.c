@@ -0,0 +1,453 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/*
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* A scan converter for strokes no wider than a pixel.
+ *
+ * Rather than widening the path into a polygon and filling that, each
+ * flattened segment is drawn directly in the manner of Wu's lines:
+ * stepping along its major axis one pixel at a time, the coverage of
+ * the line is split between the two pixels straddling its centre on
+ * the minor axis.  The coverage deposited per step is the area of the
+ * line within that pixel column (or row), its width times its length
+ * there, so that diagonal lines are as heavy as straight ones.
+ *
+ * Joins and caps are not drawn, and where segments overlap their
+ * coverage adds up; at this width neither is readily visible, which is
+ * why this converter is only used when speed has been asked for.
+ * Large extents are processed in bands of rows, as by the area
+ * converter.
+ */
+
+#include "cairoint.h"
+#include "cairo-array-private.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-spans-private.h"
+#include "cairo-error-private.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+/* The maximum number of accumulators in a band. */
+#define HAIRLINE_BAND_CELLS	(32*1024)
+
+typedef struct _hairline_segment {
+    double x0, y0, x1, y1;
+    double ymin, ymax;
+    double slope;
+    double coverage;
+    cairo_bool_t x_major;
+} hairline_segment_t;
+
+typedef struct _cairo_hairline_scan_converter {
+    cairo_scan_converter_t base;
+
+    int xmin, ymin, xmax, ymax;
+    int width, height;
+    double line_width;
+
+    cairo_array_t segments;
+    cairo_point_t current_point, last_move_to;
+
+    /* The rows currently being accumulated. */
+    int band_ymin, band_ymax, band_height;
+
+    int32_t *cells;
+    int *row_min, *row_max;
+
+    cairo_half_open_span_t *spans;
+
+    int32_t cells_embedded[1024];
+    int rows_embedded[2*64];
+    cairo_half_open_span_t spans_embedded[64];
+} cairo_hairline_scan_converter_t;
+
+static cairo_status_t
+add_segment (cairo_hairline_scan_converter_t *self,
+	     const cairo_point_t *p1,
+	     const cairo_point_t *p2)
+{
+    hairline_segment_t s;
+    double dx, dy;
+
+    if (p1->x == p2->x && p1->y == p2->y)
+	return CAIRO_STATUS_SUCCESS;
+
+    s.x0 = _cairo_fixed_to_double (p1->x);
+    s.y0 = _cairo_fixed_to_double (p1->y);
+    s.x1 = _cairo_fixed_to_double (p2->x);
+    s.y1 = _cairo_fixed_to_double (p2->y);
+
+    dx = s.x1 - s.x0;
+    dy = s.y1 - s.y0;
+    s.x_major = fabs (dx) >= fabs (dy);
+    if (s.x_major) {
+	if (dx < 0) {
+	    double t;
+
+	    t = s.x0; s.x0 = s.x1; s.x1 = t;
+	    t = s.y0; s.y0 = s.y1; s.y1 = t;
+	}
+	s.slope = dy / dx;
+    } else {
+	if (dy < 0) {
+	    double t;
+
+	    t = s.x0; s.x0 = s.x1; s.x1 = t;
+	    t = s.y0; s.y0 = s.y1; s.y1 = t;
+	}
+	s.slope = dx / dy;
+    }
+    s.ymin = MIN (s.y0, s.y1);
+    s.ymax = MAX (s.y0, s.y1);
+    s.coverage = 256 * self->line_width * sqrt (1 + s.slope * s.slope);
+
+    /* Wu's lines reach up to a pixel beyond the centre line. */
+    if (s.ymax + 1 < self->ymin || s.ymin - 1 >= self->ymax)
+	return CAIRO_STATUS_SUCCESS;
+    if (MAX (s.x0, s.x1) + 1 < self->xmin || MIN (s.x0, s.x1) - 1 >= self->xmax)
+	return CAIRO_STATUS_SUCCESS;
+
+    return _cairo_array_append (&self->segments, &s);
+}
+
+static cairo_status_t
+_hairline_move_to (void *closure, const cairo_point_t *point)
+{
+    cairo_hairline_scan_converter_t *self = closure;
+
+    self->current_point = *point;
+    self->last_move_to = *point;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_hairline_line_to (void *closure, const cairo_point_t *point)
+{
+    cairo_hairline_scan_converter_t *self = closure;
+    cairo_status_t status;
+
+    status = add_segment (self, &self->current_point, point);
+    self->current_point = *point;
+    return status;
+}
+
+static cairo_status_t
+_hairline_close_path (void *closure)
+{
+    cairo_hairline_scan_converter_t *self = closure;
+
+    return _hairline_line_to (self, &self->last_move_to);
+}
+
+cairo_status_t
+_cairo_hairline_scan_converter_add_path (void			*converter,
+					 const cairo_path_fixed_t	*path,
+					 double				 tolerance)
+{
+    cairo_hairline_scan_converter_t *self = converter;
+    cairo_status_t status;
+
+    if (unlikely (self->base.status))
+	return self->base.status;
+
+    status = _cairo_path_fixed_interpret_flat (path,
+					       _hairline_move_to,
+					       _hairline_line_to,
+					       _hairline_close_path,
+					       self,
+					       tolerance);
+    if (unlikely (status))
+	return _cairo_scan_converter_set_error (self, status);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static inline void
+cell_add (cairo_hairline_scan_converter_t *self, int x, int y, double v)
+{
+    x -= self->xmin;
+    y -= self->band_ymin;
+    if ((unsigned) x >= (unsigned) self->width ||
+	(unsigned) y >= (unsigned) (self->band_ymax - self->band_ymin))
+	return;
+
+    self->cells[y * self->width + x] += (int32_t) (v + .5);
+    if (x < self->row_min[y])
+	self->row_min[y] = x;
+    if (x > self->row_max[y])
+	self->row_max[y] = x;
+}
+
+/* Deposits a step of the line centred at @c on the minor axis, split
+ * between the two pixels whose centres straddle it. */
+static inline void
+plot (cairo_hairline_scan_converter_t *self,
+      cairo_bool_t x_major, int major, double c, double v)
+{
+    double f;
+    int minor;
+
+    c -= .5;
+    minor = floor (c);
+    f = c - minor;
+    if (x_major) {
+	cell_add (self, major, minor, v * (1 - f));
+	cell_add (self, major, minor + 1, v * f);
+    } else {
+	cell_add (self, minor, major, v * (1 - f));
+	cell_add (self, minor + 1, major, v * f);
+    }
+}
+
+/* Steps the segment along its major axis from @lo to @hi, which have
+ * already been clipped to the region of interest. */
+static void
+step_segment (cairo_hairline_scan_converter_t *self,
+	      const hairline_segment_t *s,
+	      double a0, double b0, double lo, double hi)
+{
+    int i;
+
+    for (i = floor (lo); i < hi; i++) {
+	double c0 = MAX (lo, i);
+	double c1 = MIN (hi, i + 1);
+	double m;
+
+	if (c1 <= c0)
+	    continue;
+
+	m = (c0 + c1) / 2;
+	plot (self, s->x_major, i, b0 + s->slope * (m - a0),
+	      s->coverage * (c1 - c0));
+    }
+}
+
+static void
+add_band_segment (cairo_hairline_scan_converter_t *self,
+		  const hairline_segment_t *s)
+{
+    double top = self->band_ymin - 1;
+    double bottom = self->band_ymax + 1;
+    double lo, hi;
+
+    if (s->ymax < top || s->ymin >= bottom)
+	return;
+
+    if (s->x_major) {
+	/* Limit the columns to those where the line nears the band. */
+	lo = MAX (s->x0, self->xmin);
+	hi = MIN (s->x1, self->xmax);
+	if (s->slope != 0) {
+	    double xa = s->x0 + (top - s->y0) / s->slope;
+	    double xb = s->x0 + (bottom - s->y0) / s->slope;
+
+	    lo = MAX (lo, MIN (xa, xb));
+	    hi = MIN (hi, MAX (xa, xb));
+	}
+	step_segment (self, s, s->x0, s->y0, lo, hi);
+    } else {
+	lo = MAX (s->y0, self->band_ymin);
+	hi = MIN (s->y1, self->band_ymax);
+	step_segment (self, s, s->y0, s->x0, lo, hi);
+    }
+}
+
+static void
+accumulate_band (cairo_hairline_scan_converter_t *self, int ymin, int ymax)
+{
+    const hairline_segment_t *s;
+    int i, n, y;
+
+    self->band_ymin = ymin;
+    self->band_ymax = ymax;
+
+    memset (self->cells, 0,
+	    self->width * (ymax - ymin) * sizeof (int32_t));
+    for (y = 0; y < ymax - ymin; y++) {
+	self->row_min[y] = INT_MAX;
+	self->row_max[y] = -1;
+    }
+
+    n = _cairo_array_num_elements (&self->segments);
+    if (n == 0)
+	return;
+
+    s = _cairo_array_index_const (&self->segments, 0);
+    for (i = 0; i < n; i++)
+	add_band_segment (self, &s[i]);
+}
+
+static cairo_status_t
+render_band (cairo_hairline_scan_converter_t *self,
+	     cairo_span_renderer_t *renderer)
+{
+    cairo_half_open_span_t *spans = self->spans;
+    int y;
+
+    for (y = 0; y < self->band_ymax - self->band_ymin; y++) {
+	const int32_t *row = self->cells + y * self->width;
+	int x, num_spans;
+	uint8_t last, alpha;
+	cairo_status_t status;
+
+	if (self->row_min[y] > self->row_max[y])
+	    continue;
+
+	last = 0;
+	num_spans = 0;
+	for (x = self->row_min[y]; x <= self->row_max[y]; x++) {
+	    alpha = MIN (row[x], 255);
+	    if (alpha != last) {
+		spans[num_spans].x = self->xmin + x;
+		spans[num_spans].coverage = alpha;
+		last = alpha;
+		num_spans++;
+	    }
+	}
+	if (last) {
+	    spans[num_spans].x = self->xmin + x;
+	    spans[num_spans].coverage = 0;
+	    num_spans++;
+	}
+
+	if (num_spans) {
+	    status = renderer->render_rows (renderer, self->band_ymin + y, 1,
+					    spans, num_spans);
+	    if (unlikely (status))
+		return status;
+	}
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_hairline_scan_converter_generate (void			*converter,
+					 cairo_span_renderer_t	*renderer)
+{
+    cairo_hairline_scan_converter_t *self = converter;
+    cairo_status_t status;
+    int y;
+
+    for (y = self->ymin; y < self->ymax; y += self->band_height) {
+	accumulate_band (self, y, MIN (y + self->band_height, self->ymax));
+
+	status = render_band (self, renderer);
+	if (unlikely (status))
+	    return _cairo_scan_converter_set_error (self, status);
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static void
+_cairo_hairline_scan_converter_destroy (void *converter)
+{
+    cairo_hairline_scan_converter_t *self = converter;
+
+    _cairo_array_fini (&self->segments);
+    if (self->cells != self->cells_embedded)
+	free (self->cells);
+    if (self->row_min != self->rows_embedded)
+	free (self->row_min);
+    if (self->spans != self->spans_embedded)
+	free (self->spans);
+    free (self);
+}
+
+cairo_scan_converter_t *
+_cairo_hairline_scan_converter_create (int	xmin,
+				       int	ymin,
+				       int	xmax,
+				       int	ymax,
+				       double	line_width)
+{
+    cairo_hairline_scan_converter_t *self;
+    cairo_status_t status;
+
+    self = _cairo_malloc (sizeof (cairo_hairline_scan_converter_t));
+    if (unlikely (self == NULL)) {
+	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	goto bail_nomem;
+    }
+
+    self->base.destroy = _cairo_hairline_scan_converter_destroy;
+    self->base.generate = _cairo_hairline_scan_converter_generate;
+    self->base.status = CAIRO_STATUS_SUCCESS;
+
+    self->xmin = xmin;
+    self->ymin = ymin;
+    self->xmax = xmax;
+    self->ymax = ymax;
+    self->width = MAX (xmax - xmin, 0);
+    self->height = MAX (ymax - ymin, 0);
+    self->line_width = MIN (line_width, 1.);
+
+    _cairo_array_init (&self->segments, sizeof (hairline_segment_t));
+    self->current_point.x = self->current_point.y = 0;
+    self->last_move_to = self->current_point;
+
+    self->band_height = MAX (HAIRLINE_BAND_CELLS / MAX (self->width, 1), 1);
+    self->band_height = MIN (self->band_height, self->height);
+
+    self->cells = self->cells_embedded;
+    self->row_min = self->rows_embedded;
+    self->spans = self->spans_embedded;
+
+    if (self->width * self->band_height > ARRAY_LENGTH (self->cells_embedded)) {
+	self->cells = _cairo_malloc_abc (self->band_height, self->width,
+					 sizeof (int32_t));
+	if (unlikely (self->cells == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+
+    if (2 * self->band_height > ARRAY_LENGTH (self->rows_embedded)) {
+	self->row_min = _cairo_malloc_ab (2 * self->band_height, sizeof (int));
+	if (unlikely (self->row_min == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+    self->row_max = self->row_min + self->band_height;
+
+    if (self->width + 1 > ARRAY_LENGTH (self->spans_embedded)) {
+	self->spans = _cairo_malloc_ab (self->width + 1,
+					sizeof (cairo_half_open_span_t));
+	if (unlikely (self->spans == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail;
+	}
+    }
+
+    return &self->base;
+
+ bail:
+    self->base.destroy (&self->base);
+ bail_nomem:
+    return _cairo_scan_converter_create_in_error (status);
+}
@@ -43,7 +43,9 @@
 
 #include "cairoint.h"
 
+#include "cairo-atomic-private.h"
 #include "cairo-image-surface-private.h"
+#include "cairo-parallel-private.h"
 
 #include "cairo-compositor-private.h"
 #include "cairo-spans-compositor-private.h"
@@ -809,42 +811,104 @@ check_composite_glyphs (const cairo_composite_rectangles_t *extents,
 }
 
 #if HAS_PIXMAN_GLYPHS
-static pixman_glyph_cache_t *global_glyph_cache;
+/* Rather than a single pixman glyph cache behind a global mutex, each
+ * rendering thread works out of its own shard, so that threads drawing
+ * text concurrently do not serialise on each other.  The shard mutexes
+ * are then only contended when a glyph is being evicted, as that has
+ * to remove it from every shard.
+ *
+ * pixman_glyph_cache_insert() keeps its own copy of the glyph image,
+ * so a glyph drawn by several threads is stored once per shard they
+ * use.  Shards are only created on first use, and each is capped by
+ * pixman's own limit on the number of cached glyphs, so the cost is
+ * bounded by GLYPH_CACHE_SHARDS times that of the single shared cache
+ * of old.  The count is kept small, with further threads sharing
+ * shards, to hold that bound down and to keep the per-glyph eviction
+ * cheap.
+ */
+#define GLYPH_CACHE_SHARDS 8
+
+typedef struct _cairo_glyph_cache_shard {
+    cairo_mutex_t mutex;
+    pixman_glyph_cache_t *cache;
+} cairo_glyph_cache_shard_t;
+
+static cairo_glyph_cache_shard_t glyph_cache_shards[GLYPH_CACHE_SHARDS];
+
+static void
+glyph_cache_shards_init (void)
+{
+    static cairo_atomic_once_t once = CAIRO_ATOMIC_ONCE_INIT;
+
+    if (_cairo_atomic_init_once_enter (&once)) {
+	int i;
+
+	for (i = 0; i < GLYPH_CACHE_SHARDS; i++) {
+	    CAIRO_MUTEX_INIT (glyph_cache_shards[i].mutex);
+	    glyph_cache_shards[i].cache = NULL;
+	}
+
+	_cairo_atomic_init_once_leave (&once);
+    }
+}
+
+static inline cairo_glyph_cache_shard_t *
+get_glyph_cache_shard (void)
+{
+    glyph_cache_shards_init ();
+    return &glyph_cache_shards[_cairo_parallel_get_thread_slot () %
+			       GLYPH_CACHE_SHARDS];
+}
 
 static inline pixman_glyph_cache_t *
-get_glyph_cache (void)
+get_glyph_cache (cairo_glyph_cache_shard_t *shard)
 {
-    if (!global_glyph_cache)
-	global_glyph_cache = pixman_glyph_cache_create ();
+    if (!shard->cache)
+	shard->cache = pixman_glyph_cache_create ();
 
-    return global_glyph_cache;
+    return shard->cache;
 }
 
 void
 _cairo_image_compositor_reset_static_data (void)
 {
-    CAIRO_MUTEX_LOCK (_cairo_glyph_cache_mutex);
+    int i;
+
+    glyph_cache_shards_init ();
+    for (i = 0; i < GLYPH_CACHE_SHARDS; i++) {
+	cairo_glyph_cache_shard_t *shard = &glyph_cache_shards[i];
 
-    if (global_glyph_cache)
-	pixman_glyph_cache_destroy (global_glyph_cache);
-    global_glyph_cache = NULL;
+	CAIRO_MUTEX_LOCK (shard->mutex);
 
-    CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
+	if (shard->cache)
+	    pixman_glyph_cache_destroy (shard->cache);
+	shard->cache = NULL;
+
+	CAIRO_MUTEX_UNLOCK (shard->mutex);
+    }
 }
 
 void
 _cairo_image_scaled_glyph_fini (cairo_scaled_font_t *scaled_font,
 				cairo_scaled_glyph_t *scaled_glyph)
 {
-    CAIRO_MUTEX_LOCK (_cairo_glyph_cache_mutex);
+    int i;
 
-    if (global_glyph_cache) {
-	pixman_glyph_cache_remove (
-	    global_glyph_cache, scaled_font,
-	    (void *)_cairo_scaled_glyph_index (scaled_glyph));
-    }
+    /* The glyph may have been drawn, and so cached, by any thread */
+    glyph_cache_shards_init ();
+    for (i = 0; i < GLYPH_CACHE_SHARDS; i++) {
+	cairo_glyph_cache_shard_t *shard = &glyph_cache_shards[i];
+
+	CAIRO_MUTEX_LOCK (shard->mutex);
 
-    CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
+	if (shard->cache) {
+	    pixman_glyph_cache_remove (
+		shard->cache, scaled_font,
+		(void *)_cairo_scaled_glyph_index (scaled_glyph));
+	}
+
+	CAIRO_MUTEX_UNLOCK (shard->mutex);
+    }
 }
 
 static cairo_int_status_t
@@ -858,6 +922,7 @@ composite_glyphs (void				*_dst,
 		  cairo_composite_glyphs_info_t *info)
 {
     cairo_int_status_t status = CAIRO_INT_STATUS_SUCCESS;
+    cairo_glyph_cache_shard_t *shard;
     pixman_glyph_cache_t *glyph_cache;
     pixman_glyph_t pglyphs_stack[CAIRO_STACK_ARRAY_LENGTH (pixman_glyph_t)];
     pixman_glyph_t *pglyphs = pglyphs_stack;
@@ -866,9 +931,10 @@ composite_glyphs (void				*_dst,
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
 
-    CAIRO_MUTEX_LOCK (_cairo_glyph_cache_mutex);
+    shard = get_glyph_cache_shard ();
+    CAIRO_MUTEX_LOCK (shard->mutex);
 
-    glyph_cache = get_glyph_cache();
+    glyph_cache = get_glyph_cache (shard);
     if (unlikely (glyph_cache == NULL)) {
 	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
 	goto out_unlock;
@@ -897,11 +963,11 @@ composite_glyphs (void				*_dst,
 	    /* This call can actually end up recursing, so we have to
 	     * drop the mutex around it.
 	     */
-	    CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
+	    CAIRO_MUTEX_UNLOCK (shard->mutex);
 	    status = _cairo_scaled_glyph_lookup (info->font, index,
 						 CAIRO_SCALED_GLYPH_INFO_SURFACE,
 						 &scaled_glyph);
-	    CAIRO_MUTEX_LOCK (_cairo_glyph_cache_mutex);
+	    CAIRO_MUTEX_LOCK (shard->mutex);
 
 	    if (unlikely (status))
 		goto out_thaw;
@@ -953,7 +1019,7 @@ out_thaw:
 	free(pglyphs);
 
 out_unlock:
-    CAIRO_MUTEX_UNLOCK (_cairo_glyph_cache_mutex);
+    CAIRO_MUTEX_UNLOCK (shard->mutex);
     return status;
 }
 #else
@@ -1324,6 +1390,72 @@ _cairo_image_mask_compositor_get (void)
     return &compositor.base;
 }
 
+/* Tally of which span renderer each composite ended up with, so that
+ * workloads falling off the in-place fast paths can be spotted. Kept
+ * and dumped to stderr by cairo_debug_reset_static_data() only when
+ * CAIRO_DEBUG_SPANS is set in the environment.
+ */
+enum {
+    SPAN_RENDERER_MONO,
+    SPAN_RENDERER_FILL,
+    SPAN_RENDERER_BLIT,
+    SPAN_RENDERER_INPLACE,
+    SPAN_RENDERER_INPLACE_SRC,
+    SPAN_RENDERER_MASK,
+    SPAN_RENDERER_UNSUPPORTED,
+    SPAN_RENDERER_NUM
+};
+
+static const char * const span_renderer_names[SPAN_RENDERER_NUM] = {
+    "mono",
+    "fill",
+    "blit",
+    "inplace",
+    "inplace-src",
+    "mask",
+    "unsupported",
+};
+
+static cairo_atomic_int_t span_renderer_counts[SPAN_RENDERER_NUM];
+
+/* Counting is off unless CAIRO_DEBUG_SPANS was set at the first
+ * composite, so that ordinary use does not contend on the counters. */
+static cairo_bool_t
+span_renderer_counting (void)
+{
+    static cairo_atomic_once_t once = CAIRO_ATOMIC_ONCE_INIT;
+    static cairo_bool_t enabled;
+
+    if (_cairo_atomic_init_once_enter (&once)) {
+	enabled = getenv ("CAIRO_DEBUG_SPANS") != NULL;
+	_cairo_atomic_init_once_leave (&once);
+    }
+
+    return enabled;
+}
+
+static inline void
+span_renderer_count (int path)
+{
+    if (unlikely (span_renderer_counting ()))
+	_cairo_atomic_int_inc (&span_renderer_counts[path]);
+}
+
+void
+_cairo_image_spans_compositor_reset_static_data (void)
+{
+    cairo_bool_t print = getenv ("CAIRO_DEBUG_SPANS") != NULL;
+    int i;
+
+    for (i = 0; i < SPAN_RENDERER_NUM; i++) {
+	int count = _cairo_atomic_int_get (&span_renderer_counts[i]);
+	if (print && count)
+	    fprintf (stderr, "span renderer %s: %d\n",
+		     span_renderer_names[i], count);
+	_cairo_atomic_int_set_relaxed (&span_renderer_counts[i], 0);
+    }
+}
+
 #if PIXMAN_HAS_COMPOSITOR
 typedef struct _cairo_image_span_renderer {
     cairo_span_renderer_t base;
@@ -1601,6 +1733,7 @@ typedef struct _cairo_image_span_renderer {
 	    ptrdiff_t stride;
 	    uint8_t *data;
 	    uint32_t pixel;
+	    uint32_t argb;
 	} fill;
 	struct blit {
 	    int stride;
@@ -1719,6 +1852,25 @@ _cairo_image_spans_and_zero (void *abstract_renderer,
     return CAIRO_STATUS_SUCCESS;
 }
 
+static cairo_status_t
+_cairo_image_finish_spans (void *abstract_renderer)
+{
+    cairo_image_span_renderer_t *r = abstract_renderer;
+    const cairo_composite_rectangles_t *composite = r->composite;
+
+    pixman_image_composite32 (r->op, r->src, r->mask,
+			      to_pixman_image (composite->surface),
+			      composite->unbounded.x + r->u.mask.src_x,
+			      composite->unbounded.y + r->u.mask.src_y,
+			      0, 0,
+			      composite->unbounded.x,
+			      composite->unbounded.y,
+			      composite->unbounded.width,
+			      composite->unbounded.height);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
 static cairo_status_t
 _cairo_image_finish_spans_and_zero (void *abstract_renderer)
 {
@@ -1727,7 +1879,7 @@ _cairo_image_finish_spans_and_zero (void *abstract_renderer)
     if (r->u.mask.extents.y < r->u.mask.extents.height)
 	memset (r->u.mask.data, 0, (r->u.mask.extents.height - r->u.mask.extents.y) * r->u.mask.stride);
 
-    return CAIRO_STATUS_SUCCESS;
+    return _cairo_image_finish_spans (r);
 }
 
 static cairo_status_t
@@ -2152,12 +2304,18 @@ mono_renderer_init (cairo_image_span_renderer_t	*r,
 #define RB_MASK_PLUS_ONE 0x01000100
 #define G_SHIFT 8
 static inline uint32_t
-mul8x2_8 (uint32_t a, uint8_t b)
+mul8x2_8_round (uint32_t a, uint8_t b, uint32_t half)
 {
-    uint32_t t = (a & RB_MASK) * b + RB_ONE_HALF;
+    uint32_t t = (a & RB_MASK) * b + half;
     return ((t + ((t >> G_SHIFT) & RB_MASK)) >> G_SHIFT) & RB_MASK;
 }
 
+static inline uint32_t
+mul8x2_8 (uint32_t a, uint8_t b)
+{
+    return mul8x2_8_round (a, b, RB_ONE_HALF);
+}
+
 static inline uint32_t
 add8x2_8x2 (uint32_t a, uint32_t b)
 {
@@ -2167,12 +2325,39 @@ add8x2_8x2 (uint32_t a, uint32_t b)
 }
 
 static inline uint8_t
-mul8_8 (uint8_t a, uint8_t b)
+mul8_8_round (uint8_t a, uint8_t b, uint16_t half)
 {
-    uint16_t t = a * (uint16_t)b + ONE_HALF;
+    uint16_t t = a * (uint16_t)b + half;
     return ((t >> G_SHIFT) + t) >> G_SHIFT;
 }
 
+static inline uint8_t
+mul8_8 (uint8_t a, uint8_t b)
+{
+    return mul8_8_round (a, b, ONE_HALF);
+}
+
+static inline uint8_t
+add8_8 (uint8_t a, uint8_t b)
+{
+    uint16_t t = a + (uint16_t)b;
+    return t | (0 - (t >> G_SHIFT));
+}
+
+static inline uint32_t
+mul8x4_8_round (uint32_t a, uint8_t b, uint32_t half)
+{
+    return mul8x2_8_round (a, b, half) |
+	   mul8x2_8_round (a >> G_SHIFT, b, half) << G_SHIFT;
+}
+
+static inline uint32_t
+add8x4_8x4 (uint32_t a, uint32_t b)
+{
+    return add8x2_8x2 (a & RB_MASK, b & RB_MASK) |
+	   add8x2_8x2 ((a >> G_SHIFT) & RB_MASK, (b >> G_SHIFT) & RB_MASK) << G_SHIFT;
+}
+
 static inline uint32_t
 lerp8x4 (uint32_t src, uint8_t a, uint32_t dst)
 {
@@ -2406,6 +2591,186 @@ _fill_xrgb32_lerp_spans (void *abstract_renderer, int y, int h,
     return CAIRO_STATUS_SUCCESS;
 }
 
+static inline uint32_t
+rgb565_to_xrgb32 (uint16_t p)
+{
+    return (((p << 3) & 0xf8) | ((p >> 2) & 0x7)) |
+	   (((p << 5) & 0xfc00) | ((p >> 1) & 0x300)) |
+	   (((p << 8) & 0xf80000) | ((p << 3) & 0x70000));
+}
+
+static inline uint16_t
+xrgb32_to_rgb565 (uint32_t p)
+{
+    return ((p >> 3) & 0x001f) | ((p >> 5) & 0x07e0) | ((p >> 8) & 0xf800);
+}
+
+static inline uint16_t
+lerp565 (uint32_t src, uint8_t a, uint16_t dst)
+{
+    return xrgb32_to_rgb565 (lerp8x4 (src, a, rgb565_to_xrgb32 (dst)));
+}
+
+static cairo_status_t
+_fill_rgb565_lerp_opaque_spans (void *abstract_renderer, int y, int h,
+				const cairo_half_open_span_t *spans, unsigned num_spans)
+{
+    cairo_image_span_renderer_t *r = abstract_renderer;
+
+    if (num_spans == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    do {
+	uint8_t a = spans[0].coverage;
+	if (a) {
+	    int yy = y, hh = h;
+	    do {
+		int len = spans[1].x - spans[0].x;
+		uint16_t *d = (uint16_t*)(r->u.fill.data + r->u.fill.stride*yy + spans[0].x*2);
+		if (a == 0xff) {
+		    while (len-- > 0)
+			*d++ = r->u.fill.pixel;
+		} else while (len-- > 0) {
+		    *d = lerp565 (r->u.fill.argb, a, *d);
+		    d++;
+		}
+		yy++;
+	    } while (--hh);
+	}
+	spans++;
+    } while (--num_spans > 1);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_fill_rgb565_lerp_spans (void *abstract_renderer, int y, int h,
+			 const cairo_half_open_span_t *spans, unsigned num_spans)
+{
+    cairo_image_span_renderer_t *r = abstract_renderer;
+
+    if (num_spans == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    do {
+	uint8_t a = mul8_8 (spans[0].coverage, r->bpp);
+	if (a) {
+	    int yy = y, hh = h;
+	    do {
+		int len = spans[1].x - spans[0].x;
+		uint16_t *d = (uint16_t*)(r->u.fill.data + r->u.fill.stride*yy + spans[0].x*2);
+		while (len-- > 0) {
+		    *d = lerp565 (r->u.fill.argb, a, *d);
+		    d++;
+		}
+		yy++;
+	    } while (--hh);
+	}
+	spans++;
+    } while (--num_spans > 1);
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Specialised solid-source span kernels.
+ *
+ * Each kernel is stamped out from the same row/span loop with the
+ * per-pixel operator inlined, so that the inner loop is a straight
+ * read-modify-write over a run of pixels that the compiler can keep in
+ * registers and vectorise. Products are rounded as pixman does (x*a +
+ * 0x80) so the output matches the generic _inplace_spans path that
+ * they replace.
+ */
+#define PIXMAN_ONE_HALF		0x80
+#define PIXMAN_RB_ONE_HALF	0x00800080
+
+#define IN_A8(p, a)		mul8_8_round (p, a, PIXMAN_ONE_HALF)
+#define IN_8888(p, a)		mul8x4_8_round (p, a, PIXMAN_RB_ONE_HALF)
+
+#define OVER_A8(s, d)		((uint8_t)((s) + IN_A8 (d, ~(s))))
+#define ADD_A8(s, d)		add8_8 (s, d)
+#define OVER_8888(s, d)		add8x4_8x4 (IN_8888 (d, ~(s) >> 24), s)
+#define ADD_8888(s, d)		add8x4_8x4 (s, d)
+
+#define DEFINE_SOLID_SPANS(name, pixel_t, IN, OP)			\
+static cairo_status_t							\
+name (void *abstract_renderer, int y, int h,				\
+      const cairo_half_open_span_t *spans, unsigned num_spans)		\
+{									\
+    cairo_image_span_renderer_t *r = abstract_renderer;		\
+									\
+    if (num_spans == 0)							\
+	return CAIRO_STATUS_SUCCESS;					\
+									\
+    do {								\
+	uint8_t a = mul8_8 (spans[0].coverage, r->bpp);		\
+	if (a) {							\
+	    const pixel_t s = IN (r->u.fill.pixel, a);			\
+	    uint8_t *row = r->u.fill.data + r->u.fill.stride*y +	\
+			   spans[0].x * sizeof (pixel_t);		\
+	    int len = spans[1].x - spans[0].x;				\
+	    int hh = h;							\
+	    do {							\
+		pixel_t *d = (pixel_t *) row;				\
+		int i;							\
+		for (i = 0; i < len; i++)				\
+		    d[i] = OP (s, d[i]);				\
+		row += r->u.fill.stride;				\
+	    } while (--hh);						\
+	}								\
+	spans++;							\
+    } while (--num_spans > 1);						\
+									\
+    return CAIRO_STATUS_SUCCESS;					\
+}
+
+DEFINE_SOLID_SPANS (_over_a8_solid_spans, uint8_t, IN_A8, OVER_A8)
+DEFINE_SOLID_SPANS (_add_a8_solid_spans, uint8_t, IN_A8, ADD_A8)
+DEFINE_SOLID_SPANS (_over_8888_solid_spans, uint32_t, IN_8888, OVER_8888)
+DEFINE_SOLID_SPANS (_add_8888_solid_spans, uint32_t, IN_8888, ADD_8888)
+
+#undef DEFINE_SOLID_SPANS
+
+static const struct solid_span_kernel {
+    cairo_format_t format;
+    cairo_operator_t op;
+    cairo_status_t (*render_rows) (void *abstract_renderer, int y, int h,
+				   const cairo_half_open_span_t *spans,
+				   unsigned num_spans);
+} solid_span_kernels[] = {
+    { CAIRO_FORMAT_ARGB32, CAIRO_OPERATOR_OVER, _over_8888_solid_spans },
+    { CAIRO_FORMAT_ARGB32, CAIRO_OPERATOR_ADD, _add_8888_solid_spans },
+    { CAIRO_FORMAT_RGB24, CAIRO_OPERATOR_OVER, _over_8888_solid_spans },
+    { CAIRO_FORMAT_A8, CAIRO_OPERATOR_OVER, _over_a8_solid_spans },
+    { CAIRO_FORMAT_A8, CAIRO_OPERATOR_ADD, _add_a8_solid_spans },
+};
+
+static cairo_bool_t
+solid_span_kernel_init (cairo_image_span_renderer_t *r,
+			cairo_image_surface_t *dst,
+			cairo_operator_t op,
+			const cairo_color_t *color)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_LENGTH (solid_span_kernels); i++) {
+	const struct solid_span_kernel *k = &solid_span_kernels[i];
+
+	if (k->format != dst->format || k->op != op)
+	    continue;
+
+	if (! color_to_pixel (color, dst->pixman_format, &r->u.fill.pixel))
+	    return FALSE;
+
+	r->u.fill.data = dst->data;
+	r->u.fill.stride = dst->stride;
+	r->base.render_rows = k->render_rows;
+	return TRUE;
+    }
+
+    return FALSE;
+}
+
 static cairo_status_t
 _blit_xrgb32_lerp_spans (void *abstract_renderer, int y, int h,
 			 const cairo_half_open_span_t *spans, unsigned num_spans)
@@ -2842,8 +3207,11 @@ inplace_renderer_init (cairo_image_span_renderer_t	*r,
 		case CAIRO_FORMAT_ARGB32:
 		    r->base.render_rows = _fill_xrgb32_lerp_opaque_spans;
 		    break;
-		case CAIRO_FORMAT_A1:
 		case CAIRO_FORMAT_RGB16_565:
+		    r->u.fill.argb = color_to_uint32 (color);
+		    r->base.render_rows = _fill_rgb565_lerp_opaque_spans;
+		    break;
+		case CAIRO_FORMAT_A1:
 		case CAIRO_FORMAT_RGB30:
 		case CAIRO_FORMAT_RGB96F:
 		case CAIRO_FORMAT_RGBA128F:
@@ -2859,8 +3227,11 @@ inplace_renderer_init (cairo_image_span_renderer_t	*r,
 		case CAIRO_FORMAT_ARGB32:
 		    r->base.render_rows = _fill_xrgb32_lerp_spans;
 		    break;
-		case CAIRO_FORMAT_A1:
 		case CAIRO_FORMAT_RGB16_565:
+		    r->u.fill.argb = color_to_uint32 (color);
+		    r->base.render_rows = _fill_rgb565_lerp_spans;
+		    break;
+		case CAIRO_FORMAT_A1:
 		case CAIRO_FORMAT_RGB30:
 		case CAIRO_FORMAT_RGB96F:
 		case CAIRO_FORMAT_RGBA128F:
@@ -2870,6 +3241,8 @@ inplace_renderer_init (cairo_image_span_renderer_t	*r,
 	    }
 	    r->u.fill.data = dst->data;
 	    r->u.fill.stride = dst->stride;
+	} else {
+	    solid_span_kernel_init (r, dst, composite->op, color);
 	}
     } else if ((dst->format == CAIRO_FORMAT_ARGB32 || dst->format == CAIRO_FORMAT_RGB24) &&
 	       (composite->op == CAIRO_OPERATOR_SOURCE ||
@@ -2963,6 +3336,20 @@ inplace_renderer_init (cairo_image_span_renderer_t	*r,
     return CAIRO_INT_STATUS_SUCCESS;
 }
 
+static int
+inplace_renderer_path (const cairo_image_span_renderer_t *r)
+{
+    if (r->base.render_rows == _blit_xrgb32_lerp_spans)
+	return SPAN_RENDERER_BLIT;
+    if (r->base.render_rows == _inplace_spans ||
+	r->base.render_rows == _inplace_opacity_spans)
+	return SPAN_RENDERER_INPLACE;
+    if (r->base.render_rows == _inplace_src_spans ||
+	r->base.render_rows == _inplace_src_opacity_spans)
+	return SPAN_RENDERER_INPLACE_SRC;
+    return SPAN_RENDERER_FILL;
+}
+
 static cairo_int_status_t
 span_renderer_init (cairo_abstract_span_renderer_t	*_r,
 		    const cairo_composite_rectangles_t *composite,
@@ -2978,8 +3365,10 @@ span_renderer_init (cairo_abstract_span_renderer_t	*_r,
     TRACE ((stderr, "%s: antialias=%d, needs_clip=%d\n", __FUNCTION__,
 	    antialias, needs_clip));
 
-    if (needs_clip)
+    if (needs_clip) {
+	span_renderer_count (SPAN_RENDERER_UNSUPPORTED);
 	return CAIRO_INT_STATUS_UNSUPPORTED;
+    }
 
     r->composite = composite;
     r->mask = NULL;
@@ -2987,12 +3376,16 @@ span_renderer_init (cairo_abstract_span_renderer_t	*_r,
     r->base.finish = NULL;
 
     status = mono_renderer_init (r, composite, antialias, needs_clip);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+    if (status != CAIRO_INT_STATUS_UNSUPPORTED) {
+	span_renderer_count (SPAN_RENDERER_MONO);
 	return status;
+    }
 
     status = inplace_renderer_init (r, composite, antialias, needs_clip);
-    if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+    if (status != CAIRO_INT_STATUS_UNSUPPORTED) {
+	span_renderer_count (inplace_renderer_path (r));
 	return status;
+    }
 
     r->bpp = 0;
 
@@ -3019,6 +3412,7 @@ span_renderer_init (cairo_abstract_span_renderer_t	*_r,
 #if PIXMAN_HAS_OP_LERP
 	    op = PIXMAN_OP_LERP_SRC;
 #else
+	    span_renderer_count (SPAN_RENDERER_UNSUPPORTED);
 	    return CAIRO_INT_STATUS_UNSUPPORTED;
 #endif
 	}
@@ -3076,7 +3470,7 @@ span_renderer_init (cairo_abstract_span_renderer_t	*_r,
 					    NULL, 0);
 
 	r->base.render_rows = _cairo_image_spans;
-	r->base.finish = NULL;
+	r->base.finish = _cairo_image_finish_spans;
     } else {
 	r->mask = pixman_image_create_bits (PIXMAN_a8,
 					    r->u.mask.extents.width,
@@ -3093,6 +3487,7 @@ span_renderer_init (cairo_abstract_span_renderer_t	*_r,
     r->u.mask.stride = pixman_image_get_stride (r->mask);
 
     r->u.mask.extents.height += r->u.mask.extents.y;
+    span_renderer_count (SPAN_RENDERER_MASK);
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -3104,23 +3499,12 @@ span_renderer_fini (cairo_abstract_span_renderer_t *_r,
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
 
+    /* The mask is composited by finish(), which may already have been
+     * run by a worker thread if this renderer was handed a band. */
     if (likely (status == CAIRO_INT_STATUS_SUCCESS)) {
 	if (r->base.finish)
 	    r->base.finish (r);
     }
-    if (likely (status == CAIRO_INT_STATUS_SUCCESS && r->bpp == 0)) {
-	const cairo_composite_rectangles_t *composite = r->composite;
-
-	pixman_image_composite32 (r->op, r->src, r->mask,
-				  to_pixman_image (composite->surface),
-				  composite->unbounded.x + r->u.mask.src_x,
-				  composite->unbounded.y + r->u.mask.src_y,
-				  0, 0,
-				  composite->unbounded.x,
-				  composite->unbounded.y,
-				  composite->unbounded.width,
-				  composite->unbounded.height);
-    }
 
     if (r->src)
 	pixman_image_unref (r->src);
@@ -3147,6 +3531,9 @@ _cairo_image_spans_compositor_get (void)
 #if PIXMAN_HAS_OP_LERP
 	spans.flags |= CAIRO_SPANS_COMPOSITOR_HAS_LERP;
 #endif
+#if ! PIXMAN_HAS_COMPOSITOR
+	spans.flags |= CAIRO_SPANS_COMPOSITOR_HAS_THREADS;
+#endif
 
 	//spans.acquire = acquire;
 	//spans.release = release;
@@ -44,6 +44,7 @@
 
 #include "cairoint.h"
 
+#include "cairo-atomic-private.h"
 #include "cairo-image-surface-private.h"
 
 #include "cairo-compositor-private.h"
@@ -162,21 +163,6 @@ _pixman_white_image (void)
     return image;
 }
 
-static uint32_t
-hars_petruska_f54_1_random (void)
-{
-#define rol(x,k) ((x << k) | (x >> (32-k)))
-    static uint32_t x;
-    return x = (x ^ rol (x, 5) ^ rol (x, 24)) + 0x37798849;
-#undef rol
-}
-
-static struct {
-    cairo_color_t color;
-    pixman_image_t *image;
-} cache[16];
-static int n_cached;
-
 #else  /* !PIXMAN_HAS_ATOMIC_OPS */
 static pixman_image_t *
 _pixman_transparent_image (void)
@@ -200,6 +186,149 @@ _pixman_white_image (void)
 }
 #endif /* !PIXMAN_HAS_ATOMIC_OPS */
 
+/* pixman's reference counts are only atomic with PIXMAN_HAS_ATOMIC_OPS,
+ * in which case a single cache of solid fills can be shared by every
+ * thread.  Otherwise each thread keeps a cache of its own: an image is
+ * then only ever referenced and released by the thread that looked it
+ * up, and the lookup needs no lock at all.
+ */
+#if PIXMAN_HAS_ATOMIC_OPS
+#define HAS_SOLID_CACHE 1
+#elif CAIRO_HAS_REAL_PTHREAD
+#include <pthread.h>
+#define HAS_SOLID_CACHE 1
+#define SOLID_CACHE_PER_THREAD 1
+#endif
+
+#if HAS_SOLID_CACHE
+/* The cache is a direct-mapped table hashed on the colour.  Its size
+ * may be set with the CAIRO_SOLID_CACHE_SIZE environment variable,
+ * which is rounded up to a power of two, with 0 disabling the cache.
+ */
+#define SOLID_CACHE_DEFAULT_SIZE 16
+#define SOLID_CACHE_MAX_SIZE 4096
+
+typedef struct _cairo_solid_cache_entry {
+    cairo_color_t color;
+    pixman_image_t *image;
+} cairo_solid_cache_entry_t;
+
+typedef struct _cairo_solid_cache {
+    unsigned int mask;
+    cairo_solid_cache_entry_t entries[1];
+} cairo_solid_cache_t;
+
+static int solid_cache_size;
+
+#if SOLID_CACHE_PER_THREAD
+static pthread_key_t solid_cache_key;
+#else
+static cairo_solid_cache_t *solid_cache;
+#endif
+
+static void
+_cairo_solid_cache_destroy (void *closure)
+{
+    cairo_solid_cache_t *cache = closure;
+    unsigned int i;
+
+    for (i = 0; i <= cache->mask; i++) {
+	if (cache->entries[i].image)
+	    pixman_image_unref (cache->entries[i].image);
+    }
+
+    free (cache);
+}
+
+static void
+_cairo_solid_cache_init_once (void)
+{
+    static cairo_atomic_once_t once = CAIRO_ATOMIC_ONCE_INIT;
+
+    if (_cairo_atomic_init_once_enter (&once)) {
+	const char *env = getenv ("CAIRO_SOLID_CACHE_SIZE");
+	int size = SOLID_CACHE_DEFAULT_SIZE;
+
+	if (env != NULL) {
+	    size = atoi (env);
+	    if (size < 0)
+		size = 0;
+	    if (size > SOLID_CACHE_MAX_SIZE)
+		size = SOLID_CACHE_MAX_SIZE;
+	}
+
+	solid_cache_size = 0;
+	if (size) {
+	    solid_cache_size = 1;
+	    while (solid_cache_size < size)
+		solid_cache_size *= 2;
+	}
+
+#if SOLID_CACHE_PER_THREAD
+	pthread_key_create (&solid_cache_key, _cairo_solid_cache_destroy);
+#endif
+
+	_cairo_atomic_init_once_leave (&once);
+    }
+}
+
+static cairo_solid_cache_t *
+_cairo_solid_cache_get (void)
+{
+    cairo_solid_cache_t *cache;
+
+    _cairo_solid_cache_init_once ();
+    if (solid_cache_size == 0)
+	return NULL;
+
+#if SOLID_CACHE_PER_THREAD
+    cache = pthread_getspecific (solid_cache_key);
+#else
+    cache = solid_cache;
+#endif
+    if (cache != NULL)
+	return cache;
+
+    cache = _cairo_malloc_ab_plus_c (solid_cache_size - 1,
+				     sizeof (cairo_solid_cache_entry_t),
+				     sizeof (cairo_solid_cache_t));
+    if (unlikely (cache == NULL))
+	return NULL;
+
+    memset (cache, 0,
+	    sizeof (cairo_solid_cache_t) +
+	    (solid_cache_size - 1) * sizeof (cairo_solid_cache_entry_t));
+    cache->mask = solid_cache_size - 1;
+
+#if SOLID_CACHE_PER_THREAD
+    if (pthread_setspecific (solid_cache_key, cache)) {
+	free (cache);
+	return NULL;
+    }
+#else
+    solid_cache = cache;
+#endif
+
+    return cache;
+}
+
+static inline cairo_solid_cache_entry_t *
+_cairo_solid_cache_entry (cairo_solid_cache_t *cache,
+			  const cairo_color_t *color)
+{
+    uint32_t hash;
+
+    hash = color->red_short;
+    hash = hash * 31 + color->green_short;
+    hash = hash * 31 + color->blue_short;
+    hash = hash * 31 + color->alpha_short;
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+
+    return &cache->entries[hash & cache->mask];
+}
+#endif /* HAS_SOLID_CACHE */
 
 pixman_image_t *
 _pixman_image_for_color (const cairo_color_t *cairo_color)
@@ -207,9 +336,12 @@ _pixman_image_for_color (const cairo_color_t *cairo_color)
     pixman_color_t color;
     pixman_image_t *image;
 
-#if PIXMAN_HAS_ATOMIC_OPS
-    int i;
+#if HAS_SOLID_CACHE
+    cairo_solid_cache_t *cache;
+    cairo_solid_cache_entry_t *entry = NULL;
+#endif
 
+#if PIXMAN_HAS_ATOMIC_OPS
     if (CAIRO_COLOR_IS_CLEAR (cairo_color))
 	return _pixman_transparent_image ();
 
@@ -228,11 +360,19 @@ _pixman_image_for_color (const cairo_color_t *cairo_color)
 	    return _pixman_white_image ();
 	}
     }
+#endif
 
+#if HAS_SOLID_CACHE
+#if ! SOLID_CACHE_PER_THREAD
     CAIRO_MUTEX_LOCK (_cairo_image_solid_cache_mutex);
-    for (i = 0; i < n_cached; i++) {
-	if (_cairo_color_equal (&cache[i].color, cairo_color)) {
-	    image = pixman_image_ref (cache[i].image);
+#endif
+    cache = _cairo_solid_cache_get ();
+    if (cache != NULL) {
+	entry = _cairo_solid_cache_entry (cache, cairo_color);
+	if (entry->image != NULL &&
+	    _cairo_color_equal (&entry->color, cairo_color))
+	{
+	    image = pixman_image_ref (entry->image);
 	    goto UNLOCK;
 	}
     }
@@ -244,32 +384,336 @@ _pixman_image_for_color (const cairo_color_t *cairo_color)
     color.alpha = cairo_color->alpha_short;
 
     image = pixman_image_create_solid_fill (&color);
-#if PIXMAN_HAS_ATOMIC_OPS
-    if (image == NULL)
-	goto UNLOCK;
-
-    if (n_cached < ARRAY_LENGTH (cache)) {
-	i = n_cached++;
-    } else {
-	i = hars_petruska_f54_1_random () % ARRAY_LENGTH (cache);
-	pixman_image_unref (cache[i].image);
+#if HAS_SOLID_CACHE
+    if (image != NULL && entry != NULL) {
+	if (entry->image != NULL)
+	    pixman_image_unref (entry->image);
+	entry->image = pixman_image_ref (image);
+	entry->color = *cairo_color;
     }
-    cache[i].image = pixman_image_ref (image);
-    cache[i].color = *cairo_color;
 
 UNLOCK:
+#if ! SOLID_CACHE_PER_THREAD
     CAIRO_MUTEX_UNLOCK (_cairo_image_solid_cache_mutex);
+#endif
 #endif
     return image;
 }
 
 
+/* With CAIRO_FILTER_FAST, linear gradients are drawn by sampling a
+ * precomputed colour ramp instead of having pixman walk the stops for
+ * every pixel.  The ramps are immutable and shared through a small
+ * cache keyed on the gradient's type, extend mode and stops, so a
+ * gradient that is drawn many times only pays for its ramp once; each
+ * draw just wraps the ramp in a pixman image of its own.
+ */
+#define GRADIENT_RAMP_WIDTH 1024
+#define GRADIENT_RAMP_CACHE_SIZE 32
+
+typedef struct _cairo_gradient_ramp {
+    cairo_cache_entry_t base;
+    cairo_reference_count_t ref_count;
+
+    cairo_pattern_type_t type;
+    cairo_extend_t extend;
+    unsigned int n_stops;
+    cairo_gradient_stop_t *stops;
+
+    uint32_t pixels[GRADIENT_RAMP_WIDTH];
+} cairo_gradient_ramp_t;
+
+static cairo_cache_t gradient_ramp_cache;
+
+static unsigned long
+_cairo_gradient_ramp_hash (const cairo_gradient_pattern_t *pattern)
+{
+    unsigned long hash = _CAIRO_HASH_INIT_VALUE;
+    unsigned int i;
+
+    hash = _cairo_hash_bytes (hash, &pattern->base.type, sizeof (pattern->base.type));
+    hash = _cairo_hash_bytes (hash, &pattern->base.extend, sizeof (pattern->base.extend));
+    for (i = 0; i < pattern->n_stops; i++) {
+	const cairo_gradient_stop_t *stop = &pattern->stops[i];
+
+	hash = _cairo_hash_bytes (hash, &stop->offset, sizeof (stop->offset));
+	hash = _cairo_hash_bytes (hash, &stop->color.red_short, sizeof (unsigned short));
+	hash = _cairo_hash_bytes (hash, &stop->color.green_short, sizeof (unsigned short));
+	hash = _cairo_hash_bytes (hash, &stop->color.blue_short, sizeof (unsigned short));
+	hash = _cairo_hash_bytes (hash, &stop->color.alpha_short, sizeof (unsigned short));
+    }
+
+    return hash;
+}
+
+static cairo_bool_t
+_cairo_gradient_ramp_equal (const void *key_a, const void *key_b)
+{
+    const cairo_gradient_ramp_t *a = key_a, *b = key_b;
+    unsigned int i;
+
+    if (a->type != b->type ||
+	a->extend != b->extend ||
+	a->n_stops != b->n_stops)
+	return FALSE;
+
+    for (i = 0; i < a->n_stops; i++) {
+	if (a->stops[i].offset != b->stops[i].offset ||
+	    ! _cairo_color_stop_equal (&a->stops[i].color, &b->stops[i].color))
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+_cairo_gradient_ramp_destroy (void *closure)
+{
+    cairo_gradient_ramp_t *ramp = closure;
+
+    if (! _cairo_reference_count_dec_and_test (&ramp->ref_count))
+	return;
+
+    free (ramp);
+}
+
+static void
+_cairo_gradient_ramp_release (pixman_image_t *image, void *closure)
+{
+    _cairo_gradient_ramp_destroy (closure);
+}
+
+static uint32_t
+_cairo_gradient_ramp_color (const cairo_gradient_stop_t *stops,
+			    unsigned int n_stops,
+			    double t)
+{
+    const cairo_color_stop_t *c0, *c1;
+    double r, g, b, a, s;
+    unsigned int i;
+
+    if (t <= stops[0].offset) {
+	c0 = c1 = &stops[0].color;
+	s = 0;
+    } else if (t >= stops[n_stops-1].offset) {
+	c0 = c1 = &stops[n_stops-1].color;
+	s = 0;
+    } else {
+	for (i = 1; t >= stops[i].offset; i++)
+	    ;
+	c0 = &stops[i-1].color;
+	c1 = &stops[i].color;
+	s = (t - stops[i-1].offset) / (stops[i].offset - stops[i-1].offset);
+    }
+
+    /* interpolate unpremultiplied, as pixman does, then premultiply */
+    a = (c0->alpha_short + s * (c1->alpha_short - c0->alpha_short)) / 65535.;
+    r = (c0->red_short   + s * (c1->red_short   - c0->red_short))   / 65535.;
+    g = (c0->green_short + s * (c1->green_short - c0->green_short)) / 65535.;
+    b = (c0->blue_short  + s * (c1->blue_short  - c0->blue_short))  / 65535.;
+
+    return ((uint32_t) (a * 255. + .5) << 24) |
+	   ((uint32_t) (r * a * 255. + .5) << 16) |
+	   ((uint32_t) (g * a * 255. + .5) << 8) |
+	   ((uint32_t) (b * a * 255. + .5) << 0);
+}
+
+static cairo_gradient_ramp_t *
+_cairo_gradient_ramp_create (const cairo_gradient_pattern_t *pattern,
+			     unsigned long hash)
+{
+    cairo_gradient_ramp_t *ramp;
+    unsigned int i;
+
+    ramp = _cairo_malloc_ab_plus_c (pattern->n_stops,
+				    sizeof (cairo_gradient_stop_t),
+				    sizeof (cairo_gradient_ramp_t));
+    if (unlikely (ramp == NULL))
+	return NULL;
+
+    ramp->base.hash = hash;
+    ramp->base.size = 1;
+    CAIRO_REFERENCE_COUNT_INIT (&ramp->ref_count, 1);
+
+    ramp->type = pattern->base.type;
+    ramp->extend = pattern->base.extend;
+    ramp->n_stops = pattern->n_stops;
+    ramp->stops = (cairo_gradient_stop_t *) (ramp + 1);
+    memcpy (ramp->stops, pattern->stops,
+	    pattern->n_stops * sizeof (cairo_gradient_stop_t));
+
+    for (i = 0; i < GRADIENT_RAMP_WIDTH; i++) {
+	ramp->pixels[i] =
+	    _cairo_gradient_ramp_color (ramp->stops, ramp->n_stops,
+					(i + .5) / GRADIENT_RAMP_WIDTH);
+    }
+
+    return ramp;
+}
+
+static cairo_gradient_ramp_t *
+_cairo_gradient_ramp_lookup (const cairo_gradient_pattern_t *pattern)
+{
+    cairo_gradient_ramp_t key, *ramp;
+
+    key.base.hash = _cairo_gradient_ramp_hash (pattern);
+    key.type = pattern->base.type;
+    key.extend = pattern->base.extend;
+    key.n_stops = pattern->n_stops;
+    key.stops = pattern->stops;
+
+    CAIRO_MUTEX_LOCK (_cairo_image_gradient_cache_mutex);
+    if (unlikely (gradient_ramp_cache.hash_table == NULL)) {
+	if (_cairo_cache_init (&gradient_ramp_cache,
+			       _cairo_gradient_ramp_equal,
+			       NULL,
+			       _cairo_gradient_ramp_destroy,
+			       GRADIENT_RAMP_CACHE_SIZE))
+	{
+	    gradient_ramp_cache.hash_table = NULL;
+	    CAIRO_MUTEX_UNLOCK (_cairo_image_gradient_cache_mutex);
+	    return NULL;
+	}
+    }
+
+    ramp = _cairo_cache_lookup (&gradient_ramp_cache, &key.base);
+    if (ramp != NULL)
+	_cairo_reference_count_inc (&ramp->ref_count);
+    CAIRO_MUTEX_UNLOCK (_cairo_image_gradient_cache_mutex);
+    if (ramp != NULL)
+	return ramp;
+
+    ramp = _cairo_gradient_ramp_create (pattern, key.base.hash);
+    if (unlikely (ramp == NULL))
+	return NULL;
+
+    /* One reference for the cache, one for the caller; if it cannot
+     * be cached, the ramp is simply used just this once. */
+    _cairo_reference_count_inc (&ramp->ref_count);
+    CAIRO_MUTEX_LOCK (_cairo_image_gradient_cache_mutex);
+    if (_cairo_cache_insert (&gradient_ramp_cache, &ramp->base))
+	_cairo_reference_count_dec (&ramp->ref_count);
+    CAIRO_MUTEX_UNLOCK (_cairo_image_gradient_cache_mutex);
+
+    return ramp;
+}
+
+static pixman_image_t *
+_pixman_image_for_gradient_ramp (const cairo_gradient_pattern_t *pattern,
+				 const cairo_matrix_t *matrix,
+				 const cairo_circle_double_t extremes[2],
+				 const cairo_rectangle_int_t *extents,
+				 int *ix, int *iy)
+{
+    cairo_gradient_ramp_t *ramp;
+    pixman_image_t *pixman_image;
+    pixman_transform_t pixman_transform;
+    pixman_repeat_t pixman_repeat;
+    cairo_matrix_t to_ramp, m;
+    double dx, dy, len2, scale;
+    cairo_int_status_t status;
+
+    if (pattern->n_stops == 0)
+	return NULL;
+
+    /* Map the gradient vector onto [0, GRADIENT_RAMP_WIDTH) along the
+     * single row of the ramp. */
+    dx = extremes[1].center.x - extremes[0].center.x;
+    dy = extremes[1].center.y - extremes[0].center.y;
+    len2 = dx * dx + dy * dy;
+    if (len2 < 1.)
+	return NULL;
+
+    scale = GRADIENT_RAMP_WIDTH / len2;
+    cairo_matrix_init (&to_ramp,
+		       scale * dx, 0,
+		       scale * dy, 0,
+		       -scale * (extremes[0].center.x * dx +
+				 extremes[0].center.y * dy),
+		       .5);
+    cairo_matrix_multiply (&m, matrix, &to_ramp);
+    if (fabs (m.xx) > PIXMAN_MAX_INT || fabs (m.xy) > PIXMAN_MAX_INT ||
+	fabs (m.x0) > PIXMAN_MAX_INT)
+	return NULL;
+
+    *ix = *iy = 0;
+    status = _cairo_matrix_to_pixman_matrix_offset (&m, pattern->base.filter,
+						    extents->x + extents->width/2.,
+						    extents->y + extents->height/2.,
+						    &pixman_transform, ix, iy);
+    if (unlikely (status != CAIRO_INT_STATUS_SUCCESS))
+	return NULL;
+
+    ramp = _cairo_gradient_ramp_lookup (pattern);
+    if (unlikely (ramp == NULL))
+	return NULL;
+
+    pixman_image = pixman_image_create_bits (PIXMAN_a8r8g8b8,
+					     GRADIENT_RAMP_WIDTH, 1,
+					     ramp->pixels,
+					     sizeof (ramp->pixels));
+    if (unlikely (pixman_image == NULL)) {
+	_cairo_gradient_ramp_destroy (ramp);
+	return NULL;
+    }
+    pixman_image_set_destroy_function (pixman_image,
+				       _cairo_gradient_ramp_release,
+				       ramp);
+
+    if (! pixman_image_set_transform (pixman_image, &pixman_transform)) {
+	pixman_image_unref (pixman_image);
+	return NULL;
+    }
+
+    switch (pattern->base.extend) {
+    default:
+    case CAIRO_EXTEND_NONE:
+	pixman_repeat = PIXMAN_REPEAT_NONE;
+	break;
+    case CAIRO_EXTEND_REPEAT:
+	pixman_repeat = PIXMAN_REPEAT_NORMAL;
+	break;
+    case CAIRO_EXTEND_REFLECT:
+	pixman_repeat = PIXMAN_REPEAT_REFLECT;
+	break;
+    case CAIRO_EXTEND_PAD:
+	pixman_repeat = PIXMAN_REPEAT_PAD;
+	break;
+    }
+    pixman_image_set_repeat (pixman_image, pixman_repeat);
+    pixman_image_set_filter (pixman_image, PIXMAN_FILTER_BILINEAR, NULL, 0);
+
+    return pixman_image;
+}
+
 void
 _cairo_image_reset_static_data (void)
 {
+#if SOLID_CACHE_PER_THREAD
+    cairo_solid_cache_t *cache;
+
+    /* Only the calling thread's cache can be released here, the others
+     * are released as their threads exit. */
+    _cairo_solid_cache_init_once ();
+    cache = pthread_getspecific (solid_cache_key);
+    if (cache != NULL) {
+	pthread_setspecific (solid_cache_key, NULL);
+	_cairo_solid_cache_destroy (cache);
+    }
+#endif
+
+    CAIRO_MUTEX_LOCK (_cairo_image_gradient_cache_mutex);
+    if (gradient_ramp_cache.hash_table != NULL) {
+	_cairo_cache_fini (&gradient_ramp_cache);
+	gradient_ramp_cache.hash_table = NULL;
+    }
+    CAIRO_MUTEX_UNLOCK (_cairo_image_gradient_cache_mutex);
+
 #if PIXMAN_HAS_ATOMIC_OPS
-    while (n_cached)
-	pixman_image_unref (cache[--n_cached].image);
+    if (solid_cache != NULL) {
+	_cairo_solid_cache_destroy (solid_cache);
+	solid_cache = NULL;
+    }
 
     if (__pixman_transparent_image) {
 	pixman_image_unref (__pixman_transparent_image);
@@ -305,6 +749,18 @@ _pixman_image_for_gradient (const cairo_gradient_pattern_t *pattern,
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
 
+    _cairo_gradient_pattern_fit_to_range (pattern, PIXMAN_MAX_INT >> 1, &matrix, extremes);
+
+    if (pattern->base.type == CAIRO_PATTERN_TYPE_LINEAR &&
+	pattern->base.filter == CAIRO_FILTER_FAST)
+    {
+	pixman_image = _pixman_image_for_gradient_ramp (pattern, &matrix,
+							 extremes, extents,
+							 ix, iy);
+	if (pixman_image != NULL)
+	    return pixman_image;
+    }
+
     if (pattern->n_stops > ARRAY_LENGTH(pixman_stops_static)) {
 	pixman_stops = _cairo_malloc_ab (pattern->n_stops,
 					 sizeof(pixman_gradient_stop_t));
@@ -320,7 +776,6 @@ _pixman_image_for_gradient (const cairo_gradient_pattern_t *pattern,
 	pixman_stops[i].color.alpha = pattern->stops[i].color.alpha_short;
     }
 
-    _cairo_gradient_pattern_fit_to_range (pattern, PIXMAN_MAX_INT >> 1, &matrix, extremes);
 
     p1.x = _cairo_fixed_16_16_from_double (extremes[0].center.x);
     p1.y = _cairo_fixed_16_16_from_double (extremes[0].center.y);
@@ -916,15 +1371,16 @@ create_separable_convolution (int *n_values,
 /* ========================================================================== */
 
 static cairo_bool_t
-_pixman_image_set_properties (pixman_image_t *pixman_image,
-			      const cairo_pattern_t *pattern,
-			      const cairo_rectangle_int_t *extents,
-			      int *ix,int *iy)
+_pixman_image_set_properties_for_matrix (pixman_image_t *pixman_image,
+					 const cairo_pattern_t *pattern,
+					 const cairo_matrix_t *matrix,
+					 const cairo_rectangle_int_t *extents,
+					 int *ix,int *iy)
 {
     pixman_transform_t pixman_transform;
     cairo_int_status_t status;
 
-    status = _cairo_matrix_to_pixman_matrix_offset (&pattern->matrix,
+    status = _cairo_matrix_to_pixman_matrix_offset (matrix,
 						    pattern->filter,
 						    extents->x + extents->width/2.,
 						    extents->y + extents->height/2.,
@@ -954,8 +1410,8 @@ _pixman_image_set_properties (pixman_image_t *pixman_image,
 	 * rectangle with the same area as the parallelgram a 1x1
 	 * square transforms to.
 	 */
-	dx = hypot (pattern->matrix.xx, pattern->matrix.xy);
-	dy = hypot (pattern->matrix.yx, pattern->matrix.yy);
+	dx = hypot (matrix->xx, matrix->xy);
+	dy = hypot (matrix->yx, matrix->yy);
 
 	/* Clip at maximum pixman_fixed number. Besides making it
 	 * passable to pixman, this avoids errors from inf and nan.
@@ -1054,6 +1510,259 @@ _pixman_image_set_properties (pixman_image_t *pixman_image,
     return TRUE;
 }
 
+static cairo_bool_t
+_pixman_image_set_properties (pixman_image_t *pixman_image,
+			      const cairo_pattern_t *pattern,
+			      const cairo_rectangle_int_t *extents,
+			      int *ix,int *iy)
+{
+    return _pixman_image_set_properties_for_matrix (pixman_image,
+						    pattern, &pattern->matrix,
+						    extents, ix, iy);
+}
+
+/* Downscaling with the GOOD and BEST filters convolves the source with
+ * a kernel as wide as the scale factor in each direction, so painting
+ * a large image as a thumbnail touches every source pixel many times
+ * over.  When enabled through the CAIRO_MIPMAP environment variable,
+ * such sources are instead sampled from the level of a box-filtered
+ * mip pyramid that leaves a scale factor between 1 and 2, which the
+ * filter then handles with only a few taps.
+ *
+ * The pyramid is built lazily, one level at a time, and attached to
+ * the image as a snapshot so that it is dropped as soon as the image
+ * is modified or flushed for direct access.  All of its levels
+ * together take at most a third of the memory of the image itself.
+ * Looking it up and building levels is serialised by a global mutex,
+ * as the same image may be used as a source from several threads;
+ * levels are never changed once built, so they are read unlocked.
+ *
+ * This is off by default as the result differs slightly from filtering
+ * the full resolution image.
+ */
+#define MIPMAP_MAX_LEVELS 16
+
+typedef struct _cairo_image_mipmap_level {
+    int width, height, stride;
+    uint32_t *data;
+} cairo_image_mipmap_level_t;
+
+typedef struct _cairo_image_mipmap {
+    cairo_surface_t base;
+    int num_levels;
+    cairo_image_mipmap_level_t levels[MIPMAP_MAX_LEVELS];
+} cairo_image_mipmap_t;
+
+static cairo_status_t
+_cairo_image_mipmap_finish (void *abstract_surface)
+{
+    cairo_image_mipmap_t *mipmap = abstract_surface;
+    int i;
+
+    for (i = 0; i < mipmap->num_levels; i++)
+	free (mipmap->levels[i].data);
+    mipmap->num_levels = 0;
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static const cairo_surface_backend_t _cairo_image_mipmap_backend = {
+    CAIRO_INTERNAL_SURFACE_TYPE_NULL,
+    _cairo_image_mipmap_finish,
+};
+
+static cairo_bool_t
+_cairo_image_mipmap_enabled (void)
+{
+    static cairo_atomic_once_t once = CAIRO_ATOMIC_ONCE_INIT;
+    static cairo_bool_t enabled;
+
+    if (_cairo_atomic_init_once_enter (&once)) {
+	const char *env = getenv ("CAIRO_MIPMAP");
+
+	enabled = env != NULL && atoi (env) != 0;
+	_cairo_atomic_init_once_leave (&once);
+    }
+
+    return enabled;
+}
+
+/* Average each 2x2 block of src into one pixel of dst, replicating the
+ * last row and column of src when its size is odd.  The four 8-bit
+ * channels are summed two at a time in the 16-bit halves of a word. */
+static void
+_cairo_image_mipmap_downsample (const uint8_t *src_data,
+				int src_width, int src_height, int src_stride,
+				uint8_t *dst_data,
+				int dst_width, int dst_height, int dst_stride)
+{
+    int x, y;
+
+    for (y = 0; y < dst_height; y++) {
+	const uint32_t *row0 = (const uint32_t *) (src_data + 2*y * (ptrdiff_t) src_stride);
+	const uint32_t *row1 = (const uint32_t *) (src_data + MIN (2*y + 1, src_height - 1) * (ptrdiff_t) src_stride);
+	uint32_t *dst = (uint32_t *) (dst_data + y * (ptrdiff_t) dst_stride);
+
+	for (x = 0; x < dst_width; x++) {
+	    int x0 = 2*x, x1 = MIN (2*x + 1, src_width - 1);
+	    uint32_t lo, hi;
+
+	    lo = (row0[x0] & 0x00ff00ff) + (row0[x1] & 0x00ff00ff) +
+		 (row1[x0] & 0x00ff00ff) + (row1[x1] & 0x00ff00ff) +
+		 0x00020002;
+	    hi = ((row0[x0] >> 8) & 0x00ff00ff) + ((row0[x1] >> 8) & 0x00ff00ff) +
+		 ((row1[x0] >> 8) & 0x00ff00ff) + ((row1[x1] >> 8) & 0x00ff00ff) +
+		 0x00020002;
+
+	    dst[x] = ((lo >> 2) & 0x00ff00ff) | ((hi << 6) & 0xff00ff00);
+	}
+    }
+}
+
+/* Returns a reference to the pyramid for source, with at least the
+ * requested level built, where level 1 is half the size of the image. */
+static cairo_image_mipmap_t *
+_cairo_image_mipmap_get (cairo_image_surface_t *source, int level)
+{
+    cairo_image_mipmap_t *mipmap;
+
+    CAIRO_MUTEX_LOCK (_cairo_image_mipmap_mutex);
+
+    mipmap = (cairo_image_mipmap_t *)
+	_cairo_surface_has_snapshot (&source->base, &_cairo_image_mipmap_backend);
+    if (mipmap == NULL) {
+	mipmap = _cairo_malloc (sizeof (cairo_image_mipmap_t));
+	if (unlikely (mipmap == NULL))
+	    goto UNLOCK;
+
+	_cairo_surface_init (&mipmap->base, &_cairo_image_mipmap_backend,
+			     NULL, source->base.content, FALSE);
+	mipmap->num_levels = 0;
+
+	_cairo_surface_attach_snapshot (&source->base, &mipmap->base, NULL);
+	cairo_surface_destroy (&mipmap->base);
+    }
+
+    while (mipmap->num_levels < level) {
+	cairo_image_mipmap_level_t *dst = &mipmap->levels[mipmap->num_levels];
+	const uint8_t *src_data;
+	int src_width, src_height, src_stride;
+
+	if (mipmap->num_levels == 0) {
+	    src_data = source->data;
+	    src_width = source->width;
+	    src_height = source->height;
+	    src_stride = source->stride;
+	} else {
+	    const cairo_image_mipmap_level_t *src = dst - 1;
+
+	    src_data = (const uint8_t *) src->data;
+	    src_width = src->width;
+	    src_height = src->height;
+	    src_stride = src->stride;
+	}
+
+	dst->width = (src_width + 1) / 2;
+	dst->height = (src_height + 1) / 2;
+	dst->stride = dst->width * 4;
+	dst->data = _cairo_malloc_ab (dst->height, dst->stride);
+	if (unlikely (dst->data == NULL)) {
+	    mipmap = NULL;
+	    goto UNLOCK;
+	}
+
+	_cairo_image_mipmap_downsample (src_data, src_width, src_height, src_stride,
+					(uint8_t *) dst->data,
+					dst->width, dst->height, dst->stride);
+	mipmap->num_levels++;
+    }
+
+    /* Keep the pyramid alive should the image be modified as soon as
+     * the lock is dropped */
+    cairo_surface_reference (&mipmap->base);
+
+UNLOCK:
+    CAIRO_MUTEX_UNLOCK (_cairo_image_mipmap_mutex);
+    return mipmap;
+}
+
+static pixman_image_t *
+_pixman_image_for_mipmap (cairo_image_surface_t *source,
+			  const cairo_surface_pattern_t *pattern,
+			  const cairo_rectangle_int_t *extents,
+			  int *ix, int *iy)
+{
+    const cairo_matrix_t *m = &pattern->base.matrix;
+    cairo_image_mipmap_t *mipmap;
+    cairo_image_mipmap_level_t *level;
+    pixman_image_t *pixman_image;
+    cairo_matrix_t matrix, to_level;
+    double scale;
+    int n, size;
+
+    if (pattern->base.filter != CAIRO_FILTER_GOOD &&
+	pattern->base.filter != CAIRO_FILTER_BEST)
+	return NULL;
+
+    /* Only clamp to the edges, a repeating pattern would have to wrap
+     * around blocks straddling the edges of odd-sized images */
+    if (pattern->base.extend != CAIRO_EXTEND_NONE &&
+	pattern->base.extend != CAIRO_EXTEND_PAD)
+	return NULL;
+
+    if (source->pixman_format != PIXMAN_a8r8g8b8 &&
+	source->pixman_format != PIXMAN_x8r8g8b8)
+	return NULL;
+
+    if (! _cairo_image_mipmap_enabled ())
+	return NULL;
+
+    /* Pick the level by the smaller of the two scale factors (computed
+     * as in _pixman_image_set_properties), so that the filter never has
+     * to upscale in the other direction */
+    scale = MIN (hypot (m->xx, m->xy), hypot (m->yx, m->yy));
+    if (! (scale >= 2.))
+	return NULL;
+
+    size = MAX (source->width, source->height);
+    for (n = 0; n < MIPMAP_MAX_LEVELS && scale >= 2. && size > 1; n++) {
+	scale /= 2;
+	size = (size + 1) / 2;
+    }
+    if (n == 0)
+	return NULL;
+
+    mipmap = _cairo_image_mipmap_get (source, n);
+    if (unlikely (mipmap == NULL))
+	return NULL;
+
+    level = &mipmap->levels[n - 1];
+    pixman_image = pixman_image_create_bits (source->pixman_format,
+					     level->width, level->height,
+					     level->data, level->stride);
+    if (unlikely (pixman_image == NULL)) {
+	cairo_surface_destroy (&mipmap->base);
+	return NULL;
+    }
+
+    pixman_image_set_destroy_function (pixman_image,
+				       _defer_free_cleanup,
+				       &mipmap->base);
+
+    cairo_matrix_init_scale (&to_level, 1. / (1 << n), 1. / (1 << n));
+    cairo_matrix_multiply (&matrix, m, &to_level);
+    if (! _pixman_image_set_properties_for_matrix (pixman_image,
+						   &pattern->base, &matrix,
+						   extents, ix, iy))
+    {
+	pixman_image_unref (pixman_image);
+	return NULL;
+    }
+
+    return pixman_image;
+}
+
+
 struct proxy {
     cairo_surface_t base;
     cairo_surface_t *image;
@@ -1337,6 +2046,13 @@ _pixman_image_for_surface (cairo_image_surface_t *dst,
 	    }
 #endif
 
+	    pixman_image = _pixman_image_for_mipmap (source, pattern,
+						     extents, ix, iy);
+	    if (pixman_image != NULL) {
+		cairo_surface_destroy (defer_free);
+		return pixman_image;
+	    }
+
 	    pixman_image = pixman_image_create_bits (source->pixman_format,
 						     source->width,
 						     source->height,
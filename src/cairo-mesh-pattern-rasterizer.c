@@ -37,6 +37,7 @@
 #include "cairoint.h"
 
 #include "cairo-array-private.h"
+#include "cairo-parallel-private.h"
 #include "cairo-pattern-private.h"
 
 /*
@@ -181,6 +182,31 @@ _color_delta_to_shifted_short (int32_t from, int32_t to, int shift)
 	return -((-delta) >> shift);
 }
 
+/*
+ * Colors are stepped along a curve as four 16-bit lanes packed into a
+ * single 64-bit word (red in the lowest lane, alpha in the highest),
+ * so that the four components can be updated with one addition.
+ */
+#define COLOR_LANES_MSB 0x8000800080008000ULL
+
+static inline uint64_t
+_color_pack (uint16_t r, uint16_t g, uint16_t b, uint16_t a)
+{
+    return (uint64_t) r | (uint64_t) g << 16 | (uint64_t) b << 32 | (uint64_t) a << 48;
+}
+
+/*
+ * Add the packed colors c and d lane by lane, wrapping around modulo
+ * 2^16 in each lane exactly like four uint16_t additions would: the
+ * top bit of each lane is left out of the addition, so that no carry
+ * can cross into the next lane, and then added back in by hand.
+ */
+static inline uint64_t
+_color_add (uint64_t c, uint64_t d)
+{
+    return ((c & ~COLOR_LANES_MSB) + (d & ~COLOR_LANES_MSB)) ^ ((c ^ d) & COLOR_LANES_MSB);
+}
+
 /*
  * Convert a number of steps to the equivalent shift.
  *
@@ -439,10 +465,11 @@ intersect_interval (double a, double b, double c, double d)
  * Set the color of a pixel.
  *
  * Input: data is the base pointer of the image
- *        width, height are the dimensions of the image
+ *        width is the width of the image
  *        stride is the stride in bytes between adjacent rows
+ *        y_min, y_max delimit the rows [y_min, y_max) that may be written
  *        x, y are the coordinates of the pixel to be colored
- *        r,g,b,a are the color components of the color to be set
+ *        color is the packed (r,g,b,a) color to be set
  *
  * Output: the (x,y) pixel in data has the (r,g,b,a) color
  *
@@ -450,25 +477,30 @@ intersect_interval (double a, double b, double c, double d)
  * stored in the image is assumed to be in CAIRO_FORMAT_ARGB32 (8 bpc,
  * premultiplied).
  *
- * If the pixel to be set is outside the image, this function does
- * nothing.
+ * If the pixel to be set is outside the image or outside the allowed
+ * rows, this function does nothing.
  */
 static inline void
-draw_pixel (unsigned char *data, int width, int height, int stride,
-	    int x, int y, uint16_t r, uint16_t g, uint16_t b, uint16_t a)
+draw_pixel (unsigned char *data, int width, int stride, int y_min, int y_max,
+	    int x, int y, uint64_t color)
 {
-    if (likely (0 <= x && 0 <= y && x < width && y < height)) {
+    if (likely (0 <= x && y_min <= y && x < width && y < y_max)) {
+	uint64_t trb;
 	uint32_t tr, tg, tb, ta;
 
-	/* Premultiply and round */
-	ta = a;
-	tr = r * ta + 0x8000;
-	tg = g * ta + 0x8000;
-	tb = b * ta + 0x8000;
+	/* Premultiply and round; red and blue are multiplied together
+	 * in the two 32-bit halves of trb, as neither product can
+	 * overflow into the other half */
+	ta = color >> 48;
+	trb = (color & 0xffff) | (color & 0xffff00000000ULL);
+	trb = trb * ta + 0x0000800000008000ULL;
+	tg = ((color >> 16) & 0xffff) * ta + 0x8000;
 
-	tr += tr >> 16;
+	trb += (trb >> 16) & 0x0000ffff0000ffffULL;
 	tg += tg >> 16;
-	tb += tb >> 16;
+
+	tr = trb;
+	tb = trb >> 32;
 
 	*((uint32_t*) (data + y*(ptrdiff_t)stride + 4*x)) = ((ta << 16) & 0xff000000) |
 	    ((tr >> 8) & 0xff0000) | ((tg >> 16) & 0xff00) | (tb >> 24);
@@ -479,8 +511,9 @@ draw_pixel (unsigned char *data, int width, int height, int stride,
  * Forward-rasterize a cubic curve using forward differences.
  *
  * Input: data is the base pointer of the image
- *        width, height are the dimensions of the image
+ *        width is the width of the image
  *        stride is the stride in bytes between adjacent rows
+ *        y_min, y_max delimit the rows [y_min, y_max) that may be written
  *        ushift is log2(n) if n is the number of desired steps
  *        dxu[i], dyu[i] are the x,y forward differences of the curve
  *        r0,g0,b0,a0 are the color components of the start point
@@ -499,7 +532,8 @@ draw_pixel (unsigned char *data, int width, int height, int stride,
  * [0,1] (including both extremes).
  */
 static inline void
-rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
+rasterize_bezier_curve (unsigned char *data, int width, int stride,
+			int y_min, int y_max,
 			int ushift, double dxu[4], double dyu[4],
 			uint16_t r0, uint16_t g0, uint16_t b0, uint16_t a0,
 			uint16_t r3, uint16_t g3, uint16_t b3, uint16_t a3)
@@ -507,11 +541,11 @@ rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
     int32_t xu[4], yu[4];
     int x0, y0, u, usteps = 1 << ushift;
 
-    uint16_t r = r0, g = g0, b = b0, a = a0;
-    int16_t dr = _color_delta_to_shifted_short (r0, r3, ushift);
-    int16_t dg = _color_delta_to_shifted_short (g0, g3, ushift);
-    int16_t db = _color_delta_to_shifted_short (b0, b3, ushift);
-    int16_t da = _color_delta_to_shifted_short (a0, a3, ushift);
+    uint64_t color = _color_pack (r0, g0, b0, a0);
+    uint64_t dcolor = _color_pack (_color_delta_to_shifted_short (r0, r3, ushift),
+				   _color_delta_to_shifted_short (g0, g3, ushift),
+				   _color_delta_to_shifted_short (b0, b3, ushift),
+				   _color_delta_to_shifted_short (a0, a3, ushift));
 
     fd_fixed (dxu, xu);
     fd_fixed (dyu, yu);
@@ -537,14 +571,11 @@ rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
 	int x = _cairo_fixed_integer_floor (x0 + (xu[0] >> 15) + ((xu[0] >> 14) & 1));
 	int y = _cairo_fixed_integer_floor (y0 + (yu[0] >> 15) + ((yu[0] >> 14) & 1));
 
-	draw_pixel (data, width, height, stride, x, y, r, g, b, a);
+	draw_pixel (data, width, stride, y_min, y_max, x, y, color);
 
 	fd_fixed_fwd (xu);
 	fd_fixed_fwd (yu);
-	r += dr;
-	g += dg;
-	b += db;
-	a += da;
+	color = _color_add (color, dcolor);
     }
 }
 
@@ -554,6 +585,7 @@ rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
  * Input: data is the base pointer of the image
  *        width, height are the dimensions of the image
  *        stride is the stride in bytes between adjacent rows
+ *        y_min, y_max delimit the rows [y_min, y_max) that may be written
  *        p[i] is the i-th node of the Bezier curve
  *        c0[i] is the i-th color component at the start point
  *        c3[i] is the i-th color component at the end point
@@ -574,6 +606,7 @@ rasterize_bezier_curve (unsigned char *data, int width, int height, int stride,
  */
 static void
 draw_bezier_curve (unsigned char *data, int width, int height, int stride,
+		   int y_min, int y_max,
 		   cairo_point_double_t p[4], double c0[4], double c3[4])
 {
     double top, bottom, left, right, steps_sq;
@@ -585,6 +618,13 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
 	bottom = MAX (bottom, p[i].y);
     }
 
+    /* Skip curves that cannot touch the allowed rows, leaving a pixel
+     * of slack for the rounding in the forward differences.  This is
+     * kept separate from the visibility check below so that the
+     * number of steps only ever depends on the full image. */
+    if (bottom < y_min - 1 || top >= y_max + 1)
+	return;
+
     /* Check visibility */
     v = intersect_interval (top, bottom, 0, height);
     if (v == OUTSIDE)
@@ -615,8 +655,8 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
 	midc[1] = (c0[1] + c3[1]) * 0.5;
 	midc[2] = (c0[2] + c3[2]) * 0.5;
 	midc[3] = (c0[3] + c3[3]) * 0.5;
-	draw_bezier_curve (data, width, height, stride, first, c0, midc);
-	draw_bezier_curve (data, width, height, stride, second, midc, c3);
+	draw_bezier_curve (data, width, height, stride, y_min, y_max, first, c0, midc);
+	draw_bezier_curve (data, width, height, stride, y_min, y_max, second, midc, c3);
     } else {
 	double xu[4], yu[4];
 	int ushift = sqsteps2shift (steps_sq), k;
@@ -629,7 +669,7 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
 	    fd_down (yu);
 	}
 
-	rasterize_bezier_curve (data, width, height, stride, ushift,
+	rasterize_bezier_curve (data, width, stride, y_min, y_max, ushift,
 				xu, yu,
 				_cairo_color_double_to_short (c0[0]),
 				_cairo_color_double_to_short (c0[1]),
@@ -642,13 +682,13 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
 
 	/* Draw the end point, to make sure that we didn't leave it
 	 * out because of rounding */
-	draw_pixel (data, width, height, stride,
+	draw_pixel (data, width, stride, y_min, y_max,
 		    _cairo_fixed_integer_floor (_cairo_fixed_from_double (p[3].x)),
 		    _cairo_fixed_integer_floor (_cairo_fixed_from_double (p[3].y)),
-		    _cairo_color_double_to_short (c3[0]),
-		    _cairo_color_double_to_short (c3[1]),
-		    _cairo_color_double_to_short (c3[2]),
-		    _cairo_color_double_to_short (c3[3]));
+		    _color_pack (_cairo_color_double_to_short (c3[0]),
+				 _cairo_color_double_to_short (c3[1]),
+				 _cairo_color_double_to_short (c3[2]),
+				 _cairo_color_double_to_short (c3[3])));
     }
 }
 
@@ -658,6 +698,7 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
  * Input: data is the base pointer of the image
  *        width, height are the dimensions of the image
  *        stride is the stride in bytes between adjacent rows
+ *        y_min, y_max delimit the rows [y_min, y_max) that may be written
  *        vshift is log2(n) if n is the number of desired steps
  *        p[i][j], p[i][j] are the the nodes of the Bezier patch
  *        col[i][j] is the j-th color component of the i-th corner
@@ -693,7 +734,8 @@ draw_bezier_curve (unsigned char *data, int width, int height, int stride,
  * [0,1] (including both extremes).
  */
 static inline void
-rasterize_bezier_patch (unsigned char *data, int width, int height, int stride, int vshift,
+rasterize_bezier_patch (unsigned char *data, int width, int height, int stride,
+			int y_min, int y_max, int vshift,
 			cairo_point_double_t p[4][4], double col[4][4])
 {
     double pv[4][2][4], cstart[4], cend[4], dcstart[4], dcend[4];
@@ -736,7 +778,7 @@ rasterize_bezier_patch (unsigned char *data, int width, int height, int stride,
 	    nodes[i].y = pv[i][1][0];
 	}
 
-	draw_bezier_curve (data, width, height, stride, nodes, cstart, cend);
+	draw_bezier_curve (data, width, height, stride, y_min, y_max, nodes, cstart, cend);
 
 	for (i = 0; i < 4; ++i) {
 	    fd_fwd (pv[i][0]);
@@ -753,6 +795,7 @@ rasterize_bezier_patch (unsigned char *data, int width, int height, int stride,
  * Input: data is the base pointer of the image
  *        width, height are the dimensions of the image
  *        stride is the stride in bytes between adjacent rows
+ *        y_min, y_max delimit the rows [y_min, y_max) that may be written
  *        p[i][j], p[i][j] are the nodes of the patch
  *        col[i][j] is the j-th color component of the i-th corner
  *
@@ -790,7 +833,8 @@ rasterize_bezier_patch (unsigned char *data, int width, int height, int stride,
  */
 static void
 draw_bezier_patch (unsigned char *data, int width, int height, int stride,
-		     cairo_point_double_t p[4][4], double c[4][4])
+		   int y_min, int y_max,
+		   cairo_point_double_t p[4][4], double c[4][4])
 {
     double top, bottom, left, right, steps_sq;
     int i, j, v;
@@ -803,6 +847,9 @@ draw_bezier_patch (unsigned char *data, int width, int height, int stride,
 	}
     }
 
+    if (bottom < y_min - 1 || top >= y_max + 1)
+	return;
+
     v = intersect_interval (top, bottom, 0, height);
     if (v == OUTSIDE)
 	return;
@@ -845,7 +892,7 @@ draw_bezier_patch (unsigned char *data, int width, int height, int stride,
 	    subc[3][i] = 0.5 * (c[1][i] + c[3][i]);
 	}
 
-	draw_bezier_patch (data, width, height, stride, first, subc);
+	draw_bezier_patch (data, width, height, stride, y_min, y_max, first, subc);
 
 	for (i = 0; i < 4; ++i) {
 	    subc[0][i] = subc[2][i];
@@ -853,59 +900,41 @@ draw_bezier_patch (unsigned char *data, int width, int height, int stride,
 	    subc[2][i] = c[2][i];
 	    subc[3][i] = c[3][i];
 	}
-	draw_bezier_patch (data, width, height, stride, second, subc);
+	draw_bezier_patch (data, width, height, stride, y_min, y_max, second, subc);
     } else {
-	rasterize_bezier_patch (data, width, height, stride, sqsteps2shift (steps_sq), p, c);
+	rasterize_bezier_patch (data, width, height, stride, y_min, y_max,
+				sqsteps2shift (steps_sq), p, c);
     }
 }
 
 /*
- * Draw a tensor product shading pattern.
- *
- * Input: mesh is the mesh pattern
- *        data is the base pointer of the image
- *        width, height are the dimensions of the image
- *        stride is the stride in bytes between adjacent rows
+ * Draw the patches of a tensor product shading pattern, limiting the
+ * output to the rows [y_min, y_max).
  *
- * Output: data will be changed to have the pattern drawn on it
- *
- * data is assumed to be clear and its content is assumed to be in
- * CAIRO_FORMAT_ARGB32 (8 bpc, premultiplied).
- *
- * This function can be used to rasterize a PDF type 7 shading (see
- * http://www.adobe.com/devnet/pdf/pdf_reference.html).
+ * The patches are always drawn in order, so that later patches cover
+ * earlier ones exactly like they would when drawing the whole image
+ * at once.
  */
-void
-_cairo_mesh_pattern_rasterize (const cairo_mesh_pattern_t *mesh,
-			       void                       *data,
-			       int                         width,
-			       int                         height,
-			       int                         stride,
-			       double                      x_offset,
-			       double                      y_offset)
+static void
+draw_mesh_patches (const cairo_mesh_pattern_t *mesh,
+		   const cairo_matrix_t *p2u,
+		   unsigned char *data, int width, int height, int stride,
+		   int y_min, int y_max,
+		   double x_offset, double y_offset)
 {
     cairo_point_double_t nodes[4][4];
     double colors[4][4];
-    cairo_matrix_t p2u;
     unsigned int i, j, k, n;
-    cairo_status_t status;
     const cairo_mesh_patch_t *patch;
     const cairo_color_t *c;
 
-    assert (mesh->base.status == CAIRO_STATUS_SUCCESS);
-    assert (mesh->current_patch == NULL);
-
-    p2u = mesh->base.matrix;
-    status = cairo_matrix_invert (&p2u);
-    assert (status == CAIRO_STATUS_SUCCESS);
-
     n = _cairo_array_num_elements (&mesh->patches);
     patch = _cairo_array_index_const (&mesh->patches, 0);
     for (i = 0; i < n; i++) {
 	for (j = 0; j < 4; j++) {
 	    for (k = 0; k < 4; k++) {
 		nodes[j][k] = patch->points[j][k];
-		cairo_matrix_transform_point (&p2u, &nodes[j][k].x, &nodes[j][k].y);
+		cairo_matrix_transform_point (p2u, &nodes[j][k].x, &nodes[j][k].y);
 		nodes[j][k].x += x_offset;
 		nodes[j][k].y += y_offset;
 	    }
@@ -935,7 +964,95 @@ _cairo_mesh_pattern_rasterize (const cairo_mesh_pattern_t *mesh,
 	colors[3][2] = c->blue;
 	colors[3][3] = c->alpha;
 
-	draw_bezier_patch (data, width, height, stride, nodes, colors);
+	draw_bezier_patch (data, width, height, stride, y_min, y_max, nodes, colors);
 	patch++;
     }
 }
+
+/*
+ * When more than one thread is available, the image is split into
+ * horizontal bands which are rasterized independently.  Every band
+ * walks all of the patches, but only writes its own rows and skips
+ * whatever lies entirely above or below it; since the subdivision
+ * only depends on the full image, the result is identical to drawing
+ * the whole image on a single thread.
+ */
+#define MESH_BAND_MIN_HEIGHT 32
+
+typedef struct _cairo_mesh_bands {
+    const cairo_mesh_pattern_t *mesh;
+    cairo_matrix_t p2u;
+    unsigned char *data;
+    int width, height, stride;
+    int band_height;
+    double x_offset, y_offset;
+} cairo_mesh_bands_t;
+
+static void
+draw_mesh_band (void *closure, int index)
+{
+    cairo_mesh_bands_t *bands = closure;
+    int y_min = index * bands->band_height;
+    int y_max = MIN (y_min + bands->band_height, bands->height);
+
+    draw_mesh_patches (bands->mesh, &bands->p2u,
+		       bands->data, bands->width, bands->height, bands->stride,
+		       y_min, y_max,
+		       bands->x_offset, bands->y_offset);
+}
+
+/*
+ * Draw a tensor product shading pattern.
+ *
+ * Input: mesh is the mesh pattern
+ *        data is the base pointer of the image
+ *        width, height are the dimensions of the image
+ *        stride is the stride in bytes between adjacent rows
+ *
+ * Output: data will be changed to have the pattern drawn on it
+ *
+ * data is assumed to be clear and its content is assumed to be in
+ * CAIRO_FORMAT_ARGB32 (8 bpc, premultiplied).
+ *
+ * This function can be used to rasterize a PDF type 7 shading (see
+ * http://www.adobe.com/devnet/pdf/pdf_reference.html).
+ */
+void
+_cairo_mesh_pattern_rasterize (const cairo_mesh_pattern_t *mesh,
+			       void                       *data,
+			       int                         width,
+			       int                         height,
+			       int                         stride,
+			       double                      x_offset,
+			       double                      y_offset)
+{
+    cairo_mesh_bands_t bands;
+    cairo_status_t status;
+    int num_bands;
+
+    assert (mesh->base.status == CAIRO_STATUS_SUCCESS);
+    assert (mesh->current_patch == NULL);
+
+    bands.mesh = mesh;
+    bands.p2u = mesh->base.matrix;
+    status = cairo_matrix_invert (&bands.p2u);
+    assert (status == CAIRO_STATUS_SUCCESS);
+
+    bands.data = data;
+    bands.width = width;
+    bands.height = height;
+    bands.stride = stride;
+    bands.x_offset = x_offset;
+    bands.y_offset = y_offset;
+
+    num_bands = MIN (_cairo_parallel_get_num_threads (),
+		     height / MESH_BAND_MIN_HEIGHT);
+    if (num_bands <= 1) {
+	bands.band_height = height;
+	draw_mesh_band (&bands, 0);
+	return;
+    }
+
+    bands.band_height = (height + num_bands - 1) / num_bands;
+    _cairo_parallel_run (draw_mesh_band, &bands, num_bands);
+}
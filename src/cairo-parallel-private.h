@@ -0,0 +1,76 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is University of Southern
+ * California.
+ */
+
+#ifndef CAIRO_PARALLEL_PRIVATE_H
+#define CAIRO_PARALLEL_PRIVATE_H
+
+#include "cairo-compiler-private.h"
+
+CAIRO_BEGIN_DECLS
+
+/* Upper bound on the number of worker threads used for a single
+ * operation, regardless of what the environment asks for. */
+#define CAIRO_PARALLEL_MAX_THREADS 64
+
+typedef void (*cairo_parallel_func_t) (void *closure, int index);
+
+/* Returns the number of threads cairo may use to split up a single
+ * drawing operation.  This is read once from the CAIRO_THREADS
+ * environment variable and defaults to 1, i.e. everything is done
+ * on the calling thread unless the user explicitly opts in. */
+cairo_private int
+_cairo_parallel_get_num_threads (void);
+
+/* Returns a small number in [0, CAIRO_PARALLEL_MAX_THREADS) that
+ * stays fixed for the lifetime of the calling thread.  Threads are
+ * numbered in the order in which they first ask, wrapping around once
+ * there are more threads than slots, so the slot can be used to pick
+ * a mostly uncontended shard of some shared state.  Always 0 without
+ * thread support. */
+cairo_private int
+_cairo_parallel_get_thread_slot (void);
+
+/* Calls func(closure, i) for every i in [0, count), spreading the
+ * calls over up to _cairo_parallel_get_num_threads() threads (the
+ * calling thread included) and returning once all of them have
+ * completed.  The helper threads are kept in a pool between calls.
+ * Calls are made in order on the calling thread when there is no
+ * thread support, or when the pool is already busy with another
+ * operation (including one that is calling back in). */
+cairo_private void
+_cairo_parallel_run (cairo_parallel_func_t func,
+		     void *closure,
+		     int count);
+
+CAIRO_END_DECLS
+
+#endif /* CAIRO_PARALLEL_PRIVATE_H */
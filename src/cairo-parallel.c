@@ -0,0 +1,224 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is University of Southern
+ * California.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-atomic-private.h"
+#include "cairo-parallel-private.h"
+
+#if CAIRO_HAS_REAL_PTHREAD
+#include <pthread.h>
+#endif
+
+static int _cairo_parallel_num_threads;
+
+int
+_cairo_parallel_get_num_threads (void)
+{
+    static cairo_atomic_once_t once = CAIRO_ATOMIC_ONCE_INIT;
+
+    if (_cairo_atomic_init_once_enter (&once)) {
+	const char *env = getenv ("CAIRO_THREADS");
+	int num_threads = 1;
+
+#if CAIRO_HAS_REAL_PTHREAD
+	if (env != NULL)
+	    num_threads = atoi (env);
+	if (num_threads < 1)
+	    num_threads = 1;
+	if (num_threads > CAIRO_PARALLEL_MAX_THREADS)
+	    num_threads = CAIRO_PARALLEL_MAX_THREADS;
+#else
+	(void) env;
+#endif
+
+	_cairo_parallel_num_threads = num_threads;
+	_cairo_atomic_init_once_leave (&once);
+    }
+
+    return _cairo_parallel_num_threads;
+}
+
+#if CAIRO_HAS_REAL_PTHREAD
+static pthread_key_t _cairo_parallel_slot_key;
+static cairo_atomic_int_t _cairo_parallel_next_slot;
+
+int
+_cairo_parallel_get_thread_slot (void)
+{
+    static cairo_atomic_once_t once = CAIRO_ATOMIC_ONCE_INIT;
+    cairo_atomic_int_t slot;
+    void *value;
+
+    if (_cairo_atomic_init_once_enter (&once)) {
+	pthread_key_create (&_cairo_parallel_slot_key, NULL);
+	_cairo_atomic_init_once_leave (&once);
+    }
+
+    /* The slot is stored off by one so that NULL means unassigned */
+    value = pthread_getspecific (_cairo_parallel_slot_key);
+    if (value != NULL)
+	return (intptr_t) value - 1;
+
+    /* Wrap the counter itself, so that it can never overflow into a
+     * negative slot however many threads come and go. */
+    do {
+	slot = _cairo_atomic_int_get (&_cairo_parallel_next_slot);
+    } while (! _cairo_atomic_int_cmpxchg (&_cairo_parallel_next_slot,
+					  slot,
+					  (slot + 1) % CAIRO_PARALLEL_MAX_THREADS));
+
+    pthread_setspecific (_cairo_parallel_slot_key, (void *) (intptr_t) (slot + 1));
+    return slot;
+}
+
+/* The helper threads are started on first use and then kept around,
+ * waiting for the next job, so that splitting up an operation costs a
+ * wakeup rather than a thread creation.  Only one job runs at a time;
+ * a caller that finds the pool busy, such as a helper that itself
+ * tries to split its share, simply does all of its work inline.
+ */
+typedef struct _cairo_parallel_pool {
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    int num_workers;
+    int active;
+    unsigned int generation;
+
+    cairo_parallel_func_t func;
+    void *closure;
+    int next, count;
+} cairo_parallel_pool_t;
+
+static cairo_parallel_pool_t _cairo_parallel_pool = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+};
+static pthread_mutex_t _cairo_parallel_busy = PTHREAD_MUTEX_INITIALIZER;
+
+/* Called with the pool mutex held, which is dropped around each call */
+static void
+_cairo_parallel_pool_drain (cairo_parallel_pool_t *pool)
+{
+    while (pool->next < pool->count) {
+	int i = pool->next++;
+
+	pthread_mutex_unlock (&pool->mutex);
+	pool->func (pool->closure, i);
+	pthread_mutex_lock (&pool->mutex);
+    }
+}
+
+static void *
+_cairo_parallel_worker_main (void *arg)
+{
+    cairo_parallel_pool_t *pool = arg;
+    unsigned int seen = 0;
+
+    pthread_mutex_lock (&pool->mutex);
+    for (;;) {
+	while (pool->generation == seen)
+	    pthread_cond_wait (&pool->work, &pool->mutex);
+	seen = pool->generation;
+
+	pool->active++;
+	_cairo_parallel_pool_drain (pool);
+	if (--pool->active == 0)
+	    pthread_cond_signal (&pool->done);
+    }
+
+    return NULL;
+}
+
+void
+_cairo_parallel_run (cairo_parallel_func_t func,
+		     void *closure,
+		     int count)
+{
+    cairo_parallel_pool_t *pool = &_cairo_parallel_pool;
+    int num_threads, i;
+
+    num_threads = MIN (count, _cairo_parallel_get_num_threads ());
+    if (num_threads < 2 || pthread_mutex_trylock (&_cairo_parallel_busy)) {
+	for (i = 0; i < count; i++)
+	    func (closure, i);
+	return;
+    }
+
+    pthread_mutex_lock (&pool->mutex);
+
+    /* If we fail to spawn a helper, the work is shared among fewer */
+    while (pool->num_workers < num_threads - 1) {
+	pthread_t thread;
+
+	if (pthread_create (&thread, NULL, _cairo_parallel_worker_main, pool))
+	    break;
+
+	pthread_detach (thread);
+	pool->num_workers++;
+    }
+
+    pool->func = func;
+    pool->closure = closure;
+    pool->next = 0;
+    pool->count = count;
+    pool->generation++;
+    pthread_cond_broadcast (&pool->work);
+
+    /* The calling thread takes its share too */
+    _cairo_parallel_pool_drain (pool);
+    while (pool->active)
+	pthread_cond_wait (&pool->done, &pool->mutex);
+
+    pthread_mutex_unlock (&pool->mutex);
+    pthread_mutex_unlock (&_cairo_parallel_busy);
+}
+#else
+int
+_cairo_parallel_get_thread_slot (void)
+{
+    return 0;
+}
+
+void
+_cairo_parallel_run (cairo_parallel_func_t func,
+		     void *closure,
+		     int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+	func (closure, i);
+}
+#endif
@@ -40,6 +40,7 @@
 #include "cairo-error-private.h"
 #include "cairo-path-fixed-private.h"
 #include "cairo-region-private.h"
+#include "cairo-slope-private.h"
 #include "cairo-traps-private.h"
 
 typedef struct cairo_filler {
@@ -51,8 +52,98 @@ typedef struct cairo_filler {
 
     cairo_point_t current_point;
     cairo_point_t last_move_to;
+
+    /* Convexity of the outline, tracked as it is emitted: a single
+     * contour that always turns the same way and only reverses its
+     * vertical direction twice (at its top and bottom) is convex. */
+    cairo_bool_t convex;
+    int num_contours;
+    cairo_slope_t first, last;
+    int turn;
+    int first_dy, last_dy;
+    int dy_changes;
 } cairo_filler_t;
 
+static inline int
+_sign (cairo_fixed_t v)
+{
+    return (v > 0) - (v < 0);
+}
+
+static void
+_cairo_filler_turn (cairo_filler_t *filler,
+		    const cairo_slope_t *a,
+		    const cairo_slope_t *b)
+{
+    int turn;
+
+    turn = _cairo_int64_cmp (_cairo_int32x32_64_mul (a->dx, b->dy),
+			     _cairo_int32x32_64_mul (a->dy, b->dx));
+    if (turn == 0) {
+	/* Collinear, but doubling back on itself is a cusp. */
+	if (_sign (a->dx) != _sign (b->dx) || _sign (a->dy) != _sign (b->dy))
+	    filler->convex = FALSE;
+	return;
+    }
+
+    if (filler->turn == 0)
+	filler->turn = turn;
+    else if (filler->turn != turn)
+	filler->convex = FALSE;
+}
+
+static void
+_cairo_filler_add_segment (cairo_filler_t *filler,
+			   const cairo_point_t *point)
+{
+    cairo_slope_t slope;
+    int dy;
+
+    _cairo_slope_init (&slope, &filler->current_point, point);
+    if (slope.dx == 0 && slope.dy == 0)
+	return;
+
+    dy = _sign (slope.dy);
+    if (filler->first.dx == 0 && filler->first.dy == 0) {
+	if (++filler->num_contours > 1)
+	    filler->convex = FALSE;
+	filler->first = slope;
+	filler->first_dy = dy;
+    } else {
+	_cairo_filler_turn (filler, &filler->last, &slope);
+    }
+
+    if (dy) {
+	if (filler->last_dy && dy != filler->last_dy)
+	    filler->dy_changes++;
+	filler->last_dy = dy;
+	if (filler->first_dy == 0)
+	    filler->first_dy = dy;
+    }
+
+    filler->last = slope;
+}
+
+/* Completes the convexity test for the contour just closed, including
+ * the turn from its last segment back to its first. */
+static void
+_cairo_filler_end_contour (cairo_filler_t *filler)
+{
+    if (filler->first.dx == 0 && filler->first.dy == 0)
+	return;
+
+    _cairo_filler_turn (filler, &filler->last, &filler->first);
+    if (filler->first_dy && filler->first_dy != filler->last_dy)
+	filler->dy_changes++;
+    if (filler->dy_changes > 2)
+	filler->convex = FALSE;
+
+    filler->first.dx = filler->first.dy = 0;
+    filler->turn = 0;
+    filler->first_dy = filler->last_dy = 0;
+    filler->dy_changes = 0;
+}
+
 static cairo_status_t
 _cairo_filler_line_to (void *closure,
 		       const cairo_point_t *point)
@@ -60,6 +151,9 @@ _cairo_filler_line_to (void *closure,
     cairo_filler_t *filler = closure;
     cairo_status_t status;
 
+    if (filler->convex)
+	_cairo_filler_add_segment (filler, point);
+
     status = _cairo_polygon_add_external_edge (filler->polygon,
 					       &filler->current_point,
 					       point);
@@ -90,6 +184,9 @@ _cairo_filler_move_to (void *closure,
     if (unlikely (status))
 	return status;
 
+    if (filler->convex)
+	_cairo_filler_end_contour (filler);
+
         /* make sure that the closure represents a degenerate path */
     filler->current_point = *point;
     filler->last_move_to = *point;
@@ -144,16 +241,42 @@ _cairo_path_fixed_fill_to_polygon (const cairo_path_fixed_t *path,
     filler.current_point.y = 0;
     filler.last_move_to = filler.current_point;
 
-    status = _cairo_path_fixed_interpret (path,
-					  _cairo_filler_move_to,
-					  _cairo_filler_line_to,
-					  _cairo_filler_curve_to,
-					  _cairo_filler_close,
-					  &filler);
+    /* Only an outline filled into an empty polygon can be flagged. */
+    filler.convex = polygon->num_edges == 0;
+    filler.num_contours = 0;
+    filler.first.dx = filler.first.dy = 0;
+    filler.turn = 0;
+    filler.first_dy = filler.last_dy = 0;
+    filler.dy_changes = 0;
+
+    if (filler.has_limits) {
+	status = _cairo_path_fixed_interpret_culled (path,
+						     &filler.limit,
+						     _cairo_filler_move_to,
+						     _cairo_filler_line_to,
+						     _cairo_filler_curve_to,
+						     _cairo_filler_close,
+						     &filler);
+    } else {
+	status = _cairo_path_fixed_interpret (path,
+					      _cairo_filler_move_to,
+					      _cairo_filler_line_to,
+					      _cairo_filler_curve_to,
+					      _cairo_filler_close,
+					      &filler);
+    }
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_filler_close (&filler);
     if (unlikely (status))
 	return status;
 
-    return _cairo_filler_close (&filler);
+    if (filler.convex)
+	_cairo_filler_end_contour (&filler);
+    polygon->is_convex = filler.convex && polygon->num_edges > 0;
+
+    return CAIRO_STATUS_SUCCESS;
 }
 
 typedef struct cairo_filler_rectilinear_aligned {
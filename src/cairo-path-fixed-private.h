@@ -112,6 +112,27 @@ struct _cairo_path_fixed {
 
     cairo_box_t extents;
 
+    /* A flattened copy of the path, recorded once the path has been
+     * flattened twice in a row at the same tolerance without being
+     * modified.  Only the last tolerance is remembered, as a key from
+     * _cairo_path_flat_tolerance_key(), so that it can be updated
+     * atomically; a path flattened at alternating tolerances is never
+     * recorded. */
+    struct _cairo_path_flat *flat;
+    cairo_atomic_int_t flat_tolerance;
+
+    /* Likewise the output of the last dashed stroke, recorded once the
+     * path has been stroked twice with the same dash and style, and
+     * replaced when it is then stroked twice with another.  The last
+     * dash seen is remembered as a key folded from its hash. */
+    struct _cairo_stroker_dash_cache *dash_cache;
+    cairo_atomic_int_t dash_hash;
+
+    /* The ops and points of a compacted path, delta-coded in place of
+     * the buffers, which are then left empty.  A compacted path is only
+     * ever read, never added to or transformed. */
+    struct _cairo_path_packed *packed;
+
     cairo_path_buf_fixed_t  buf;
 };
 
@@ -120,6 +141,27 @@ _cairo_path_fixed_translate (cairo_path_fixed_t *path,
 			     cairo_fixed_t offx,
 			     cairo_fixed_t offy);
 
+cairo_private cairo_status_t
+_cairo_path_fixed_record_flat (cairo_path_fixed_t *path,
+			       double		   tolerance);
+
+cairo_private cairo_status_t
+_cairo_path_fixed_init_compact (cairo_path_fixed_t	 *path,
+				const cairo_path_fixed_t *other);
+
+cairo_private cairo_status_t
+_cairo_path_fixed_init_translated (cairo_path_fixed_t	    *path,
+				   const cairo_path_fixed_t *other,
+				   cairo_fixed_t	     offx,
+				   cairo_fixed_t	     offy);
+
+cairo_private cairo_bool_t
+_cairo_path_fixed_can_decimate (const cairo_path_fixed_t *path);
+
+cairo_private cairo_status_t
+_cairo_path_fixed_init_decimated (cairo_path_fixed_t	   *path,
+				  const cairo_path_fixed_t *other);
+
 cairo_private cairo_status_t
 _cairo_path_fixed_append (cairo_path_fixed_t		    *path,
 			  const cairo_path_fixed_t	    *other,
@@ -141,6 +183,13 @@ typedef struct _cairo_path_fixed_iter {
     const cairo_path_buf_t *buf;
     unsigned int n_op;
     unsigned int n_point;
+
+    /* or, for a compacted path, the op last read from it */
+    const struct _cairo_path_packed *packed;
+    const uint8_t *data;
+    cairo_path_op_t op;
+    cairo_point_t last;
+    cairo_point_t points[3];
 } cairo_path_fixed_iter_t;
 
 cairo_private void
@@ -203,4 +252,14 @@ _cairo_path_fixed_is_stroke_box (const cairo_path_fixed_t *path,
 cairo_private cairo_bool_t
 _cairo_path_fixed_is_simple_quad (const cairo_path_fixed_t *path);
 
+cairo_private cairo_bool_t
+_cairo_path_fixed_is_ellipse (const cairo_path_fixed_t *path,
+			      double *cx, double *cy,
+			      double *rx, double *ry);
+
+cairo_private cairo_bool_t
+_cairo_path_fixed_is_rounded_box (const cairo_path_fixed_t *path,
+				  cairo_box_t *box,
+				  double *rx, double *ry);
+
 #endif /* CAIRO_PATH_FIXED_PRIVATE_H */
@@ -38,11 +38,14 @@
 
 #include "cairoint.h"
 
+#include "cairo-array-private.h"
+#include "cairo-atomic-private.h"
 #include "cairo-box-inline.h"
 #include "cairo-error-private.h"
 #include "cairo-list-inline.h"
 #include "cairo-path-fixed-private.h"
 #include "cairo-slope-private.h"
+#include "cairo-stroke-dash-private.h"
 
 static cairo_status_t
 _cairo_path_fixed_add (cairo_path_fixed_t  *path,
@@ -69,6 +72,311 @@ _cairo_path_buf_add_points (cairo_path_buf_t       *buf,
 			    const cairo_point_t    *points,
 			    int		            num_points);
 
+static void
+_cairo_path_fixed_drop_flat (cairo_path_fixed_t *path);
+
+static void
+_cairo_path_fixed_drop_caches (cairo_path_fixed_t *path);
+
+/* A compacted path is a stream of ops, each a byte followed by its
+ * points.  Each point is stored as its difference from the one before
+ * in a pair of 16-bit words, or else, escaped by the first word being
+ * CAIRO_PATH_DELTA_ESCAPE, in a pair of 32-bit words after them. */
+typedef struct _cairo_path_packed {
+    unsigned int num_ops;
+    unsigned int num_points;
+    unsigned int size;
+} cairo_path_packed_t;
+
+#define CAIRO_PATH_DELTA_ESCAPE INT16_MIN
+#define CAIRO_PATH_DELTA_SIZE (2 * sizeof (int16_t))
+#define CAIRO_PATH_DELTA_ESCAPED_SIZE (CAIRO_PATH_DELTA_SIZE + 2 * sizeof (int32_t))
+
+static const uint8_t _cairo_path_op_num_points[] = { 1, 1, 3, 0 };
+
+#define _cairo_path_packed_data(packed__) ((uint8_t *) ((packed__) + 1))
+
+/* Differences wrap around rather than overflow. */
+static inline int32_t
+_cairo_path_delta (cairo_fixed_t a, cairo_fixed_t b)
+{
+    return (int32_t) ((uint32_t) a - (uint32_t) b);
+}
+
+static inline cairo_bool_t
+_cairo_path_delta_is_short (int32_t dx, int32_t dy)
+{
+    return dx == (int16_t) dx && dx != CAIRO_PATH_DELTA_ESCAPE &&
+	   dy == (int16_t) dy;
+}
+
+/* The stream is never stored, so its words are in native order. */
+static inline uint8_t *
+_cairo_path_pack_point (uint8_t *data,
+			const cairo_point_t *point,
+			cairo_point_t *last)
+{
+    int32_t dx = _cairo_path_delta (point->x, last->x);
+    int32_t dy = _cairo_path_delta (point->y, last->y);
+
+    *last = *point;
+    if (likely (_cairo_path_delta_is_short (dx, dy))) {
+	int16_t d[2] = { dx, dy };
+
+	memcpy (data, d, sizeof (d));
+	return data + CAIRO_PATH_DELTA_SIZE;
+    } else {
+	int16_t escape[2] = { CAIRO_PATH_DELTA_ESCAPE, 0 };
+	int32_t d[2] = { dx, dy };
+
+	memcpy (data, escape, sizeof (escape));
+	memcpy (data + sizeof (escape), d, sizeof (d));
+	return data + CAIRO_PATH_DELTA_ESCAPED_SIZE;
+    }
+}
+
+static inline const uint8_t *
+_cairo_path_unpack_point (const uint8_t *data,
+			  cairo_point_t *last)
+{
+    int16_t d[2];
+
+    memcpy (d, data, sizeof (d));
+    if (unlikely (d[0] == CAIRO_PATH_DELTA_ESCAPE)) {
+	int32_t e[2];
+
+	memcpy (e, data + sizeof (d), sizeof (e));
+	last->x = (cairo_fixed_t) ((uint32_t) last->x + (uint32_t) e[0]);
+	last->y = (cairo_fixed_t) ((uint32_t) last->y + (uint32_t) e[1]);
+	return data + CAIRO_PATH_DELTA_ESCAPED_SIZE;
+    }
+
+    last->x = (cairo_fixed_t) ((uint32_t) last->x + (uint32_t) d[0]);
+    last->y = (cairo_fixed_t) ((uint32_t) last->y + (uint32_t) d[1]);
+    return data + CAIRO_PATH_DELTA_SIZE;
+}
+
+/* Reads the op at @data into @op and @points, following on from the
+ * point @last; returns where the next op starts. */
+static inline const uint8_t *
+_cairo_path_unpack_op (const uint8_t *data,
+		       cairo_path_op_t *op,
+		       cairo_point_t *last,
+		       cairo_point_t *points)
+{
+    switch ((*op = *data++)) {
+    case CAIRO_PATH_OP_CURVE_TO:
+	data = _cairo_path_unpack_point (data, last);
+	points[0] = *last;
+	data = _cairo_path_unpack_point (data, last);
+	points[1] = *last;
+	data = _cairo_path_unpack_point (data, last);
+	points[2] = *last;
+	break;
+    case CAIRO_PATH_OP_MOVE_TO:
+    case CAIRO_PATH_OP_LINE_TO:
+	data = _cairo_path_unpack_point (data, last);
+	points[0] = *last;
+	break;
+    }
+
+    return data;
+}
+
+/* Returns the size of the stream for the ops and points of @path. */
+static unsigned int
+_cairo_path_packed_size (const cairo_path_fixed_t *path)
+{
+    const cairo_path_buf_t *buf;
+    cairo_point_t last;
+    unsigned int size;
+
+    last.x = last.y = 0;
+    size = 0;
+    cairo_path_foreach_buf_start (buf, path) {
+	unsigned int i;
+
+	size += buf->num_ops;
+	for (i = 0; i < buf->num_points; i++) {
+	    if (_cairo_path_delta_is_short (_cairo_path_delta (buf->points[i].x, last.x),
+					    _cairo_path_delta (buf->points[i].y, last.y)))
+		size += CAIRO_PATH_DELTA_SIZE;
+	    else
+		size += CAIRO_PATH_DELTA_ESCAPED_SIZE;
+	    last = buf->points[i];
+	}
+    } cairo_path_foreach_buf_end (buf, path);
+
+    return size;
+}
+
+static cairo_path_packed_t *
+_cairo_path_packed_create (const cairo_path_fixed_t *path)
+{
+    const cairo_path_buf_t *buf;
+    cairo_path_packed_t *packed;
+    cairo_point_t last;
+    uint8_t *data;
+    unsigned int size;
+
+    /* Paths of nothing but long jumps are left as they are. */
+    size = _cairo_path_packed_size (path);
+    if (size >= _cairo_path_fixed_size (path))
+	return NULL;
+
+    packed = _cairo_malloc (sizeof (cairo_path_packed_t) + size);
+    if (unlikely (packed == NULL))
+	return NULL;
+
+    packed->num_ops = packed->num_points = 0;
+    packed->size = size;
+
+    last.x = last.y = 0;
+    data = _cairo_path_packed_data (packed);
+    cairo_path_foreach_buf_start (buf, path) {
+	const cairo_point_t *points = buf->points;
+	unsigned int i, j;
+
+	for (i = 0; i < buf->num_ops; i++) {
+	    unsigned int num_points = _cairo_path_op_num_points[(int) buf->op[i]];
+
+	    *data++ = buf->op[i];
+	    for (j = 0; j < num_points; j++)
+		data = _cairo_path_pack_point (data, &points[j], &last);
+	    points += num_points;
+	}
+
+	packed->num_ops += buf->num_ops;
+	packed->num_points += buf->num_points;
+    } cairo_path_foreach_buf_end (buf, path);
+    assert (data == _cairo_path_packed_data (packed) + size);
+
+    return packed;
+}
+
+static cairo_path_packed_t *
+_cairo_path_packed_copy (const cairo_path_packed_t *other)
+{
+    cairo_path_packed_t *packed;
+
+    packed = _cairo_malloc (sizeof (cairo_path_packed_t) + other->size);
+    if (likely (packed != NULL))
+	memcpy (packed, other, sizeof (cairo_path_packed_t) + other->size);
+
+    return packed;
+}
+
+/* Fills the empty buffers of @path with the ops and points of @packed. */
+static cairo_status_t
+_cairo_path_packed_unpack (const cairo_path_packed_t *packed,
+			   cairo_path_fixed_t *path)
+{
+    cairo_path_buf_t *buf = cairo_path_head (path);
+    const uint8_t *data = _cairo_path_packed_data (packed);
+    cairo_point_t last, points[3];
+    unsigned int i, num_points = 0;
+    cairo_path_op_t op;
+
+    last.x = last.y = 0;
+    for (i = 0; i < packed->num_ops; i++) {
+	data = _cairo_path_unpack_op (data, &op, &last, points);
+
+	/* What does not fit in the embedded buffer goes into one more */
+	if (buf->num_ops == buf->size_ops ||
+	    buf->num_points + _cairo_path_op_num_points[(int) op] > buf->size_points)
+	{
+	    buf = _cairo_path_buf_create (packed->num_ops - i,
+					  packed->num_points - num_points);
+	    if (unlikely (buf == NULL))
+		return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+	    _cairo_path_fixed_add_buf (path, buf);
+	}
+
+	_cairo_path_buf_add_op (buf, op);
+	_cairo_path_buf_add_points (buf, points, _cairo_path_op_num_points[(int) op]);
+	num_points += _cairo_path_op_num_points[(int) op];
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_path_packed_interpret (const cairo_path_packed_t		*packed,
+			      cairo_path_fixed_move_to_func_t	*move_to,
+			      cairo_path_fixed_line_to_func_t	*line_to,
+			      cairo_path_fixed_curve_to_func_t	*curve_to,
+			      cairo_path_fixed_close_path_func_t	*close_path,
+			      void				*closure)
+{
+    const uint8_t *data = _cairo_path_packed_data (packed);
+    cairo_point_t last, points[3];
+    cairo_status_t status;
+    unsigned int i;
+
+    last.x = last.y = 0;
+    for (i = 0; i < packed->num_ops; i++) {
+	switch (*data++) {
+	case CAIRO_PATH_OP_MOVE_TO:
+	    data = _cairo_path_unpack_point (data, &last);
+	    status = (*move_to) (closure, &last);
+	    break;
+	case CAIRO_PATH_OP_LINE_TO:
+	    data = _cairo_path_unpack_point (data, &last);
+	    status = (*line_to) (closure, &last);
+	    break;
+	case CAIRO_PATH_OP_CURVE_TO:
+	    data = _cairo_path_unpack_point (data, &last);
+	    points[0] = last;
+	    data = _cairo_path_unpack_point (data, &last);
+	    points[1] = last;
+	    data = _cairo_path_unpack_point (data, &last);
+	    status = (*curve_to) (closure, &points[0], &points[1], &last);
+	    break;
+	default:
+	    ASSERT_NOT_REACHED;
+	case CAIRO_PATH_OP_CLOSE_PATH:
+	    status = (*close_path) (closure);
+	    break;
+	}
+
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static unsigned long
+_cairo_path_packed_hash (const cairo_path_packed_t *packed)
+{
+    unsigned long hash = _CAIRO_HASH_INIT_VALUE;
+    const uint8_t *data;
+    cairo_point_t last, points[3];
+    cairo_path_op_t op;
+    unsigned int i;
+
+    /* As _cairo_path_fixed_hash(): the ops, then the points */
+    data = _cairo_path_packed_data (packed);
+    last.x = last.y = 0;
+    for (i = 0; i < packed->num_ops; i++) {
+	data = _cairo_path_unpack_op (data, &op, &last, points);
+	hash = _cairo_hash_bytes (hash, &op, sizeof (op));
+    }
+    hash = _cairo_hash_bytes (hash, &packed->num_ops, sizeof (packed->num_ops));
+
+    data = _cairo_path_packed_data (packed);
+    last.x = last.y = 0;
+    for (i = 0; i < packed->num_ops; i++) {
+	data = _cairo_path_unpack_op (data, &op, &last, points);
+	hash = _cairo_hash_bytes (hash, points,
+				  _cairo_path_op_num_points[(int) op] * sizeof (points[0]));
+    }
+    hash = _cairo_hash_bytes (hash, &packed->num_points, sizeof (packed->num_points));
+
+    return hash;
+}
+
 void
 _cairo_path_fixed_init (cairo_path_fixed_t *path)
 {
@@ -98,6 +406,12 @@ _cairo_path_fixed_init (cairo_path_fixed_t *path)
 
     path->extents.p1.x = path->extents.p1.y = 0;
     path->extents.p2.x = path->extents.p2.y = 0;
+
+    path->flat = NULL;
+    path->flat_tolerance = 0;
+    path->dash_cache = NULL;
+    path->dash_hash = 0;
+    path->packed = NULL;
 }
 
 cairo_status_t
@@ -106,6 +420,7 @@ _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
 {
     cairo_path_buf_t *buf, *other_buf;
     unsigned int num_points, num_ops;
+    cairo_status_t status;
 
     VG (VALGRIND_MAKE_MEM_UNDEFINED (path, sizeof (cairo_path_fixed_t)));
 
@@ -130,6 +445,24 @@ _cairo_path_fixed_init_copy (cairo_path_fixed_t *path,
 
     path->extents = other->extents;
 
+    path->flat = NULL;
+    path->flat_tolerance = 0;
+    path->dash_cache = NULL;
+    path->dash_hash = 0;
+    path->packed = NULL;
+
+    /* Copies of a compacted path are expanded, ready to be modified. */
+    if (other->packed != NULL) {
+	path->buf.base.num_ops = 0;
+	path->buf.base.num_points = 0;
+
+	status = _cairo_path_packed_unpack (other->packed, path);
+	if (unlikely (status))
+	    _cairo_path_fixed_fini (path);
+
+	return status;
+    }
+
     path->buf.base.num_ops = other->buf.base.num_ops;
     path->buf.base.num_points = other->buf.base.num_points;
     memcpy (path->buf.op, other->buf.base.op,
@@ -179,6 +512,9 @@ _cairo_path_fixed_hash (const cairo_path_fixed_t *path)
     const cairo_path_buf_t *buf;
     unsigned int count;
 
+    if (path->packed != NULL)
+	return _cairo_path_packed_hash (path->packed);
+
     count = 0;
     cairo_path_foreach_buf_start (buf, path) {
 	hash = _cairo_hash_bytes (hash, buf->op,
@@ -204,6 +540,9 @@ _cairo_path_fixed_size (const cairo_path_fixed_t *path)
     const cairo_path_buf_t *buf;
     int num_points, num_ops;
 
+    if (path->packed != NULL)
+	return path->packed->size;
+
     num_ops = num_points = 0;
     cairo_path_foreach_buf_start (buf, path) {
 	num_ops    += buf->num_ops;
@@ -214,6 +553,38 @@ _cairo_path_fixed_size (const cairo_path_fixed_t *path)
 	   num_points * sizeof (buf->points[0]);
 }
 
+static cairo_bool_t
+_cairo_path_fixed_equal_packed (const cairo_path_fixed_t *a,
+				const cairo_path_fixed_t *b)
+{
+    cairo_path_fixed_t copy;
+    cairo_bool_t equal;
+
+    /* The same ops and points always pack the same way. */
+    if (a->packed != NULL && b->packed != NULL) {
+	return a->packed->num_ops == b->packed->num_ops &&
+	       a->packed->num_points == b->packed->num_points &&
+	       a->packed->size == b->packed->size &&
+	       memcmp (_cairo_path_packed_data (a->packed),
+		       _cairo_path_packed_data (b->packed),
+		       a->packed->size) == 0;
+    }
+
+    if (a->packed == NULL) {
+	const cairo_path_fixed_t *t = a;
+	a = b;
+	b = t;
+    }
+
+    if (unlikely (_cairo_path_fixed_init_copy (&copy, a)))
+	return FALSE;
+
+    equal = _cairo_path_fixed_equal (&copy, b);
+    _cairo_path_fixed_fini (&copy);
+
+    return equal;
+}
+
 cairo_bool_t
 _cairo_path_fixed_equal (const cairo_path_fixed_t *a,
 			 const cairo_path_fixed_t *b)
@@ -241,6 +612,9 @@ _cairo_path_fixed_equal (const cairo_path_fixed_t *a,
 	return FALSE;
     }
 
+    if (a->packed != NULL || b->packed != NULL)
+	return _cairo_path_fixed_equal_packed (a, b);
+
     num_ops_a = num_points_a = 0;
     cairo_path_foreach_buf_start (buf_a, a) {
 	num_ops_a    += buf_a->num_ops;
@@ -320,6 +694,55 @@ _cairo_path_fixed_equal (const cairo_path_fixed_t *a,
     return TRUE;
 }
 
+/**
+ * _cairo_path_fixed_init_compact:
+ * @path: the path to initialise
+ * @other: the path to copy
+ *
+ * Like _cairo_path_fixed_init_copy(), except that a path too long for
+ * the buffer embedded in @path is stored delta-coded, in a little over
+ * half the space, for keeping rather than building upon.  Reading @path
+ * is just as for any other path, but it must not be modified; a copy of
+ * it may be.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS or %CAIRO_STATUS_NO_MEMORY.
+ **/
+cairo_status_t
+_cairo_path_fixed_init_compact (cairo_path_fixed_t	 *path,
+				const cairo_path_fixed_t *other)
+{
+    cairo_path_packed_t *packed;
+
+    if (other->packed != NULL)
+	packed = _cairo_path_packed_copy (other->packed);
+    else if (cairo_path_buf_next (cairo_path_head (other)) != cairo_path_head (other))
+	packed = _cairo_path_packed_create (other);
+    else
+	packed = NULL;
+
+    if (packed == NULL)
+	return _cairo_path_fixed_init_copy (path, other);
+
+    _cairo_path_fixed_init (path);
+
+    path->current_point = other->current_point;
+    path->last_move_point = other->last_move_point;
+
+    path->has_current_point = other->has_current_point;
+    path->needs_move_to = other->needs_move_to;
+    path->has_extents = other->has_extents;
+    path->has_curve_to = other->has_curve_to;
+    path->stroke_is_rectilinear = other->stroke_is_rectilinear;
+    path->fill_is_rectilinear = other->fill_is_rectilinear;
+    path->fill_maybe_region = other->fill_maybe_region;
+    path->fill_is_empty = other->fill_is_empty;
+
+    path->extents = other->extents;
+
+    path->packed = packed;
+    return CAIRO_STATUS_SUCCESS;
+}
+
 cairo_path_fixed_t *
 _cairo_path_fixed_create (void)
 {
@@ -347,6 +770,9 @@ _cairo_path_fixed_fini (cairo_path_fixed_t *path)
 	_cairo_path_buf_destroy (this);
     }
 
+    free (path->packed);
+    _cairo_path_fixed_drop_caches (path);
+
     VG (VALGRIND_MAKE_MEM_UNDEFINED (path, sizeof (cairo_path_fixed_t)));
 }
 
@@ -362,6 +788,8 @@ _cairo_path_fixed_last_op (cairo_path_fixed_t *path)
 {
     cairo_path_buf_t *buf;
 
+    assert (path->packed == NULL);
+
     buf = cairo_path_tail (path);
     assert (buf->num_ops != 0);
 
@@ -391,6 +819,8 @@ _cairo_path_fixed_drop_line_to (cairo_path_fixed_t *path)
 
     assert (_cairo_path_fixed_last_op (path) == CAIRO_PATH_OP_LINE_TO);
 
+    _cairo_path_fixed_drop_caches (path);
+
     buf = cairo_path_tail (path);
     buf->num_points--;
     buf->num_ops--;
@@ -697,6 +1127,9 @@ _cairo_path_fixed_add (cairo_path_fixed_t   *path,
 {
     cairo_path_buf_t *buf = cairo_path_tail (path);
 
+    assert (path->packed == NULL);
+    _cairo_path_fixed_drop_caches (path);
+
     if (buf->num_ops + 1 > buf->size_ops ||
 	buf->num_points + num_points > buf->size_points)
     {
@@ -817,6 +1250,17 @@ _cairo_path_fixed_interpret (const cairo_path_fixed_t		*path,
     const cairo_path_buf_t *buf;
     cairo_status_t status;
 
+    if (path->packed != NULL) {
+	status = _cairo_path_packed_interpret (path->packed,
+					       move_to,
+					       line_to,
+					       curve_to,
+					       close_path,
+					       closure);
+	if (unlikely (status))
+	    return status;
+    }
+
     cairo_path_foreach_buf_start (buf, path) {
 	const cairo_point_t *points = buf->points;
 	unsigned int i;
@@ -853,86 +1297,356 @@ _cairo_path_fixed_interpret (const cairo_path_fixed_t		*path,
     return CAIRO_STATUS_SUCCESS;
 }
 
-typedef struct _cairo_path_fixed_append_closure {
-    cairo_point_t	    offset;
-    cairo_path_fixed_t	    *path;
-} cairo_path_fixed_append_closure_t;
+/* Closure for culling the path against a box */
+typedef struct cairo_path_culler {
+    cairo_box_t bounds;
+    cairo_path_fixed_move_to_func_t *move_to;
+    cairo_path_fixed_line_to_func_t *line_to;
+    cairo_path_fixed_curve_to_func_t *curve_to;
+    cairo_path_fixed_close_path_func_t *close_path;
+    void *closure;
 
-static cairo_status_t
-_append_move_to (void		 *abstract_closure,
-		 const cairo_point_t  *point)
+    cairo_point_t current_point;
+    cairo_point_t last_move_to;
+    cairo_bool_t has_first_segment;
+
+    /* The run of culled segments, and the last of them */
+    unsigned int run;
+    unsigned int run_length;
+    cairo_path_op_t last_op;
+    cairo_point_t last_start;
+    cairo_point_t last[3];
+} cpc_t;
+
+enum {
+    CPC_LEFT = 0x1,
+    CPC_RIGHT = 0x2,
+    CPC_ABOVE = 0x4,
+    CPC_BELOW = 0x8
+};
+
+static inline unsigned int
+_cpc_outcode (const cpc_t *cpc, const cairo_point_t *point)
 {
-    cairo_path_fixed_append_closure_t	*closure = abstract_closure;
+    unsigned int code = 0;
 
-    return _cairo_path_fixed_move_to (closure->path,
-				      point->x + closure->offset.x,
-				      point->y + closure->offset.y);
+    if (point->x < cpc->bounds.p1.x)
+	code |= CPC_LEFT;
+    else if (point->x > cpc->bounds.p2.x)
+	code |= CPC_RIGHT;
+
+    if (point->y < cpc->bounds.p1.y)
+	code |= CPC_ABOVE;
+    else if (point->y > cpc->bounds.p2.y)
+	code |= CPC_BELOW;
+
+    return code;
 }
 
+/* Ends a run of culled segments: a line stands in for all but the last
+ * segment, which is passed on as it was so that whatever follows the
+ * run joins onto it just the same. */
 static cairo_status_t
-_append_line_to (void		 *abstract_closure,
-		 const cairo_point_t *point)
+_cpc_flush (cpc_t *cpc)
 {
-    cairo_path_fixed_append_closure_t	*closure = abstract_closure;
+    cairo_status_t status;
 
-    return _cairo_path_fixed_line_to (closure->path,
-				      point->x + closure->offset.x,
-				      point->y + closure->offset.y);
+    if (cpc->run == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    cpc->run = 0;
+    if (cpc->run_length > 1) {
+	status = cpc->line_to (cpc->closure, &cpc->last_start);
+	if (unlikely (status))
+	    return status;
+    }
+
+    if (cpc->last_op == CAIRO_PATH_OP_CURVE_TO) {
+	return cpc->curve_to (cpc->closure,
+			      &cpc->last[0], &cpc->last[1], &cpc->last[2]);
+    }
+
+    return cpc->line_to (cpc->closure, &cpc->last[0]);
 }
 
-static cairo_status_t
-_append_curve_to (void	  *abstract_closure,
-		  const cairo_point_t *p0,
-		  const cairo_point_t *p1,
-		  const cairo_point_t *p2)
+/* A segment wholly beyond one side of the bounds joins the run beyond
+ * that side; returns FALSE if it must be passed on instead. */
+static cairo_bool_t
+_cpc_cull (cpc_t *cpc,
+	   unsigned int side,
+	   cairo_path_op_t op,
+	   const cairo_point_t *points,
+	   int num_points)
 {
-    cairo_path_fixed_append_closure_t	*closure = abstract_closure;
+    /* Closing the subpath joins onto its first segment, so that is
+     * always passed on as it is. */
+    if (side == 0 || ! cpc->has_first_segment)
+	return FALSE;
 
-    return _cairo_path_fixed_curve_to (closure->path,
-				       p0->x + closure->offset.x,
-				       p0->y + closure->offset.y,
-				       p1->x + closure->offset.x,
-				       p1->y + closure->offset.y,
-				       p2->x + closure->offset.x,
-				       p2->y + closure->offset.y);
+    /* Edges beyond the left or right side are still clipped to vertical
+     * edges along it, so a vertex dropped there alongside the bounds
+     * would move where those edges end, and with it how the rows they
+     * end in are rasterised. */
+    if ((side & (CPC_ABOVE | CPC_BELOW)) == 0) {
+	const cairo_point_t *end = &points[num_points - 1];
+
+	if (end->y > cpc->bounds.p1.y && end->y < cpc->bounds.p2.y)
+	    return FALSE;
+    }
+
+    if (cpc->run && (cpc->run & side) == 0)
+	return FALSE;
+
+    if (cpc->run) {
+	cpc->run &= side;
+	cpc->run_length++;
+    } else {
+	cpc->run = side;
+	cpc->run_length = 1;
+    }
+
+    cpc->last_op = op;
+    cpc->last_start = cpc->current_point;
+    memcpy (cpc->last, points, num_points * sizeof (cairo_point_t));
+    cpc->current_point = points[num_points - 1];
+    return TRUE;
 }
 
 static cairo_status_t
-_append_close_path (void *abstract_closure)
+_cpc_move_to (void *closure,
+	      const cairo_point_t *point)
 {
-    cairo_path_fixed_append_closure_t	*closure = abstract_closure;
+    cpc_t *cpc = closure;
+    cairo_status_t status;
 
-    return _cairo_path_fixed_close_path (closure->path);
+    status = _cpc_flush (cpc);
+    if (unlikely (status))
+	return status;
+
+    cpc->current_point = *point;
+    cpc->last_move_to = *point;
+    cpc->has_first_segment = FALSE;
+    return cpc->move_to (cpc->closure, point);
 }
 
-cairo_status_t
-_cairo_path_fixed_append (cairo_path_fixed_t		    *path,
-			  const cairo_path_fixed_t	    *other,
-			  cairo_fixed_t			     tx,
-			  cairo_fixed_t			     ty)
+static cairo_status_t
+_cpc_line_to (void *closure,
+	      const cairo_point_t *point)
 {
-    cairo_path_fixed_append_closure_t closure;
+    cpc_t *cpc = closure;
+    cairo_status_t status;
+    unsigned int side;
 
-    closure.path = path;
-    closure.offset.x = tx;
-    closure.offset.y = ty;
+    side = _cpc_outcode (cpc, &cpc->current_point) & _cpc_outcode (cpc, point);
+    if (_cpc_cull (cpc, side, CAIRO_PATH_OP_LINE_TO, point, 1))
+	return CAIRO_STATUS_SUCCESS;
 
-    return _cairo_path_fixed_interpret (other,
-					_append_move_to,
-					_append_line_to,
-					_append_curve_to,
-					_append_close_path,
-					&closure);
+    status = _cpc_flush (cpc);
+    if (unlikely (status))
+	return status;
+
+    /* A run may start afresh on the far side. */
+    if (_cpc_cull (cpc, side, CAIRO_PATH_OP_LINE_TO, point, 1))
+	return CAIRO_STATUS_SUCCESS;
+
+    cpc->current_point = *point;
+    cpc->has_first_segment = TRUE;
+    return cpc->line_to (cpc->closure, point);
 }
 
-static void
-_cairo_path_fixed_offset_and_scale (cairo_path_fixed_t *path,
-				    cairo_fixed_t offx,
-				    cairo_fixed_t offy,
-				    cairo_fixed_t scalex,
-				    cairo_fixed_t scaley)
+static cairo_status_t
+_cpc_curve_to (void *closure,
+	       const cairo_point_t *p0,
+	       const cairo_point_t *p1,
+	       const cairo_point_t *p2)
 {
-    cairo_path_buf_t *buf;
+    cpc_t *cpc = closure;
+    cairo_point_t points[3];
+    cairo_status_t status;
+    unsigned int side;
+
+    /* The curve lies within the hull of its control points. */
+    side = _cpc_outcode (cpc, &cpc->current_point) &
+	   _cpc_outcode (cpc, p0) &
+	   _cpc_outcode (cpc, p1) &
+	   _cpc_outcode (cpc, p2);
+
+    points[0] = *p0;
+    points[1] = *p1;
+    points[2] = *p2;
+    if (_cpc_cull (cpc, side, CAIRO_PATH_OP_CURVE_TO, points, 3))
+	return CAIRO_STATUS_SUCCESS;
+
+    status = _cpc_flush (cpc);
+    if (unlikely (status))
+	return status;
+
+    if (_cpc_cull (cpc, side, CAIRO_PATH_OP_CURVE_TO, points, 3))
+	return CAIRO_STATUS_SUCCESS;
+
+    cpc->current_point = *p2;
+    cpc->has_first_segment = TRUE;
+    return cpc->curve_to (cpc->closure, p0, p1, p2);
+}
+
+static cairo_status_t
+_cpc_close_path (void *closure)
+{
+    cpc_t *cpc = closure;
+    cairo_status_t status;
+
+    status = _cpc_flush (cpc);
+    if (unlikely (status))
+	return status;
+
+    cpc->current_point = cpc->last_move_to;
+    cpc->has_first_segment = FALSE;
+    return cpc->close_path (cpc->closure);
+}
+
+/**
+ * _cairo_path_fixed_interpret_culled:
+ *
+ * Like _cairo_path_fixed_interpret(), except that the parts of the path
+ * far outside of @bounds are simplified away.  Each run of segments
+ * lying wholly beyond the same side of @bounds is passed on as a single
+ * line to the start of its last segment, followed by that segment.  The
+ * line lies beyond the same side, and so crosses nothing within @bounds
+ * that the run did not.  Fills keep their winding within @bounds, and
+ * outlines built around the path keep their shape within @bounds less
+ * however far they may reach from the path.  A zoomed-in view of a huge
+ * path then costs in proportion to what is visible.
+ *
+ * The lengths of segments are not kept, so this is no good for dashing.
+ **/
+cairo_status_t
+_cairo_path_fixed_interpret_culled (const cairo_path_fixed_t		*path,
+				    const cairo_box_t			*bounds,
+				    cairo_path_fixed_move_to_func_t	*move_to,
+				    cairo_path_fixed_line_to_func_t	*line_to,
+				    cairo_path_fixed_curve_to_func_t	*curve_to,
+				    cairo_path_fixed_close_path_func_t	*close_path,
+				    void				*closure)
+{
+    cpc_t cpc;
+    cairo_status_t status;
+
+    if (path->extents.p1.x >= bounds->p1.x &&
+	path->extents.p2.x <= bounds->p2.x &&
+	path->extents.p1.y >= bounds->p1.y &&
+	path->extents.p2.y <= bounds->p2.y)
+    {
+	return _cairo_path_fixed_interpret (path,
+					    move_to,
+					    line_to,
+					    curve_to,
+					    close_path,
+					    closure);
+    }
+
+    cpc.bounds = *bounds;
+    cpc.move_to = move_to;
+    cpc.line_to = line_to;
+    cpc.curve_to = curve_to;
+    cpc.close_path = close_path;
+    cpc.closure = closure;
+    cpc.current_point.x = cpc.current_point.y = 0;
+    cpc.last_move_to = cpc.current_point;
+    cpc.has_first_segment = FALSE;
+    cpc.run = 0;
+
+    status = _cairo_path_fixed_interpret (path,
+					  _cpc_move_to,
+					  _cpc_line_to,
+					  _cpc_curve_to,
+					  _cpc_close_path,
+					  &cpc);
+    if (unlikely (status))
+	return status;
+
+    return _cpc_flush (&cpc);
+}
+
+typedef struct _cairo_path_fixed_append_closure {
+    cairo_point_t	    offset;
+    cairo_path_fixed_t	    *path;
+} cairo_path_fixed_append_closure_t;
+
+static cairo_status_t
+_append_move_to (void		 *abstract_closure,
+		 const cairo_point_t  *point)
+{
+    cairo_path_fixed_append_closure_t	*closure = abstract_closure;
+
+    return _cairo_path_fixed_move_to (closure->path,
+				      point->x + closure->offset.x,
+				      point->y + closure->offset.y);
+}
+
+static cairo_status_t
+_append_line_to (void		 *abstract_closure,
+		 const cairo_point_t *point)
+{
+    cairo_path_fixed_append_closure_t	*closure = abstract_closure;
+
+    return _cairo_path_fixed_line_to (closure->path,
+				      point->x + closure->offset.x,
+				      point->y + closure->offset.y);
+}
+
+static cairo_status_t
+_append_curve_to (void	  *abstract_closure,
+		  const cairo_point_t *p0,
+		  const cairo_point_t *p1,
+		  const cairo_point_t *p2)
+{
+    cairo_path_fixed_append_closure_t	*closure = abstract_closure;
+
+    return _cairo_path_fixed_curve_to (closure->path,
+				       p0->x + closure->offset.x,
+				       p0->y + closure->offset.y,
+				       p1->x + closure->offset.x,
+				       p1->y + closure->offset.y,
+				       p2->x + closure->offset.x,
+				       p2->y + closure->offset.y);
+}
+
+static cairo_status_t
+_append_close_path (void *abstract_closure)
+{
+    cairo_path_fixed_append_closure_t	*closure = abstract_closure;
+
+    return _cairo_path_fixed_close_path (closure->path);
+}
+
+cairo_status_t
+_cairo_path_fixed_append (cairo_path_fixed_t		    *path,
+			  const cairo_path_fixed_t	    *other,
+			  cairo_fixed_t			     tx,
+			  cairo_fixed_t			     ty)
+{
+    cairo_path_fixed_append_closure_t closure;
+
+    closure.path = path;
+    closure.offset.x = tx;
+    closure.offset.y = ty;
+
+    return _cairo_path_fixed_interpret (other,
+					_append_move_to,
+					_append_line_to,
+					_append_curve_to,
+					_append_close_path,
+					&closure);
+}
+
+static void
+_cairo_path_fixed_offset_and_scale (cairo_path_fixed_t *path,
+				    cairo_fixed_t offx,
+				    cairo_fixed_t offy,
+				    cairo_fixed_t scalex,
+				    cairo_fixed_t scaley)
+{
+    cairo_path_buf_t *buf;
     unsigned int i;
 
     if (scalex == CAIRO_FIXED_ONE && scaley == CAIRO_FIXED_ONE) {
@@ -940,6 +1654,9 @@ _cairo_path_fixed_offset_and_scale (cairo_path_fixed_t *path,
 	return;
     }
 
+    assert (path->packed == NULL);
+    _cairo_path_fixed_drop_caches (path);
+
     path->last_move_point.x = _cairo_fixed_mul (scalex, path->last_move_point.x) + offx;
     path->last_move_point.y = _cairo_fixed_mul (scaley, path->last_move_point.y) + offy;
     path->current_point.x   = _cairo_fixed_mul (scalex, path->current_point.x) + offx;
@@ -994,6 +1711,9 @@ _cairo_path_fixed_translate (cairo_path_fixed_t *path,
     if (offx == 0 && offy == 0)
 	return;
 
+    assert (path->packed == NULL);
+    _cairo_path_fixed_drop_caches (path);
+
     path->last_move_point.x += offx;
     path->last_move_point.y += offy;
     path->current_point.x += offx;
@@ -1063,6 +1783,9 @@ _cairo_path_fixed_transform (cairo_path_fixed_t	*path,
 	return;
     }
 
+    assert (path->packed == NULL);
+    _cairo_path_fixed_drop_caches (path);
+
     _cairo_path_fixed_transform_point (&path->last_move_point, matrix);
     _cairo_path_fixed_transform_point (&path->current_point, matrix);
 
@@ -1166,6 +1889,169 @@ _cpf_close_path (void *closure)
     return cpf->close_path (cpf->closure);
 }
 
+/* The flattened path, recorded as the sequence of callbacks made by
+ * _cairo_path_fixed_interpret_flat(). */
+typedef struct _cairo_path_flat {
+    double tolerance;
+    cairo_array_t ops;
+    cairo_array_t points;
+} cairo_path_flat_t;
+
+/* Reduces a tolerance to the bits of a float, never 0 for a valid
+ * tolerance, so that the last one seen fits in an atomic int. */
+static cairo_atomic_int_t
+_cairo_path_flat_tolerance_key (double tolerance)
+{
+    union {
+	float f;
+	int32_t i;
+    } u;
+
+    u.f = tolerance;
+    return u.i;
+}
+
+/* Beyond this many points a flattened path is not worth keeping. */
+#define CAIRO_PATH_FLAT_MAX_POINTS (1 << 20)
+
+static void
+_cairo_path_flat_destroy (cairo_path_flat_t *flat)
+{
+    _cairo_array_fini (&flat->ops);
+    _cairo_array_fini (&flat->points);
+    free (flat);
+}
+
+static void
+_cairo_path_fixed_drop_flat (cairo_path_fixed_t *path)
+{
+    if (unlikely (path->flat != NULL)) {
+	_cairo_path_flat_destroy (path->flat);
+	path->flat = NULL;
+    }
+    path->flat_tolerance = 0;
+}
+
+/* Forgets everything derived from the path, as it is about to change. */
+static void
+_cairo_path_fixed_drop_caches (cairo_path_fixed_t *path)
+{
+    _cairo_path_fixed_drop_flat (path);
+
+    if (unlikely (path->dash_cache != NULL)) {
+	_cairo_stroker_dash_cache_destroy (path->dash_cache);
+	path->dash_cache = NULL;
+    }
+    path->dash_hash = 0;
+}
+
+static cairo_status_t
+_cairo_path_flat_interpret (const cairo_path_flat_t		*flat,
+			    cairo_path_fixed_move_to_func_t	*move_to,
+			    cairo_path_fixed_line_to_func_t	*line_to,
+			    cairo_path_fixed_close_path_func_t	*close_path,
+			    void				*closure)
+{
+    const cairo_path_op_t *op;
+    const cairo_point_t *points;
+    unsigned int i, num_ops;
+    cairo_status_t status;
+
+    num_ops = _cairo_array_num_elements (&flat->ops);
+    if (num_ops == 0)
+	return CAIRO_STATUS_SUCCESS;
+
+    op = _cairo_array_index_const (&flat->ops, 0);
+    points = _cairo_array_index_const (&flat->points, 0);
+    for (i = 0; i < num_ops; i++) {
+	switch (op[i]) {
+	case CAIRO_PATH_OP_MOVE_TO:
+	    status = move_to (closure, points++);
+	    break;
+	case CAIRO_PATH_OP_LINE_TO:
+	    status = line_to (closure, points++);
+	    break;
+	case CAIRO_PATH_OP_CLOSE_PATH:
+	    status = close_path (closure);
+	    break;
+	case CAIRO_PATH_OP_CURVE_TO:
+	default:
+	    ASSERT_NOT_REACHED;
+	    status = CAIRO_STATUS_SUCCESS;
+	    break;
+	}
+	if (unlikely (status))
+	    return status;
+    }
+
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Passes the flattened path on to the caller, recording it on the way.
+ * Should recording fail, the path is still passed on, just not kept. */
+typedef struct _cairo_path_flat_recorder {
+    cairo_path_flat_t *flat;
+    cairo_path_fixed_move_to_func_t	*move_to;
+    cairo_path_fixed_line_to_func_t	*line_to;
+    cairo_path_fixed_close_path_func_t	*close_path;
+    void *closure;
+} cairo_path_flat_recorder_t;
+
+static void
+_cairo_path_flat_record (cairo_path_flat_recorder_t *recorder,
+			 cairo_path_op_t op,
+			 const cairo_point_t *point)
+{
+    cairo_path_flat_t *flat = recorder->flat;
+
+    if (flat == NULL)
+	return;
+
+    if (point != NULL) {
+	if (_cairo_array_num_elements (&flat->points) == CAIRO_PATH_FLAT_MAX_POINTS)
+	    goto drop;
+	if (unlikely (_cairo_array_append (&flat->points, point)))
+	    goto drop;
+    }
+    if (unlikely (_cairo_array_append (&flat->ops, &op)))
+	goto drop;
+
+    return;
+
+drop:
+    _cairo_path_flat_destroy (flat);
+    recorder->flat = NULL;
+}
+
+static cairo_status_t
+_cairo_path_flat_record_move_to (void *closure,
+				 const cairo_point_t *point)
+{
+    cairo_path_flat_recorder_t *recorder = closure;
+
+    _cairo_path_flat_record (recorder, CAIRO_PATH_OP_MOVE_TO, point);
+    return recorder->move_to (recorder->closure, point);
+}
+
+static cairo_status_t
+_cairo_path_flat_record_line_to (void *closure,
+				 const cairo_point_t *point)
+{
+    cairo_path_flat_recorder_t *recorder = closure;
+
+    _cairo_path_flat_record (recorder, CAIRO_PATH_OP_LINE_TO, point);
+    return recorder->line_to (recorder->closure, point);
+}
+
+static cairo_status_t
+_cairo_path_flat_record_close_path (void *closure)
+{
+    cairo_path_flat_recorder_t *recorder = closure;
+
+    _cairo_path_flat_record (recorder, CAIRO_PATH_OP_CLOSE_PATH, NULL);
+    return recorder->close_path (recorder->closure);
+}
+
 cairo_status_t
 _cairo_path_fixed_interpret_flat (const cairo_path_fixed_t		*path,
 				  cairo_path_fixed_move_to_func_t	*move_to,
@@ -1174,7 +2060,12 @@ _cairo_path_fixed_interpret_flat (const cairo_path_fixed_t		*path,
 				  void					*closure,
 				  double				tolerance)
 {
+    cairo_path_fixed_t *cache = (cairo_path_fixed_t *) path;
+    cairo_path_flat_recorder_t recorder;
+    cairo_path_flat_t *flat;
+    cairo_atomic_int_t key, seen;
     cpf_t flattener;
+    cairo_status_t status;
 
     if (! path->has_curve_to) {
 	return _cairo_path_fixed_interpret (path,
@@ -1185,17 +2076,373 @@ _cairo_path_fixed_interpret_flat (const cairo_path_fixed_t		*path,
 					    closure);
     }
 
+    /* The path is logically const; the flattened copy kept alongside
+     * it is only ever installed once, and only dropped by modifying
+     * the path.  Recording is deferred until the same path is flattened
+     * again, so that a path filled just the once costs nothing more.
+     * Only the last tolerance is remembered, so alternating between two
+     * tolerances keeps replacing it and nothing is ever recorded. */
+    flat = _cairo_atomic_ptr_get ((void **) &cache->flat);
+    if (flat != NULL && flat->tolerance == tolerance)
+	return _cairo_path_flat_interpret (flat, move_to, line_to, close_path,
+					   closure);
+
+    /* A racing flatten may overwrite the tolerance seen; that only
+     * costs a recording, never correctness. */
+    recorder.flat = NULL;
+    key = _cairo_path_flat_tolerance_key (tolerance);
+    seen = _cairo_atomic_int_get (&cache->flat_tolerance);
+    if (seen != key) {
+	_cairo_atomic_int_cmpxchg (&cache->flat_tolerance, seen, key);
+    } else if (flat == NULL) {
+	recorder.flat = _cairo_malloc (sizeof (cairo_path_flat_t));
+	if (likely (recorder.flat != NULL)) {
+	    recorder.flat->tolerance = tolerance;
+	    _cairo_array_init (&recorder.flat->ops, sizeof (cairo_path_op_t));
+	    _cairo_array_init (&recorder.flat->points, sizeof (cairo_point_t));
+	}
+    }
+
     flattener.tolerance = tolerance;
     flattener.move_to = move_to;
     flattener.line_to = line_to;
     flattener.close_path = close_path;
     flattener.closure = closure;
-    return _cairo_path_fixed_interpret (path,
-					_cpf_move_to,
-					_cpf_line_to,
-					_cpf_curve_to,
-					_cpf_close_path,
-					&flattener);
+    if (recorder.flat != NULL) {
+	recorder.move_to = move_to;
+	recorder.line_to = line_to;
+	recorder.close_path = close_path;
+	recorder.closure = closure;
+
+	flattener.move_to = _cairo_path_flat_record_move_to;
+	flattener.line_to = _cairo_path_flat_record_line_to;
+	flattener.close_path = _cairo_path_flat_record_close_path;
+	flattener.closure = &recorder;
+    }
+
+    status = _cairo_path_fixed_interpret (path,
+					  _cpf_move_to,
+					  _cpf_line_to,
+					  _cpf_curve_to,
+					  _cpf_close_path,
+					  &flattener);
+
+    if (recorder.flat != NULL) {
+	if (status != CAIRO_STATUS_SUCCESS ||
+	    ! _cairo_atomic_ptr_cmpxchg ((void **) &cache->flat,
+					 NULL, recorder.flat))
+	{
+	    _cairo_path_flat_destroy (recorder.flat);
+	}
+    }
+
+    return status;
+}
+
+static cairo_status_t
+_cairo_path_flat_discard_point (void *closure,
+				const cairo_point_t *point)
+{
+    return CAIRO_STATUS_SUCCESS;
+}
+
+static cairo_status_t
+_cairo_path_flat_discard_close_path (void *closure)
+{
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Flattens the path now and keeps the result, rather than waiting to
+ * see the same tolerance twice, for callers that know the path will be
+ * filled repeatedly. */
+cairo_status_t
+_cairo_path_fixed_record_flat (cairo_path_fixed_t *path,
+			       double		   tolerance)
+{
+    if (! path->has_curve_to)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (path->flat != NULL && path->flat->tolerance == tolerance)
+	return CAIRO_STATUS_SUCCESS;
+
+    _cairo_path_fixed_drop_flat (path);
+    path->flat_tolerance = _cairo_path_flat_tolerance_key (tolerance);
+    return _cairo_path_fixed_interpret_flat (path,
+					     _cairo_path_flat_discard_point,
+					     _cairo_path_flat_discard_point,
+					     _cairo_path_flat_discard_close_path,
+					     NULL,
+					     tolerance);
+}
+
+/* Copies @other offset by (@offx, @offy).  Flattening only ever works
+ * on differences between points, so the flattened form of @other,
+ * translated, is exactly that of the copy and is kept with it. */
+cairo_status_t
+_cairo_path_fixed_init_translated (cairo_path_fixed_t	    *path,
+				   const cairo_path_fixed_t *other,
+				   cairo_fixed_t	     offx,
+				   cairo_fixed_t	     offy)
+{
+    const cairo_path_flat_t *other_flat;
+    cairo_path_flat_t *flat;
+    cairo_point_t *points;
+    unsigned int i, num_points;
+    cairo_status_t status;
+
+    status = _cairo_path_fixed_init_copy (path, other);
+    if (unlikely (status))
+	return status;
+
+    _cairo_path_fixed_translate (path, offx, offy);
+
+    other_flat = _cairo_atomic_ptr_get ((void **) &other->flat);
+    if (other_flat == NULL)
+	return CAIRO_STATUS_SUCCESS;
+
+    flat = _cairo_malloc (sizeof (cairo_path_flat_t));
+    if (unlikely (flat == NULL))
+	return CAIRO_STATUS_SUCCESS;
+
+    flat->tolerance = other_flat->tolerance;
+    _cairo_array_init (&flat->ops, sizeof (cairo_path_op_t));
+    _cairo_array_init (&flat->points, sizeof (cairo_point_t));
+
+    num_points = _cairo_array_num_elements (&other_flat->points);
+    if (unlikely (_cairo_array_append_multiple (&flat->ops,
+						_cairo_array_index_const (&other_flat->ops, 0),
+						_cairo_array_num_elements (&other_flat->ops)) ||
+		  _cairo_array_append_multiple (&flat->points,
+						_cairo_array_index_const (&other_flat->points, 0),
+						num_points)))
+    {
+	_cairo_path_flat_destroy (flat);
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    points = _cairo_array_index (&flat->points, 0);
+    for (i = 0; i < num_points; i++) {
+	points[i].x += offx;
+	points[i].y += offy;
+    }
+
+    path->flat = flat;
+    path->flat_tolerance = _cairo_path_flat_tolerance_key (flat->tolerance);
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Only bother decimating paths with many more points than they span
+ * pixel columns. */
+#define DECIMATE_MIN_POINTS 1024
+#define DECIMATE_MIN_DENSITY 8
+
+cairo_bool_t
+_cairo_path_fixed_can_decimate (const cairo_path_fixed_t *path)
+{
+    const cairo_path_buf_t *buf;
+    unsigned long num_points, num_columns;
+
+    num_points = 0;
+    if (path->packed != NULL)
+	num_points = path->packed->num_points;
+    cairo_path_foreach_buf_start (buf, path) {
+	num_points += buf->num_points;
+    } cairo_path_foreach_buf_end (buf, path);
+
+    if (num_points < DECIMATE_MIN_POINTS)
+	return FALSE;
+
+    num_columns = _cairo_fixed_integer_ceil (path->extents.p2.x) -
+		  _cairo_fixed_integer_floor (path->extents.p1.x);
+    return num_points / DECIMATE_MIN_DENSITY > num_columns;
+}
+
+/* Closure for decimating a path by pixel columns */
+typedef struct cairo_path_decimator {
+    cairo_path_fixed_t *path;
+
+    /* The points passed through the current column, by order of arrival;
+     * the first of them has already been added to the path. */
+    int column;
+    unsigned int count;
+    cairo_point_t min, max, last;
+    unsigned int min_index, max_index;
+} cpd_t;
+
+static cairo_status_t
+_cpd_add_point (cpd_t *cpd, const cairo_point_t *point)
+{
+    return _cairo_path_fixed_line_to (cpd->path, point->x, point->y);
+}
+
+/* Adds the lowest and highest points of the column in the order they
+ * arrived, then the last, leaving the extent of the line within the
+ * column and its exit from it as they were. */
+static cairo_status_t
+_cpd_flush (cpd_t *cpd)
+{
+    const cairo_point_t *first, *second;
+    unsigned int first_index, second_index;
+    cairo_status_t status;
+
+    if (cpd->count <= 1)
+	return CAIRO_STATUS_SUCCESS;
+
+    if (cpd->min_index <= cpd->max_index) {
+	first = &cpd->min, first_index = cpd->min_index;
+	second = &cpd->max, second_index = cpd->max_index;
+    } else {
+	first = &cpd->max, first_index = cpd->max_index;
+	second = &cpd->min, second_index = cpd->min_index;
+    }
+
+    if (first_index != 0 && first_index != cpd->count - 1) {
+	status = _cpd_add_point (cpd, first);
+	if (unlikely (status))
+	    return status;
+    }
+
+    if (second_index != 0 &&
+	second_index != first_index &&
+	second_index != cpd->count - 1)
+    {
+	status = _cpd_add_point (cpd, second);
+	if (unlikely (status))
+	    return status;
+    }
+
+    return _cpd_add_point (cpd, &cpd->last);
+}
+
+static void
+_cpd_start (cpd_t *cpd, const cairo_point_t *point)
+{
+    cpd->column = _cairo_fixed_integer_floor (point->x);
+    cpd->count = 1;
+    cpd->min = cpd->max = cpd->last = *point;
+    cpd->min_index = cpd->max_index = 0;
+}
+
+static cairo_status_t
+_cpd_move_to (void *closure,
+	      const cairo_point_t *point)
+{
+    cpd_t *cpd = closure;
+    cairo_status_t status;
+
+    status = _cpd_flush (cpd);
+    if (unlikely (status))
+	return status;
+
+    _cpd_start (cpd, point);
+    return _cairo_path_fixed_move_to (cpd->path, point->x, point->y);
+}
+
+static cairo_status_t
+_cpd_line_to (void *closure,
+	      const cairo_point_t *point)
+{
+    cpd_t *cpd = closure;
+    cairo_status_t status;
+
+    if (cpd->count && _cairo_fixed_integer_floor (point->x) == cpd->column) {
+	if (point->y < cpd->min.y) {
+	    cpd->min = *point;
+	    cpd->min_index = cpd->count;
+	}
+	if (point->y > cpd->max.y) {
+	    cpd->max = *point;
+	    cpd->max_index = cpd->count;
+	}
+	cpd->last = *point;
+	cpd->count++;
+	return CAIRO_STATUS_SUCCESS;
+    }
+
+    status = _cpd_flush (cpd);
+    if (unlikely (status))
+	return status;
+
+    _cpd_start (cpd, point);
+    return _cpd_add_point (cpd, point);
+}
+
+static cairo_status_t
+_cpd_curve_to (void *closure,
+	       const cairo_point_t *p0,
+	       const cairo_point_t *p1,
+	       const cairo_point_t *p2)
+{
+    cpd_t *cpd = closure;
+    cairo_status_t status;
+
+    status = _cpd_flush (cpd);
+    if (unlikely (status))
+	return status;
+
+    _cpd_start (cpd, p2);
+    return _cairo_path_fixed_curve_to (cpd->path,
+				       p0->x, p0->y,
+				       p1->x, p1->y,
+				       p2->x, p2->y);
+}
+
+static cairo_status_t
+_cpd_close_path (void *closure)
+{
+    cpd_t *cpd = closure;
+    cairo_status_t status;
+
+    status = _cpd_flush (cpd);
+    if (unlikely (status))
+	return status;
+
+    cpd->count = 0;
+    return _cairo_path_fixed_close_path (cpd->path);
+}
+
+/**
+ * _cairo_path_fixed_init_decimated:
+ * @path: the path to initialise
+ * @other: the path to decimate
+ *
+ * Initialises @path as a copy of @other with runs of lines through the
+ * same pixel column collapsed.  Of each run, only the points where the
+ * line reaches highest and lowest within the column and where it leaves
+ * are kept, so that the polyline covers the same span of every column.
+ * Lines through millions of points, as plotted from long time series,
+ * are then stroked at a cost in proportion to their width in pixels.
+ *
+ * The lengths of lines are not kept, nor exactly the coverage within
+ * a pixel, so this is only for strokes that are undashed and allowed
+ * to be approximate.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS or %CAIRO_STATUS_NO_MEMORY.
+ **/
+cairo_status_t
+_cairo_path_fixed_init_decimated (cairo_path_fixed_t	   *path,
+				  const cairo_path_fixed_t *other)
+{
+    cpd_t cpd;
+    cairo_status_t status;
+
+    _cairo_path_fixed_init (path);
+
+    cpd.path = path;
+    cpd.count = 0;
+
+    status = _cairo_path_fixed_interpret (other,
+					  _cpd_move_to,
+					  _cpd_line_to,
+					  _cpd_curve_to,
+					  _cpd_close_path,
+					  &cpd);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cpd_flush (&cpd);
+    if (unlikely (status))
+	_cairo_path_fixed_fini (path);
+
+    return status;
 }
 
 static inline void
@@ -1384,6 +2631,341 @@ _cairo_path_fixed_is_simple_quad (const cairo_path_fixed_t *path)
     return TRUE;
 }
 
+/* The control point offset of a quarter arc, 4/3 (sqrt(2) - 1). */
+#define ROUNDED_BOX_KAPPA 0.55228474983079339840
+
+/* Returns the angle of a point on the ellipse, in the parametrisation
+ * (cx + rx cos θ, cy + ry sin θ), if it lies within tolerance of it. */
+static cairo_bool_t
+_ellipse_point_angle (const cairo_point_t *p,
+		      double cx, double cy, double rx, double ry,
+		      double tolerance, double *theta)
+{
+    double dx = _cairo_fixed_to_double (p->x) - cx;
+    double dy = _cairo_fixed_to_double (p->y) - cy;
+    double t;
+
+    t = atan2 (dy / ry, dx / rx);
+    if (fabs (dx - rx * cos (t)) > tolerance ||
+	fabs (dy - ry * sin (t)) > tolerance)
+	return FALSE;
+
+    *theta = t;
+    return TRUE;
+}
+
+static cairo_bool_t
+_ellipse_point_near (const cairo_point_t *p, double x, double y,
+		     double tolerance)
+{
+    return fabs (_cairo_fixed_to_double (p->x) - x) <= tolerance &&
+	   fabs (_cairo_fixed_to_double (p->y) - y) <= tolerance;
+}
+
+/*
+ * Check whether the given path is a single closed contour tracing an
+ * axis-aligned ellipse (or circle) with Bézier arcs, as emitted by
+ * cairo_arc() for a full turn under a scale-only transformation.  Each
+ * on-curve point must lie on the ellipse inscribed in the path extents
+ * and each pair of control points must be those of the standard arc
+ * approximation, to within a sixteenth of a pixel or so, and the arcs
+ * must turn in one direction through exactly one revolution.
+ */
+cairo_bool_t
+_cairo_path_fixed_is_ellipse (const cairo_path_fixed_t *path,
+			      double *cx_out, double *cy_out,
+			      double *rx_out, double *ry_out)
+{
+    const cairo_path_buf_t *buf;
+    const cairo_point_t *start = NULL, *current = NULL;
+    double cx, cy, rx, ry, tolerance;
+    double theta = 0, sweep = 0;
+    int direction = 0;
+    cairo_bool_t closed = FALSE;
+
+    if (! path->has_curve_to || path->fill_is_empty)
+	return FALSE;
+
+    cx = (_cairo_fixed_to_double (path->extents.p1.x) +
+	  _cairo_fixed_to_double (path->extents.p2.x)) / 2;
+    cy = (_cairo_fixed_to_double (path->extents.p1.y) +
+	  _cairo_fixed_to_double (path->extents.p2.y)) / 2;
+    rx = _cairo_fixed_to_double (path->extents.p2.x - path->extents.p1.x) / 2;
+    ry = _cairo_fixed_to_double (path->extents.p2.y - path->extents.p1.y) / 2;
+    if (rx < 1. / 16 || ry < 1. / 16)
+	return FALSE;
+
+    tolerance = MAX (1. / 16, 1e-3 * MAX (rx, ry));
+
+    cairo_path_foreach_buf_start (buf, path) {
+	const cairo_point_t *points = buf->points;
+	unsigned int i;
+
+	for (i = 0; i < buf->num_ops; i++) {
+	    double t, delta, h, x0, y0, x3, y3;
+
+	    switch (buf->op[i]) {
+	    case CAIRO_PATH_OP_MOVE_TO:
+		if (start != NULL)
+		    return FALSE;
+		if (! _ellipse_point_angle (points, cx, cy, rx, ry,
+					    tolerance, &theta))
+		    return FALSE;
+		start = current = points++;
+		break;
+
+	    case CAIRO_PATH_OP_LINE_TO:
+		/* Rounding may leave a short join between the arcs, or
+		 * between the last of them and the start. */
+		if (closed ||
+		    ! _ellipse_point_near (points,
+					   _cairo_fixed_to_double (current->x),
+					   _cairo_fixed_to_double (current->y),
+					   tolerance) ||
+		    ! _ellipse_point_angle (points, cx, cy, rx, ry,
+					    tolerance, &t))
+		    return FALSE;
+
+		delta = t - theta;
+		if (delta > M_PI)
+		    delta -= 2 * M_PI;
+		else if (delta < -M_PI)
+		    delta += 2 * M_PI;
+		sweep += delta;
+		theta = t;
+		current = points++;
+		break;
+
+	    case CAIRO_PATH_OP_CURVE_TO:
+		if (closed ||
+		    ! _ellipse_point_angle (&points[2], cx, cy, rx, ry,
+					    tolerance, &t))
+		    return FALSE;
+
+		/* The first control point sets off along the tangent,
+		 * which tells the direction the arc turns. */
+		x0 = cx + rx * cos (theta);
+		y0 = cy + ry * sin (theta);
+		h = (_cairo_fixed_to_double (points[0].x) - x0) * -rx * sin (theta) +
+		    (_cairo_fixed_to_double (points[0].y) - y0) * ry * cos (theta);
+		if (h == 0 || (direction && (h > 0) != (direction > 0)))
+		    return FALSE;
+		direction = h > 0 ? 1 : -1;
+
+		delta = t - theta;
+		if (direction > 0 && delta <= 0)
+		    delta += 2 * M_PI;
+		else if (direction < 0 && delta >= 0)
+		    delta -= 2 * M_PI;
+		if (fabs (delta) > M_PI + .1)
+		    return FALSE;
+
+		h = 4. / 3 * tan (delta / 4);
+		x3 = cx + rx * cos (t);
+		y3 = cy + ry * sin (t);
+		if (! _ellipse_point_near (&points[0],
+					   x0 - h * rx * sin (theta),
+					   y0 + h * ry * cos (theta),
+					   tolerance) ||
+		    ! _ellipse_point_near (&points[1],
+					   x3 + h * rx * sin (t),
+					   y3 - h * ry * cos (t),
+					   tolerance))
+		    return FALSE;
+
+		sweep += delta;
+		theta = t;
+		current = &points[2];
+		points += 3;
+		break;
+
+	    case CAIRO_PATH_OP_CLOSE_PATH:
+		closed = TRUE;
+		break;
+
+	    default:
+		ASSERT_NOT_REACHED;
+	    }
+	}
+    } cairo_path_foreach_buf_end (buf, path);
+
+    if (start == NULL || fabs (fabs (sweep) - 2 * M_PI) > .5)
+	return FALSE;
+
+    if (! _ellipse_point_near (current,
+			       _cairo_fixed_to_double (start->x),
+			       _cairo_fixed_to_double (start->y),
+			       tolerance))
+	return FALSE;
+
+    *cx_out = cx;
+    *cy_out = cy;
+    *rx_out = rx;
+    *ry_out = ry;
+    return TRUE;
+}
+
+/* Identifies the corner rounded by a quarter arc between a side of the
+ * box and an adjacent side, returning its index (bit 0 set on the right,
+ * bit 1 at the bottom) and the radii and turn of the arc. */
+static int
+_rounded_box_corner (const cairo_point_t *p0,
+		     const cairo_point_t *points,
+		     const double box[4],
+		     double tolerance,
+		     double *rx, double *ry, double *turn)
+{
+    double x0 = _cairo_fixed_to_double (p0->x);
+    double y0 = _cairo_fixed_to_double (p0->y);
+    double x3 = _cairo_fixed_to_double (points[2].x);
+    double y3 = _cairo_fixed_to_double (points[2].y);
+    double x1, y1, x2, y2, sx, sy;
+    cairo_bool_t vertical_first;
+
+    *rx = fabs (x3 - x0);
+    *ry = fabs (y3 - y0);
+    if (*rx <= tolerance || *ry <= tolerance)
+	return -1;
+
+    /* The arc runs from a point on one of the vertical sides to one on
+     * a horizontal side, or vice versa. */
+    if ((fabs (x0 - box[0]) <= tolerance || fabs (x0 - box[2]) <= tolerance) &&
+	(fabs (y3 - box[1]) <= tolerance || fabs (y3 - box[3]) <= tolerance))
+    {
+	vertical_first = TRUE;
+	sx = x0 < x3 ? -1 : 1;
+	sy = y3 < y0 ? -1 : 1;
+    }
+    else if ((fabs (y0 - box[1]) <= tolerance || fabs (y0 - box[3]) <= tolerance) &&
+	     (fabs (x3 - box[0]) <= tolerance || fabs (x3 - box[2]) <= tolerance))
+    {
+	vertical_first = FALSE;
+	sx = x3 < x0 ? -1 : 1;
+	sy = y0 < y3 ? -1 : 1;
+    }
+    else
+	return -1;
+
+    if (vertical_first) {
+	x1 = x0;
+	y1 = y0 + sy * ROUNDED_BOX_KAPPA * *ry;
+	x2 = x3 + sx * ROUNDED_BOX_KAPPA * *rx;
+	y2 = y3;
+    } else {
+	x1 = x0 + sx * ROUNDED_BOX_KAPPA * *rx;
+	y1 = y0;
+	x2 = x3;
+	y2 = y3 + sy * ROUNDED_BOX_KAPPA * *ry;
+    }
+    if (! _ellipse_point_near (&points[0], x1, y1, tolerance) ||
+	! _ellipse_point_near (&points[1], x2, y2, tolerance))
+	return -1;
+
+    *turn = (x1 - x0) * (y3 - y0) - (y1 - y0) * (x3 - x0);
+    return (sx > 0) | (sy > 0) << 1;
+}
+
+/*
+ * Check whether the given path is a single rectangle with its corners
+ * rounded by quarter ellipses, as built by cairo_rounded_rectangle()
+ * under a scale-only transformation: a quarter arc at each corner of
+ * the path extents, each a single Bézier curve, turning the same way and
+ * joined by lines along the sides.
+ */
+cairo_bool_t
+_cairo_path_fixed_is_rounded_box (const cairo_path_fixed_t *path,
+				  cairo_box_t *box,
+				  double *rx_out, double *ry_out)
+{
+    const cairo_path_buf_t *buf = cairo_path_head (path);
+    const cairo_point_t *points, *current;
+    double bounds[4], rx = 0, ry = 0, turn = 0;
+    double tolerance = 1. / 32;
+    unsigned int i, corners = 0;
+
+    if (! path->has_curve_to || path->fill_is_empty)
+	return FALSE;
+
+    if (cairo_path_buf_next (buf) != buf ||
+	buf->num_ops < 5 || buf->op[0] != CAIRO_PATH_OP_MOVE_TO)
+	return FALSE;
+
+    bounds[0] = _cairo_fixed_to_double (path->extents.p1.x);
+    bounds[1] = _cairo_fixed_to_double (path->extents.p1.y);
+    bounds[2] = _cairo_fixed_to_double (path->extents.p2.x);
+    bounds[3] = _cairo_fixed_to_double (path->extents.p2.y);
+
+    current = &buf->points[0];
+    points = &buf->points[1];
+    for (i = 1; i < buf->num_ops; i++) {
+	double x, y, arc_rx, arc_ry, arc_turn;
+	int corner;
+
+	switch (buf->op[i]) {
+	case CAIRO_PATH_OP_MOVE_TO:
+	    return FALSE;
+
+	case CAIRO_PATH_OP_LINE_TO:
+	    x = _cairo_fixed_to_double (points->x);
+	    y = _cairo_fixed_to_double (points->y);
+	    if (points->y == current->y) {
+		if (fabs (y - bounds[1]) > tolerance &&
+		    fabs (y - bounds[3]) > tolerance)
+		    return FALSE;
+	    } else if (points->x == current->x) {
+		if (fabs (x - bounds[0]) > tolerance &&
+		    fabs (x - bounds[2]) > tolerance)
+		    return FALSE;
+	    } else {
+		return FALSE;
+	    }
+	    current = points++;
+	    break;
+
+	case CAIRO_PATH_OP_CURVE_TO:
+	    corner = _rounded_box_corner (current, points, bounds, tolerance,
+					  &arc_rx, &arc_ry, &arc_turn);
+	    if (corner < 0 || corners & (1 << corner))
+		return FALSE;
+
+	    if (corners == 0) {
+		rx = arc_rx;
+		ry = arc_ry;
+		turn = arc_turn;
+	    } else if (fabs (arc_rx - rx) > tolerance ||
+		       fabs (arc_ry - ry) > tolerance ||
+		       (arc_turn > 0) != (turn > 0))
+		return FALSE;
+
+	    corners |= 1 << corner;
+	    current = &points[2];
+	    points += 3;
+	    break;
+
+	case CAIRO_PATH_OP_CLOSE_PATH:
+	    if (i != buf->num_ops - 1)
+		return FALSE;
+	    break;
+
+	default:
+	    ASSERT_NOT_REACHED;
+	}
+    }
+
+    if (corners != 0xf ||
+	current->x != buf->points[0].x || current->y != buf->points[0].y)
+	return FALSE;
+
+    if (2 * rx > bounds[2] - bounds[0] + tolerance ||
+	2 * ry > bounds[3] - bounds[1] + tolerance)
+	return FALSE;
+
+    *box = path->extents;
+    *rx_out = MIN (rx, (bounds[2] - bounds[0]) / 2);
+    *ry_out = MIN (ry, (bounds[3] - bounds[1]) / 2);
+    return TRUE;
+}
+
 cairo_bool_t
 _cairo_path_fixed_is_stroke_box (const cairo_path_fixed_t *path,
 				 cairo_box_t *box)
@@ -1466,11 +3048,48 @@ _cairo_path_fixed_iter_init (cairo_path_fixed_iter_t *iter,
     iter->first = iter->buf = cairo_path_head (path);
     iter->n_op = 0;
     iter->n_point = 0;
+
+    iter->packed = path->packed;
+    if (iter->packed != NULL) {
+	iter->last.x = iter->last.y = 0;
+	iter->data = _cairo_path_unpack_op (_cairo_path_packed_data (iter->packed),
+					    &iter->op, &iter->last, iter->points);
+    }
+}
+
+static inline cairo_path_op_t
+_cairo_path_fixed_iter_op (const cairo_path_fixed_iter_t *iter)
+{
+    if (iter->packed != NULL)
+	return iter->op;
+
+    return iter->buf->op[iter->n_op];
+}
+
+static inline cairo_point_t
+_cairo_path_fixed_iter_point (cairo_path_fixed_iter_t *iter)
+{
+    if (iter->packed != NULL)
+	return iter->points[iter->n_point++];
+
+    return iter->buf->points[iter->n_point++];
 }
 
 static cairo_bool_t
 _cairo_path_fixed_iter_next_op (cairo_path_fixed_iter_t *iter)
 {
+    if (iter->packed != NULL) {
+	if (++iter->n_op >= iter->packed->num_ops) {
+	    iter->buf = NULL;
+	    return FALSE;
+	}
+
+	iter->data = _cairo_path_unpack_op (iter->data,
+					    &iter->op, &iter->last, iter->points);
+	iter->n_point = 0;
+	return TRUE;
+    }
+
     if (++iter->n_op >= iter->buf->num_ops) {
 	iter->buf = cairo_path_buf_next (iter->buf);
 	if (iter->buf == iter->first) {
@@ -1497,24 +3116,25 @@ _cairo_path_fixed_iter_is_fill_box (cairo_path_fixed_iter_t *_iter,
 
     iter = *_iter;
 
-    if (iter.n_op == iter.buf->num_ops && ! _cairo_path_fixed_iter_next_op (&iter))
+    if (iter.packed == NULL &&
+	iter.n_op == iter.buf->num_ops && ! _cairo_path_fixed_iter_next_op (&iter))
 	return FALSE;
 
     /* Check whether the ops are those that would be used for a rectangle */
-    if (iter.buf->op[iter.n_op] != CAIRO_PATH_OP_MOVE_TO)
+    if (_cairo_path_fixed_iter_op (&iter) != CAIRO_PATH_OP_MOVE_TO)
 	return FALSE;
-    points[0] = iter.buf->points[iter.n_point++];
+    points[0] = _cairo_path_fixed_iter_point (&iter);
     if (! _cairo_path_fixed_iter_next_op (&iter))
 	return FALSE;
 
-    if (iter.buf->op[iter.n_op] != CAIRO_PATH_OP_LINE_TO)
+    if (_cairo_path_fixed_iter_op (&iter) != CAIRO_PATH_OP_LINE_TO)
 	return FALSE;
-    points[1] = iter.buf->points[iter.n_point++];
+    points[1] = _cairo_path_fixed_iter_point (&iter);
     if (! _cairo_path_fixed_iter_next_op (&iter))
 	return FALSE;
 
     /* a horizontal/vertical closed line is also a degenerate rectangle */
-    switch (iter.buf->op[iter.n_op]) {
+    switch (_cairo_path_fixed_iter_op (&iter)) {
     case CAIRO_PATH_OP_CLOSE_PATH:
 	_cairo_path_fixed_iter_next_op (&iter);
     case CAIRO_PATH_OP_MOVE_TO: /* implicit close */
@@ -1527,27 +3147,27 @@ _cairo_path_fixed_iter_is_fill_box (cairo_path_fixed_iter_t *_iter,
 	break;
     }
 
-    points[2] = iter.buf->points[iter.n_point++];
+    points[2] = _cairo_path_fixed_iter_point (&iter);
     if (! _cairo_path_fixed_iter_next_op (&iter))
 	return FALSE;
 
-    if (iter.buf->op[iter.n_op] != CAIRO_PATH_OP_LINE_TO)
+    if (_cairo_path_fixed_iter_op (&iter) != CAIRO_PATH_OP_LINE_TO)
 	return FALSE;
-    points[3] = iter.buf->points[iter.n_point++];
+    points[3] = _cairo_path_fixed_iter_point (&iter);
 
     /* Now, there are choices. The rectangle might end with a LINE_TO
      * (to the original point), but this isn't required. If it
      * doesn't, then it must end with a CLOSE_PATH (which may be implicit). */
     if (! _cairo_path_fixed_iter_next_op (&iter)) {
 	/* implicit close due to fill */
-    } else if (iter.buf->op[iter.n_op] == CAIRO_PATH_OP_LINE_TO) {
-	points[4] = iter.buf->points[iter.n_point++];
+    } else if (_cairo_path_fixed_iter_op (&iter) == CAIRO_PATH_OP_LINE_TO) {
+	points[4] = _cairo_path_fixed_iter_point (&iter);
 	if (points[4].x != points[0].x || points[4].y != points[0].y)
 	    return FALSE;
 	_cairo_path_fixed_iter_next_op (&iter);
-    } else if (iter.buf->op[iter.n_op] == CAIRO_PATH_OP_CLOSE_PATH) {
+    } else if (_cairo_path_fixed_iter_op (&iter) == CAIRO_PATH_OP_CLOSE_PATH) {
 	_cairo_path_fixed_iter_next_op (&iter);
-    } else if (iter.buf->op[iter.n_op] == CAIRO_PATH_OP_MOVE_TO) {
+    } else if (_cairo_path_fixed_iter_op (&iter) == CAIRO_PATH_OP_MOVE_TO) {
 	/* implicit close-path due to new-sub-path */
     } else {
 	return FALSE;
@@ -1585,5 +3205,8 @@ _cairo_path_fixed_iter_at_end (const cairo_path_fixed_iter_t *iter)
     if (iter->buf == NULL)
 	return TRUE;
 
+    if (iter->packed != NULL)
+	return FALSE;
+
     return iter->n_op == iter->buf->num_ops;
 }
@@ -478,6 +478,7 @@ _cairo_rectilinear_stroker_line_to_dashed (void		*closure,
     const cairo_point_t *b = point;
     cairo_bool_t fully_in_bounds;
     double sf, sign, remain;
+    double remain_visible, remain_hidden;
     cairo_fixed_t mag;
     cairo_status_t status;
     cairo_line_t segment;
@@ -516,10 +517,52 @@ _cairo_rectilinear_stroker_line_to_dashed (void		*closure,
 	sign = -1.;
     }
 
+    /* Only the stretch of the line within the bounds can be seen: from
+     * when remain falls to remain_visible until it reaches remain_hidden. */
+    remain_visible = remain;
+    remain_hidden = 0;
+    if (! fully_in_bounds) {
+	double t_start, t_end;
+
+	if (_cairo_stroker_dash_visible_range (&stroker->bounds, a, b,
+					       &t_start, &t_end))
+	{
+	    remain_visible = remain - t_start * remain;
+	    remain_hidden = remain - t_end * remain;
+	}
+	else
+	{
+	    remain_visible = 0;
+	}
+    }
+
     segment.p2 = segment.p1 = *a;
     while (remain > 0.) {
 	double step_length;
 
+	/* Dashes outside the bounds draw nothing, so step over them all
+	 * at once. */
+	if (remain > remain_visible || remain <= remain_hidden) {
+	    dash_on = FALSE;
+
+	    if (remain > remain_visible) {
+		_cairo_stroker_dash_skip (&stroker->dash,
+					  (remain - remain_visible) / sf);
+		remain = remain_visible;
+	    } else {
+		_cairo_stroker_dash_skip (&stroker->dash, remain / sf);
+		remain = 0;
+	    }
+
+	    mag = _cairo_fixed_from_double (sign*remain);
+	    if (is_horizontal & 0x1)
+		segment.p2.x = b->x + mag;
+	    else
+		segment.p2.y = b->y + mag;
+	    segment.p1 = segment.p2;
+	    continue;
+	}
+
 	step_length = MIN (sf * stroker->dash.dash_remain, remain);
 	remain -= step_length;
 
@@ -614,6 +657,8 @@ _cairo_path_fixed_stroke_rectilinear_to_boxes (const cairo_path_fixed_t	*path,
 					       cairo_boxes_t		*boxes)
 {
     cairo_rectilinear_stroker_t rectilinear_stroker;
+    cairo_stroker_dash_cache_t *cache = NULL;
+    cairo_stroker_dash_key_t key;
     cairo_int_status_t status;
     cairo_box_t box;
 
@@ -626,6 +671,31 @@ _cairo_path_fixed_stroke_rectilinear_to_boxes (const cairo_path_fixed_t	*path,
 	return CAIRO_INT_STATUS_UNSUPPORTED;
     }
 
+    /* A dashed path stroked the same way again gives the same boxes. */
+    if (boxes->num_boxes == 0 &&
+	_cairo_stroker_dash_key_init (&key, TRUE, stroke_style, ctm,
+				      0., antialias,
+				      boxes->limits, boxes->num_limits))
+    {
+	const cairo_point_t *points;
+	unsigned int i, num_points;
+
+	points = _cairo_stroker_dash_cache_lookup (path, &key, &num_points);
+	if (points != NULL) {
+	    for (i = 0; i < num_points; i += 2) {
+		box.p1 = points[i];
+		box.p2 = points[i+1];
+		status = _cairo_boxes_add (boxes, antialias, &box);
+		if (unlikely (status))
+		    goto BAIL;
+	    }
+
+	    goto done;
+	}
+
+	cache = _cairo_stroker_dash_cache_begin (path, &key);
+    }
+
     if (! rectilinear_stroker.dash.dashed &&
 	_cairo_path_fixed_is_stroke_box (path, &box) &&
 	/* if the segments overlap we need to feed them into the tessellator */
@@ -700,11 +770,26 @@ _cairo_path_fixed_stroke_rectilinear_to_boxes (const cairo_path_fixed_t	*path,
     if (unlikely (status))
 	goto BAIL;
 
+    if (cache != NULL) {
+	const struct _cairo_boxes_chunk *chunk;
+	int i;
+
+	for (chunk = &boxes->chunks; chunk != NULL; chunk = chunk->next) {
+	    for (i = 0; i < chunk->count; i++) {
+		_cairo_stroker_dash_cache_add (&cache,
+					       &chunk->base[i].p1,
+					       &chunk->base[i].p2);
+	    }
+	}
+	_cairo_stroker_dash_cache_end (path, cache, CAIRO_STATUS_SUCCESS);
+    }
+
 done:
     _cairo_rectilinear_stroker_fini (&rectilinear_stroker);
     return CAIRO_STATUS_SUCCESS;
 
 BAIL:
+    _cairo_stroker_dash_cache_end (path, cache, status);
     _cairo_rectilinear_stroker_fini (&rectilinear_stroker);
     _cairo_boxes_clear (boxes);
     return status;
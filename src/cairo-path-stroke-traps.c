@@ -822,6 +822,7 @@ line_to_dashed (void *closure, const cairo_point_t *point)
 {
     struct stroker *stroker = closure;
     double mag, remain, step_length = 0;
+    double remain_visible, remain_hidden;
     double slope_dx, slope_dy;
     double dx2, dy2;
     cairo_stroke_face_t sub_start, sub_end;
@@ -855,9 +856,58 @@ line_to_dashed (void *closure, const cairo_point_t *point)
     if (mag <= DBL_EPSILON)
 	return CAIRO_STATUS_SUCCESS;
 
+    /* Only the stretch of the line within the bounds can be seen: from
+     * when remain falls to remain_visible until it reaches remain_hidden. */
+    remain_visible = mag;
+    remain_hidden = 0;
+    if (! fully_in_bounds) {
+	double t_start, t_end;
+
+	if (_cairo_stroker_dash_visible_range (&stroker->join_bounds, p1, p2,
+					       &t_start, &t_end))
+	{
+	    remain_visible = mag - t_start * mag;
+	    remain_hidden = mag - t_end * mag;
+	}
+	else
+	{
+	    remain_visible = 0;
+	}
+    }
+
     remain = mag;
     segment.p1 = *p1;
     while (remain) {
+	/* Dashes outside the bounds draw nothing, so step over them all
+	 * at once.  The first dash of a sub-path is kept regardless, as
+	 * closing the path joins onto it. */
+	if ((remain > remain_visible || remain <= remain_hidden) &&
+	    (stroker->has_first_face || ! stroker->dash.dash_starts_on))
+	{
+	    if (stroker->has_current_face) {
+		/* Cap final face from previous segment */
+		add_trailing_cap (stroker, &stroker->current_face);
+
+		stroker->has_current_face = FALSE;
+	    }
+
+	    if (remain > remain_visible) {
+		_cairo_stroker_dash_skip (&stroker->dash,
+					  remain - remain_visible);
+		remain = remain_visible;
+	    } else {
+		_cairo_stroker_dash_skip (&stroker->dash, remain);
+		break;
+	    }
+
+	    dx2 = slope_dx * (mag - remain);
+	    dy2 = slope_dy * (mag - remain);
+	    cairo_matrix_transform_distance (stroker->ctm, &dx2, &dy2);
+	    segment.p1.x = _cairo_fixed_from_double (dx2) + p1->x;
+	    segment.p1.y = _cairo_fixed_from_double (dy2) + p1->y;
+	    continue;
+	}
+
 	step_length = MIN (stroker->dash.dash_remain, remain);
 	remain -= step_length;
 	dx2 = slope_dx * (mag - remain);
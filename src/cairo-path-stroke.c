@@ -873,16 +873,32 @@ _cairo_stroker_add_caps (cairo_stroker_t *stroker)
     return CAIRO_STATUS_SUCCESS;
 }
 
+/* Every dash along a line shares the same face, only moved along the
+ * line, so it need only be computed the once. */
+static void
+_move_face (const cairo_stroke_face_t *face,
+	    const cairo_point_t *point,
+	    cairo_stroke_face_t *moved)
+{
+    cairo_point_t offset;
+
+    offset.x = point->x - face->point.x;
+    offset.y = point->y - face->point.y;
+
+    *moved = *face;
+    moved->point = *point;
+    _translate_point (&moved->ccw, &offset);
+    _translate_point (&moved->cw, &offset);
+}
+
 static cairo_status_t
-_cairo_stroker_add_sub_edge (cairo_stroker_t *stroker,
-			     const cairo_point_t *p1,
-			     const cairo_point_t *p2,
-			     cairo_slope_t *dev_slope,
-			     double slope_dx, double slope_dy,
-			     cairo_stroke_face_t *start,
-			     cairo_stroke_face_t *end)
+_cairo_stroker_add_face_edge (cairo_stroker_t *stroker,
+			      const cairo_point_t *p2,
+			      const cairo_stroke_face_t *start,
+			      cairo_stroke_face_t *end)
 {
-    _compute_face (p1, dev_slope, slope_dx, slope_dy, stroker, start);
+    const cairo_point_t *p1 = &start->point;
+
     *end = *start;
 
     if (p1->x == p2->x && p1->y == p2->y)
@@ -920,6 +936,19 @@ _cairo_stroker_add_sub_edge (cairo_stroker_t *stroker,
     }
 }
 
+static cairo_status_t
+_cairo_stroker_add_sub_edge (cairo_stroker_t *stroker,
+			     const cairo_point_t *p1,
+			     const cairo_point_t *p2,
+			     cairo_slope_t *dev_slope,
+			     double slope_dx, double slope_dy,
+			     cairo_stroke_face_t *start,
+			     cairo_stroke_face_t *end)
+{
+    _compute_face (p1, dev_slope, slope_dx, slope_dy, stroker, start);
+    return _cairo_stroker_add_face_edge (stroker, p2, start, end);
+}
+
 static cairo_status_t
 _cairo_stroker_move_to (void *closure,
 			const cairo_point_t *point)
@@ -1089,9 +1118,10 @@ _cairo_stroker_line_to_dashed (void *closure,
 {
     cairo_stroker_t *stroker = closure;
     double mag, remain, step_length = 0;
+    double remain_visible, remain_hidden;
     double slope_dx, slope_dy;
     double dx2, dy2;
-    cairo_stroke_face_t sub_start, sub_end;
+    cairo_stroke_face_t face, sub_start, sub_end;
     cairo_point_t *p1 = &stroker->current_point;
     cairo_slope_t dev_slope;
     cairo_line_t segment;
@@ -1122,9 +1152,63 @@ _cairo_stroker_line_to_dashed (void *closure,
 	return CAIRO_STATUS_SUCCESS;
     }
 
+    /* Only the stretch of the line within the bounds can be seen: from
+     * when remain falls to remain_visible until it reaches remain_hidden. */
+    remain_visible = mag;
+    remain_hidden = 0;
+    if (! fully_in_bounds) {
+	double t_start, t_end;
+
+	if (_cairo_stroker_dash_visible_range (&stroker->bounds, p1, p2,
+					       &t_start, &t_end))
+	{
+	    remain_visible = mag - t_start * mag;
+	    remain_hidden = mag - t_end * mag;
+	}
+	else
+	{
+	    remain_visible = 0;
+	}
+    }
+
+    _compute_face (p1, &dev_slope, slope_dx, slope_dy, stroker, &face);
+
     remain = mag;
     segment.p1 = *p1;
     while (remain) {
+	/* Dashes outside the bounds draw nothing, so step over them all
+	 * at once.  The first dash of a sub-path is kept regardless, as
+	 * closing the path joins onto it. */
+	if ((remain > remain_visible || remain <= remain_hidden) &&
+	    (stroker->has_first_face || ! stroker->dash.dash_starts_on))
+	{
+	    if (stroker->has_current_face) {
+		/* Cap final face from previous segment */
+		status = _cairo_stroker_add_trailing_cap (stroker,
+							  &stroker->current_face);
+		if (unlikely (status))
+		    return status;
+
+		stroker->has_current_face = FALSE;
+	    }
+
+	    if (remain > remain_visible) {
+		_cairo_stroker_dash_skip (&stroker->dash,
+					  remain - remain_visible);
+		remain = remain_visible;
+	    } else {
+		_cairo_stroker_dash_skip (&stroker->dash, remain);
+		break;
+	    }
+
+	    dx2 = slope_dx * (mag - remain);
+	    dy2 = slope_dy * (mag - remain);
+	    cairo_matrix_transform_distance (stroker->ctm, &dx2, &dy2);
+	    segment.p1.x = _cairo_fixed_from_double (dx2) + p1->x;
+	    segment.p1.y = _cairo_fixed_from_double (dy2) + p1->y;
+	    continue;
+	}
+
 	step_length = MIN (stroker->dash.dash_remain, remain);
 	remain -= step_length;
 	dx2 = slope_dx * (mag - remain);
@@ -1138,11 +1222,10 @@ _cairo_stroker_line_to_dashed (void *closure,
 	     (! stroker->has_first_face && stroker->dash.dash_starts_on) ||
 	     _cairo_box_intersects_line_segment (&stroker->bounds, &segment)))
 	{
-	    status = _cairo_stroker_add_sub_edge (stroker,
-						  &segment.p1, &segment.p2,
-						  &dev_slope,
-						  slope_dx, slope_dy,
-						  &sub_start, &sub_end);
+	    _move_face (&face, &segment.p1, &sub_start);
+	    status = _cairo_stroker_add_face_edge (stroker,
+						   &segment.p2,
+						   &sub_start, &sub_end);
 	    if (unlikely (status))
 		return status;
 
@@ -1207,10 +1290,7 @@ _cairo_stroker_line_to_dashed (void *closure,
 	 * path stroking.
 	 * On the other hand, Acroread 7 also produces the degenerate caps.
 	 */
-	_compute_face (p2, &dev_slope,
-		       slope_dx, slope_dy,
-		       stroker,
-		       &stroker->current_face);
+	_move_face (&face, p2, &stroker->current_face);
 
 	status = _cairo_stroker_add_leading_cap (stroker,
 						 &stroker->current_face);
@@ -1409,6 +1489,24 @@ BAIL:
     return status;
 }
 
+/* Passes the edges of a dashed stroke on to the polygon, keeping a copy
+ * to be replayed when the path is next stroked the same way. */
+typedef struct _cairo_stroker_recorder {
+    cairo_polygon_t *polygon;
+    cairo_stroker_dash_cache_t *cache;
+} cairo_stroker_recorder_t;
+
+static cairo_status_t
+_cairo_stroker_record_external_edge (void *closure,
+				     const cairo_point_t *p1,
+				     const cairo_point_t *p2)
+{
+    cairo_stroker_recorder_t *recorder = closure;
+
+    _cairo_stroker_dash_cache_add (&recorder->cache, p1, p2);
+    return _cairo_polygon_add_external_edge (recorder->polygon, p1, p2);
+}
+
 cairo_status_t
 _cairo_path_fixed_stroke_dashed_to_polygon (const cairo_path_fixed_t	*path,
 					    const cairo_stroke_style_t	*stroke_style,
@@ -1418,16 +1516,49 @@ _cairo_path_fixed_stroke_dashed_to_polygon (const cairo_path_fixed_t	*path,
 					    cairo_polygon_t *polygon)
 {
     cairo_stroker_t stroker;
+    cairo_stroker_recorder_t recorder;
+    cairo_stroker_dash_key_t key;
     cairo_status_t status;
 
+    recorder.polygon = polygon;
+    recorder.cache = NULL;
+    if (_cairo_stroker_dash_key_init (&key, FALSE, stroke_style, ctm,
+				      tolerance, CAIRO_ANTIALIAS_DEFAULT,
+				      polygon->limits, polygon->num_limits))
+    {
+	const cairo_point_t *points;
+	unsigned int i, num_points;
+
+	points = _cairo_stroker_dash_cache_lookup (path, &key, &num_points);
+	if (points != NULL) {
+	    for (i = 0; i < num_points; i += 2) {
+		status = _cairo_polygon_add_external_edge (polygon,
+							   &points[i],
+							   &points[i+1]);
+		if (unlikely (status))
+		    return status;
+	    }
+
+	    return CAIRO_STATUS_SUCCESS;
+	}
+
+	recorder.cache = _cairo_stroker_dash_cache_begin (path, &key);
+    }
+
     status = _cairo_stroker_init (&stroker, path, stroke_style,
 			          ctm, ctm_inverse, tolerance,
 				  polygon->limits, polygon->num_limits);
-    if (unlikely (status))
+    if (unlikely (status)) {
+	_cairo_stroker_dash_cache_end (path, recorder.cache, status);
 	return status;
+    }
 
     stroker.add_external_edge = _cairo_polygon_add_external_edge,
     stroker.closure = polygon;
+    if (recorder.cache != NULL) {
+	stroker.add_external_edge = _cairo_stroker_record_external_edge;
+	stroker.closure = &recorder;
+    }
 
     status = _cairo_path_fixed_interpret (path,
 					  _cairo_stroker_move_to,
@@ -1446,6 +1577,7 @@ _cairo_path_fixed_stroke_dashed_to_polygon (const cairo_path_fixed_t	*path,
 
 BAIL:
     _cairo_stroker_fini (&stroker);
+    _cairo_stroker_dash_cache_end (path, recorder.cache, status);
 
     return status;
 }
@@ -127,6 +127,7 @@ _cairo_polygon_init (cairo_polygon_t *polygon,
     polygon->status = CAIRO_STATUS_SUCCESS;
 
     polygon->num_edges = 0;
+    polygon->is_convex = FALSE;
 
     polygon->edges = polygon->edges_embedded;
     polygon->edges_size = ARRAY_LENGTH (polygon->edges_embedded);
@@ -159,6 +160,7 @@ _cairo_polygon_init_boxes (cairo_polygon_t *polygon,
     polygon->status = CAIRO_STATUS_SUCCESS;
 
     polygon->num_edges = 0;
+    polygon->is_convex = FALSE;
 
     polygon->edges = polygon->edges_embedded;
     polygon->edges_size = ARRAY_LENGTH (polygon->edges_embedded);
@@ -207,6 +209,7 @@ _cairo_polygon_init_box_array (cairo_polygon_t *polygon,
     polygon->status = CAIRO_STATUS_SUCCESS;
 
     polygon->num_edges = 0;
+    polygon->is_convex = FALSE;
 
     polygon->edges = polygon->edges_embedded;
     polygon->edges_size = ARRAY_LENGTH (polygon->edges_embedded);
@@ -300,6 +303,8 @@ _add_edge (cairo_polygon_t *polygon,
 	    return;
     }
 
+    polygon->is_convex = FALSE;
+
     edge = &polygon->edges[polygon->num_edges++];
     edge->line.p1 = *p1;
     edge->line.p2 = *p2;
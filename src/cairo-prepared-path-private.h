@@ -0,0 +1,79 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is University of Southern
+ * California.
+ */
+
+#ifndef CAIRO_PREPARED_PATH_PRIVATE_H
+#define CAIRO_PREPARED_PATH_PRIVATE_H
+
+#include "cairoint.h"
+#include "cairo-path-fixed-private.h"
+#include "cairo-reference-count-private.h"
+
+CAIRO_BEGIN_DECLS
+
+struct _cairo_prepared_path {
+    cairo_reference_count_t ref_count;
+    cairo_status_t status;
+
+    /* The path as the user drew it, for when the transformation no
+     * longer matches the one it was prepared under. */
+    cairo_path_t *user_path;
+    cairo_fill_rule_t fill_rule;
+    double tolerance;
+
+    /* The path in device space, already flattened at @tolerance, valid
+     * whenever the user to device transformation equals @matrix up to
+     * a whole pixel translation. */
+    cairo_bool_t has_device_path;
+    cairo_matrix_t matrix;
+    cairo_path_fixed_t device_path;
+};
+
+cairo_private cairo_prepared_path_t *
+_cairo_prepared_path_create (void);
+
+cairo_private cairo_prepared_path_t *
+_cairo_prepared_path_create_in_error (cairo_status_t status);
+
+cairo_private cairo_status_t
+_cairo_prepared_path_set_device_path (cairo_prepared_path_t	*prepared,
+				      const cairo_path_fixed_t	*path,
+				      const cairo_matrix_t	*matrix);
+
+cairo_private cairo_bool_t
+_cairo_prepared_path_get_offset (const cairo_prepared_path_t *prepared,
+				 const cairo_matrix_t	     *matrix,
+				 cairo_fixed_t		     *offx,
+				 cairo_fixed_t		     *offy);
+
+CAIRO_END_DECLS
+
+#endif /* CAIRO_PREPARED_PATH_PRIVATE_H */
@@ -0,0 +1,218 @@
+/* -*- Mode: c; tab-width: 8; c-basic-offset: 4; indent-tabs-mode: t; -*- */
+/* cairo - a vector graphics library with display and print output
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it either under the terms of the GNU Lesser General Public
+ * License version 2.1 as published by the Free Software Foundation
+ * (the "LGPL") or, at your option, under the terms of the Mozilla
+ * Public License Version 1.1 (the "MPL"). If you do not alter this
+ * notice, a recipient may use your version of this file under either
+ * the MPL or the LGPL.
+ *
+ * You should have received a copy of the LGPL along with this library
+ * in the file COPYING-LGPL-2.1; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Suite 500, Boston, MA 02110-1335, USA
+ * You should have received a copy of the MPL along with this library
+ * in the file COPYING-MPL-1.1
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.1 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * This software is distributed on an "AS IS" basis, WITHOUT WARRANTY
+ * OF ANY KIND, either express or implied. See the LGPL or the MPL for
+ * the specific language governing rights and limitations.
+ *
+ * The Original Code is the cairo graphics library.
+ *
+ * The Initial Developer of the Original Code is University of Southern
+ * California.
+ */
+
+#include "cairoint.h"
+
+#include "cairo-error-private.h"
+#include "cairo-prepared-path-private.h"
+
+/**
+ * SECTION:cairo-prepared-path
+ * @Title: Prepared paths
+ * @Short_Description: Paths made ready for repeated filling
+ * @See_Also: #cairo_t, #cairo_path_t
+ *
+ * A #cairo_prepared_path_t holds a path that has already been
+ * transformed to device space and flattened, so that filling it again
+ * with cairo_fill_prepared() skips straight to rasterization. It is
+ * created with cairo_prepare_fill().
+ **/
+
+static const cairo_prepared_path_t _cairo_prepared_path_nil = {
+    CAIRO_REFERENCE_COUNT_INVALID,	/* ref_count */
+    CAIRO_STATUS_NO_MEMORY,		/* status */
+};
+
+cairo_prepared_path_t *
+_cairo_prepared_path_create (void)
+{
+    cairo_prepared_path_t *prepared;
+
+    prepared = _cairo_malloc (sizeof (cairo_prepared_path_t));
+    if (unlikely (prepared == NULL))
+	return _cairo_prepared_path_create_in_error (_cairo_error (CAIRO_STATUS_NO_MEMORY));
+
+    CAIRO_REFERENCE_COUNT_INIT (&prepared->ref_count, 1);
+    prepared->status = CAIRO_STATUS_SUCCESS;
+
+    prepared->user_path = NULL;
+    prepared->fill_rule = CAIRO_FILL_RULE_WINDING;
+    prepared->tolerance = CAIRO_GSTATE_TOLERANCE_DEFAULT;
+    prepared->has_device_path = FALSE;
+
+    return prepared;
+}
+
+cairo_prepared_path_t *
+_cairo_prepared_path_create_in_error (cairo_status_t status)
+{
+    cairo_prepared_path_t *prepared;
+
+    /* special case NO_MEMORY so as to avoid allocations */
+    if (status == CAIRO_STATUS_NO_MEMORY)
+	return (cairo_prepared_path_t *) &_cairo_prepared_path_nil;
+
+    prepared = _cairo_malloc (sizeof (cairo_prepared_path_t));
+    if (unlikely (prepared == NULL)) {
+	_cairo_error_throw (CAIRO_STATUS_NO_MEMORY);
+	return (cairo_prepared_path_t *) &_cairo_prepared_path_nil;
+    }
+
+    CAIRO_REFERENCE_COUNT_INIT (&prepared->ref_count, 1);
+    prepared->status = status;
+    prepared->user_path = NULL;
+    prepared->has_device_path = FALSE;
+
+    return prepared;
+}
+
+cairo_status_t
+_cairo_prepared_path_set_device_path (cairo_prepared_path_t	*prepared,
+				      const cairo_path_fixed_t	*path,
+				      const cairo_matrix_t	*matrix)
+{
+    cairo_status_t status;
+
+    assert (! prepared->has_device_path);
+
+    status = _cairo_path_fixed_init_copy (&prepared->device_path, path);
+    if (unlikely (status))
+	return status;
+
+    status = _cairo_path_fixed_record_flat (&prepared->device_path,
+					    prepared->tolerance);
+    if (unlikely (status)) {
+	_cairo_path_fixed_fini (&prepared->device_path);
+	return status;
+    }
+
+    prepared->matrix = *matrix;
+    prepared->has_device_path = TRUE;
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* Checks whether the device path can be reused under @matrix, the
+ * current user to device transformation.  Only a change of translation
+ * by whole pixels is allowed, as that shifts every point of the path,
+ * flattened or not, by exactly the same amount. */
+cairo_bool_t
+_cairo_prepared_path_get_offset (const cairo_prepared_path_t *prepared,
+				 const cairo_matrix_t	     *matrix,
+				 cairo_fixed_t		     *offx,
+				 cairo_fixed_t		     *offy)
+{
+    if (! prepared->has_device_path)
+	return FALSE;
+
+    if (matrix->xx != prepared->matrix.xx ||
+	matrix->yx != prepared->matrix.yx ||
+	matrix->xy != prepared->matrix.xy ||
+	matrix->yy != prepared->matrix.yy)
+    {
+	return FALSE;
+    }
+
+    *offx = _cairo_fixed_from_double (matrix->x0 - prepared->matrix.x0);
+    *offy = _cairo_fixed_from_double (matrix->y0 - prepared->matrix.y0);
+    return _cairo_fixed_is_integer (*offx) && _cairo_fixed_is_integer (*offy);
+}
+
+/**
+ * cairo_prepared_path_reference:
+ * @prepared: a #cairo_prepared_path_t
+ *
+ * Increases the reference count on @prepared by one. This prevents
+ * @prepared from being destroyed until a matching call to
+ * cairo_prepared_path_destroy() is made.
+ *
+ * Return value: the referenced #cairo_prepared_path_t.
+ *
+ * Since: 1.18
+ **/
+cairo_prepared_path_t *
+cairo_prepared_path_reference (cairo_prepared_path_t *prepared)
+{
+    if (prepared == NULL ||
+	CAIRO_REFERENCE_COUNT_IS_INVALID (&prepared->ref_count))
+	return prepared;
+
+    assert (CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&prepared->ref_count));
+
+    _cairo_reference_count_inc (&prepared->ref_count);
+    return prepared;
+}
+
+/**
+ * cairo_prepared_path_destroy:
+ * @prepared: a #cairo_prepared_path_t
+ *
+ * Decreases the reference count on @prepared by one. If the result is
+ * zero, then @prepared and all associated resources are freed. See
+ * cairo_prepared_path_reference().
+ *
+ * Since: 1.18
+ **/
+void
+cairo_prepared_path_destroy (cairo_prepared_path_t *prepared)
+{
+    if (prepared == NULL ||
+	CAIRO_REFERENCE_COUNT_IS_INVALID (&prepared->ref_count))
+	return;
+
+    assert (CAIRO_REFERENCE_COUNT_HAS_REFERENCE (&prepared->ref_count));
+
+    if (! _cairo_reference_count_dec_and_test (&prepared->ref_count))
+	return;
+
+    if (prepared->has_device_path)
+	_cairo_path_fixed_fini (&prepared->device_path);
+    cairo_path_destroy (prepared->user_path);
+    free (prepared);
+}
+
+/**
+ * cairo_prepared_path_status:
+ * @prepared: a #cairo_prepared_path_t
+ *
+ * Checks whether an error has previously occurred for this
+ * prepared path.
+ *
+ * Return value: %CAIRO_STATUS_SUCCESS or %CAIRO_STATUS_NO_MEMORY, or
+ * the error status of the context the path was prepared from.
+ *
+ * Since: 1.18
+ **/
+cairo_status_t
+cairo_prepared_path_status (cairo_prepared_path_t *prepared)
+{
+    return prepared->status;
+}
@@ -868,7 +868,7 @@ _cairo_recording_surface_stroke (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_path_fixed_init_copy (&command->path, path);
+    status = _cairo_path_fixed_init_compact (&command->path, path);
     if (unlikely (status))
 	goto CLEANUP_SOURCE;
 
@@ -944,7 +944,7 @@ _cairo_recording_surface_fill (void			*abstract_surface,
     if (unlikely (status))
 	goto CLEANUP_COMMAND;
 
-    status = _cairo_path_fixed_init_copy (&command->path, path);
+    status = _cairo_path_fixed_init_compact (&command->path, path);
     if (unlikely (status))
 	goto CLEANUP_SOURCE;
 
@@ -1280,7 +1280,7 @@ _cairo_recording_surface_copy__stroke (cairo_recording_surface_t *surface,
     if (unlikely (status))
 	goto err_command;
 
-    status = _cairo_path_fixed_init_copy (&command->path, &src->stroke.path);
+    status = _cairo_path_fixed_init_compact (&command->path, &src->stroke.path);
     if (unlikely (status))
 	goto err_source;
 
@@ -1332,7 +1332,7 @@ _cairo_recording_surface_copy__fill (cairo_recording_surface_t *surface,
     if (unlikely (status))
 	goto err_command;
 
-    status = _cairo_path_fixed_init_copy (&command->path, &src->fill.path);
+    status = _cairo_path_fixed_init_compact (&command->path, &src->fill.path);
     if (unlikely (status))
 	goto err_source;
 
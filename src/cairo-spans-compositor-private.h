@@ -54,6 +54,8 @@ struct cairo_spans_compositor {
 
     unsigned int flags;
 #define CAIRO_SPANS_COMPOSITOR_HAS_LERP 0x1
+/* span renderers may run concurrently on disjoint rows of the target */
+#define CAIRO_SPANS_COMPOSITOR_HAS_THREADS 0x2
 
     /* pixel-aligned fast paths */
     cairo_int_status_t (*fill_boxes)	(void			*surface,
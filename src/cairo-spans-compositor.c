@@ -46,6 +46,7 @@
 #include "cairo-clip-private.h"
 #include "cairo-image-surface-private.h"
 #include "cairo-paginated-private.h"
+#include "cairo-parallel-private.h"
 #include "cairo-pattern-inline.h"
 #include "cairo-region-private.h"
 #include "cairo-recording-surface-inline.h"
@@ -79,10 +80,10 @@ clip_and_composite_polygon (const cairo_spans_compositor_t	*compositor,
 			    cairo_fill_rule_t			 fill_rule,
 			    cairo_antialias_t			 antialias);
 static cairo_surface_t *
-get_clip_surface (const cairo_spans_compositor_t *compositor,
-		  cairo_surface_t *dst,
-		  const cairo_clip_t *clip,
-		  const cairo_rectangle_int_t *extents)
+draw_clip_surface (const cairo_spans_compositor_t *compositor,
+		   cairo_surface_t *dst,
+		   const cairo_clip_t *clip,
+		   const cairo_rectangle_int_t *extents)
 {
     cairo_composite_rectangles_t composite;
     cairo_surface_t *surface;
@@ -238,6 +239,111 @@ error:
     return _cairo_int_surface_create_in_error (status);
 }
 
+/* Returns the mask for all of the clip paths, covering the whole area
+ * that they enclose, rasterizing it only if it is not already cached
+ * on the innermost path.  Layouts tend to reuse one clip for many
+ * draws, and every copy of the clip made for those draws shares the
+ * same paths and hence the same mask.  A clip is not rasterized in
+ * full for its first draw, as it may never be used again. */
+static cairo_surface_t *
+get_clip_path_mask (const cairo_spans_compositor_t *compositor,
+		    cairo_surface_t *dst,
+		    cairo_clip_path_t *clip_path,
+		    cairo_rectangle_int_t *mask_extents)
+{
+    cairo_surface_t *mask;
+    cairo_clip_t *clip;
+
+    if (! _cairo_clip_path_get_mask_extents (clip_path, mask_extents))
+	return NULL;
+
+    mask = _cairo_clip_path_lookup_mask (clip_path, dst);
+    if (mask != NULL)
+	return mask;
+
+    if (_cairo_clip_path_first_mask_use (clip_path))
+	return NULL;
+
+    clip = _cairo_clip_create ();
+    if (unlikely (clip == NULL))
+	return NULL;
+
+    clip->path = _cairo_clip_path_reference (clip_path);
+    clip->extents = *mask_extents;
+    mask = draw_clip_surface (compositor, dst, clip, mask_extents);
+    _cairo_clip_destroy (clip);
+
+    if (unlikely (mask->status)) {
+	cairo_surface_destroy (mask);
+	return NULL;
+    }
+
+    /* Drawn by the compositor directly, so the surface does not know
+     * that it is no longer clear. */
+    mask->is_clear = FALSE;
+
+    _cairo_clip_path_cache_mask (clip_path, mask);
+    return mask;
+}
+
+static cairo_surface_t *
+get_clip_surface (const cairo_spans_compositor_t *compositor,
+		  cairo_surface_t *dst,
+		  const cairo_clip_t *clip,
+		  const cairo_rectangle_int_t *extents)
+{
+    cairo_surface_pattern_t pattern;
+    cairo_rectangle_int_t mask_extents;
+    cairo_surface_t *surface, *mask;
+    cairo_box_t box;
+    cairo_status_t status;
+
+    assert (clip->path);
+
+    /* The cached mask leaves out the clip boxes, so it can only be used
+     * when they do not cut into the area we need. */
+    _cairo_box_from_rectangle (&box, extents);
+    if (clip->num_boxes > 1 ||
+	(clip->num_boxes == 1 &&
+	 ! (clip->boxes[0].p1.x <= box.p1.x && clip->boxes[0].p1.y <= box.p1.y &&
+	    clip->boxes[0].p2.x >= box.p2.x && clip->boxes[0].p2.y >= box.p2.y)))
+    {
+	return draw_clip_surface (compositor, dst, clip, extents);
+    }
+
+    mask = get_clip_path_mask (compositor, dst, clip->path, &mask_extents);
+    if (mask == NULL)
+	return draw_clip_surface (compositor, dst, clip, extents);
+
+    surface = _cairo_surface_create_scratch (dst,
+					     CAIRO_CONTENT_ALPHA,
+					     extents->width,
+					     extents->height,
+					     CAIRO_COLOR_TRANSPARENT);
+    if (unlikely (surface->status)) {
+	cairo_surface_destroy (mask);
+	return surface;
+    }
+
+    _cairo_pattern_init_for_surface (&pattern, mask);
+    cairo_matrix_init_translate (&pattern.base.matrix,
+				 extents->x - mask_extents.x,
+				 extents->y - mask_extents.y);
+    pattern.base.filter = CAIRO_FILTER_NEAREST;
+    pattern.base.extend = CAIRO_EXTEND_NONE;
+    status = _cairo_surface_paint (surface, CAIRO_OPERATOR_SOURCE,
+				   &pattern.base, NULL);
+    _cairo_pattern_fini (&pattern.base);
+    cairo_surface_destroy (mask);
+
+    if (unlikely (status)) {
+	cairo_surface_destroy (surface);
+	return _cairo_int_surface_create_in_error (status);
+    }
+
+    return surface;
+}
+
 static cairo_int_status_t
 fixup_unbounded_mask (const cairo_spans_compositor_t *compositor,
 		      const cairo_composite_rectangles_t *extents,
@@ -746,6 +852,226 @@ cleanup_converter:
     return status;
 }
 
+/* Large polygons may be rendered as a number of horizontal bands, each
+ * scan converted and composited on its own thread.  A band is only
+ * cut where the tor converter guarantees the result to be identical to
+ * a single sweep, so the output does not depend upon the number of
+ * threads in use.
+ */
+#define BAND_MIN_HEIGHT 64
+#define BAND_MIN_AREA (256*256)
+#define BAND_SPLIT_SEARCH 8
+
+typedef struct {
+    cairo_composite_rectangles_t composite;
+    cairo_abstract_span_renderer_t renderer;
+    cairo_scan_converter_t *converter;
+    cairo_int_status_t status;
+} composite_band_t;
+
+static cairo_bool_t
+pattern_is_band_safe (const cairo_pattern_t *pattern)
+{
+    switch (pattern->type) {
+    case CAIRO_PATTERN_TYPE_SOLID:
+    case CAIRO_PATTERN_TYPE_LINEAR:
+    case CAIRO_PATTERN_TYPE_RADIAL:
+	return TRUE;
+    case CAIRO_PATTERN_TYPE_SURFACE:
+	/* Anything else may be replayed or uploaded per band */
+	return ((const cairo_surface_pattern_t *) pattern)->surface->type ==
+	    CAIRO_SURFACE_TYPE_IMAGE;
+    case CAIRO_PATTERN_TYPE_MESH:
+    case CAIRO_PATTERN_TYPE_RASTER_SOURCE:
+    default:
+	return FALSE;
+    }
+}
+
+static int
+find_band_split (const cairo_polygon_t *polygon,
+		 int y, int ymin, int ymax)
+{
+    int i;
+
+    for (i = 0; i <= BAND_SPLIT_SEARCH; i++) {
+	if (y + i < ymax &&
+	    _cairo_tor_scan_converter_can_split (polygon, y + i))
+	    return y + i;
+	if (i && y - i > ymin &&
+	    _cairo_tor_scan_converter_can_split (polygon, y - i))
+	    return y - i;
+    }
+
+    return -1;
+}
+
+static void
+composite_band (void *closure, int index)
+{
+    composite_band_t *band = (composite_band_t *) closure + index;
+    cairo_span_renderer_t *renderer = &band->renderer.base;
+
+    if (band->status)
+	return;
+
+    band->status = band->converter->generate (band->converter, renderer);
+    if (band->status == CAIRO_INT_STATUS_SUCCESS && renderer->finish) {
+	band->status = renderer->finish (renderer);
+	renderer->finish = NULL;
+    }
+}
+
+static cairo_int_status_t
+composite_polygon_bands (const cairo_spans_compositor_t	*compositor,
+			 cairo_composite_rectangles_t	*extents,
+			 cairo_polygon_t		*polygon,
+			 cairo_fill_rule_t		 fill_rule,
+			 cairo_antialias_t		 antialias)
+{
+    const cairo_rectangle_int_t *r = &extents->unbounded;
+    int cuts[CAIRO_PARALLEL_MAX_THREADS + 1];
+    composite_band_t *bands;
+    cairo_int_status_t status;
+    int num_bands, n, i;
+
+    if ((compositor->flags & CAIRO_SPANS_COMPOSITOR_HAS_THREADS) == 0)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    if (antialias == CAIRO_ANTIALIAS_FAST || antialias == CAIRO_ANTIALIAS_NONE)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    /* Every band must be worth handing to another thread */
+    num_bands = MIN (_cairo_parallel_get_num_threads (),
+		     r->height / BAND_MIN_HEIGHT);
+    num_bands = MIN (num_bands,
+		     (int64_t) r->width * r->height / BAND_MIN_AREA);
+    if (num_bands < 2)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    if (! pattern_is_band_safe (&extents->source_pattern.base) ||
+	! pattern_is_band_safe (&extents->mask_pattern.base))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    cuts[0] = r->y;
+    for (i = n = 1; i < num_bands; i++) {
+	int y = r->y + (int) ((int64_t) r->height * i / num_bands);
+
+	y = find_band_split (polygon, y, cuts[n-1], r->y + r->height);
+	if (y > cuts[n-1])
+	    cuts[n++] = y;
+    }
+    cuts[n] = r->y + r->height;
+    num_bands = n;
+    if (num_bands < 2)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    TRACE ((stderr, "%s: %d bands\n", __FUNCTION__, num_bands));
+
+    bands = _cairo_malloc_ab (num_bands, sizeof (composite_band_t));
+    if (unlikely (bands == NULL))
+	return _cairo_error (CAIRO_STATUS_NO_MEMORY);
+
+    /* Acquiring the sources is not thread-safe, so set up every band
+     * up front and only run the rasterisation in parallel. */
+    status = CAIRO_INT_STATUS_SUCCESS;
+    for (n = 0; n < num_bands; n++) {
+	composite_band_t *band = &bands[n];
+	cairo_rectangle_int_t rect;
+
+	rect.x = r->x;
+	rect.y = cuts[n];
+	rect.width = r->width;
+	rect.height = cuts[n+1] - cuts[n];
+
+	band->composite = *extents;
+	_cairo_rectangle_intersect (&band->composite.unbounded, &rect);
+	_cairo_rectangle_intersect (&band->composite.bounded, &rect);
+
+	band->converter = _cairo_tor_scan_converter_create (rect.x, rect.y,
+							    rect.x + rect.width,
+							    rect.y + rect.height,
+							    fill_rule, antialias);
+	status = band->converter->status;
+	if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	    status = _cairo_tor_scan_converter_add_polygon (band->converter,
+							    polygon);
+	if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	    status = compositor->renderer_init (&band->renderer,
+						&band->composite,
+						antialias, FALSE);
+	if (unlikely (status)) {
+	    band->converter->destroy (band->converter);
+	    break;
+	}
+
+	band->status = CAIRO_INT_STATUS_SUCCESS;
+    }
+
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	_cairo_parallel_run (composite_band, bands, num_bands);
+    else
+	for (i = 0; i < n; i++)
+	    bands[i].status = status;
+
+    for (i = 0; i < n; i++) {
+	composite_band_t *band = &bands[i];
+
+	compositor->renderer_fini (&band->renderer, band->status);
+	band->converter->destroy (band->converter);
+	if (status == CAIRO_INT_STATUS_SUCCESS)
+	    status = band->status;
+    }
+
+    free (bands);
+    return status;
+}
+
+/* For small fills with CAIRO_ANTIALIAS_FAST, setting up the sorted edge
+ * lists of tor22 costs more than the pixels produced, so accumulate
+ * the edge areas directly instead.
+ */
+#define AREA_MAX_PIXELS (64*64)
+
+/* A single convex outline needs neither the edge sort nor the active
+ * edge list of the general converters. Only used for
+ * CAIRO_ANTIALIAS_FAST, as the other modes are expected to reproduce
+ * the sampling of the tor converter exactly. */
+static cairo_int_status_t
+composite_convex_polygon (const cairo_spans_compositor_t	*compositor,
+			  cairo_composite_rectangles_t		*extents,
+			  cairo_polygon_t			*polygon,
+			  cairo_antialias_t			 antialias,
+			  cairo_bool_t				 needs_clip)
+{
+    const cairo_rectangle_int_t *r = &extents->unbounded;
+    cairo_abstract_span_renderer_t renderer;
+    cairo_scan_converter_t *converter;
+    cairo_int_status_t status;
+
+    if (antialias != CAIRO_ANTIALIAS_FAST || ! polygon->is_convex)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    converter = _cairo_convex_scan_converter_create (r->x, r->y,
+						     r->x + r->width,
+						     r->y + r->height);
+    status = _cairo_convex_scan_converter_add_polygon (converter, polygon);
+    if (unlikely (status))
+	goto cleanup_converter;
+
+    TRACE ((stderr, "%s\n", __FUNCTION__));
+
+    status = compositor->renderer_init (&renderer, extents,
+					antialias, needs_clip);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = converter->generate (converter, &renderer.base);
+    compositor->renderer_fini (&renderer, status);
+
+cleanup_converter:
+    converter->destroy (converter);
+    return status;
+}
+
 static cairo_int_status_t
 composite_polygon (const cairo_spans_compositor_t	*compositor,
 		   cairo_composite_rectangles_t		 *extents,
@@ -772,7 +1098,25 @@ composite_polygon (const cairo_spans_compositor_t	*compositor,
     } else {
 	const cairo_rectangle_int_t *r = &extents->unbounded;
 
-	if (antialias == CAIRO_ANTIALIAS_FAST) {
+	status = composite_polygon_bands (compositor, extents, polygon,
+					  fill_rule, antialias);
+	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	    return status;
+
+	status = composite_convex_polygon (compositor, extents, polygon,
+					   antialias, needs_clip);
+	if (status != CAIRO_INT_STATUS_UNSUPPORTED)
+	    return status;
+
+	if (antialias == CAIRO_ANTIALIAS_FAST &&
+	    (r->width + 1) * r->height <= AREA_MAX_PIXELS)
+	{
+	    converter = _cairo_area_scan_converter_create (r->x, r->y,
+							   r->x + r->width,
+							   r->y + r->height,
+							   fill_rule);
+	    status = _cairo_area_scan_converter_add_polygon (converter, polygon);
+	} else if (antialias == CAIRO_ANTIALIAS_FAST) {
 	    converter = _cairo_tor22_scan_converter_create (r->x, r->y,
 							    r->x + r->width,
 							    r->y + r->height,
@@ -900,6 +1244,130 @@ clip_and_composite_boxes (const cairo_spans_compositor_t	*compositor,
     return status;
 }
 
+/* With CAIRO_ANTIALIAS_FAST, a path tracing an axis-aligned circle,
+ * ellipse or rounded rectangle is drawn with its exact analytic coverage
+ * rather than as a flattened outline.
+ */
+static cairo_int_status_t
+composite_rounded (const cairo_spans_compositor_t	*compositor,
+		   cairo_composite_rectangles_t		*extents,
+		   const cairo_path_fixed_t		*path)
+{
+    const cairo_rectangle_int_t *r = &extents->unbounded;
+    cairo_abstract_span_renderer_t renderer;
+    cairo_scan_converter_t *converter;
+    cairo_int_status_t status;
+    cairo_box_t box;
+    double cx, cy, rx, ry;
+    cairo_bool_t is_ellipse;
+
+    if (! _clip_is_region (extents->clip) || extents->clip->num_boxes > 1)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    is_ellipse = _cairo_path_fixed_is_ellipse (path, &cx, &cy, &rx, &ry);
+    if (! is_ellipse && ! _cairo_path_fixed_is_rounded_box (path, &box, &rx, &ry))
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    converter = _cairo_ellipse_scan_converter_create (r->x, r->y,
+						      r->x + r->width,
+						      r->y + r->height);
+    if (is_ellipse)
+	status = _cairo_ellipse_scan_converter_add_ellipse (converter,
+							    cx, cy, rx, ry);
+    else
+	status = _cairo_ellipse_scan_converter_add_rounded_box (converter,
+								&box, rx, ry);
+    if (unlikely (status))
+	goto cleanup_converter;
+
+    status = compositor->renderer_init (&renderer, extents,
+					CAIRO_ANTIALIAS_FAST, FALSE);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = converter->generate (converter, &renderer.base);
+    compositor->renderer_fini (&renderer, status);
+
+cleanup_converter:
+    converter->destroy (converter);
+    return status;
+}
+
+/* With CAIRO_ANTIALIAS_FAST, curved paths are fed to the area converter
+ * as they are, which steps each curve row by row instead of flattening
+ * it into a polygon beforehand.
+ */
+static cairo_int_status_t
+composite_path (const cairo_spans_compositor_t	*compositor,
+		cairo_composite_rectangles_t	*extents,
+		const cairo_path_fixed_t	*path,
+		cairo_fill_rule_t		 fill_rule,
+		double				 tolerance)
+{
+    const cairo_rectangle_int_t *r = &extents->unbounded;
+    cairo_abstract_span_renderer_t renderer;
+    cairo_scan_converter_t *converter;
+    cairo_int_status_t status;
+
+    if (! _clip_is_region (extents->clip) || extents->clip->num_boxes > 1)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    converter = _cairo_area_scan_converter_create (r->x, r->y,
+						   r->x + r->width,
+						   r->y + r->height,
+						   fill_rule);
+    status = _cairo_area_scan_converter_add_path (converter, path, tolerance);
+    if (unlikely (status))
+	goto cleanup_converter;
+
+    status = compositor->renderer_init (&renderer, extents,
+					CAIRO_ANTIALIAS_FAST, FALSE);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = converter->generate (converter, &renderer.base);
+    compositor->renderer_fini (&renderer, status);
+
+cleanup_converter:
+    converter->destroy (converter);
+    return status;
+}
+
+/* With CAIRO_ANTIALIAS_FAST, strokes no wider than a device pixel are
+ * drawn straight from the flattened path as Wu lines, skipping both
+ * the stroker and the tessellation of its output.
+ */
+static cairo_int_status_t
+composite_hairline (const cairo_spans_compositor_t	*compositor,
+		    cairo_composite_rectangles_t	*extents,
+		    const cairo_path_fixed_t		*path,
+		    double				 line_width,
+		    double				 tolerance)
+{
+    const cairo_rectangle_int_t *r = &extents->unbounded;
+    cairo_abstract_span_renderer_t renderer;
+    cairo_scan_converter_t *converter;
+    cairo_int_status_t status;
+
+    if (! _clip_is_region (extents->clip) || extents->clip->num_boxes > 1)
+	return CAIRO_INT_STATUS_UNSUPPORTED;
+
+    converter = _cairo_hairline_scan_converter_create (r->x, r->y,
+						       r->x + r->width,
+						       r->y + r->height,
+						       line_width);
+    status = _cairo_hairline_scan_converter_add_path (converter, path,
+						      tolerance);
+    if (unlikely (status))
+	goto cleanup_converter;
+
+    status = compositor->renderer_init (&renderer, extents,
+					CAIRO_ANTIALIAS_FAST, FALSE);
+    if (likely (status == CAIRO_INT_STATUS_SUCCESS))
+	status = converter->generate (converter, &renderer.base);
+    compositor->renderer_fini (&renderer, status);
+
+cleanup_converter:
+    converter->destroy (converter);
+    return status;
+}
+
 static cairo_int_status_t
 clip_and_composite_polygon (const cairo_spans_compositor_t	*compositor,
 			    cairo_composite_rectangles_t	 *extents,
@@ -1013,12 +1481,36 @@ _cairo_spans_compositor_stroke (const cairo_compositor_t	*_compositor,
 				cairo_antialias_t		 antialias)
 {
     const cairo_spans_compositor_t *compositor = (cairo_spans_compositor_t*)_compositor;
+    cairo_path_fixed_t decimated;
     cairo_int_status_t status;
+    double width;
 
     TRACE ((stderr, "%s\n", __FUNCTION__));
     TRACE_ (_cairo_debug_print_path (stderr, path));
     TRACE_ (_cairo_debug_print_clip (stderr, extents->clip));
 
+    width = 2 * _cairo_matrix_transformed_circle_major_axis (ctm,
+							     style->line_width / 2);
+
+    /* Dense polylines need only keep their shape to the pixel when fast
+     * antialiasing is asked for.  Dropping vertices moves the joins, so
+     * only do so where that cannot show: on a hairline, or on a thin
+     * line with round joins, which cannot grow a miter or bevel corner
+     * wider than the pixel the vertex was dropped within. */
+    if (antialias == CAIRO_ANTIALIAS_FAST &&
+	style->num_dashes == 0 &&
+	(width <= 1. ||
+	 (style->line_join == CAIRO_LINE_JOIN_ROUND && width <= 2.)) &&
+	! _cairo_path_fixed_stroke_is_rectilinear (path) &&
+	_cairo_path_fixed_can_decimate (path))
+    {
+	status = _cairo_path_fixed_init_decimated (&decimated, path);
+	if (unlikely (status))
+	    return status;
+
+	path = &decimated;
+    }
+
     status = CAIRO_INT_STATUS_UNSUPPORTED;
     if (_cairo_path_fixed_stroke_is_rectilinear (path)) {
 	cairo_boxes_t boxes;
@@ -1039,6 +1531,15 @@ _cairo_spans_compositor_stroke (const cairo_compositor_t	*_compositor,
 	_cairo_boxes_fini (&boxes);
     }
 
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED &&
+	antialias == CAIRO_ANTIALIAS_FAST &&
+	style->num_dashes == 0 &&
+	width <= 1.)
+    {
+	status = composite_hairline (compositor, extents, path,
+				     width, tolerance);
+    }
+
     if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
 	cairo_polygon_t polygon;
 	cairo_fill_rule_t fill_rule = CAIRO_FILL_RULE_WINDING;
@@ -1091,6 +1592,9 @@ _cairo_spans_compositor_stroke (const cairo_compositor_t	*_compositor,
 	_cairo_polygon_fini (&polygon);
     }
 
+    if (path == &decimated)
+	_cairo_path_fixed_fini (&decimated);
+
     return status;
 }
 
@@ -1126,6 +1630,15 @@ _cairo_spans_compositor_fill (const cairo_compositor_t		*_compositor,
 	    status = clip_and_composite_boxes (compositor, extents, &boxes);
 	_cairo_boxes_fini (&boxes);
     }
+    if (status == CAIRO_INT_STATUS_UNSUPPORTED &&
+	antialias == CAIRO_ANTIALIAS_FAST && path->has_curve_to)
+    {
+	TRACE((stderr, "%s - curves\n", __FUNCTION__));
+	status = composite_rounded (compositor, extents, path);
+	if (status == CAIRO_INT_STATUS_UNSUPPORTED)
+	    status = composite_path (compositor, extents, path,
+				     fill_rule, tolerance);
+    }
     if (status == CAIRO_INT_STATUS_UNSUPPORTED) {
 	cairo_polygon_t polygon;
 
@@ -93,6 +93,9 @@ _cairo_tor_scan_converter_create (int			xmin,
 cairo_private cairo_status_t
 _cairo_tor_scan_converter_add_polygon (void		*converter,
 				       const cairo_polygon_t *polygon);
+cairo_private cairo_bool_t
+_cairo_tor_scan_converter_can_split (const cairo_polygon_t *polygon,
+				     int y);
 
 cairo_private cairo_scan_converter_t *
 _cairo_tor22_scan_converter_create (int			xmin,
@@ -115,6 +118,67 @@ cairo_private cairo_status_t
 _cairo_mono_scan_converter_add_polygon (void		*converter,
 					const cairo_polygon_t *polygon);
 
+/* The area converter references rather than copies its polygon or path,
+ * which must remain valid until it has been generated. */
+cairo_private cairo_scan_converter_t *
+_cairo_area_scan_converter_create (int			xmin,
+				   int			ymin,
+				   int			xmax,
+				   int			ymax,
+				   cairo_fill_rule_t	fill_rule);
+cairo_private cairo_status_t
+_cairo_area_scan_converter_add_polygon (void		*converter,
+					const cairo_polygon_t *polygon);
+cairo_private cairo_status_t
+_cairo_area_scan_converter_add_path (void			*converter,
+				     const cairo_path_fixed_t	*path,
+				     double			 tolerance);
+
+/* The convex converter only accepts a polygon flagged as convex by
+ * _cairo_path_fixed_fill_to_polygon(), returning
+ * CAIRO_INT_STATUS_UNSUPPORTED for any other.  The polygon must remain
+ * valid until it has been generated. */
+cairo_private cairo_scan_converter_t *
+_cairo_convex_scan_converter_create (int	xmin,
+				     int	ymin,
+				     int	xmax,
+				     int	ymax);
+cairo_private cairo_int_status_t
+_cairo_convex_scan_converter_add_polygon (void			*converter,
+					  const cairo_polygon_t	*polygon);
+
+/* Computes the exact coverage of an axis-aligned ellipse or rounded box,
+ * such as those recognised by _cairo_path_fixed_is_ellipse() and
+ * _cairo_path_fixed_is_rounded_box(). */
+cairo_private cairo_scan_converter_t *
+_cairo_ellipse_scan_converter_create (int	xmin,
+				      int	ymin,
+				      int	xmax,
+				      int	ymax);
+cairo_private cairo_status_t
+_cairo_ellipse_scan_converter_add_ellipse (void		*converter,
+					   double	 cx,
+					   double	 cy,
+					   double	 rx,
+					   double	 ry);
+cairo_private cairo_status_t
+_cairo_ellipse_scan_converter_add_rounded_box (void		 *converter,
+					       const cairo_box_t *box,
+					       double		  rx,
+					       double		  ry);
+
+/* Draws the path as a stroke of the given width, at most a pixel. */
+cairo_private cairo_scan_converter_t *
+_cairo_hairline_scan_converter_create (int	xmin,
+				       int	ymin,
+				       int	xmax,
+				       int	ymax,
+				       double	line_width);
+cairo_private cairo_status_t
+_cairo_hairline_scan_converter_add_path (void			*converter,
+					 const cairo_path_fixed_t	*path,
+					 double				 tolerance);
+
 cairo_private cairo_scan_converter_t *
 _cairo_clip_tor_scan_converter_create (cairo_clip_t *clip,
 				       cairo_polygon_t *polygon,
@@ -145,6 +145,7 @@ _lerp_half (const cairo_point_t *a, const cairo_point_t *b, cairo_point_t *resul
     result->y = a->y + ((b->y - a->y) >> 1);
 }
 
+/* Splits s2 in half, leaving the first half in s1 and the second in s2. */
 static void
 _de_casteljau (cairo_spline_knots_t *s1, cairo_spline_knots_t *s2)
 {
@@ -152,21 +153,21 @@ _de_casteljau (cairo_spline_knots_t *s1, cairo_spline_knots_t *s2)
     cairo_point_t abbc, bccd;
     cairo_point_t final;
 
-    _lerp_half (&s1->a, &s1->b, &ab);
-    _lerp_half (&s1->b, &s1->c, &bc);
-    _lerp_half (&s1->c, &s1->d, &cd);
+    _lerp_half (&s2->a, &s2->b, &ab);
+    _lerp_half (&s2->b, &s2->c, &bc);
+    _lerp_half (&s2->c, &s2->d, &cd);
     _lerp_half (&ab, &bc, &abbc);
     _lerp_half (&bc, &cd, &bccd);
     _lerp_half (&abbc, &bccd, &final);
 
-    s2->a = final;
-    s2->b = bccd;
-    s2->c = cd;
-    s2->d = s1->d;
-
+    s1->a = s2->a;
     s1->b = ab;
     s1->c = abbc;
     s1->d = final;
+
+    s2->a = final;
+    s2->b = bccd;
+    s2->c = cd;
 }
 
 /* Return an upper bound on the error (squared) that could result from
@@ -236,35 +237,52 @@ _cairo_spline_error_squared (const cairo_spline_knots_t *knots)
 	return cerr;
 }
 
+/* The depth of subdivision beyond which every piece is taken to be flat.
+ * Each level halves the differences between the knots, so this is only
+ * reached with a vanishingly small tolerance. */
+#define SPLINE_MAX_DEPTH 64
+
 static cairo_status_t
-_cairo_spline_decompose_into (cairo_spline_knots_t *s1,
+_cairo_spline_decompose_into (const cairo_spline_knots_t *knots,
 			      double tolerance_squared,
 			      cairo_spline_t *result)
 {
-    cairo_spline_knots_t s2;
-    cairo_status_t status;
+    cairo_spline_knots_t stack[SPLINE_MAX_DEPTH];
+    int top = 0;
 
-    if (_cairo_spline_error_squared (s1) < tolerance_squared)
-	return _cairo_spline_add_point (result, &s1->a, &s1->b);
+    /* Subdivide depth first, keeping the second half of each split on
+     * a stack, so that points are emitted in order along the curve. */
+    stack[0] = *knots;
+    do {
+	cairo_spline_knots_t *s1 = &stack[top];
 
-    _de_casteljau (s1, &s2);
+	if (top == SPLINE_MAX_DEPTH - 1 ||
+	    _cairo_spline_error_squared (s1) < tolerance_squared)
+	{
+	    cairo_status_t status;
 
-    status = _cairo_spline_decompose_into (s1, tolerance_squared, result);
-    if (unlikely (status))
-	return status;
+	    status = _cairo_spline_add_point (result, &s1->a, &s1->b);
+	    if (unlikely (status))
+		return status;
+
+	    top--;
+	} else {
+	    _de_casteljau (&stack[top + 1], s1);
+	    top++;
+	}
+    } while (top >= 0);
 
-    return _cairo_spline_decompose_into (&s2, tolerance_squared, result);
+    return CAIRO_STATUS_SUCCESS;
 }
 
 cairo_status_t
 _cairo_spline_decompose (cairo_spline_t *spline, double tolerance)
 {
-    cairo_spline_knots_t s1;
     cairo_status_t status;
 
-    s1 = spline->knots;
-    spline->last_point = s1.a;
-    status = _cairo_spline_decompose_into (&s1, tolerance * tolerance, spline);
+    spline->last_point = spline->knots.a;
+    status = _cairo_spline_decompose_into (&spline->knots,
+					   tolerance * tolerance, spline);
     if (unlikely (status))
 	return status;
 
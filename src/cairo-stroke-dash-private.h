@@ -51,10 +51,25 @@ typedef struct _cairo_stroker_dash {
     double dash_remain;
 
     double dash_offset;
+    double dash_period;
     const double *dashes;
     unsigned int num_dashes;
 } cairo_stroker_dash_t;
 
+typedef struct _cairo_stroker_dash_cache cairo_stroker_dash_cache_t;
+
+/* What a dashed stroke depends upon besides the path itself. */
+typedef struct _cairo_stroker_dash_key {
+    unsigned long hash;
+    cairo_bool_t rectilinear;
+    cairo_antialias_t antialias;
+    double tolerance;
+    const cairo_stroke_style_t *style;
+    double xx, yx, xy, yy;
+    cairo_bool_t has_limit;
+    cairo_box_t limit;
+} cairo_stroker_dash_key_t;
+
 cairo_private void
 _cairo_stroker_dash_init (cairo_stroker_dash_t *dash,
 			  const cairo_stroke_style_t *style);
@@ -65,6 +80,48 @@ _cairo_stroker_dash_start (cairo_stroker_dash_t *dash);
 cairo_private void
 _cairo_stroker_dash_step (cairo_stroker_dash_t *dash, double step);
 
+cairo_private void
+_cairo_stroker_dash_skip (cairo_stroker_dash_t *dash, double length);
+
+cairo_private cairo_bool_t
+_cairo_stroker_dash_visible_range (const cairo_box_t *bounds,
+				   const cairo_point_t *p1,
+				   const cairo_point_t *p2,
+				   double *t_start,
+				   double *t_end);
+
+cairo_private cairo_bool_t
+_cairo_stroker_dash_key_init (cairo_stroker_dash_key_t	*key,
+			      cairo_bool_t		 rectilinear,
+			      const cairo_stroke_style_t	*style,
+			      const cairo_matrix_t	*ctm,
+			      double			 tolerance,
+			      cairo_antialias_t		 antialias,
+			      const cairo_box_t		*limits,
+			      int			 num_limits);
+
+cairo_private const cairo_point_t *
+_cairo_stroker_dash_cache_lookup (const cairo_path_fixed_t	 *path,
+				  const cairo_stroker_dash_key_t *key,
+				  unsigned int			 *num_points);
+
+cairo_private cairo_stroker_dash_cache_t *
+_cairo_stroker_dash_cache_begin (const cairo_path_fixed_t	*path,
+				 const cairo_stroker_dash_key_t	*key);
+
+cairo_private void
+_cairo_stroker_dash_cache_add (cairo_stroker_dash_cache_t **cache,
+			       const cairo_point_t *p1,
+			       const cairo_point_t *p2);
+
+cairo_private void
+_cairo_stroker_dash_cache_end (const cairo_path_fixed_t	*path,
+			       cairo_stroker_dash_cache_t	*cache,
+			       cairo_status_t			 status);
+
+cairo_private void
+_cairo_stroker_dash_cache_destroy (cairo_stroker_dash_cache_t *cache);
+
 CAIRO_END_DECLS
 
 #endif /* CAIRO_STROKE_DASH_PRIVATE_H */
@@ -38,6 +38,9 @@
 
 #include "cairoint.h"
 
+#include "cairo-array-private.h"
+#include "cairo-atomic-private.h"
+#include "cairo-path-fixed-private.h"
 #include "cairo-stroke-dash-private.h"
 
 void
@@ -80,10 +83,90 @@ _cairo_stroker_dash_step (cairo_stroker_dash_t *dash, double step)
     }
 }
 
+/* Advances the dash pattern by length, as if by a sequence of steps
+ * each no longer than the current dash.  Whole periods of the pattern
+ * leave the state unchanged, so a long run costs no more than a short
+ * one. */
+void
+_cairo_stroker_dash_skip (cairo_stroker_dash_t *dash, double length)
+{
+    if (length > dash->dash_remain + dash->dash_period) {
+	length -= dash->dash_period *
+	    floor ((length - dash->dash_remain) / dash->dash_period);
+    }
+
+    while (length > 0.) {
+	double step = MIN (dash->dash_remain, length);
+
+	_cairo_stroker_dash_step (dash, step);
+	length -= step;
+    }
+}
+
+static cairo_bool_t
+_clip_range (double lo, double hi, double d, double *t0, double *t1)
+{
+    double a, b;
+
+    if (d == 0.)
+	return lo <= 0. && hi >= 0.;
+
+    a = lo / d;
+    b = hi / d;
+    if (d < 0.) {
+	double t = a;
+	a = b;
+	b = t;
+    }
+
+    if (a > *t0)
+	*t0 = a;
+    if (b < *t1)
+	*t1 = b;
+
+    return *t0 <= *t1;
+}
+
+/* Finds the part of the line from p1 to p2 that lies within bounds, as
+ * fractions of its length.  Returns FALSE if the line misses bounds
+ * altogether.  The range is widened by a unit either side, so rounding
+ * can only ever make it too generous. */
+cairo_bool_t
+_cairo_stroker_dash_visible_range (const cairo_box_t *bounds,
+				   const cairo_point_t *p1,
+				   const cairo_point_t *p2,
+				   double *t_start,
+				   double *t_end)
+{
+    double t0 = 0., t1 = 1.;
+
+    if (! _clip_range ((double) bounds->p1.x - p1->x - 1,
+		       (double) bounds->p2.x - p1->x + 1,
+		       (double) p2->x - p1->x,
+		       &t0, &t1))
+    {
+	return FALSE;
+    }
+
+    if (! _clip_range ((double) bounds->p1.y - p1->y - 1,
+		       (double) bounds->p2.y - p1->y + 1,
+		       (double) p2->y - p1->y,
+		       &t0, &t1))
+    {
+	return FALSE;
+    }
+
+    *t_start = t0;
+    *t_end = t1;
+    return TRUE;
+}
+
 void
 _cairo_stroker_dash_init (cairo_stroker_dash_t *dash,
 			  const cairo_stroke_style_t *style)
 {
+    unsigned int i;
+
     dash->dashed = style->dash != NULL;
     if (! dash->dashed)
 	return;
@@ -92,5 +175,231 @@ _cairo_stroker_dash_init (cairo_stroker_dash_t *dash,
     dash->num_dashes = style->num_dashes;
     dash->dash_offset = style->dash_offset;
 
+    /* An odd number of dashes swaps on and off on every repeat. */
+    dash->dash_period = 0.;
+    for (i = 0; i < dash->num_dashes; i++)
+	dash->dash_period += dash->dashes[i];
+    if (dash->num_dashes & 1)
+	dash->dash_period *= 2;
+
     _cairo_stroker_dash_start (dash);
 }
+
+/* The output of a dashed stroke, kept on the path it was made from so
+ * that stroking the same path again in the same way (cairo_stroke_preserve
+ * in a loop, say) can replay it instead of walking every dash anew.  It
+ * is recorded as point pairs: the polygon edges handed out by the general
+ * stroker, or the boxes made by the rectilinear one. */
+struct _cairo_stroker_dash_cache {
+    cairo_stroker_dash_key_t key;
+    cairo_stroke_style_t style;
+    cairo_array_t points;
+
+    /* The recording on the path when this one was begun, which it
+     * replaces once finished. */
+    struct _cairo_stroker_dash_cache *replaces;
+};
+
+/* Beyond this many points the stroke is not worth keeping. */
+#define CAIRO_STROKER_DASH_CACHE_MAX_POINTS (1 << 20)
+
+cairo_bool_t
+_cairo_stroker_dash_key_init (cairo_stroker_dash_key_t	*key,
+			      cairo_bool_t		 rectilinear,
+			      const cairo_stroke_style_t	*style,
+			      const cairo_matrix_t	*ctm,
+			      double			 tolerance,
+			      cairo_antialias_t		 antialias,
+			      const cairo_box_t		*limits,
+			      int			 num_limits)
+{
+    unsigned long hash;
+
+    if (style->dash == NULL || num_limits > 1)
+	return FALSE;
+
+    key->rectilinear = rectilinear;
+    key->antialias = antialias;
+    key->tolerance = tolerance;
+    key->style = style;
+    key->xx = ctm->xx;
+    key->yx = ctm->yx;
+    key->xy = ctm->xy;
+    key->yy = ctm->yy;
+    key->has_limit = num_limits;
+    if (num_limits)
+	key->limit = limits[0];
+    else
+	memset (&key->limit, 0, sizeof (key->limit));
+
+    hash = _CAIRO_HASH_INIT_VALUE;
+    hash = _cairo_hash_bytes (hash, &key->xx, 4 * sizeof (double));
+    hash = _cairo_hash_bytes (hash, &key->limit, sizeof (key->limit));
+    hash = _cairo_hash_bytes (hash, &style->line_width, sizeof (double));
+    hash = _cairo_hash_bytes (hash, &style->dash_offset, sizeof (double));
+    hash = _cairo_hash_bytes (hash, style->dash,
+			      style->num_dashes * sizeof (double));
+    hash += (style->line_cap << 1 | style->line_join << 3 | rectilinear) +
+	    (unsigned long) antialias * 31;
+    key->hash = hash ? hash : 1;
+
+    return TRUE;
+}
+
+static cairo_bool_t
+_cairo_stroker_dash_key_equal (const cairo_stroker_dash_key_t *a,
+			       const cairo_stroker_dash_key_t *b)
+{
+    const cairo_stroke_style_t *sa = a->style, *sb = b->style;
+
+    return a->hash == b->hash &&
+	   a->rectilinear == b->rectilinear &&
+	   a->antialias == b->antialias &&
+	   a->tolerance == b->tolerance &&
+	   a->xx == b->xx && a->yx == b->yx &&
+	   a->xy == b->xy && a->yy == b->yy &&
+	   a->has_limit == b->has_limit &&
+	   memcmp (&a->limit, &b->limit, sizeof (a->limit)) == 0 &&
+	   sa->line_width == sb->line_width &&
+	   sa->line_cap == sb->line_cap &&
+	   sa->line_join == sb->line_join &&
+	   sa->miter_limit == sb->miter_limit &&
+	   sa->dash_offset == sb->dash_offset &&
+	   sa->num_dashes == sb->num_dashes &&
+	   memcmp (sa->dash, sb->dash, sa->num_dashes * sizeof (double)) == 0;
+}
+
+void
+_cairo_stroker_dash_cache_destroy (cairo_stroker_dash_cache_t *cache)
+{
+    _cairo_array_fini (&cache->points);
+    free (cache);
+}
+
+/* Folds the hash of a key into an atomic int, never 0, so that the last
+ * dash a path was stroked with can be updated atomically. */
+static cairo_atomic_int_t
+_cairo_stroker_dash_seen_key (const cairo_stroker_dash_key_t *key)
+{
+    cairo_atomic_int_t seen;
+
+    seen = (key->hash ^ (key->hash >> 16 >> 16)) & 0x7fffffff;
+    return seen ? seen : 1;
+}
+
+/* Returns the recorded stroke for key, if the path has one. */
+const cairo_point_t *
+_cairo_stroker_dash_cache_lookup (const cairo_path_fixed_t	 *path,
+				  const cairo_stroker_dash_key_t *key,
+				  unsigned int			 *num_points)
+{
+    cairo_stroker_dash_cache_t *cache;
+
+    cache = _cairo_atomic_ptr_get ((void **) &path->dash_cache);
+    if (cache == NULL || ! _cairo_stroker_dash_key_equal (&cache->key, key))
+	return NULL;
+
+    *num_points = _cairo_array_num_elements (&cache->points);
+    return _cairo_array_index_const (&cache->points, 0);
+}
+
+/* Starts recording the stroke for key.  As with flattening, nothing is
+ * recorded until the path is stroked the same way a second time, so a
+ * path stroked only once pays nothing extra.  A recording for another
+ * dash is replaced, so that a path restroked with a new dash is cached
+ * for that dash rather than keeping the first forever. */
+cairo_stroker_dash_cache_t *
+_cairo_stroker_dash_cache_begin (const cairo_path_fixed_t	*path,
+				 const cairo_stroker_dash_key_t	*key)
+{
+    cairo_path_fixed_t *owner = (cairo_path_fixed_t *) path;
+    cairo_stroker_dash_cache_t *cache, *old;
+    const cairo_stroke_style_t *style = key->style;
+    cairo_atomic_int_t seen, hash;
+
+    /* A racing stroke may overwrite the dash seen; that only costs a
+     * recording, never correctness. */
+    hash = _cairo_stroker_dash_seen_key (key);
+    seen = _cairo_atomic_int_get (&owner->dash_hash);
+    if (seen != hash) {
+	_cairo_atomic_int_cmpxchg (&owner->dash_hash, seen, hash);
+	return NULL;
+    }
+
+    old = _cairo_atomic_ptr_get ((void **) &owner->dash_cache);
+    if (old != NULL && _cairo_stroker_dash_key_equal (&old->key, key))
+	return NULL;
+
+    cache = _cairo_malloc_ab_plus_c (style->num_dashes, sizeof (double),
+				     sizeof (cairo_stroker_dash_cache_t));
+    if (unlikely (cache == NULL))
+	return NULL;
+
+    cache->style = *style;
+    cache->style.dash = (double *) (cache + 1);
+    memcpy (cache->style.dash, style->dash,
+	    style->num_dashes * sizeof (double));
+    cache->key = *key;
+    cache->key.style = &cache->style;
+    _cairo_array_init (&cache->points, sizeof (cairo_point_t));
+    cache->replaces = old;
+
+    return cache;
+}
+
+/* Records a pair of points, giving up on the recording should it fail or
+ * grow too large. */
+void
+_cairo_stroker_dash_cache_add (cairo_stroker_dash_cache_t **cache,
+			       const cairo_point_t *p1,
+			       const cairo_point_t *p2)
+{
+    cairo_point_t pair[2];
+
+    if (*cache == NULL)
+	return;
+
+    if (_cairo_array_num_elements (&(*cache)->points) >=
+	CAIRO_STROKER_DASH_CACHE_MAX_POINTS)
+    {
+	goto drop;
+    }
+
+    pair[0] = *p1;
+    pair[1] = *p2;
+    if (unlikely (_cairo_array_append_multiple (&(*cache)->points, pair, 2)))
+	goto drop;
+
+    return;
+
+drop:
+    _cairo_stroker_dash_cache_destroy (*cache);
+    *cache = NULL;
+}
+
+/* Keeps a finished recording on the path in place of the one it was
+ * begun over, unless stroking failed or another thread changed the
+ * path's recording in the meantime. */
+void
+_cairo_stroker_dash_cache_end (const cairo_path_fixed_t	*path,
+			       cairo_stroker_dash_cache_t	*cache,
+			       cairo_status_t			 status)
+{
+    cairo_path_fixed_t *owner = (cairo_path_fixed_t *) path;
+
+    if (cache == NULL)
+	return;
+
+    if (status != CAIRO_STATUS_SUCCESS ||
+	! _cairo_atomic_ptr_cmpxchg ((void **) &owner->dash_cache,
+				     cache->replaces, cache))
+    {
+	_cairo_stroker_dash_cache_destroy (cache);
+	return;
+    }
+
+    if (cache->replaces != NULL) {
+	_cairo_stroker_dash_cache_destroy (cache->replaces);
+	cache->replaces = NULL;
+    }
+}
@@ -2421,6 +2421,9 @@ _cairo_svg_surface_fill (void			*abstract_surface,
 {
     cairo_svg_surface_t *surface = abstract_surface;
     cairo_status_t status;
+    cairo_box_t box;
+    double rx, ry;
+    cairo_bool_t is_rounded_box;
 
     if (surface->paginated_mode == CAIRO_PAGINATED_MODE_ANALYZE)
 	return _cairo_svg_surface_analyze_operation (surface, op, source);
@@ -2431,14 +2434,32 @@ _cairo_svg_surface_fill (void			*abstract_surface,
     if (unlikely (status))
 	return status;
 
-    _cairo_output_stream_printf (surface->xml_node, "<path style=\" stroke:none;");
+    /* A rounded rectangle is written as such, rather than as its path. */
+    is_rounded_box = _cairo_path_fixed_is_rounded_box (path, &box, &rx, &ry);
+
+    _cairo_output_stream_printf (surface->xml_node,
+				 is_rounded_box ?
+				 "<rect style=\" stroke:none;" :
+				 "<path style=\" stroke:none;");
     status = _cairo_svg_surface_emit_fill_style (surface->xml_node, surface, op, source, fill_rule, NULL);
     if (unlikely (status))
 	return status;
 
     _cairo_output_stream_printf (surface->xml_node, "\" ");
 
-    _cairo_svg_surface_emit_path (surface->xml_node, path, NULL);
+    if (is_rounded_box) {
+	_cairo_output_stream_printf (surface->xml_node,
+				     "x=\"%f\" y=\"%f\" "
+				     "width=\"%f\" height=\"%f\" "
+				     "rx=\"%f\" ry=\"%f\"",
+				     _cairo_fixed_to_double (box.p1.x),
+				     _cairo_fixed_to_double (box.p1.y),
+				     _cairo_fixed_to_double (box.p2.x - box.p1.x),
+				     _cairo_fixed_to_double (box.p2.y - box.p1.y),
+				     rx, ry);
+    } else {
+	_cairo_svg_surface_emit_path (surface->xml_node, path, NULL);
+    }
 
     _cairo_output_stream_printf (surface->xml_node, "/>\n");
 
@@ -96,12 +96,22 @@
 #include "cairoint.h"
 #include "cairo-spans-private.h"
 #include "cairo-error-private.h"
+#include "cairo-combsort-inline.h"
+#include "cairo-freed-pool-private.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <setjmp.h>
 
+/* Dense coverage rows are converted to spans with SSE4.1/AVX2 kernels
+ * chosen at runtime. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+#define HAVE_DENSE_ROWS 1
+#include <immintrin.h>
+#endif
+
 /*-------------------------------------------------------------------------
  * cairo specific config
  */
@@ -361,6 +371,7 @@ struct polygon {
      * it is added to the polygon. */
     struct edge **y_buckets;
     struct edge *y_buckets_embedded[64];
+    unsigned num_y_buckets;
 
     struct {
 	struct pool base[1];
@@ -416,9 +427,27 @@ struct cell {
     int16_t		 covered_height;
 };
 
+/* Accumulates the coverage of a pixel row into spans. */
+struct dense_row {
+    cairo_half_open_span_t *spans;
+    unsigned num_spans;
+    int16_t cover, last_cover;
+};
+
+typedef void
+(*dense_row_func_t) (struct dense_row *row,
+		     const struct cell *cell,
+		     int x, int x_end);
+
 /* A cell list represents the scan line sparsely as cells ordered by
  * ascending x.  It is geared towards scanning the cells in order
- * using an internal cursor. */
+ * using an internal cursor.
+ *
+ * If the CPU has a vectorised row converter and the clip is narrow
+ * enough, the cells are instead kept in a dense array indexed by x:
+ * dense[0] collects the cells left of the clip, dense[width+1] those
+ * right of it, and [dense_lo, dense_hi] is the range touched on the
+ * current row. */
 struct cell_list {
     /* Sentinel nodes */
     struct cell head, tail;
@@ -426,6 +455,15 @@ struct cell_list {
     /* Cursor state for iterating through the cell list. */
     struct cell *cursor, *rewind;
 
+    struct cell *dense;
+    dense_row_func_t dense_row;
+    int dense_xmin, dense_width;
+    int dense_lo, dense_hi;
+
+    /* Allocation backing dense, kept for reuse. */
+    struct cell *dense_cells;
+    int dense_size;
+
     /* Cells in the cell list are owned by the cell list and are
      * allocated from this pool.  */
     struct {
@@ -460,6 +498,7 @@ struct glitter_scan_converter {
 
     cairo_half_open_span_t *spans;
     cairo_half_open_span_t spans_embedded[64];
+    int num_spans;
 
     /* Clip box. */
     grid_scaled_x_t xmin, xmax;
@@ -593,6 +632,22 @@ pool_reset (struct pool *pool)
     pool->current->size = 0;
 }
 
+/* Returns the number of bytes held by the pool's malloced chunks. */
+static size_t
+pool_size (const struct pool *pool)
+{
+    const struct _pool_chunk *chunk;
+    size_t size = 0;
+
+    for (chunk = pool->current; chunk; chunk = chunk->prev_chunk)
+	if (chunk != (void *) pool->sentinel)
+	    size += chunk->capacity;
+    for (chunk = pool->first_free; chunk; chunk = chunk->prev_chunk)
+	size += chunk->capacity;
+
+    return size;
+}
+
 /* Rewinds the cell list's cursor to the beginning.  After rewinding
  * we're good to cell_list_find() the cell any x coordinate. */
 inline static void
@@ -628,11 +683,18 @@ cell_list_init(struct cell_list *cells, jmp_buf *jmp)
     cells->head.x = INT_MIN;
     cells->head.next = &cells->tail;
     cell_list_rewind (cells);
+    cells->dense = NULL;
+    cells->dense_row = NULL;
+    cells->dense_lo = INT_MAX;
+    cells->dense_hi = -1;
+    cells->dense_cells = NULL;
+    cells->dense_size = 0;
 }
 
 static void
 cell_list_fini(struct cell_list *cells)
 {
+    free (cells->dense_cells);
     pool_fini (cells->cell_pool.base);
 }
 
@@ -644,6 +706,30 @@ cell_list_reset (struct cell_list *cells)
     cell_list_rewind (cells);
     cells->head.next = &cells->tail;
     pool_reset (cells->cell_pool.base);
+
+    if (cells->dense_lo <= cells->dense_hi) {
+	memset (cells->dense_cells + cells->dense_lo, 0,
+		(cells->dense_hi - cells->dense_lo + 1) * sizeof (struct cell));
+	cells->dense_lo = INT_MAX;
+	cells->dense_hi = -1;
+    }
+}
+
+inline static struct cell *
+cell_list_find_dense (struct cell_list *cells, int x)
+{
+    x -= cells->dense_xmin - 1;
+    if (x < 0)
+	x = 0;
+    else if (x > cells->dense_width)
+	x = cells->dense_width + 1;
+
+    if (x < cells->dense_lo)
+	cells->dense_lo = x;
+    if (x > cells->dense_hi)
+	cells->dense_hi = x;
+
+    return &cells->dense[x];
 }
 
 inline static struct cell *
@@ -672,6 +758,9 @@ cell_list_find (struct cell_list *cells, int x)
 {
     struct cell *tail = cells->cursor;
 
+    if (cells->dense)
+	return cell_list_find_dense (cells, x);
+
     if (tail->x == x)
 	return tail;
 
@@ -701,6 +790,12 @@ cell_list_find_pair(struct cell_list *cells, int x1, int x2)
 {
     struct cell_pair pair;
 
+    if (cells->dense) {
+	pair.cell1 = cell_list_find_dense (cells, x1);
+	pair.cell2 = cell_list_find_dense (cells, x2);
+	return pair;
+    }
+
     pair.cell1 = cells->cursor;
     while (1) {
 	UNROLL3({
@@ -934,6 +1029,7 @@ polygon_init (struct polygon *polygon, jmp_buf *jmp)
 {
     polygon->ymin = polygon->ymax = 0;
     polygon->y_buckets = polygon->y_buckets_embedded;
+    polygon->num_y_buckets = ARRAY_LENGTH (polygon->y_buckets_embedded);
     pool_init (polygon->edge_pool.base, jmp,
 	       8192 - sizeof (struct _pool_chunk),
 	       sizeof (polygon->edge_pool.embedded));
@@ -964,15 +1060,18 @@ polygon_reset (struct polygon *polygon,
     if (unlikely (h > 0x7FFFFFFFU - GRID_Y))
 	goto bail_no_mem; /* even if you could, you wouldn't want to. */
 
-    if (polygon->y_buckets != polygon->y_buckets_embedded)
-	free (polygon->y_buckets);
+    if (num_buckets > polygon->num_y_buckets) {
+	if (polygon->y_buckets != polygon->y_buckets_embedded)
+	    free (polygon->y_buckets);
 
-    polygon->y_buckets =  polygon->y_buckets_embedded;
-    if (num_buckets > ARRAY_LENGTH (polygon->y_buckets_embedded)) {
 	polygon->y_buckets = _cairo_malloc_ab (num_buckets,
 					       sizeof (struct edge *));
-	if (unlikely (NULL == polygon->y_buckets))
+	if (unlikely (NULL == polygon->y_buckets)) {
+	    polygon->y_buckets = polygon->y_buckets_embedded;
+	    polygon->num_y_buckets = ARRAY_LENGTH (polygon->y_buckets_embedded);
 	    goto bail_no_mem;
+	}
+	polygon->num_y_buckets = num_buckets;
     }
     memset (polygon->y_buckets, 0, num_buckets * sizeof (struct edge *));
 
@@ -1357,12 +1456,37 @@ _glitter_scan_converter_init(glitter_scan_converter_t *converter, jmp_buf *jmp)
     polygon_init(converter->polygon, jmp);
     active_list_init(converter->active);
     cell_list_init(converter->coverages, jmp);
+    converter->spans = converter->spans_embedded;
+    converter->num_spans = ARRAY_LENGTH (converter->spans_embedded);
     converter->xmin=0;
     converter->ymin=0;
     converter->xmax=0;
     converter->ymax=0;
 }
 
+/* Returns the converter's arenas to their idle state ready for reuse,
+ * or FALSE if it holds on to too much memory to be worth keeping. */
+#define GLITTER_MAX_RETAINED_SIZE (64 << 10)
+static cairo_bool_t
+_glitter_scan_converter_release(glitter_scan_converter_t *self)
+{
+    size_t size;
+
+    pool_reset (self->polygon->edge_pool.base);
+    cell_list_reset (self->coverages);
+    self->coverages->dense = NULL;
+
+    size  = pool_size (self->polygon->edge_pool.base);
+    size += pool_size (self->coverages->cell_pool.base);
+    size += self->coverages->dense_size * sizeof (struct cell);
+    if (self->polygon->y_buckets != self->polygon->y_buckets_embedded)
+	size += self->polygon->num_y_buckets * sizeof (struct edge *);
+    if (self->spans != self->spans_embedded)
+	size += self->num_spans * sizeof (cairo_half_open_span_t);
+
+    return size <= GLITTER_MAX_RETAINED_SIZE;
+}
+
 static void
 _glitter_scan_converter_fini(glitter_scan_converter_t *self)
 {
@@ -1410,13 +1534,19 @@ glitter_scan_converter_reset(
 
     max_num_spans = xmax - xmin + 1;
 
-    if (max_num_spans > ARRAY_LENGTH(converter->spans_embedded)) {
+    if (max_num_spans > converter->num_spans) {
+	if (converter->spans != converter->spans_embedded)
+	    free (converter->spans);
+
 	converter->spans = _cairo_malloc_ab (max_num_spans,
 					     sizeof (cairo_half_open_span_t));
-	if (unlikely (converter->spans == NULL))
+	if (unlikely (converter->spans == NULL)) {
+	    converter->spans = converter->spans_embedded;
+	    converter->num_spans = ARRAY_LENGTH (converter->spans_embedded);
 	    return _cairo_error (CAIRO_STATUS_NO_MEMORY);
-    } else
-	converter->spans = converter->spans_embedded;
+	}
+	converter->num_spans = max_num_spans;
+    }
 
     xmin = int_to_grid_scaled_x(xmin);
     ymin = int_to_grid_scaled_y(ymin);
@@ -1425,6 +1555,7 @@ glitter_scan_converter_reset(
 
     active_list_reset(converter->active);
     cell_list_reset(converter->coverages);
+    converter->coverages->dense = NULL;
     status = polygon_reset(converter->polygon, ymin, ymax);
     if (status)
 	return status;
@@ -1462,27 +1593,16 @@ glitter_scan_converter_reset(
     (out) = tmp__;						\
 } while (0)
 
+/* Computes the scan conversion state of an edge that becomes active
+ * at the subsample row ytop and remains so until ybot. */
 inline static void
-polygon_add_edge (struct polygon *polygon,
-		  const cairo_edge_t *edge)
+edge_init (struct edge *e,
+	   const cairo_edge_t *edge,
+	   grid_scaled_y_t ytop,
+	   grid_scaled_y_t ybot)
 {
-    struct edge *e;
-    grid_scaled_y_t ytop, ybot;
     const cairo_point_t *p1, *p2;
 
-    INPUT_TO_GRID_Y (edge->top, ytop);
-    if (ytop < polygon->ymin)
-	    ytop = polygon->ymin;
-
-    INPUT_TO_GRID_Y (edge->bottom, ybot);
-    if (ybot > polygon->ymax)
-	    ybot = polygon->ymax;
-
-    if (ybot <= ytop)
-	    return;
-
-    e = pool_alloc (polygon->edge_pool.base, sizeof (struct edge));
-
     e->ytop = ytop;
     e->height_left = ybot - ytop;
     if (edge->line.p2.y > edge->line.p1.y) {
@@ -1543,6 +1663,28 @@ polygon_add_edge (struct polygon *polygon,
 	e->cell = e->x.quo + (e->x.rem >= Ey/2);
 	e->dy = Ey;
     }
+}
+
+inline static void
+polygon_add_edge (struct polygon *polygon,
+		  const cairo_edge_t *edge)
+{
+    struct edge *e;
+    grid_scaled_y_t ytop, ybot;
+
+    INPUT_TO_GRID_Y (edge->top, ytop);
+    if (ytop < polygon->ymin)
+	    ytop = polygon->ymin;
+
+    INPUT_TO_GRID_Y (edge->bottom, ybot);
+    if (ybot > polygon->ymax)
+	    ybot = polygon->ymax;
+
+    if (ybot <= ytop)
+	    return;
+
+    e = pool_alloc (polygon->edge_pool.base, sizeof (struct edge));
+    edge_init (e, edge, ytop, ybot);
 
     _polygon_insert_edge_into_its_y_bucket (polygon, e);
 }
@@ -1712,6 +1854,270 @@ blit_a1 (struct cell_list *cells,
     return renderer->render_rows (renderer, y, height, spans, num_spans);
 }
 
+/* Appends the spans for the pixels [x, x_end) of a dense row, where
+ * cell is the dense cell of pixel x.  The coverage of each pixel is
+ * computed exactly as by blit_a8(), modulo the same int16 arithmetic,
+ * so both emit identical spans. */
+static void
+dense_row_c (struct dense_row *row,
+	     const struct cell *cell,
+	     int x, int x_end)
+{
+    int16_t cover = row->cover, last_cover = row->last_cover;
+    cairo_half_open_span_t *spans = row->spans;
+    unsigned num_spans = row->num_spans;
+
+    for (; x < x_end; x++, cell++) {
+	int16_t area;
+
+	cover += cell->covered_height;
+	area = cover*GRID_X*2 - cell->uncovered_area;
+	if (area != last_cover) {
+	    spans[num_spans].x = x;
+	    spans[num_spans].coverage = GRID_AREA_TO_ALPHA (area);
+	    last_cover = area;
+	    ++num_spans;
+	}
+    }
+
+    row->cover = cover;
+    row->last_cover = last_cover;
+    row->num_spans = num_spans;
+}
+
+#if HAVE_DENSE_ROWS && defined(GRID_X_BITS)
+/* The kernels below compute the running covered height with a vector
+ * prefix sum over 32-bit lanes, each lane loaded from the packed
+ * uncovered_area/covered_height pair of a cell.  Only the low 16 bits
+ * of every lane are significant, matching the int16 cell arithmetic.
+ */
+#define DENSE_STRIDE ((int) (sizeof (struct cell) / sizeof (int32_t)))
+#define DENSE_PAIR(c) (*(const int32_t *) &(c)->uncovered_area)
+
+static inline void
+dense_row_emit (struct dense_row *row, const int32_t *area,
+		unsigned mask, int x)
+{
+    while (mask) {
+	int i = __builtin_ctz (mask);
+	int16_t a = area[i];
+
+	row->spans[row->num_spans].x = x + i;
+	row->spans[row->num_spans].coverage = GRID_AREA_TO_ALPHA (a);
+	++row->num_spans;
+	mask &= mask - 1;
+    }
+}
+
+__attribute__((target("sse4.1")))
+static void
+dense_row_sse41 (struct dense_row *row,
+		 const struct cell *cell,
+		 int x, int x_end)
+{
+    __m128i carry = _mm_set1_epi32 (row->cover);
+    __m128i prev = _mm_set1_epi32 (row->last_cover);
+    const __m128i zero = _mm_setzero_si128 ();
+
+    for (; x_end - x >= 4; x += 4, cell += 4) {
+	int32_t area[4];
+	__m128i d, h, a, c;
+	unsigned mask;
+
+	d = _mm_setr_epi32 (DENSE_PAIR (&cell[0]), DENSE_PAIR (&cell[1]),
+			    DENSE_PAIR (&cell[2]), DENSE_PAIR (&cell[3]));
+	h = _mm_srai_epi32 (d, 16);
+	a = _mm_srai_epi32 (_mm_slli_epi32 (d, 16), 16);
+
+	h = _mm_add_epi32 (h, _mm_slli_si128 (h, 4));
+	h = _mm_add_epi32 (h, _mm_slli_si128 (h, 8));
+	h = _mm_add_epi32 (h, carry);
+	carry = _mm_shuffle_epi32 (h, 0xff);
+
+	c = _mm_sub_epi32 (_mm_slli_epi32 (h, GRID_X_BITS + 1), a);
+	d = _mm_xor_si128 (c, _mm_alignr_epi8 (c, prev, 12));
+	d = _mm_cmpeq_epi32 (_mm_slli_epi32 (d, 16), zero);
+	mask = ~_mm_movemask_ps (_mm_castsi128_ps (d)) & 0xf;
+	prev = c;
+
+	if (mask) {
+	    _mm_storeu_si128 ((__m128i *) area, c);
+	    dense_row_emit (row, area, mask, x);
+	}
+    }
+
+    row->cover = _mm_cvtsi128_si32 (carry);
+    row->last_cover = _mm_extract_epi32 (prev, 3);
+    dense_row_c (row, cell, x, x_end);
+}
+
+__attribute__((target("avx2")))
+static void
+dense_row_avx2 (struct dense_row *row,
+		const struct cell *cell,
+		int x, int x_end)
+{
+    const __m256i index = _mm256_setr_epi32 (0*DENSE_STRIDE, 1*DENSE_STRIDE,
+					     2*DENSE_STRIDE, 3*DENSE_STRIDE,
+					     4*DENSE_STRIDE, 5*DENSE_STRIDE,
+					     6*DENSE_STRIDE, 7*DENSE_STRIDE);
+    const __m256i rotate = _mm256_setr_epi32 (7, 0, 1, 2, 3, 4, 5, 6);
+    const __m256i last = _mm256_set1_epi32 (7);
+    const __m256i zero = _mm256_setzero_si256 ();
+    __m256i carry = _mm256_set1_epi32 (row->cover);
+    __m256i prev = _mm256_set1_epi32 (row->last_cover);
+
+    for (; x_end - x >= 8; x += 8, cell += 8) {
+	int32_t area[8];
+	__m256i d, h, a, c, t;
+	unsigned mask;
+
+	d = _mm256_i32gather_epi32 (&DENSE_PAIR (cell), index, 4);
+	h = _mm256_srai_epi32 (d, 16);
+	a = _mm256_srai_epi32 (_mm256_slli_epi32 (d, 16), 16);
+
+	h = _mm256_add_epi32 (h, _mm256_slli_si256 (h, 4));
+	h = _mm256_add_epi32 (h, _mm256_slli_si256 (h, 8));
+	t = _mm256_shuffle_epi32 (h, 0xff);
+	h = _mm256_add_epi32 (h, _mm256_permute2x128_si256 (t, t, 0x08));
+	h = _mm256_add_epi32 (h, carry);
+	carry = _mm256_permutevar8x32_epi32 (h, last);
+
+	c = _mm256_sub_epi32 (_mm256_slli_epi32 (h, GRID_X_BITS + 1), a);
+	t = _mm256_blend_epi32 (_mm256_permutevar8x32_epi32 (c, rotate),
+				prev, 0x01);
+	d = _mm256_xor_si256 (c, t);
+	d = _mm256_cmpeq_epi32 (_mm256_slli_epi32 (d, 16), zero);
+	mask = ~_mm256_movemask_ps (_mm256_castsi256_ps (d)) & 0xff;
+	prev = _mm256_permutevar8x32_epi32 (c, last);
+
+	if (mask) {
+	    _mm256_storeu_si256 ((__m256i *) area, c);
+	    dense_row_emit (row, area, mask, x);
+	}
+    }
+
+    row->cover = _mm_cvtsi128_si32 (_mm256_castsi256_si128 (carry));
+    row->last_cover = _mm_cvtsi128_si32 (_mm256_castsi256_si128 (prev));
+    dense_row_c (row, cell, x, x_end);
+}
+
+static dense_row_func_t
+dense_row_choose (void)
+{
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2"))
+	return dense_row_avx2;
+    if (__builtin_cpu_supports ("sse4.1"))
+	return dense_row_sse41;
+    return NULL;
+}
+#else
+static dense_row_func_t
+dense_row_choose (void)
+{
+    return NULL;
+}
+#endif
+
+/* Rows wider than this keep using the sparse cell list, as do
+ * polygons with too few edges for the row scan to pay for itself. */
+#define DENSE_MAX_WIDTH 4096
+#define DENSE_MIN_EDGES(width) ((width) / 8)
+
+static void
+cell_list_init_dense (struct cell_list *cells,
+		      int xmin, int xmax,
+		      int num_edges)
+{
+    dense_row_func_t func;
+
+    if (cells->dense)
+	return;
+
+    if (xmax - xmin > DENSE_MAX_WIDTH ||
+	num_edges < DENSE_MIN_EDGES (xmax - xmin))
+	return;
+
+    func = dense_row_choose ();
+    if (func == NULL)
+	return;
+
+    if (xmax - xmin + 2 > cells->dense_size) {
+	free (cells->dense_cells);
+	cells->dense_size = 0;
+
+	/* The sparse list remains usable if this fails. */
+	cells->dense_cells = calloc (xmax - xmin + 2, sizeof (struct cell));
+	if (cells->dense_cells == NULL)
+	    return;
+
+	cells->dense_size = xmax - xmin + 2;
+    }
+
+    cells->dense = cells->dense_cells;
+    cells->dense_row = func;
+    cells->dense_xmin = xmin;
+    cells->dense_width = xmax - xmin;
+}
+
+/* The dense equivalent of blit_a8(). */
+static glitter_status_t
+blit_a8_dense (struct cell_list *cells,
+	       cairo_span_renderer_t *renderer,
+	       cairo_half_open_span_t *spans,
+	       int y, int height,
+	       int xmin, int xmax)
+{
+    const struct cell *dense = cells->dense;
+    struct dense_row row;
+    int16_t cover;
+    int lo, hi;
+
+    if (cells->dense_lo > cells->dense_hi)
+	return CAIRO_STATUS_SUCCESS;
+
+    row.spans = spans;
+    row.num_spans = 0;
+    row.cover = dense[0].covered_height;
+    row.last_cover = 0;
+
+    lo = MAX (cells->dense_lo, 1) - 1 + xmin;
+    hi = MIN (cells->dense_hi, cells->dense_width) - 1 + xmin;
+
+    /* Untouched pixels carry the coverage of the cells to their left. */
+    cover = row.cover*GRID_X*2;
+    if (cover && (lo > xmin || lo > hi)) {
+	spans[row.num_spans].x = xmin;
+	spans[row.num_spans].coverage = GRID_AREA_TO_ALPHA (cover);
+	row.last_cover = cover;
+	++row.num_spans;
+    }
+
+    if (lo <= hi) {
+	cells->dense_row (&row, dense + lo - xmin + 1, lo, hi + 1);
+
+	cover = row.cover*GRID_X*2;
+	if (hi + 1 < xmax && cover != row.last_cover) {
+	    spans[row.num_spans].x = hi + 1;
+	    spans[row.num_spans].coverage = GRID_AREA_TO_ALPHA (cover);
+	    row.last_cover = cover;
+	    ++row.num_spans;
+	}
+    }
+
+    if (cover != row.last_cover) {
+	spans[row.num_spans].x = xmax;
+	spans[row.num_spans].coverage = GRID_AREA_TO_ALPHA (cover);
+	++row.num_spans;
+    } else if (row.last_cover) {
+	spans[row.num_spans].x = xmax;
+	spans[row.num_spans].coverage = 0;
+	++row.num_spans;
+    }
+
+    return renderer->render_rows (renderer, y, height, spans, row.num_spans);
+}
 
 I void
 glitter_scan_converter_render(glitter_scan_converter_t *converter,
@@ -1790,7 +2196,10 @@ glitter_scan_converter_render(glitter_scan_converter_t *converter,
 	    }
 	}
 
-	if (antialias)
+	if (coverages->dense)
+	    blit_a8_dense (coverages, renderer, converter->spans,
+			   i+ymin_i, j-i, xmin_i, xmax_i);
+	else if (antialias)
 	    blit_a8 (coverages, renderer, converter->spans,
 		     i+ymin_i, j-i, xmin_i, xmax_i);
 	else
@@ -1814,6 +2223,17 @@ struct _cairo_tor_scan_converter {
 
 typedef struct _cairo_tor_scan_converter cairo_tor_scan_converter_t;
 
+/* Converters are recycled, arenas and all, so that filling many small
+ * shapes does not hit malloc once warm. */
+static freed_pool_t converter_pool;
+
+static void
+_cairo_tor_scan_converter_fini (cairo_tor_scan_converter_t *self)
+{
+    _glitter_scan_converter_fini (self->converter);
+    free (self);
+}
+
 static void
 _cairo_tor_scan_converter_destroy (void *converter)
 {
@@ -1821,8 +2241,21 @@ _cairo_tor_scan_converter_destroy (void *converter)
     if (self == NULL) {
 	return;
     }
-    _glitter_scan_converter_fini (self->converter);
-    free(self);
+
+    if (_glitter_scan_converter_release (self->converter) &&
+	_freed_pool_try_put (&converter_pool, self))
+	return;
+
+    _cairo_tor_scan_converter_fini (self);
+}
+
+void
+_cairo_tor_scan_converter_reset_static_data (void)
+{
+    cairo_tor_scan_converter_t *self;
+
+    while ((self = _freed_pool_get (&converter_pool)))
+	_cairo_tor_scan_converter_fini (self);
 }
 
 cairo_status_t
@@ -1841,6 +2274,12 @@ _cairo_tor_scan_converter_add_polygon (void		*converter,
     for (i = 0; i < polygon->num_edges; i++)
 	 glitter_scan_converter_add_edge (self->converter, &polygon->edges[i]);
 
+    if (self->antialias != CAIRO_ANTIALIAS_NONE)
+	cell_list_init_dense (self->converter->coverages,
+			      self->converter->xmin / GRID_X,
+			      self->converter->xmax / GRID_X,
+			      polygon->num_edges);
+
     return CAIRO_STATUS_SUCCESS;
 }
 
@@ -1872,21 +2311,26 @@ _cairo_tor_scan_converter_create (int			xmin,
     cairo_tor_scan_converter_t *self;
     cairo_status_t status;
 
-    self = _cairo_malloc (sizeof(struct _cairo_tor_scan_converter));
-    if (unlikely (self == NULL)) {
-	status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
-	goto bail_nomem;
-    }
+    self = _freed_pool_get (&converter_pool);
+    if (self == NULL) {
+	self = _cairo_malloc (sizeof(struct _cairo_tor_scan_converter));
+	if (unlikely (self == NULL)) {
+	    status = _cairo_error (CAIRO_STATUS_NO_MEMORY);
+	    goto bail_nomem;
+	}
+
+	self->base.destroy = _cairo_tor_scan_converter_destroy;
+	self->base.generate = _cairo_tor_scan_converter_generate;
 
-    self->base.destroy = _cairo_tor_scan_converter_destroy;
-    self->base.generate = _cairo_tor_scan_converter_generate;
+	_glitter_scan_converter_init (self->converter, &self->jmp);
+    }
 
-    _glitter_scan_converter_init (self->converter, &self->jmp);
     status = glitter_scan_converter_reset (self->converter,
 					   xmin, ymin, xmax, ymax);
     if (unlikely (status))
 	goto bail;
 
+    self->base.status = CAIRO_STATUS_SUCCESS;
     self->fill_rule = fill_rule;
     self->antialias = antialias;
 
@@ -1897,3 +2341,107 @@ _cairo_tor_scan_converter_create (int			xmin,
  bail_nomem:
     return _cairo_scan_converter_create_in_error (status);
 }
+
+/* A polygon may be scan converted as a set of horizontal bands, each
+ * by its own converter clipped to the band, and produce exactly the
+ * same coverage as the single sweep provided that a converter starting
+ * afresh on the first row of a band arrives at the state the sweep
+ * would have had there.  Edge positions are computed exactly from the
+ * edge end points, so the only state a fresh converter may not
+ * reproduce is the relative order of distinct edges that round to the
+ * same cell: the sweep orders those by their history, and the order
+ * decides whether a row is rendered analytically or supersampled.
+ * Identical edges may be freely permuted.
+ */
+struct band_edge {
+    int cell;
+    struct quorem x;
+    struct quorem dxdy;
+    int64_t dy;
+};
+
+static inline int
+band_edge_compare (const struct band_edge *a, const struct band_edge *b)
+{
+    return a->cell - b->cell;
+}
+
+#define BAND_EDGE_COMPARE(a, b) band_edge_compare (&(a), &(b))
+CAIRO_COMBSORT_DECLARE (band_edges_sort, struct band_edge, BAND_EDGE_COMPARE)
+
+static inline cairo_bool_t
+band_edge_equal (const struct band_edge *a, const struct band_edge *b)
+{
+    return a->x.quo == b->x.quo && a->x.rem == b->x.rem &&
+	   a->dxdy.quo == b->dxdy.quo && a->dxdy.rem == b->dxdy.rem &&
+	   a->dy == b->dy;
+}
+
+/* Returns TRUE if scan conversion of the polygon may be restarted at
+ * pixel row y without changing the result.  (Allocation failure is
+ * reported as FALSE, i.e. just don't split here.) */
+cairo_bool_t
+_cairo_tor_scan_converter_can_split (const cairo_polygon_t *polygon,
+				     int y)
+{
+    struct band_edge stack_edges[CAIRO_STACK_ARRAY_LENGTH (struct band_edge)];
+    struct band_edge *edges = stack_edges;
+    grid_scaled_y_t ysplit;
+    cairo_bool_t can_split = TRUE;
+    int i, n;
+
+    ysplit = int_to_grid_scaled_y (y);
+
+    n = 0;
+    for (i = 0; i < polygon->num_edges; i++) {
+	const cairo_edge_t *edge = &polygon->edges[i];
+	grid_scaled_y_t ytop, ybot;
+
+	INPUT_TO_GRID_Y (edge->top, ytop);
+	INPUT_TO_GRID_Y (edge->bottom, ybot);
+	if (ytop <= ysplit && ybot > ysplit)
+	    n++;
+    }
+    if (n < 2)
+	return TRUE;
+
+    if (n > ARRAY_LENGTH (stack_edges)) {
+	edges = _cairo_malloc_ab (n, sizeof (struct band_edge));
+	if (unlikely (edges == NULL))
+	    return FALSE;
+    }
+
+    n = 0;
+    for (i = 0; i < polygon->num_edges; i++) {
+	const cairo_edge_t *edge = &polygon->edges[i];
+	grid_scaled_y_t ytop, ybot;
+	struct edge e;
+
+	INPUT_TO_GRID_Y (edge->top, ytop);
+	INPUT_TO_GRID_Y (edge->bottom, ybot);
+	if (ytop > ysplit || ybot <= ysplit)
+	    continue;
+
+	edge_init (&e, edge, ysplit, ybot);
+	edges[n].cell = e.cell;
+	edges[n].x = e.x;
+	edges[n].dxdy = e.dxdy;
+	edges[n].dy = e.dy;
+	n++;
+    }
+
+    band_edges_sort (edges, n);
+    for (i = 1; i < n; i++) {
+	if (edges[i].cell == edges[i-1].cell &&
+	    ! band_edge_equal (&edges[i], &edges[i-1]))
+	{
+	    can_split = FALSE;
+	    break;
+	}
+    }
+
+    if (edges != stack_edges)
+	free (edges);
+
+    return can_split;
+}
@@ -328,6 +328,9 @@ typedef struct _cairo_polygon {
     int edges_size;
     cairo_edge_t *edges;
     cairo_edge_t  edges_embedded[32];
+
+    /* Set when the edges are the outline of a single convex contour. */
+    cairo_bool_t is_convex;
 } cairo_polygon_t;
 
 typedef cairo_warn cairo_status_t
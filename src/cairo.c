@@ -45,6 +45,7 @@
 #include "cairo-error-private.h"
 #include "cairo-path-private.h"
 #include "cairo-pattern-private.h"
+#include "cairo-prepared-path-private.h"
 #include "cairo-surface-private.h"
 #include "cairo-surface-backend-private.h"
 
@@ -2088,6 +2089,110 @@ cairo_rectangle (cairo_t *cr,
 	_cairo_set_error (cr, status);
 }
 
+/* The control point offset of a quarter arc, 4/3 (sqrt(2) - 1). */
+#define QUARTER_ARC_KAPPA 0.55228474983079339840
+
+/**
+ * cairo_rounded_rectangle:
+ * @cr: a cairo context
+ * @x: the X coordinate of the top left corner of the rectangle
+ * @y: the Y coordinate to the top left corner of the rectangle
+ * @width: the width of the rectangle
+ * @height: the height of the rectangle
+ * @radius: the radius of the corners
+ *
+ * Adds a closed sub-path rectangle of the given size to the current
+ * path at position (@x, @y) in user-space coordinates, with each of its
+ * corners rounded by a quarter circle of the given @radius. The radius
+ * is limited to half the width or height of the rectangle, whichever
+ * is smaller, and a @radius of zero or less gives a plain rectangle.
+ *
+ * Each corner is a single Bézier curve approximating the quarter
+ * circle, as cairo_arc() would use for a quarter turn, so the path is
+ * close to the equivalent built with four calls to cairo_arc(), and
+ * starts at the point where the top side leaves the top left corner.
+ *
+ * Rounded rectangles filled with %CAIRO_ANTIALIAS_FAST on image
+ * surfaces are rendered with their exact coverage, and their corners
+ * are cached when they are small.
+ *
+ * Since: 1.18
+ **/
+void
+cairo_rounded_rectangle (cairo_t *cr,
+			 double x, double y,
+			 double width, double height,
+			 double radius)
+{
+    cairo_status_t status;
+    double rx, ry, kx, ky;
+
+    if (unlikely (cr->status))
+	return;
+
+    radius = MIN (radius, MIN (fabs (width), fabs (height)) / 2);
+    if (! (radius > 0)) {
+	cairo_rectangle (cr, x, y, width, height);
+	return;
+    }
+
+    /* Follow the rectangle in the same direction as cairo_rectangle(). */
+    rx = width < 0 ? -radius : radius;
+    ry = height < 0 ? -radius : radius;
+    kx = rx * QUARTER_ARC_KAPPA;
+    ky = ry * QUARTER_ARC_KAPPA;
+
+    status = cr->backend->move_to (cr, x + rx, y);
+    if (unlikely (status))
+	goto BAIL;
+
+    status = cr->backend->line_to (cr, x + width - rx, y);
+    if (unlikely (status))
+	goto BAIL;
+    status = cr->backend->curve_to (cr,
+				    x + width - rx + kx, y,
+				    x + width, y + ry - ky,
+				    x + width, y + ry);
+    if (unlikely (status))
+	goto BAIL;
+
+    status = cr->backend->line_to (cr, x + width, y + height - ry);
+    if (unlikely (status))
+	goto BAIL;
+    status = cr->backend->curve_to (cr,
+				    x + width, y + height - ry + ky,
+				    x + width - rx + kx, y + height,
+				    x + width - rx, y + height);
+    if (unlikely (status))
+	goto BAIL;
+
+    status = cr->backend->line_to (cr, x + rx, y + height);
+    if (unlikely (status))
+	goto BAIL;
+    status = cr->backend->curve_to (cr,
+				    x + rx - kx, y + height,
+				    x, y + height - ry + ky,
+				    x, y + height - ry);
+    if (unlikely (status))
+	goto BAIL;
+
+    status = cr->backend->line_to (cr, x, y + ry);
+    if (unlikely (status))
+	goto BAIL;
+    status = cr->backend->curve_to (cr,
+				    x, y + ry - ky,
+				    x + rx - kx, y,
+				    x + rx, y);
+    if (unlikely (status))
+	goto BAIL;
+
+    status = cr->backend->close_path (cr);
+
+BAIL:
+    if (unlikely (status))
+	_cairo_set_error (cr, status);
+}
+
 #if 0
 /* XXX: NYI */
 void
@@ -2450,6 +2555,150 @@ cairo_fill_preserve (cairo_t *cr)
 }
 slim_hidden_def(cairo_fill_preserve);
 
+/**
+ * cairo_prepare_fill:
+ * @cr: a cairo context
+ *
+ * Captures the current path, along with the current transformation,
+ * fill rule and tolerance, so that the same shape can be filled many
+ * times over with cairo_fill_prepared(). The path is transformed to
+ * device space and flattened here, once, leaving only rasterization
+ * to be done for each fill.
+ *
+ * The current path is left untouched.
+ *
+ * Return value: the newly created #cairo_prepared_path_t. The caller
+ * owns the returned object and should call cairo_prepared_path_destroy()
+ * when finished with it.
+ *
+ * This function always returns a valid pointer, but it will return a
+ * pointer to a "nil" prepared path if an error such as out-of-memory
+ * occurs. The error status can be retrieved with
+ * cairo_prepared_path_status().
+ *
+ * Since: 1.18
+ **/
+cairo_prepared_path_t *
+cairo_prepare_fill (cairo_t *cr)
+{
+    cairo_prepared_path_t *prepared;
+    cairo_status_t status;
+
+    if (unlikely (cr->status))
+	return _cairo_prepared_path_create_in_error (cr->status);
+
+    prepared = _cairo_prepared_path_create ();
+    if (unlikely (prepared->status))
+	return prepared;
+
+    prepared->fill_rule = cr->backend->get_fill_rule (cr);
+    prepared->tolerance = cr->backend->get_tolerance (cr);
+
+    prepared->user_path = cr->backend->copy_path (cr);
+    status = prepared->user_path->status;
+    if (unlikely (status))
+	goto BAIL;
+
+    if (cr->backend->prepare_fill != NULL) {
+	status = cr->backend->prepare_fill (cr, prepared);
+	if (unlikely (status))
+	    goto BAIL;
+    }
+
+    return prepared;
+
+BAIL:
+    cairo_prepared_path_destroy (prepared);
+    return _cairo_prepared_path_create_in_error (status);
+}
+
+static cairo_status_t
+_cairo_fill_prepared_fallback (cairo_t *cr,
+			       const cairo_prepared_path_t *prepared)
+{
+    cairo_path_t *path;
+    cairo_status_t status, restore_status;
+
+    path = cr->backend->copy_path (cr);
+    status = path->status;
+    if (unlikely (status))
+	goto BAIL;
+
+    status = cr->backend->save (cr);
+    if (unlikely (status))
+	goto BAIL;
+
+    status = cr->backend->set_fill_rule (cr, prepared->fill_rule);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = cr->backend->set_tolerance (cr, prepared->tolerance);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = cr->backend->new_path (cr);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_path_append_to_context (prepared->user_path, cr);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = cr->backend->fill (cr);
+
+    restore_status = cr->backend->restore (cr);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = restore_status;
+
+    /* Put back the user's path, which the fill consumed */
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = cr->backend->new_path (cr);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_path_append_to_context (path, cr);
+
+BAIL:
+    cairo_path_destroy (path);
+    return status;
+}
+
+/**
+ * cairo_fill_prepared:
+ * @cr: a cairo context
+ * @prepared: a #cairo_prepared_path_t from cairo_prepare_fill()
+ *
+ * A drawing operator that fills the path captured in @prepared, as
+ * given in user space, under the current transformation. The fill
+ * rule and tolerance are those in effect when it was prepared; the
+ * source, operator, antialiasing and clip are taken from @cr. The
+ * current path is neither used nor changed.
+ *
+ * The work done by cairo_prepare_fill() is reused so long as the
+ * current transformation matches the one @prepared was captured
+ * under, or differs from it only by a translation of whole device
+ * pixels. Under any other transformation the path is transformed and
+ * flattened afresh on each call.
+ *
+ * Since: 1.18
+ **/
+void
+cairo_fill_prepared (cairo_t		   *cr,
+		     cairo_prepared_path_t *prepared)
+{
+    cairo_status_t status;
+
+    if (unlikely (cr->status))
+	return;
+
+    if (unlikely (prepared == NULL)) {
+	_cairo_set_error (cr, CAIRO_STATUS_NULL_POINTER);
+	return;
+    }
+
+    if (unlikely (prepared->status)) {
+	_cairo_set_error (cr, prepared->status);
+	return;
+    }
+
+    if (cr->backend->fill_prepared != NULL)
+	status = cr->backend->fill_prepared (cr, prepared);
+    else
+	status = _cairo_fill_prepared_fallback (cr, prepared);
+    if (unlikely (status))
+	_cairo_set_error (cr, status);
+}
+
 /**
  * cairo_copy_page:
  * @cr: a cairo context
@@ -4273,6 +4522,144 @@ cairo_copy_path_flat (cairo_t *cr)
     return cr->backend->copy_path_flat (cr);
 }
 
+static cairo_status_t
+_cairo_fill_instances_fallback (cairo_t			*cr,
+				const cairo_path_t	*path,
+				const cairo_matrix_t	*transforms,
+				const double		*colors,
+				int			 num_instances)
+{
+    cairo_path_t *saved;
+    cairo_status_t status, restore_status;
+    int i;
+
+    saved = cr->backend->copy_path (cr);
+    status = saved->status;
+    if (unlikely (status))
+	goto BAIL;
+
+    for (i = 0; i < num_instances; i++) {
+	status = cr->backend->save (cr);
+	if (unlikely (status))
+	    break;
+
+	status = cr->backend->transform (cr, &transforms[i]);
+	if (likely (status == CAIRO_STATUS_SUCCESS) && colors != NULL) {
+	    status = cr->backend->set_source_rgba (cr,
+						   colors[4*i + 0],
+						   colors[4*i + 1],
+						   colors[4*i + 2],
+						   colors[4*i + 3]);
+	}
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = cr->backend->new_path (cr);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = _cairo_path_append_to_context (path, cr);
+	if (likely (status == CAIRO_STATUS_SUCCESS))
+	    status = cr->backend->fill (cr);
+
+	restore_status = cr->backend->restore (cr);
+	if (status == CAIRO_STATUS_SUCCESS)
+	    status = restore_status;
+	if (unlikely (status))
+	    break;
+    }
+
+    /* Put back the user's path, which the fills consumed */
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = cr->backend->new_path (cr);
+    if (likely (status == CAIRO_STATUS_SUCCESS))
+	status = _cairo_path_append_to_context (saved, cr);
+
+BAIL:
+    cairo_path_destroy (saved);
+    return status;
+}
+
+/**
+ * cairo_fill_instances:
+ * @cr: a cairo context
+ * @path: the shape to draw, as returned by cairo_copy_path() or
+ * constructed by hand, see cairo_append_path()
+ * @transforms: an array of @num_instances transformations
+ * @colors: %NULL, or an array of @num_instances red, green, blue and
+ * alpha quadruples, each component in the range 0 to 1
+ * @num_instances: the number of instances to draw
+ *
+ * A drawing operator that fills @path @num_instances times, in order.
+ * Instance i is drawn as if by cairo_save(), cairo_transform() with
+ * @transforms[i], cairo_set_source_rgba() with the i'th color of
+ * @colors (if not %NULL, otherwise the current source is used),
+ * appending @path, cairo_fill() and cairo_restore(). The current path
+ * is neither used nor changed.
+ *
+ * This is intended for drawing many copies of the same small shape,
+ * such as the markers of a scatter plot. On raster surfaces the shape
+ * is rasterized only once for each distinct linear transformation and
+ * quarter pixel offset and then stamped into place, so instances are
+ * positioned to the nearest quarter of a device pixel. Vector surfaces
+ * receive every instance as a separate fill.
+ *
+ * Since: 1.18
+ **/
+void
+cairo_fill_instances (cairo_t		   *cr,
+		      const cairo_path_t   *path,
+		      const cairo_matrix_t *transforms,
+		      const double	   *colors,
+		      int		    num_instances)
+{
+    cairo_status_t status;
+    int i;
+
+    if (unlikely (cr->status))
+	return;
+
+    if (unlikely (path == NULL)) {
+	_cairo_set_error (cr, CAIRO_STATUS_NULL_POINTER);
+	return;
+    }
+
+    if (unlikely (path->status)) {
+	if (path->status > CAIRO_STATUS_SUCCESS &&
+	    path->status <= CAIRO_STATUS_LAST_STATUS)
+	    _cairo_set_error (cr, path->status);
+	else
+	    _cairo_set_error (cr, CAIRO_STATUS_INVALID_STATUS);
+	return;
+    }
+
+    if (num_instances == 0 || path->num_data == 0)
+	return;
+
+    if (unlikely (num_instances < 0)) {
+	_cairo_set_error (cr, CAIRO_STATUS_NEGATIVE_COUNT);
+	return;
+    }
+
+    if (unlikely (path->data == NULL || transforms == NULL)) {
+	_cairo_set_error (cr, CAIRO_STATUS_NULL_POINTER);
+	return;
+    }
+
+    for (i = 0; i < num_instances; i++) {
+	if (unlikely (! _cairo_matrix_is_invertible (&transforms[i]))) {
+	    _cairo_set_error (cr, CAIRO_STATUS_INVALID_MATRIX);
+	    return;
+	}
+    }
+
+    if (cr->backend->fill_instances != NULL) {
+	status = cr->backend->fill_instances (cr, path, transforms,
+					      colors, num_instances);
+    } else {
+	status = _cairo_fill_instances_fallback (cr, path, transforms,
+						 colors, num_instances);
+    }
+    if (unlikely (status))
+	_cairo_set_error (cr, status);
+}
+
 /**
  * cairo_append_path:
  * @cr: a cairo context
@@ -907,6 +907,12 @@ cairo_rectangle (cairo_t *cr,
 		 double x, double y,
 		 double width, double height);
 
+cairo_public void
+cairo_rounded_rectangle (cairo_t *cr,
+			 double x, double y,
+			 double width, double height,
+			 double radius);
+
 /* XXX: NYI
 cairo_public void
 cairo_stroke_to_path (cairo_t *cr);
@@ -950,6 +956,34 @@ cairo_fill (cairo_t *cr);
 cairo_public void
 cairo_fill_preserve (cairo_t *cr);
 
+/**
+ * cairo_prepared_path_t:
+ *
+ * A #cairo_prepared_path_t is an opaque, reference counted snapshot of
+ * a path together with the transformation, fill rule and tolerance it
+ * is to be filled with. Create one with cairo_prepare_fill() and draw
+ * it as often as needed with cairo_fill_prepared().
+ *
+ * Since: 1.18
+ **/
+typedef struct _cairo_prepared_path cairo_prepared_path_t;
+
+cairo_public cairo_prepared_path_t *
+cairo_prepare_fill (cairo_t *cr);
+
+cairo_public void
+cairo_fill_prepared (cairo_t		   *cr,
+		     cairo_prepared_path_t *prepared);
+
+cairo_public cairo_prepared_path_t *
+cairo_prepared_path_reference (cairo_prepared_path_t *prepared);
+
+cairo_public void
+cairo_prepared_path_destroy (cairo_prepared_path_t *prepared);
+
+cairo_public cairo_status_t
+cairo_prepared_path_status (cairo_prepared_path_t *prepared);
+
 cairo_public void
 cairo_copy_page (cairo_t *cr);
 
@@ -2120,6 +2154,13 @@ cairo_append_path (cairo_t		*cr,
 cairo_public void
 cairo_path_destroy (cairo_path_t *path);
 
+cairo_public void
+cairo_fill_instances (cairo_t		   *cr,
+		      const cairo_path_t   *path,
+		      const cairo_matrix_t *transforms,
+		      const double	   *colors,
+		      int		    num_instances);
+
 /* Error status queries */
 
 cairo_public cairo_status_t
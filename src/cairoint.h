@@ -1015,6 +1015,15 @@ _cairo_path_fixed_interpret (const cairo_path_fixed_t	  *path,
 		       cairo_path_fixed_close_path_func_t *close_path,
 		       void				  *closure);
 
+cairo_private cairo_status_t
+_cairo_path_fixed_interpret_culled (const cairo_path_fixed_t	  *path,
+		       const cairo_box_t		  *bounds,
+		       cairo_path_fixed_move_to_func_t	  *move_to,
+		       cairo_path_fixed_line_to_func_t	  *line_to,
+		       cairo_path_fixed_curve_to_func_t	  *curve_to,
+		       cairo_path_fixed_close_path_func_t *close_path,
+		       void				  *closure);
+
 cairo_private cairo_status_t
 _cairo_path_fixed_interpret_flat (const cairo_path_fixed_t *path,
 		       cairo_path_fixed_move_to_func_t	  *move_to,
@@ -1589,6 +1598,9 @@ _cairo_image_reset_static_data (void);
 cairo_private void
 _cairo_image_compositor_reset_static_data (void);
 
+cairo_private void
+_cairo_image_spans_compositor_reset_static_data (void);
+
 cairo_private cairo_surface_t *
 _cairo_image_surface_create_with_pixman_format (unsigned char		*data,
 						pixman_format_code_t	 pixman_format,
@@ -1887,6 +1899,12 @@ _cairo_drm_device_reset_static_data (void);
 cairo_private void
 _cairo_clip_reset_static_data (void);
 
+cairo_private void
+_cairo_tor_scan_converter_reset_static_data (void);
+
+cairo_private void
+_cairo_ellipse_scan_converter_reset_static_data (void);
+
 cairo_private void
 _cairo_pattern_reset_static_data (void);
 
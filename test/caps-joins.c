@@ -117,6 +117,13 @@ draw_05 (cairo_t *cr, int width, int height)
     return draw (cr, 0.5);
 }
 
+static cairo_test_status_t
+draw_05_fast (cairo_t *cr, int width, int height)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return draw (cr, 0.5);
+}
+
 CAIRO_TEST (caps_joins,
 	    "Test caps and joins",
 	    "stroke", /* keywords */
@@ -148,3 +155,11 @@ CAIRO_TEST (caps_joins_05,
 	    3 * (PAD + SIZE) + PAD,
 	    2 * (PAD + SIZE) + PAD,
 	    NULL, draw_05)
+
+CAIRO_TEST (fast_caps_joins_05,
+	    "Test caps and joins with fine lines and fast antialiasing",
+	    "stroke", /* keywords */
+	    "target=raster", /* requirements */
+	    3 * (PAD + SIZE) + PAD,
+	    2 * (PAD + SIZE) + PAD,
+	    NULL, draw_05_fast)
@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2019 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Red Hat, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. Red Hat, Inc. makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * RED HAT, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL RED HAT, INC. BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* Strokes a long dashed line, most of which is clipped away, several
+ * times over with cairo_stroke_preserve(), so that the dashes are
+ * recorded on the path by the second stroke and replayed after that.
+ * The bottom half draws the same strokes from a fresh path each time,
+ * and must match the top half.  Changing the dash offset part of the
+ * way through must not replay the recording made with the old one,
+ * and the strokes after that replace it with one for the new offset.
+ */
+
+#include "cairo-test.h"
+
+#define WIDTH 120
+#define HEIGHT 50
+#define REPEAT 4
+
+static void
+long_lines (cairo_t *cr)
+{
+    cairo_new_path (cr);
+    cairo_move_to (cr, -20000, 8);
+    cairo_line_to (cr, 20000, 18);
+    cairo_move_to (cr, -20000, 30.5);
+    cairo_line_to (cr, 20000, 30.5);
+    cairo_line_to (cr, 20000, 40.5);
+    cairo_line_to (cr, -20000, 40.5);
+}
+
+static void
+draw_strokes (cairo_t *cr, cairo_bool_t preserve)
+{
+    static const double dashes[] = { 6, 3, 1, 3 };
+    int i;
+
+    cairo_save (cr);
+    cairo_rectangle (cr, 10, 2, WIDTH - 20, HEIGHT - 4);
+    cairo_clip (cr);
+
+    cairo_set_line_width (cr, 3);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+
+    long_lines (cr);
+    for (i = 0; i < 2 * REPEAT; i++) {
+	/* The second half is offset by a whole dash pattern plus one */
+	cairo_set_dash (cr, dashes, ARRAY_LENGTH (dashes), i < REPEAT ? 0 : 14);
+	cairo_set_source_rgba (cr, i & 1, 0, 1 - (i & 1), .25);
+	if (! preserve)
+	    long_lines (cr);
+	cairo_stroke_preserve (cr);
+    }
+    cairo_new_path (cr);
+
+    cairo_restore (cr);
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    draw_strokes (cr, TRUE);
+
+    cairo_translate (cr, 0, HEIGHT);
+    draw_strokes (cr, FALSE);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (dash_stroke_preserve,
+	    "Strokes a long, mostly clipped, dashed line several times with "
+	    "cairo_stroke_preserve",
+	    "dash, stroke, clip", /* keywords */
+	    NULL, /* requirements */
+	    WIDTH, 2 * HEIGHT,
+	    NULL, draw)
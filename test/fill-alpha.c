@@ -74,9 +74,22 @@ draw (cairo_t *cr, int width, int height)
     return CAIRO_TEST_SUCCESS;
 }
 
+static cairo_test_status_t
+draw_fast (cairo_t *cr, int width, int height)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return draw (cr, width, height);
+}
+
 CAIRO_TEST (fill_alpha,
 	    "Tests using set_rgba();fill()",
 	    "fill, alpha", /* keywords */
 	    NULL, /* requirements */
 	    2*SIZE + 4*PAD, 2*SIZE + 4*PAD,
 	    NULL, draw)
+CAIRO_TEST (fast_fill_alpha,
+	    "Tests using set_rgba();fill() with fast antialiasing",
+	    "fill, alpha", /* keywords */
+	    "target=raster", /* requirements */
+	    2*SIZE + 4*PAD, 2*SIZE + 4*PAD,
+	    NULL, draw_fast)
@@ -0,0 +1,185 @@
+/*
+ * Copyright © 2019 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Red Hat, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. Red Hat, Inc. makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * RED HAT, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL RED HAT, INC. BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* fill-instances draws a set of markers with cairo_fill_instances();
+ * fill-instances-separate draws the same markers with one cairo_fill()
+ * each. Both share the same reference image.
+ *
+ * The markers are placed on quarter pixel offsets, so that the raster
+ * stamping path positions them exactly, and several of them share a
+ * transformation and phase so that the mask cache is hit. The top
+ * right cell uses an unbounded operator and the bottom right one
+ * records the instances on a vector surface, both of which must fall
+ * back to a fill per instance.
+ */
+
+#include "cairo-test.h"
+
+#define SIZE 60
+#define NUM_MARKERS 12
+
+static void
+marker_path (cairo_t *cr)
+{
+    cairo_new_path (cr);
+    cairo_move_to (cr, -4, -3);
+    cairo_line_to (cr, 4, -4);
+    cairo_line_to (cr, 2, 4);
+    cairo_close_path (cr);
+    cairo_arc (cr, 0, 0, 2, 0, 2 * M_PI);
+}
+
+static void
+layout (cairo_matrix_t *transforms, double *colors, int n, double cell)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+	/* Walk the quarter pixel phases, repeating them every four. */
+	double x = 6 + (i % 4) * (cell - 12) / 3 + (i % 4) * .25;
+	double y = 6 + (i / 4) * (cell - 12) / 2 + (i / 4) * .25;
+
+	cairo_matrix_init_translate (&transforms[i], x, y);
+	if (i >= 8)
+	    cairo_matrix_rotate (&transforms[i], M_PI / 6);
+	if (i % 3 == 2)
+	    cairo_matrix_scale (&transforms[i], 1.5, 1.5);
+
+	colors[4*i + 0] = (i % 3) / 2.;
+	colors[4*i + 1] = (i % 4) / 3.;
+	colors[4*i + 2] = 1. - (i % 3) / 2.;
+	colors[4*i + 3] = .6 + .1 * (i % 4);
+    }
+}
+
+static void
+fill_markers (cairo_t *cr,
+	      const cairo_path_t *marker,
+	      const cairo_matrix_t *transforms,
+	      const double *colors,
+	      int n,
+	      cairo_bool_t separate)
+{
+    int i;
+
+    if (! separate) {
+	cairo_fill_instances (cr, marker, transforms, colors, n);
+	return;
+    }
+
+    for (i = 0; i < n; i++) {
+	cairo_save (cr);
+	cairo_transform (cr, &transforms[i]);
+	if (colors != NULL)
+	    cairo_set_source_rgba (cr,
+				   colors[4*i + 0], colors[4*i + 1],
+				   colors[4*i + 2], colors[4*i + 3]);
+	cairo_new_path (cr);
+	cairo_append_path (cr, marker);
+	cairo_fill (cr);
+	cairo_restore (cr);
+    }
+}
+
+static cairo_test_status_t
+draw_markers (cairo_t *cr, cairo_bool_t separate)
+{
+    cairo_matrix_t transforms[NUM_MARKERS];
+    double colors[4 * NUM_MARKERS];
+    cairo_surface_t *recording;
+    cairo_path_t *marker;
+    cairo_t *cr2;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    marker_path (cr);
+    marker = cairo_copy_path (cr);
+    cairo_new_path (cr);
+
+    /* Stamped, with per-instance colors and with the current source. */
+    layout (transforms, colors, NUM_MARKERS, SIZE);
+    fill_markers (cr, marker, transforms, colors, NUM_MARKERS, separate);
+
+    cairo_save (cr);
+    cairo_translate (cr, 0, SIZE);
+    cairo_set_source_rgba (cr, .2, .5, .2, .8);
+    fill_markers (cr, marker, transforms, NULL, NUM_MARKERS, separate);
+    cairo_restore (cr);
+
+    /* An unbounded operator, confined to its cell by the clip. */
+    cairo_save (cr);
+    cairo_translate (cr, SIZE, 0);
+    cairo_rectangle (cr, 0, 0, SIZE, SIZE);
+    cairo_clip (cr);
+    cairo_push_group (cr);
+    cairo_set_source_rgb (cr, 1, .5, 0);
+    cairo_paint (cr);
+    cairo_set_operator (cr, CAIRO_OPERATOR_IN);
+    cairo_set_source_rgba (cr, 0, 0, 1, .5);
+    fill_markers (cr, marker, transforms, NULL, NUM_MARKERS, separate);
+    cairo_pop_group_to_source (cr);
+    cairo_paint (cr);
+    cairo_restore (cr);
+
+    /* Recorded on a vector surface, then replayed. */
+    recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA,
+						NULL);
+    cr2 = cairo_create (recording);
+    fill_markers (cr2, marker, transforms, colors, NUM_MARKERS, separate);
+    cairo_destroy (cr2);
+
+    cairo_set_source_surface (cr, recording, SIZE, SIZE);
+    cairo_paint (cr);
+    cairo_surface_destroy (recording);
+
+    cairo_path_destroy (marker);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    return draw_markers (cr, FALSE);
+}
+
+static cairo_test_status_t
+draw_separate (cairo_t *cr, int width, int height)
+{
+    return draw_markers (cr, TRUE);
+}
+
+CAIRO_TEST (fill_instances,
+	    "Tests cairo_fill_instances with per-instance colors, sub-pixel "
+	    "offsets, an unbounded operator and a vector surface",
+	    "fill", /* keywords */
+	    NULL, /* requirements */
+	    2 * SIZE, 2 * SIZE,
+	    NULL, draw)
+CAIRO_TEST (fill_instances_separate,
+	    "Draws the fill-instances markers with a cairo_fill each",
+	    "fill", /* keywords */
+	    NULL, /* requirements */
+	    2 * SIZE, 2 * SIZE,
+	    NULL, draw_separate)
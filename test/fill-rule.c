@@ -119,9 +119,22 @@ draw (cairo_t *cr, int width, int height)
     return CAIRO_TEST_SUCCESS;
 }
 
+static cairo_test_status_t
+draw_fast (cairo_t *cr, int width, int height)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return draw (cr, width, height);
+}
+
 CAIRO_TEST (fill_rule,
 	    "Tests cairo_set_fill_rule with some star shapes",
 	    "fill, path", /* keywords */
 	    NULL, /* requirements */
 	    BIG_STAR_SIZE * 2 + 3, BIG_STAR_SIZE + LITTLE_STAR_SIZE + 3,
 	    NULL, draw)
+CAIRO_TEST (fast_fill_rule,
+	    "Tests cairo_set_fill_rule with some star shapes and fast antialiasing",
+	    "fill, path", /* keywords */
+	    "target=raster", /* requirements */
+	    BIG_STAR_SIZE * 2 + 3, BIG_STAR_SIZE + LITTLE_STAR_SIZE + 3,
+	    NULL, draw_fast)
@@ -0,0 +1,231 @@
+/*
+ * Copyright © 2019 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Red Hat, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. Red Hat, Inc. makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * RED HAT, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL RED HAT, INC. BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Checks that cairo_fill_prepared() draws exactly what cairo_fill()
+ * draws for the same path, both when the prepared device path can be
+ * reused (a whole pixel change of translation) and when it cannot (a
+ * fractional one), and that errors are reported on the context.
+ */
+
+#include "cairo-test.h"
+#include "buffer-diff.h"
+
+#define SIZE 64
+
+static void
+set_transform (cairo_t *cr, double tx, double ty)
+{
+    cairo_identity_matrix (cr);
+    cairo_translate (cr, tx, ty);
+    cairo_rotate (cr, 0.3);
+    cairo_scale (cr, 1.25, 0.75);
+}
+
+static void
+make_path (cairo_t *cr)
+{
+    cairo_new_path (cr);
+    cairo_move_to (cr, 4, 4);
+    cairo_curve_to (cr, 40, -4, 30, 40, 36, 36);
+    cairo_line_to (cr, 8, 30);
+    cairo_close_path (cr);
+    cairo_arc (cr, 20, 18, 8, 0, 2 * M_PI);
+}
+
+static cairo_surface_t *
+create_target (cairo_t **cr)
+{
+    cairo_surface_t *surface;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    *cr = cairo_create (surface);
+    cairo_set_fill_rule (*cr, CAIRO_FILL_RULE_EVEN_ODD);
+    cairo_set_source_rgba (*cr, 0.2, 0.4, 0.8, 0.9);
+
+    return surface;
+}
+
+static cairo_test_status_t
+compare (const cairo_test_context_t *ctx,
+	 double tx, double ty)
+{
+    cairo_surface_t *expected, *actual, *diff;
+    cairo_prepared_path_t *prepared;
+    buffer_diff_result_t result;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    cairo_t *cr;
+
+    expected = create_target (&cr);
+    set_transform (cr, tx, ty);
+    make_path (cr);
+    cairo_fill (cr);
+    cairo_destroy (cr);
+
+    /* Prepare at the origin, then fill translated by (tx, ty). */
+    actual = create_target (&cr);
+    set_transform (cr, 0, 0);
+    make_path (cr);
+    prepared = cairo_prepare_fill (cr);
+    cairo_new_path (cr);
+
+    /* Neither the fill rule nor the current path may leak in. */
+    cairo_set_fill_rule (cr, CAIRO_FILL_RULE_WINDING);
+    cairo_rectangle (cr, 0, 0, 4, 4);
+
+    set_transform (cr, tx, ty);
+    cairo_fill_prepared (cr, prepared);
+    cairo_prepared_path_destroy (prepared);
+
+    if (cairo_status (cr)) {
+	cairo_test_log (ctx, "Error: fill_prepared at (%g, %g) failed: %s\n",
+			tx, ty, cairo_status_to_string (cairo_status (cr)));
+	ret = CAIRO_TEST_FAILURE;
+    } else if (! cairo_has_current_point (cr)) {
+	cairo_test_log (ctx, "Error: fill_prepared at (%g, %g) cleared the path\n",
+			tx, ty);
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_destroy (cr);
+
+    diff = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, SIZE, SIZE);
+    if (ret == CAIRO_TEST_SUCCESS &&
+	image_diff (ctx, expected, actual, diff, &result) == CAIRO_STATUS_SUCCESS &&
+	result.pixels_changed)
+    {
+	cairo_test_log (ctx,
+			"Error: fill_prepared at (%g, %g) differs from fill "
+			"in %u pixels (max diff %u)\n",
+			tx, ty, result.pixels_changed, result.max_diff);
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    cairo_surface_destroy (diff);
+    cairo_surface_destroy (actual);
+    cairo_surface_destroy (expected);
+
+    return ret;
+}
+
+static cairo_test_status_t
+check_errors (const cairo_test_context_t *ctx)
+{
+    cairo_surface_t *surface;
+    cairo_prepared_path_t *prepared;
+    cairo_matrix_t singular;
+    cairo_t *cr, *bad;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+
+    surface = create_target (&cr);
+
+    /* A NULL prepared path is an error on the context. */
+    cairo_fill_prepared (cr, NULL);
+    if (cairo_status (cr) != CAIRO_STATUS_NULL_POINTER) {
+	cairo_test_log (ctx, "Error: fill_prepared (NULL) gave %s\n",
+			cairo_status_to_string (cairo_status (cr)));
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_destroy (cr);
+
+    /* A path prepared from a context in error carries that error, and
+     * passes it on to whichever context it is filled on. */
+    bad = cairo_create (surface);
+    cairo_matrix_init (&singular, 0, 0, 0, 0, 0, 0);
+    cairo_set_matrix (bad, &singular);
+    prepared = cairo_prepare_fill (bad);
+    cairo_destroy (bad);
+
+    if (cairo_prepared_path_status (prepared) != CAIRO_STATUS_INVALID_MATRIX) {
+	cairo_test_log (ctx, "Error: prepare_fill on an error context gave %s\n",
+			cairo_status_to_string (cairo_prepared_path_status (prepared)));
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    if (cairo_prepared_path_reference (prepared) != prepared) {
+	cairo_test_log (ctx, "Error: reference returned a different object\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_prepared_path_destroy (prepared);
+
+    cr = cairo_create (surface);
+    cairo_fill_prepared (cr, prepared);
+    if (cairo_status (cr) != CAIRO_STATUS_INVALID_MATRIX) {
+	cairo_test_log (ctx, "Error: fill_prepared with an error path gave %s\n",
+			cairo_status_to_string (cairo_status (cr)));
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_destroy (cr);
+    cairo_prepared_path_destroy (prepared);
+
+    /* The nil context hands back a path in error; referencing and
+     * destroying it, or NULL, must be harmless. */
+    prepared = cairo_prepare_fill (cairo_create (NULL));
+    if (cairo_prepared_path_status (prepared) == CAIRO_STATUS_SUCCESS) {
+	cairo_test_log (ctx, "Error: prepare_fill on the nil context succeeded\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_prepared_path_destroy (cairo_prepared_path_reference (prepared));
+    cairo_prepared_path_destroy (prepared);
+
+    if (cairo_prepared_path_reference (NULL) != NULL) {
+	cairo_test_log (ctx, "Error: reference (NULL) was not NULL\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_prepared_path_destroy (NULL);
+
+    cairo_surface_destroy (surface);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    static const struct {
+	double tx, ty;
+    } offsets[] = {
+	{ 0, 0 },
+	{ 7, 3 },	/* reuses the prepared device path */
+	{ 5.5, 2.25 },	/* must be flattened afresh */
+	{ -3, 11.75 },
+    };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_LENGTH (offsets); i++) {
+	if (compare (ctx, offsets[i].tx, offsets[i].ty))
+	    ret = CAIRO_TEST_FAILURE;
+    }
+
+    if (check_errors (ctx))
+	ret = CAIRO_TEST_FAILURE;
+
+    return ret;
+}
+
+CAIRO_TEST (prepared_path,
+	    "Tests cairo_fill_prepared against cairo_fill under a non-identity "
+	    "transformation, at whole and fractional offsets, and its error paths",
+	    "fill, api", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)
@@ -0,0 +1,165 @@
+/*
+ * Copyright © 2019 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Red Hat, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. Red Hat, Inc. makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * RED HAT, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL RED HAT, INC. BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Several threads draw the same large image, scaled down a long way
+ * with CAIRO_FILTER_GOOD, all at once.  With CAIRO_MIPMAP set this has
+ * them race to build the image's mip pyramid.  Threads drawing with the
+ * same transformation must produce identical pixels.
+ */
+
+#include "cairo-test.h"
+#include <pthread.h>
+#include <string.h>
+
+#define N_THREADS 8
+#define SOURCE_SIZE 512
+#define SCALE 8
+#define CELL (SOURCE_SIZE / SCALE)
+
+typedef struct {
+    cairo_surface_t *source;
+    cairo_surface_t *target;
+    int id;
+} thread_data_t;
+
+static void *
+draw_thread (void *arg)
+{
+    thread_data_t *thread_data = arg;
+    cairo_t *cr;
+
+    cr = cairo_create (thread_data->target);
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    /* Odd threads sample at a different phase */
+    if (thread_data->id & 1)
+	cairo_translate (cr, .5, .5);
+    cairo_scale (cr, 1. / SCALE, 1. / SCALE);
+    cairo_set_source_surface (cr, thread_data->source, 0, 0);
+    cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_GOOD);
+    cairo_paint (cr);
+
+    cairo_destroy (cr);
+
+    return NULL;
+}
+
+static cairo_surface_t *
+create_source (void)
+{
+    cairo_surface_t *source;
+    cairo_t *cr;
+    int i;
+
+    source = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+					 SOURCE_SIZE, SOURCE_SIZE);
+    cr = cairo_create (source);
+
+    /* Fine detail that only averages out correctly when every source
+     * pixel is accounted for */
+    cairo_set_source_rgb (cr, 0, 0, 0);
+    cairo_paint (cr);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    for (i = 0; i < SOURCE_SIZE; i += 4)
+	cairo_rectangle (cr, i, 0, 1 + i / (SOURCE_SIZE / 3), SOURCE_SIZE);
+    cairo_fill (cr);
+
+    cairo_set_source_rgba (cr, 0, 0, 1, .75);
+    cairo_arc (cr, SOURCE_SIZE / 2, SOURCE_SIZE / 2, SOURCE_SIZE / 3, 0, 2 * M_PI);
+    cairo_fill (cr);
+
+    cairo_destroy (cr);
+
+    return source;
+}
+
+static cairo_bool_t
+same_pixels (cairo_surface_t *a, cairo_surface_t *b)
+{
+    int stride = cairo_image_surface_get_stride (a);
+    int height = cairo_image_surface_get_height (a);
+
+    cairo_surface_flush (a);
+    cairo_surface_flush (b);
+    return memcmp (cairo_image_surface_get_data (a),
+		   cairo_image_surface_get_data (b),
+		   stride * height) == 0;
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    const cairo_test_context_t *ctx = cairo_test_get_context (cr);
+    pthread_t threads[N_THREADS];
+    thread_data_t thread_data[N_THREADS];
+    cairo_test_status_t test_status = CAIRO_TEST_SUCCESS;
+    cairo_surface_t *source;
+    int i, n;
+
+    source = create_source ();
+
+    for (n = 0; n < N_THREADS; n++) {
+	thread_data[n].source = source;
+	thread_data[n].target = cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+							    CELL, CELL);
+	thread_data[n].id = n;
+	if (pthread_create (&threads[n], NULL, draw_thread, &thread_data[n]) != 0) {
+	    cairo_surface_destroy (thread_data[n].target);
+	    test_status = CAIRO_TEST_FAILURE;
+	    break;
+	}
+    }
+
+    for (i = 0; i < n; i++)
+	pthread_join (threads[i], NULL);
+
+    for (i = 0; i < n; i++) {
+	if (i >= 2 && ! same_pixels (thread_data[i].target,
+				     thread_data[i & 1].target))
+	{
+	    cairo_test_log (ctx, "Error: thread %d drew differently from thread %d\n",
+			    i, i & 1);
+	    test_status = CAIRO_TEST_FAILURE;
+	}
+
+	cairo_set_source_surface (cr, thread_data[i].target,
+				  (i % 4) * CELL, (i / 4) * CELL);
+	cairo_paint (cr);
+    }
+
+    for (i = 0; i < n; i++)
+	cairo_surface_destroy (thread_data[i].target);
+    cairo_surface_destroy (source);
+
+    return test_status;
+}
+
+CAIRO_TEST (pthread_minify_source,
+	    "Draw the same large image scaled down with CAIRO_FILTER_GOOD "
+	    "from several threads at once",
+	    "threads, filter", /* keywords */
+	    NULL, /* requirements */
+	    4 * CELL, 2 * CELL,
+	    NULL, draw)
@@ -57,9 +57,22 @@ draw (cairo_t *cr, int width, int height)
     return CAIRO_TEST_SUCCESS;
 }
 
+static cairo_test_status_t
+draw_fast (cairo_t *cr, int width, int height)
+{
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    return draw (cr, width, height);
+}
+
 CAIRO_TEST (rounded_rectangle_fill,
 	    "Tests handling of rounded rectangles, the UI designers favourite",
 	    "fill, rounded-rectangle", /* keywords */
 	    NULL, /* requirements */
 	    SIZE, SIZE,
 	    NULL, draw)
+CAIRO_TEST (fast_rounded_rectangle_fill,
+	    "Tests handling of rounded rectangles with fast antialiasing",
+	    "fill, rounded-rectangle", /* keywords */
+	    "target=raster", /* requirements */
+	    SIZE, SIZE,
+	    NULL, draw_fast)
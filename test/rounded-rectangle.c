@@ -0,0 +1,299 @@
+/*
+ * Copyright © 2019 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Red Hat, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. Red Hat, Inc. makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * RED HAT, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL RED HAT, INC. BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Exercises cairo_rounded_rectangle() with a zero and a negative
+ * radius, which give a plain rectangle, a radius larger than half the
+ * shorter side, which is clamped, and negative widths and heights.
+ * The shapes are both filled and stroked, and the fills are checked to
+ * be written by the SVG backend as <rect> elements with their radii.
+ */
+
+#include "cairo-test.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if CAIRO_HAS_SVG_SURFACE
+#include <cairo-svg.h>
+#endif
+
+#define CELL 40
+#define PAD 6
+
+static const struct {
+    double width, height, radius;
+} cases[] = {
+    {  28,  28,  0 },	/* zero radius */
+    {  28,  28, -5 },	/* negative radius */
+    {  28,  28,  6 },
+    {  28,  16, 50 },	/* clamped to a pill */
+    { -28,  28,  8 },	/* negative width */
+    {  28, -28,  8 },	/* negative height */
+    { -28, -16, 50 },	/* both, and clamped */
+    {  16,  28, 50 },
+};
+
+static void
+rounded_rectangle (cairo_t *cr, int i)
+{
+    double x = PAD, y = PAD;
+
+    if (cases[i].width < 0)
+	x -= cases[i].width;
+    if (cases[i].height < 0)
+	y -= cases[i].height;
+
+    cairo_rounded_rectangle (cr, x, y,
+			     cases[i].width, cases[i].height,
+			     cases[i].radius);
+}
+
+static void
+draw_cases (cairo_t *cr)
+{
+    unsigned int i;
+
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_line_width (cr, 2);
+    for (i = 0; i < ARRAY_LENGTH (cases); i++) {
+	cairo_save (cr);
+	cairo_translate (cr, (i % 4) * CELL, (i / 4) * CELL);
+
+	rounded_rectangle (cr, i);
+	cairo_set_source_rgb (cr, .6, .8, 1);
+	cairo_fill_preserve (cr);
+	cairo_set_source_rgb (cr, 0, 0, .5);
+	cairo_stroke (cr);
+
+	cairo_restore (cr);
+    }
+}
+
+#if CAIRO_HAS_SVG_SURFACE
+struct svg_buffer {
+    char data[4096];
+    unsigned int length;
+};
+
+static cairo_status_t
+write_svg (void *closure, const unsigned char *data, unsigned int length)
+{
+    struct svg_buffer *buf = closure;
+
+    if (length >= sizeof (buf->data) - buf->length)
+	return CAIRO_STATUS_WRITE_ERROR;
+
+    memcpy (buf->data + buf->length, data, length);
+    buf->length += length;
+    buf->data[buf->length] = '\0';
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/* The svg targets need a rasteriser to compare against the reference
+ * image, so check what each filled case is written out as instead: a
+ * <rect> with its clamped radii, or a plain rectangle path when the
+ * radius is zero or less. */
+static cairo_test_status_t
+check_svg_case (cairo_test_context_t *ctx, int i)
+{
+    struct svg_buffer buf;
+    cairo_surface_t *surface;
+    cairo_status_t status;
+    double x, y, w, h, r;
+    double rx, ry, rw, rh, rrx, rry;
+    const char *rect;
+    cairo_t *cr;
+
+    buf.length = 0;
+    surface = cairo_svg_surface_create_for_stream (write_svg, &buf,
+						   4 * CELL, 2 * CELL);
+    cr = cairo_create (surface);
+    cairo_translate (cr, (i % 4) * CELL, (i / 4) * CELL);
+    rounded_rectangle (cr, i);
+    cairo_fill (cr);
+    status = cairo_status (cr);
+    cairo_destroy (cr);
+
+    cairo_surface_finish (surface);
+    if (status == CAIRO_STATUS_SUCCESS)
+	status = cairo_surface_status (surface);
+    cairo_surface_destroy (surface);
+
+    if (status) {
+	cairo_test_log (ctx, "Error: svg output for case %d failed: %s\n",
+			i, cairo_status_to_string (status));
+	return CAIRO_TEST_FAILURE;
+    }
+
+    /* The expected box, with its corner at the top-left */
+    w = fabs (cases[i].width);
+    h = fabs (cases[i].height);
+    x = (i % 4) * CELL + PAD;
+    y = (i / 4) * CELL + PAD;
+    r = MIN (cases[i].radius, MIN (w, h) / 2);
+
+    rect = strstr (buf.data, "<rect ");
+    if (r <= 0) {
+	char path[128];
+
+	snprintf (path, sizeof (path), "d=\"M %g %g L %g %g L %g %g L %g %g Z",
+		  x, y, x + w, y, x + w, y + h, x, y + h);
+	if (rect != NULL || strstr (buf.data, path) == NULL) {
+	    cairo_test_log (ctx, "Error: case %d is not written as the "
+			    "plain rectangle %s\"\n%s\n", i, path, buf.data);
+	    return CAIRO_TEST_FAILURE;
+	}
+	return CAIRO_TEST_SUCCESS;
+    }
+
+    if (rect == NULL ||
+	(rect = strstr (rect, "\" x=\"")) == NULL ||
+	sscanf (rect, "\" x=\"%lf\" y=\"%lf\" width=\"%lf\" height=\"%lf\" "
+		"rx=\"%lf\" ry=\"%lf\"", &rx, &ry, &rw, &rh, &rrx, &rry) != 6)
+    {
+	cairo_test_log (ctx, "Error: case %d is not written as a rounded "
+			"<rect>\n%s\n", i, buf.data);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    if (rx != x || ry != y || rw != w || rh != h || rrx != r || rry != r) {
+	cairo_test_log (ctx, "Error: case %d is written as <rect x=%g y=%g "
+			"width=%g height=%g rx=%g ry=%g>; expected <rect x=%g "
+			"y=%g width=%g height=%g rx=%g ry=%g>\n",
+			i, rx, ry, rw, rh, rrx, rry, x, y, w, h, r, r);
+	return CAIRO_TEST_FAILURE;
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+check_svg (cairo_test_context_t *ctx)
+{
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_LENGTH (cases); i++) {
+	if (check_svg_case (ctx, i))
+	    ret = CAIRO_TEST_FAILURE;
+    }
+
+    return ret;
+}
+#endif
+
+static cairo_bool_t
+same_path (cairo_t *cr, cairo_path_t *a)
+{
+    cairo_path_t *b;
+    cairo_bool_t same;
+    int i;
+
+    b = cairo_copy_path (cr);
+    cairo_new_path (cr);
+
+    same = a->num_data == b->num_data;
+    for (i = 0; same && i < a->num_data; i++) {
+	same = memcmp (&a->data[i], &b->data[i], sizeof (a->data[i])) == 0;
+    }
+
+    cairo_path_destroy (b);
+
+    return same;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    cairo_surface_t *surface;
+    cairo_path_t *rect;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    double x1, y1, x2, y2;
+    cairo_t *cr;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+    cr = cairo_create (surface);
+    cairo_surface_destroy (surface);
+
+    /* A radius of zero or less is exactly cairo_rectangle() */
+    cairo_rectangle (cr, 10, 20, -30, 40);
+    rect = cairo_copy_path (cr);
+    cairo_new_path (cr);
+
+    cairo_rounded_rectangle (cr, 10, 20, -30, 40, 0);
+    if (! same_path (cr, rect)) {
+	cairo_test_log (ctx, "Error: a zero radius differs from cairo_rectangle\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    cairo_rounded_rectangle (cr, 10, 20, -30, 40, -1);
+    if (! same_path (cr, rect)) {
+	cairo_test_log (ctx, "Error: a negative radius differs from cairo_rectangle\n");
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_path_destroy (rect);
+
+    /* However large the radius, the shape stays within the rectangle
+     * and still reaches each of its sides */
+    cairo_rounded_rectangle (cr, 10, 20, -30, -16, 1000);
+    cairo_fill_extents (cr, &x1, &y1, &x2, &y2);
+    cairo_new_path (cr);
+    if (x1 != -20 || y1 != 4 || x2 != 10 || y2 != 20) {
+	cairo_test_log (ctx, "Error: clamped extents (%g, %g), (%g, %g); "
+			"expected (-20, 4), (10, 20)\n",
+			x1, y1, x2, y2);
+	ret = CAIRO_TEST_FAILURE;
+    }
+
+    if (cairo_status (cr)) {
+	cairo_test_log (ctx, "Error: %s\n",
+			cairo_status_to_string (cairo_status (cr)));
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_destroy (cr);
+
+#if CAIRO_HAS_SVG_SURFACE
+    if (check_svg (ctx))
+	ret = CAIRO_TEST_FAILURE;
+#endif
+
+    return ret;
+}
+
+static cairo_test_status_t
+draw (cairo_t *cr, int width, int height)
+{
+    draw_cases (cr);
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+CAIRO_TEST (rounded_rectangle,
+	    "Tests cairo_rounded_rectangle with degenerate, oversized and "
+	    "negative dimensions",
+	    "fill, stroke", /* keywords */
+	    NULL, /* requirements */
+	    4 * CELL, 2 * CELL,
+	    preamble, draw)
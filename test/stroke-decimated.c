@@ -0,0 +1,236 @@
+/*
+ * Copyright © 2019 Red Hat, Inc.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without
+ * fee, provided that the above copyright notice appear in all copies
+ * and that both that copyright notice and this permission notice
+ * appear in supporting documentation, and that the name of
+ * Red Hat, Inc. not be used in advertising or publicity pertaining to
+ * distribution of the software without specific, written prior
+ * permission. Red Hat, Inc. makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as
+ * is" without express or implied warranty.
+ *
+ * RED HAT, INC. DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL RED HAT, INC. BE LIABLE FOR ANY SPECIAL,
+ * INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION
+ * OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR
+ * IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+/* Strokes a dense polyline with CAIRO_ANTIALIAS_FAST as a single path,
+ * which is decimated to a few points per pixel column when the line is
+ * thin enough, and compares it with the same polyline drawn so that it
+ * is not decimated: in pieces too short to be worth it for hairlines,
+ * and with a single dash longer than the whole line otherwise.
+ *
+ * Where decimation applies, each column must be inked over the same
+ * span to within the antialiasing either side of a dropped vertex.
+ * Where it does not, the output must be identical.
+ */
+
+#include "cairo-test.h"
+#include "buffer-diff.h"
+
+#define WIDTH 200
+#define HEIGHT 60
+#define NUM_POINTS 8000
+#define PIECE 500 /* too few points to be decimated */
+/* The rows of antialiasing either side of a dropped vertex that a
+ * decimated column may lose, or gain */
+#define SLACK 2
+#define OVERSHOOT 1
+
+static void
+polyline (cairo_t *cr, int first, int last)
+{
+    uint32_t seed = 0x12345678;
+    int i;
+
+    cairo_new_path (cr);
+    for (i = 0; i <= last; i++) {
+	double noise;
+
+	seed = seed * 1103515245 + 12345;
+	noise = ((seed >> 16 & 0xff) - 127.5) / 32.;
+	if (i >= first)
+	    cairo_line_to (cr,
+			   2 + i * (WIDTH - 4.) / NUM_POINTS,
+			   HEIGHT / 2 + (HEIGHT / 3) * sin (i * .002) + noise);
+    }
+}
+
+static cairo_surface_t *
+draw_polyline (double line_width,
+	       cairo_line_join_t line_join,
+	       cairo_bool_t decimate)
+{
+    static const double solid[] = { 1e6 };
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    int i;
+
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+    cr = cairo_create (surface);
+    cairo_set_source_rgb (cr, 1, 1, 1);
+    cairo_paint (cr);
+
+    cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+    cairo_set_line_width (cr, line_width);
+    cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+    cairo_set_line_join (cr, line_join);
+    cairo_set_source_rgb (cr, 0, 0, 0);
+
+    if (decimate) {
+	polyline (cr, 0, NUM_POINTS - 1);
+	cairo_stroke (cr);
+    } else if (line_width <= 1) {
+	/* Hairlines are drawn a segment at a time, so the pieces only
+	 * meet at their ends, where the round caps match the joins */
+	for (i = 0; i < NUM_POINTS - 1; i += PIECE) {
+	    polyline (cr, i, MIN (i + PIECE, NUM_POINTS - 1));
+	    cairo_stroke (cr);
+	}
+    } else {
+	cairo_set_dash (cr, solid, ARRAY_LENGTH (solid), 0);
+	polyline (cr, 0, NUM_POINTS - 1);
+	cairo_stroke (cr);
+    }
+
+    cairo_destroy (cr);
+
+    return surface;
+}
+
+/* Finds the first and last rows of column x with any ink in them */
+static void
+column_span (cairo_surface_t *surface, int x, int *top, int *bottom)
+{
+    const unsigned char *data = cairo_image_surface_get_data (surface);
+    int stride = cairo_image_surface_get_stride (surface);
+    int y;
+
+    *top = HEIGHT;
+    *bottom = -1;
+    for (y = 0; y < HEIGHT; y++) {
+	const uint32_t *row = (const uint32_t *) (data + y * stride);
+
+	if (row[x] != 0xffffffff) {
+	    if (*top == HEIGHT)
+		*top = y;
+	    *bottom = y;
+	}
+    }
+}
+
+static cairo_test_status_t
+compare_spans (const cairo_test_context_t *ctx,
+	       double line_width,
+	       cairo_surface_t *decimated,
+	       cairo_surface_t *reference)
+{
+    int x;
+
+    cairo_surface_flush (decimated);
+    cairo_surface_flush (reference);
+
+    /* Only the columns the points lie in; those either side see just
+     * the antialiasing of the ends */
+    for (x = 2; x < WIDTH - 2; x++) {
+	int top, bottom, ref_top, ref_bottom;
+
+	column_span (decimated, x, &top, &bottom);
+	column_span (reference, x, &ref_top, &ref_bottom);
+	if (ref_top - top > OVERSHOOT || bottom - ref_bottom > OVERSHOOT ||
+	    top - ref_top > SLACK || ref_bottom - bottom > SLACK)
+	{
+	    cairo_test_log (ctx,
+			    "Error: width %g, column %d inked over rows %d-%d, "
+			    "expected %d-%d\n",
+			    line_width, x, top, bottom, ref_top, ref_bottom);
+	    return CAIRO_TEST_FAILURE;
+	}
+    }
+
+    return CAIRO_TEST_SUCCESS;
+}
+
+static cairo_test_status_t
+compare_pixels (const cairo_test_context_t *ctx,
+		double line_width,
+		cairo_surface_t *decimated,
+		cairo_surface_t *reference)
+{
+    cairo_surface_t *diff;
+    buffer_diff_result_t result;
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+
+    diff = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+    if (image_diff (ctx, reference, decimated, diff, &result) ||
+	result.pixels_changed)
+    {
+	cairo_test_log (ctx,
+			"Error: width %g was decimated, %u pixels differ\n",
+			line_width, result.pixels_changed);
+	ret = CAIRO_TEST_FAILURE;
+    }
+    cairo_surface_destroy (diff);
+
+    return ret;
+}
+
+static cairo_test_status_t
+preamble (cairo_test_context_t *ctx)
+{
+    static const struct {
+	double line_width;
+	cairo_line_join_t line_join;
+	cairo_bool_t decimated;
+    } cases[] = {
+	{ 1, CAIRO_LINE_JOIN_MITER, TRUE },
+	{ 2, CAIRO_LINE_JOIN_ROUND, TRUE },
+	{ 2, CAIRO_LINE_JOIN_BEVEL, FALSE },	/* the corners would show */
+	{ 4, CAIRO_LINE_JOIN_ROUND, FALSE },	/* too wide */
+    };
+    cairo_test_status_t ret = CAIRO_TEST_SUCCESS;
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_LENGTH (cases); i++) {
+	cairo_surface_t *decimated, *reference;
+	cairo_test_status_t status;
+
+	decimated = draw_polyline (cases[i].line_width,
+				   cases[i].line_join,
+				   TRUE);
+	reference = draw_polyline (cases[i].line_width,
+				   cases[i].line_join,
+				   FALSE);
+
+	if (cases[i].decimated)
+	    status = compare_spans (ctx, cases[i].line_width,
+				    decimated, reference);
+	else
+	    status = compare_pixels (ctx, cases[i].line_width,
+				     decimated, reference);
+	if (status)
+	    ret = status;
+
+	cairo_surface_destroy (reference);
+	cairo_surface_destroy (decimated);
+    }
+
+    return ret;
+}
+
+CAIRO_TEST (stroke_decimated,
+	    "Compares a dense polyline stroked with CAIRO_ANTIALIAS_FAST as a "
+	    "single path, decimated where thin enough, with the same line "
+	    "drawn undecimated",
+	    "stroke", /* keywords */
+	    NULL, /* requirements */
+	    0, 0,
+	    preamble, NULL)